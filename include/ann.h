@@ -13,11 +13,9 @@
 
 #include <math.h>
 #include <stdlib.h>
+#include "fractal.h"
+#include "vector_store.h"
 
-#define VECTOR_DIM 8
-#define MAX_NEIGHBORS 16
-#define MAX_PARITY_TAGS 32
-#define MAX_HASH_SIZE 64
 #define MAX_REPLICAS 8
 
 typedef struct {
@@ -38,19 +36,6 @@ typedef struct {
     int capacity;
 } similarity_heap_t;
 
-typedef struct {
-    int id;
-    double density;
-    double coherence;
-    int neighbors[MAX_NEIGHBORS];
-    int neighbor_count;
-    char *parity_tags[MAX_PARITY_TAGS];
-    int parity_count;
-    char hash[MAX_HASH_SIZE];
-    double *vector;
-    int replication_factor;
-} TorusNode;
-
 // Core vector operations
 static inline double cosine_similarity(const double *a, const double *b, int dim) {
     double dot = 0.0, norm_a = 0.0, norm_b = 0.0;
@@ -84,13 +69,54 @@ static inline void vector_add_weighted(double *dest, const double *src, double w
 
 // ANN search function declarations
 similarity_heap_t* create_similarity_heap(int capacity);
+void similarity_heap_init(similarity_heap_t *heap, similarity_result_t *storage, int capacity);
 void heap_insert(similarity_heap_t *heap, int node_id, double similarity, double combined_score);
+int heap_drain_sorted(similarity_heap_t *heap);  // sorts results descending, returns count
 void heap_free(similarity_heap_t *heap);
 similarity_result_t* find_k_nearest(TorusNode *network, int total_nodes, int query_node, int k);
+int find_k_nearest_into(TorusNode *network, int total_nodes, int query_node, int k,
+                        similarity_result_t *out);
+
+// Same search for an arbitrary query vector, scored with the given
+// coherence; exclude is an index to skip, or -1. scratch (optional) is the
+// calling thread's HNSW visited set.
+struct hnsw_scratch;
+int find_k_nearest_vector(TorusNode *network, int total_nodes, const double *query, double coherence,
+                          int exclude, int k, struct hnsw_scratch *scratch, similarity_result_t *out);
+
+// Answers query_count queries at once on the shared thread pool. Row q of
+// out (k entries) holds query q's results, padded with node_id -1;
+// counts[q] (optional) gets the number found. Returns the total found.
+int find_k_nearest_batch(TorusNode *network, int total_nodes, const int *query_nodes,
+                         int query_count, int k, similarity_result_t *out, int *counts);
+
+// Vector injection and management. -1 when the journal (journal.h) has
+// failed: the change is refused, or was made but could not be logged.
+int inject_vector(TorusNode *node, const double *vector, int dim);
+int randomize_vector(TorusNode *node, int dim, double range);
+int evolve_vector(TorusNode *node, double learning_rate, const double *target);
+
+// Graph index (hnsw.h). When attached, find_k_nearest scores the index's
+// ef_search nearest candidates instead of scanning the whole network, and
+// vector updates above are mirrored into it.
+struct hnsw_index;
+void ann_attach_index(struct hnsw_index *index);
+struct hnsw_index* ann_get_index(void);
+int brute_force_nearest(TorusNode *network, int total_nodes, const double *query, int k,
+                        int exclude_id, similarity_result_t *out);
+
+// Contiguous AoSoA copy of every node vector (vector_store.h). When
+// attached, the exhaustive scan and routing score candidates in SIMD
+// batches from here instead of the row-major node_hot vectors.
+void ann_attach_vector_store(vector_store_t *store);
+vector_store_t* ann_get_vector_store(void);
 
-// Vector injection and management
-void inject_vector(TorusNode *node, const double *vector, int dim);
-void randomize_vector(TorusNode *node, int dim, double range);
-void evolve_vector(TorusNode *node, double learning_rate, const double *target);
+// Optional compressed copy (quantize.h). When attached it takes over
+// candidate scoring in find_k_nearest, walking the index on its codes,
+// with exact re-ranking.
+struct quantized_store;
+void ann_attach_quantized_store(struct quantized_store *store, int rerank);
+struct quantized_store* ann_get_quantized_store(void);
+void ann_recall_report(TorusNode *network, int total_nodes, int k, int ef_search, int samples);
 
 #endif // ANN_H
@@ -0,0 +1,50 @@
+/*
+ * FT-DFRP: Parity Distance Fields
+ *
+ * Dual Licensed:
+ * 1. AGPL-3.0 for research/academic use
+ * 2. Commercial license: contact michael.doran.808@gmail.com
+ *
+ * Copyright (C) 2025 Michael Doran
+ */
+
+#ifndef DISTANCE_FIELD_H
+#define DISTANCE_FIELD_H
+
+#include "tag_intern.h"
+#include "topology.h"
+#include <stdint.h>
+
+#define DISTANCE_UNREACHABLE UINT16_MAX   // also used for paths of 65535+ hops
+#define DISTANCE_FIELD_DEFAULT_LIMIT 256   // resident fields, total_nodes * 2 bytes each
+
+// Per parity tag, the hop count from every node to its nearest holder,
+// following neighbour links. A field is built on first use with one
+// multi-source BFS from all holders over the reversed graph, then kept
+// current by parity_index: an added holder only lowers distances around
+// itself, and a lost holder only re-derives the nodes whose every
+// shortest path led to it. Lookups are one array load.
+//
+// The topology is global and identical on every rank, so each rank builds
+// its own fields from its replica of the parity index, without messages.
+//
+// At most a limit's worth of fields stay resident; building one more
+// evicts the least recently looked up, which is rebuilt if used again.
+
+// Borrows graph (which must outlive the fields) and builds its reverse
+// edges; drops any existing fields.
+void distance_field_init(const topology_t *graph);
+void distance_field_free(void);
+// Drops every field; each is rebuilt on its next lookup.
+void distance_field_reset(void);
+// Caps the resident fields (at least 1), evicting down to it at once.
+void distance_field_set_limit(int max_fields);
+void distance_field_report(void);
+
+uint16_t distance_field_get(parity_tag_id_t tag, int node_id);
+
+// Called by parity_index after a tag's holder set changes.
+void distance_field_holder_added(parity_tag_id_t tag, int node_id);
+void distance_field_holder_removed(parity_tag_id_t tag, int node_id);
+
+#endif // DISTANCE_FIELD_H
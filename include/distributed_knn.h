@@ -0,0 +1,52 @@
+/*
+ * FT-DFRP: Distributed k-NN Queries
+ *
+ * Dual Licensed:
+ * 1. AGPL-3.0 for research/academic use
+ * 2. Commercial license: contact michael.doran.808@gmail.com
+ *
+ * Copyright (C) 2025 Michael Doran
+ */
+
+#ifndef DISTRIBUTED_KNN_H
+#define DISTRIBUTED_KNN_H
+
+#include "ann.h"
+
+#define DKNN_MAX_BATCH 64   // queries per collective
+
+// Scatter-gather k-NN over every shard. The querying rank broadcasts up to
+// DKNN_MAX_BATCH query vectors with MPI_Bcast; each rank answers all of
+// them from its own shard on the thread pool; the per-rank top-k rows are
+// merged with MPI_Reduce under a custom MPI_Op, which MPI runs as a tree.
+// Vectors never leave their owner.
+//
+// Only one rank may issue queries at a time. The other ranks join each
+// collective from their partition_poll loop, so they must keep polling
+// (partition_serve does). The collectives run on their own communicator
+// next to the transport's progress thread, so MPI must provide
+// MPI_THREAD_MULTIPLE.
+
+// Collective over MPI_COMM_WORLD: every rank calls it once, after
+// transport_start and partition_init. Returns -1 (and queries fail) when
+// mpi_thread_level is below MPI_THREAD_MULTIPLE.
+int distributed_knn_start(void);
+void distributed_knn_stop(void);
+int distributed_knn_ready(void);
+
+// Row q of out (k entries) holds the global top-k for query q by combined
+// score, padded with node_id -1; counts[q] (optional) gets the number
+// found. exclude[q] is a global node id to skip, or -1. Returns the total
+// found, or -1.
+int distributed_knn_vectors(const double *vectors, const double *coherence, const int *exclude,
+                            int count, int k, similarity_result_t *out, int *counts);
+// Queries by node: each node's own vector and coherence, excluding itself.
+int distributed_knn(const int *node_ids, int count, int k, similarity_result_t *out, int *counts);
+
+// Times queries random-node lookups in batches of batch and prints
+// throughput and the local-search/merge split. Run on the querying rank
+// while the others serve; repeat under mpirun -np 1..16 with a fixed
+// total (strong scaling) or a fixed per-rank node count (weak scaling).
+void distributed_knn_bench(int queries, int k, int batch);
+
+#endif // DISTRIBUTED_KNN_H
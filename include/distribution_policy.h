@@ -10,7 +10,7 @@ typedef struct {
     double centrality_weight;
     int min_replicas;
     int max_replicas;
-    int tree_evaluation_depth;
+    int max_node_load;          // tags a node may hold before placement skips it; 0 = MAX_PARITY_TAGS
 } williams_distribution_policy_t;
 
 // Default policy instance
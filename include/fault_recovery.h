@@ -0,0 +1,70 @@
+/*
+ * FT-DFRP: Fault Recovery System
+ *
+ * Dual Licensed:
+ * 1. AGPL-3.0 for research/academic use
+ * 2. Commercial license: contact michael.doran.808@gmail.com
+ *
+ * Copyright (C) 2025 Michael Doran
+ */
+
+#ifndef FAULT_RECOVERY_H
+#define FAULT_RECOVERY_H
+
+#include "distribution_policy.h"
+#include "tag_intern.h"
+
+#define RECOVERY_MAX_HOPS 8          // how far from a surviving holder targets are searched for
+#define RECOVERY_CANDIDATES 64       // candidates scored per tag before choosing
+#define RECOVERY_DEFAULT_RATE 20000  // replica transfers per second
+#define RECOVERY_DEFAULT_BURST 1024
+
+// Bulk re-replication after node loss. Every tag a failed node held is
+// topped back up to policy->min_replicas from its survivors. Targets for
+// each tag are found on the thread pool by a breadth-first search out from
+// the surviving holders (the transfer sources), scoring nearby nodes by
+// placement score, load and hop count; a node is reserved atomically
+// before it is taken, so targets are distinct per tag and no node goes
+// past the load cap however many tags choose it at once. Transfers go out
+// grouped per target node, paced by a token bucket.
+
+typedef struct {
+    int failed_nodes;
+    int affected_tags;          // held by a failed node
+    int lost_tags;              // no surviving holder; cannot be recovered
+    int replicas_needed;
+    int replicas_placed;
+    int target_nodes;           // nodes that received replicas
+    double plan_ms;
+    double transfer_ms;
+    double throttled_ms;        // part of transfer_ms spent waiting for tokens
+} recovery_stats_t;
+
+// Strips the failed nodes' tags on their owners, which announce them empty
+// to every rank's holder index, and re-replicates what they held from this
+// rank's view of the index. stats may be NULL. Returns the number of replicas placed, or -1
+// once the journal has failed, leaving the nodes not yet processed as
+// they were.
+int recover_failed_nodes(const int *failed, int count, const williams_distribution_policy_t *policy,
+                         recovery_stats_t *stats);
+void recovery_report(const recovery_stats_t *stats);
+// Transfer pacing; per_second <= 0 disables it.
+void recovery_set_rate(double per_second, int burst);
+
+// Tops one tag up to default_williams_policy.min_replicas.
+void recover_parity_tag_id(parity_tag_id_t tag_id);
+void recover_parity_tag(const char *tag);
+
+// Legacy owning copy of the holder set, -1 terminated. Prefer
+// parity_index_lookup, which does not allocate.
+int* find_nodes_with_parity(const char *tag);
+
+void assign_parity_tag(int node_id, const char *tag);
+void remove_parity_tag(int node_id, const char *tag);
+
+// Places tags tags, then fails growing racks of consecutive nodes
+// (1, 2, 4, ... up to max_failed) and times recovery of each. Afterwards
+// every node gets back the tags the holder index listed before the run.
+void recovery_bench(int tags, int max_failed);
+
+#endif // FAULT_RECOVERY_H
@@ -1,15 +1,18 @@
 #ifndef FRACTAL_H
 #define FRACTAL_H
 
-#include "parity_types.h"
-
-#define VECTOR_DIM 8
-#define MAX_NEIGHBORS 16
+#define DEFAULT_VECTOR_DIM 8
 #define MAX_PARITY_TAGS 32
 #define MAX_HASH_SIZE 65
 
-extern int total_nodes;
-extern TorusNode *network;
+typedef struct TorusNode TorusNode;
+
+#include "parity_types.h"
+
+extern int total_nodes;     // whole network, across all ranks
+extern int vector_dim;      // per network, fixed at initialize_network time
+extern TorusNode *network;  // this rank's shard and ghosts; see partition.h
+extern int mpi_thread_level;  // MPI_THREAD_* granted by MPI_Init_thread
 
 void run_cli(int argc, char **argv);
 
@@ -7,11 +7,16 @@ extern "C" {
 
 // Network state functions
 int ffi_add_node(int id, double density, double *vector);
+// Copies node id's hot state wherever it lives; vector holds vector_dim
+// doubles. Returns 0, or -1 for an unknown node.
+int ffi_get_node(int id, double *density, double *coherence, double *vector);
 int ffi_query_parity(const char *tag, int *result_nodes, int max_results);
+// path receives at most max_hops node ids, from first; returns the count or -1
 int ffi_compute_route(int from, int to, int *path, int max_hops);
 
 // Parity management
 int ffi_announce_parity(int node_id);
+// Places a new tag on replicas nodes; returns how many were placed, or -1
 int ffi_distribute_parity(const char *tag, int replicas);
 char* ffi_get_parity_map();
 int ffi_trigger_rebalance();
@@ -19,10 +24,13 @@ int ffi_trigger_rebalance();
 // ANN functions
 double ffi_vector_similarity(int node_a, int node_b);
 int ffi_find_k_nearest(int query_node, int k, int *results);
+// results holds query_count rows of k node ids, padded with -1
+int ffi_find_k_nearest_batch(const int *query_nodes, int query_count, int k, int *results);
 
 // State export
 char* ffi_export_json_state();
 int ffi_import_json_state(const char *json_str);
+// Root of this rank's Merkle tree as hex; the caller frees it.
 char* ffi_get_merkle_root();
 
 #ifdef __cplusplus
@@ -0,0 +1,80 @@
+/*
+ * FT-DFRP: Fractal Toroidal Density Field Routing Protocol - HNSW Index
+ *
+ * Dual Licensed:
+ * 1. AGPL-3.0 for research/academic use: https://www.gnu.org/licenses/agpl-3.0.html
+ * 2. Commercial license available - contact michael.doran.808@gmail.com for terms
+ *
+ * Copyright (C) 2025 Michael Doran
+ */
+
+#ifndef HNSW_H
+#define HNSW_H
+
+#include "ann.h"
+
+#define HNSW_DEFAULT_M 16
+#define HNSW_DEFAULT_EF_CONSTRUCTION 200
+#define HNSW_DEFAULT_EF_SEARCH 64
+#define HNSW_MAX_LEVEL 16
+
+// Visited-set scratch for one searching thread.
+typedef struct hnsw_scratch {
+    unsigned int *visited;  // tagged by epoch, sized to the index capacity
+    unsigned int epoch;
+    int capacity;
+} hnsw_scratch_t;
+
+// Hierarchical navigable small-world graph over node vectors.
+// Slots are addressed by the node's index in the local network array
+// (partition.h) so updates from inject_vector/evolve_vector map straight
+// onto the graph without a lookup table.
+typedef struct hnsw_index {
+    int dim;
+    int M;                  // max links per node on levels >= 1
+    int M0;                 // max links per node on level 0
+    int ef_construction;
+    int ef_search;          // recall-vs-latency knob used by find_k_nearest
+    double level_mult;
+
+    int capacity;           // highest node id + 1 that fits
+    int count;              // nodes currently indexed
+    int entry_point;
+    int max_level;
+
+    int *levels;            // levels[id] = top level of id, -1 if absent
+    int **links;            // per node: level 0 block then one block per upper level
+    double *vectors;        // capacity * dim, unit-normalized copies
+
+    hnsw_scratch_t scratch; // used by upserts and hnsw_search
+} hnsw_index_t;
+
+hnsw_index_t* hnsw_create(int capacity, int dim, int M, int ef_construction);
+void hnsw_free(hnsw_index_t *index);
+
+// Inserts node_id or, if it is already indexed, moves it to the new vector
+// and relinks it on every level it occupies.
+void hnsw_upsert(hnsw_index_t *index, int node_id, const double *vector);
+void hnsw_set_ef_search(hnsw_index_t *index, int ef_search);
+
+// Writes up to k results sorted by descending similarity; returns the count.
+// hnsw_search uses the index's own scratch and is not thread-safe; concurrent
+// readers each pass their own scratch (zero-initialized, freed with
+// hnsw_scratch_free) and must not overlap with upserts.
+int hnsw_search(hnsw_index_t *index, const double *query, int k, int ef_search,
+                int exclude_id, similarity_result_t *out);
+int hnsw_search_with_scratch(const hnsw_index_t *index, hnsw_scratch_t *scratch,
+                             const double *query, int k, int ef_search,
+                             int exclude_id, similarity_result_t *out);
+void hnsw_scratch_free(hnsw_scratch_t *scratch);
+
+// Similarity of the caller's query to stored node id.
+typedef double (*hnsw_score_fn)(const void *ctx, int id);
+// Same search, but the graph is walked on score(ctx, id) instead of the
+// index's own vectors, e.g. to read compressed codes (quantize.h).
+// Results carry score's similarities; same threading rules as above.
+int hnsw_search_scored(const hnsw_index_t *index, hnsw_scratch_t *scratch,
+                       hnsw_score_fn score, const void *ctx, int k, int ef_search,
+                       int exclude_id, similarity_result_t *out);
+
+#endif // HNSW_H
@@ -0,0 +1,132 @@
+/*
+ * FT-DFRP: Mutation Journal
+ *
+ * Dual Licensed:
+ * 1. AGPL-3.0 for research/academic use
+ * 2. Commercial license: contact michael.doran.808@gmail.com
+ *
+ * Copyright (C) 2025 Michael Doran
+ */
+
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include "parity_types.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Write-ahead journal of this rank's node mutations, one file per rank
+// next to its snapshot (<prefix>.<rank>.wal, see snapshot.h). Every tag
+// added to or removed from an owned node and every vector change is
+// appended as a record carrying a sequence number (LSN) and a CRC-32C, so
+// a restart maps the latest snapshot and replays the records after the
+// LSN it was taken at. Vector records hold the resulting vector and
+// density rather than the operation, so replaying one twice is harmless.
+//
+// Appends go to an in-memory buffer; a flush writes everything buffered
+// with one write() and, depending on the durability level, one
+// fdatasync(). Writers that need their record on disk wait for the next
+// flush instead of syncing on their own, so concurrent mutations share a
+// sync (group commit).
+
+#define JOURNAL_MAGIC "FTDFWAL"
+#define JOURNAL_VERSION 1
+#define JOURNAL_BUFFER_BYTES (1 << 20)
+#define JOURNAL_DEFAULT_INTERVAL_MS 10
+
+typedef enum {
+    JOURNAL_SYNC_NONE,    // written every interval, never synced: survives a process crash, not power loss
+    JOURNAL_SYNC_BATCH,   // synced every interval: power loss costs at most that window
+    JOURNAL_SYNC_EVERY,   // a mutation returns once its record is synced
+} journal_sync_t;
+
+typedef struct {
+    journal_sync_t sync;
+    int interval_ms;      // flush period for NONE and BATCH
+} journal_config_t;
+
+typedef enum {
+    JOURNAL_TAG_ADD = 1,      // payload: tag name
+    JOURNAL_TAG_REMOVE,       // payload: tag name
+    JOURNAL_VECTOR,           // payload: density, then vector_dim doubles
+} journal_record_type_t;
+
+// 24 bytes, followed by length payload bytes.
+typedef struct {
+    uint32_t crc;         // CRC-32C of the rest of the record, payload included
+    uint32_t length;
+    uint64_t lsn;
+    uint16_t type;
+    uint16_t reserved;
+    int32_t node_id;
+} journal_record_t;
+
+typedef struct {
+    long long appended;
+    long long flushes;
+    long long syncs;
+    long long bytes;
+} journal_stats_t;
+
+typedef struct {
+    long long records;    // valid records read
+    long long applied;    // of those, newer than the snapshot
+    long long torn_bytes; // dropped from the end: a partial or corrupt tail
+    uint64_t last_lsn;
+    double elapsed_ms;
+} journal_replay_stats_t;
+
+journal_config_t journal_default_config(void);
+// "none", "batch" or "every"; 0 on success.
+int journal_parse_sync(const char *name, journal_sync_t *sync);
+const char* journal_sync_name(journal_sync_t sync);
+
+// <prefix>.<rank>.wal into path[cap].
+void journal_path(const char *prefix, int rank, char *path, size_t cap);
+// fsyncs the directory holding path, so a file renamed into it survives a
+// crash. 0 on success.
+int journal_sync_directory(const char *path);
+
+// Starts an empty journal at path whose first record is next_lsn; replaces
+// any open journal (flushed and synced first). The file is written aside
+// and renamed into place, its directory synced. 0 on success; on failure
+// an open journal carries on unchanged.
+int journal_open(const char *path, const journal_config_t *config, uint64_t next_lsn);
+// Flushes, syncs and closes; a no-op when none is open.
+void journal_close(void);
+int journal_is_open(void);
+// Waits until every record appended so far is on disk; -1 when none is
+// open or it has failed.
+int journal_sync(void);
+// LSN of the last record appended, or of the snapshot the journal started
+// from; 0 before any journal existed.
+uint64_t journal_last_lsn(void);
+void journal_get_stats(journal_stats_t *stats);
+
+// Checkpoint: the snapshot under prefix was just written, so start this
+// rank's journal next to it from scratch.
+int journal_checkpoint(const char *prefix, const journal_config_t *config);
+// Restart: replays <prefix>.<rank>.wal on top of the restored snapshot,
+// applying records after snapshot_lsn, cuts off a torn tail, then keeps
+// appending to the same file. A missing journal counts as empty. stats
+// may be NULL. 0 on success.
+int journal_recover(const char *prefix, uint64_t snapshot_lsn, const journal_config_t *config,
+                    journal_replay_stats_t *stats);
+
+// Mutation hooks, called by the owner after the change is applied; no-ops
+// returning 0 while no journal is open. -1 when the record cannot be made
+// durable: the journal has failed, or at JOURNAL_SYNC_EVERY its sync did.
+int journal_log_tag(int node_id, parity_tag_id_t tag, int removed);
+int journal_log_vector(int node_id, int slot);
+// The errno of the write or sync that failed, 0 while the journal is
+// healthy. Mutations are refused from then on, until a checkpoint or a
+// recovery starts a new journal.
+int journal_failed(void);
+
+// Mutations/s at each durability level, logging tag and vector records for
+// this rank's nodes without applying them, then with several writers
+// logging at once to show group commit. Needs no journal open; path must
+// not exist yet, and is deleted afterwards.
+void journal_bench(int mutations, const char *path);
+
+#endif // JOURNAL_H
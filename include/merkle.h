@@ -2,25 +2,94 @@
 #define MERKLE_H
 
 #include "fractal.h"
+#include <stdint.h>
 
-typedef struct merkle_node {
-    char hash[MAX_HASH_SIZE];
-    struct merkle_node *left;
-    struct merkle_node *right;
-    int is_leaf;
-    int node_id;
-} merkle_node_t;
+#define MERKLE_MAX_DEPTH 32
+#define MERKLE_DIGEST_SIZE 32   // raw SHA-256; hex (MAX_HASH_SIZE) only at the edges
 
+#define MERKLE_LEAF_PREFIX 0x00
+#define MERKLE_NODE_PREFIX 0x01
+
+// Array-backed Merkle tree. Level 0 holds the leaf hashes, each higher
+// level the hashes of pairs below it; a level with an odd count promotes
+// its last hash unchanged. All levels live in one array, so the tree never
+// allocates after creation, a leaf update rehashes only the path to the
+// root, and the root is a plain read. A leaf hashes MERKLE_LEAF_PREFIX and
+// its data, an internal node MERKLE_NODE_PREFIX and the 64 bytes of its two
+// children's digests, so an internal node's children never verify as a
+// leaf; full rebuilds hash each level in parallel, in batches of
+// sha256_batch.
 typedef struct {
-    merkle_node_t *root;
-    char **leaf_hashes;
     int leaf_count;
-    char global_root[MAX_HASH_SIZE];
+    int levels;                     // root level is levels - 1
+    int level_offset[MERKLE_MAX_DEPTH + 1];
+    int level_size[MERKLE_MAX_DEPTH + 1];
+    uint8_t (*hashes)[MERKLE_DIGEST_SIZE];  // all levels
 } merkle_tree_t;
 
+// Inclusion proof: the sibling hash at each level where the path had one,
+// leaf first.
+typedef struct {
+    int leaf_index;
+    int length;
+    uint8_t siblings[MERKLE_MAX_DEPTH][MERKLE_DIGEST_SIZE];
+    uint8_t sibling_left[MERKLE_MAX_DEPTH];     // sibling hashes in before the path
+} merkle_proof_t;
+
+merkle_tree_t* merkle_tree_create(int leaf_count);
+void merkle_tree_free(merkle_tree_t *tree);
+// Hashes data into leaf index without touching its ancestors; follow with
+// merkle_tree_rebuild.
+void merkle_set_leaf(merkle_tree_t *tree, int index, const void *data, size_t length);
+void merkle_tree_rebuild(merkle_tree_t *tree);
+// Hashes data into leaf index and rehashes its path to the root.
+void merkle_update_leaf(merkle_tree_t *tree, int index, const void *data, size_t length);
+// Rehashes the ancestors of leaves[0..count) after merkle_set_leaf, each
+// shared ancestor once. leaves must be sorted and is overwritten.
+void merkle_rehash_paths(merkle_tree_t *tree, int *leaves, int count);
+const uint8_t* merkle_root(const merkle_tree_t *tree);
+
+static inline const uint8_t* merkle_node_hash(const merkle_tree_t *tree, int level, int index) {
+    return tree->hashes[tree->level_offset[level] + index];
+}
+
+int merkle_prove(const merkle_tree_t *tree, int index, merkle_proof_t *proof);
+// Leaf digest of data, as merkle_set_leaf stores it.
+void merkle_hash_leaf(const void *data, size_t length, uint8_t *digest);
+// 1 when leaf_hash with proof hashes up to root.
+int merkle_verify_proof(const uint8_t *leaf_hash, const merkle_proof_t *proof, const uint8_t *root);
+
+// Lowercase hex of a digest into hex[MAX_HASH_SIZE].
+void merkle_to_hex(const uint8_t *digest, char *hex);
+// 0 on success; -1 unless hex is exactly 64 hex digits.
+int merkle_from_hex(const char *hex, uint8_t *digest);
+
+// The tree over the nodes this rank owns (partition.h); leaf i is node
+// partition.first + i, hashed from the node's id, hash, hot state and
+// parity tags. Built on first use and kept: owners note changes through
+// merkle_note_changed, and the next root read rehashes just those paths.
 merkle_tree_t* build_network_merkle_tree();
+void merkle_network_free(void);
+void merkle_note_changed(int node_id);
+// The tree with every noted change applied; NULL before the network exists.
+merkle_tree_t* merkle_network_tree(void);
+// Canonical bytes of owned node slot, the data its leaf hashes, into buf of
+// merkle_record_capacity() bytes; returns the length.
+size_t merkle_record_capacity(void);
+size_t merkle_node_record(int slot, uint8_t *buf);
+// Current root of this rank's tree; NULL before the network exists.
+const uint8_t* merkle_network_root(void);
+// The same as hex into hex[MAX_HASH_SIZE]; 0 on success.
+int merkle_network_root_hex(char *hex);
 void export_merkle_journal(const char *filepath);
-int verify_merkle_path(int node_id, const char *expected_hash);
+// 1 when node_id's current state is included under expected_root, checked
+// with an inclusion proof from this rank's tree.
+int verify_merkle_path(int node_id, const uint8_t *expected_root);
+// Rehashes node_id's leaf and path now.
 void update_merkle_tree_incremental(int node_id);
 
+// Times a full build with each SHA-256 kernel this CPU has, single-leaf path
+// updates against full rebuilds, and proof round trips on a synthetic tree.
+void merkle_bench(int leaves, int updates);
+
 #endif // MERKLE_H
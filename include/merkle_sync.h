@@ -0,0 +1,60 @@
+/*
+ * FT-DFRP: Merkle-Diff State Sync
+ *
+ * Dual Licensed:
+ * 1. AGPL-3.0 for research/academic use
+ * 2. Commercial license: contact michael.doran.808@gmail.com
+ *
+ * Copyright (C) 2025 Michael Doran
+ */
+
+#ifndef MERKLE_SYNC_H
+#define MERKLE_SYNC_H
+
+#include "merkle.h"
+
+#define MERKLE_SYNC_BATCH 1000   // tree entries or records asked for per request; digests fit one reply
+
+// Reconciles this rank's copy of one shard with a peer's copy by walking
+// the two Merkle trees top-down: a subtree whose roots match is skipped
+// whole, and only the children of differing entries are fetched, one level
+// per round trip. At the leaves just the differing node records (the bytes
+// merkle_node_record hashes) cross the wire.
+//
+// The local copy of shard r is the live shard when r is this rank, so a
+// rank that restarted from stale state can pull its own nodes back from a
+// peer holding a mirror of them. Any other shard is kept as a mirror:
+// records plus a tree over them, created on first sync. A peer answers
+// for its own shard and for the mirrors it holds.
+
+typedef struct {
+    int peer_rank;
+    int shard_rank;
+    int leaf_count;
+    int rounds;                 // request/reply round trips
+    int entries_compared;       // tree entries fetched from the peer
+    int leaves_differing;
+    int records_applied;
+    long long bytes_sent;
+    long long bytes_received;
+    long long full_sync_bytes;  // every record of the shard, as a full-state sync ships it
+    double elapsed_ms;
+    int converged;              // roots match afterwards
+} merkle_sync_stats_t;
+
+// Registers the partition handlers; call once after partition_init.
+void merkle_sync_init(void);
+void merkle_sync_free(void);
+
+// Makes this rank's copy of shard_rank's nodes match peer_rank's. stats
+// may be NULL. Returns the number of records applied, or -1 when the peer
+// holds no copy of the shard or the shapes are incompatible.
+int merkle_sync(int peer_rank, int shard_rank, merkle_sync_stats_t *stats);
+void merkle_sync_report(const merkle_sync_stats_t *stats);
+
+// Mirrors shard_rank (default 1) from its owner, then changes fraction of
+// its nodes (default a sweep of 0.1%, 1% and 10%) and resyncs, reporting
+// bytes moved against a full-state sync. Needs at least two ranks.
+void merkle_sync_bench(double fraction, int shard_rank);
+
+#endif // MERKLE_SYNC_H
@@ -0,0 +1,58 @@
+/*
+ * FT-DFRP: Hot Node State
+ *
+ * Dual Licensed:
+ * 1. AGPL-3.0 for research/academic use
+ * 2. Commercial license: contact michael.doran.808@gmail.com
+ *
+ * Copyright (C) 2025 Michael Doran
+ */
+
+#ifndef NODE_STORE_H
+#define NODE_STORE_H
+
+#include "fractal.h"
+#include <stddef.h>
+
+// The per-node fields every scoring loop reads (density, coherence and
+// the embedding vector), kept as parallel component arrays indexed by
+// local slot: owned nodes first, then ghosts, the same order as network
+// (partition.h). TorusNode keeps only the colder parity and bookkeeping
+// state, so a scan over density or vectors streams a dense array instead
+// of striding across 2 KB node records.
+typedef struct {
+    int count;
+    int capacity;
+    int dim;
+    double *density;
+    double *coherence;
+    double *vectors;    // count rows of dim
+    int borrowed;       // arrays point into a snapshot mapping (snapshot.h), not the heap
+} node_store_t;
+
+extern node_store_t node_hot;
+
+void node_store_init(int count, int dim);
+// Grows or shrinks to count slots, keeping existing rows; new ones are zero.
+void node_store_resize(int count);
+void node_store_free(void);
+// Takes over arrays of capacity slots, count of them in use, without
+// copying; they stay the caller's. Growing past capacity copies them out.
+void node_store_attach(int count, int capacity, int dim, double *density, double *coherence,
+                       double *vectors);
+
+static inline double *node_vector(int slot) {
+    return node_hot.vectors + (size_t)slot * node_hot.dim;
+}
+
+// Slot of a record in network.
+static inline int node_slot(const TorusNode *node) {
+    return (int)(node - network);
+}
+
+// Compares scoring over the old array-of-structs node layout with the
+// component arrays: greedy next-hop scoring over the topology and an
+// exhaustive k-NN scan. Single rank; builds its own synthetic network.
+void node_layout_bench(int nodes, int queries);
+
+#endif // NODE_STORE_H
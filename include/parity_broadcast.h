@@ -0,0 +1,70 @@
+/*
+ * FT-DFRP: Fractal Toroidal Density Field Routing Protocol - Parity Broadcast
+ *
+ * Dual Licensed:
+ * 1. AGPL-3.0 for research/academic use: https://www.gnu.org/licenses/agpl-3.0.html
+ * 2. Commercial license available - contact michael.doran.808@gmail.com for terms
+ *
+ * Copyright (C) 2025 Michael Doran
+ */
+
+#ifndef PARITY_BROADCAST_H
+#define PARITY_BROADCAST_H
+
+#include "parity_types.h"
+
+#define PARITY_GOSSIP_FANOUT 3
+#define PARITY_ANTI_ENTROPY_INTERVAL_MS 100
+#define PARITY_ANTI_ENTROPY_BATCH 64      // owned nodes sending a digest per interval
+
+// Every tag add/remove bumps the node's parity_version and is logged, so
+// gossip only ships what a neighbour has not seen yet: nothing when it is
+// up to date, a DELTA when the change log still covers its version, and
+// the FULL state otherwise. DIGEST exchanges, swept over the owned nodes
+// from partition_poll every PARITY_ANTI_ENTROPY_INTERVAL_MS, repair deltas
+// that were lost or applied out of order. All traffic goes through the
+// asynchronous transport, so none of these calls block on the network.
+// Calls naming a node owned by another rank are forwarded to its owner.
+
+// Registers the transport and partition handlers and the anti-entropy
+// tick; call once after partition_init.
+void parity_broadcast_init(void);
+
+// -1 when the change could not be journaled (journal.h).
+int parity_record_change(int node_id, parity_tag_id_t tag, int removed);
+
+// Tag changes (fault_recovery.c). On a rank that does not own node_id they
+// go to the owner through parity_forward_tag_change. -1 when the owner's
+// journal has failed: the change is refused, or was made but not logged.
+int assign_parity_tag_id(int node_id, parity_tag_id_t tag);
+int remove_parity_tag_id(int node_id, parity_tag_id_t tag);
+void parity_forward_tag_change(int node_id, parity_tag_id_t tag, int removed);
+// Adds up to MAX_PARITY_TAGS tags to node_id, then announces it once; one
+// request to the owner when that is another rank.
+void assign_parity_tag_batch(int node_id, const parity_tag_id_t *tags, int count);
+
+// Announcement fields: the share of its MAX_PARITY_TAGS slots node_id
+// fills as this rank's index knows it, and the wall clock.
+double calculate_node_load(int node_id);
+time_t get_current_timestamp(void);
+
+void build_announcement(int node_id, parity_announcement_t *a);
+void update_parity_knowledge_map(int node_id, parity_announcement_t *a);
+void announce_parity_holdings(int node_id);
+// Announces every owned node that holds any tag, e.g. after a restore, when
+// the other ranks' parity indexes know none of this rank's holders.
+// Returns the number announced.
+int announce_owned_holdings(void);
+void send_announcement_to_neighbor(int neighbor_id, parity_announcement_t *a);
+
+// Sends a DELTA or FULL to up to PARITY_GOSSIP_FANOUT stale neighbours.
+void gossip_parity_announcement(int node_id);
+// Sends node_id's version digest to one random neighbour.
+void parity_anti_entropy_round(int node_id);
+// Applies every FULL/DELTA/DIGEST message the transport has delivered;
+// returns how many were applied. Call regularly from the owning thread.
+int parity_broadcast_poll(void);
+
+void parity_gossip_report(void);
+
+#endif // PARITY_BROADCAST_H
@@ -0,0 +1,113 @@
+/*
+ * FT-DFRP: Parity Distribution Engine
+ *
+ * Dual Licensed:
+ * 1. AGPL-3.0 for research/academic use
+ * 2. Commercial license: contact michael.doran.808@gmail.com
+ *
+ * Copyright (C) 2025 Michael Doran
+ */
+
+#ifndef PARITY_DISTRIBUTION_H
+#define PARITY_DISTRIBUTION_H
+
+#include "distribution_policy.h"
+#include "parity_types.h"
+#include <time.h>
+
+// One candidate's placement inputs, for scoring a single node.
+typedef struct {
+    int node_id;
+    double rtt_latency;
+    double centrality_score;
+    int current_load;
+    time_t last_access;
+} parity_node_t;
+
+// Placement inputs for the whole network as parallel arrays by node id.
+// Built once from the topology and kept for the life of the process: the
+// load of each node follows parity_index as tags come and go, and the
+// load-independent part of every score is cached for the last policy
+// used, so placing a tag is one streaming pass over base_score and load.
+typedef struct {
+    int node_count;
+    double *rtt_latency;     // mean outgoing edge weight
+    double *centrality;      // degree relative to the best-connected node
+    int *load;               // tags held, as this rank's parity_index sees it
+    double *base_score;      // score at zero load under policy
+    williams_distribution_policy_t policy;   // weights base_score was computed with
+    int scored;              // base_score is valid
+    double *scores;          // scratch, node_count
+    int *order;              // scratch, node_count
+} parity_computation_graph_t;
+
+// Score of one node, as the placement graph computes it for every node.
+double calculate_williams_placement_score(const parity_node_t *node,
+                                          const williams_distribution_policy_t *policy);
+
+// The graph over the current topology, built on first use.
+parity_computation_graph_t* placement_graph(void);
+// Drops the graph; it is rebuilt on next use. Call after reshaping the
+// topology or changing its edge weights.
+void placement_graph_invalidate(void);
+void placement_graph_free(void);
+// Called by parity_index whenever node_id gains or loses a tag.
+void placement_graph_load_changed(int node_id, int delta);
+
+// Tags a node may hold before placement passes it over.
+int placement_load_cap(const williams_distribution_policy_t *policy);
+// Every node's current placement score under policy, by node id;
+// -INFINITY at the load cap. Borrowed; valid until the next placement call.
+const double* placement_scores(const williams_distribution_policy_t *policy);
+
+// Writes the k best-scoring nodes below the policy's load cap to out,
+// best first; returns how many were found.
+int placement_select(const williams_distribution_policy_t *policy, int k, int *out);
+
+// Places tag on policy->min_replicas nodes, at most max_replicas, and
+// announces them; a tag that already has holders only gets the replicas it
+// is short of, on other nodes. Returns the nodes given a replica (malloc'd,
+// min_replicas long, padded with -1), or NULL for a tag longer than
+// MAX_TAG_LENGTH.
+int* distribute_parity_with_tree_evaluation(const char *new_parity_tag,
+                                            williams_distribution_policy_t *policy);
+
+typedef struct {
+    int tags;
+    int replicas_requested;
+    int replicas_placed;
+    int nodes_touched;          // one coalesced assign and announcement each
+    int load_min, load_max;     // tags per node across the network after the batch
+    double load_mean;
+    double load_stddev;
+    double imbalance;           // load_max / load_mean; 1.0 is perfectly even
+    double select_ms;
+    double assign_ms;
+} placement_batch_stats_t;
+
+// Places count tags together in one pass: scores every node once, then
+// hands out replicas from a heap, lowering each chosen node's score by
+// the load it just took on, so later tags spread over the next-best nodes.
+// replicas (0: policy->min_replicas) is clamped to max_replicas, tags that
+// already have holders are only topped up to replicas, so running the same
+// batch again places nothing, and no node goes past the policy's load cap.
+// Each affected node then receives all of its new tags in one request and
+// announces once. stats->replicas_requested counts the missing replicas.
+// placements receives count rows of replicas node ids, padded with -1;
+// stats may be NULL. Returns the number of replicas placed, or -1 when a
+// tag is longer than MAX_TAG_LENGTH.
+int distribute_parity_batch(const char **tags, int count, int replicas,
+                            const williams_distribution_policy_t *policy, int *placements,
+                            placement_batch_stats_t *stats);
+void placement_batch_report(const placement_batch_stats_t *stats);
+// Runs the same batch of count fresh tags twice and checks the second run
+// places nothing and no tag ends up with more than replicas holders (0:
+// min_replicas), then removes the tags again. 0 when it holds.
+int placement_batch_check(int count, int replicas);
+
+// Times selection alone (nothing is assigned): a rebuilt graph scored
+// serially with repeated argmax, the persistent graph with parallel
+// scoring and quickselect, and batch selection.
+void placement_bench(int tags);
+
+#endif // PARITY_DISTRIBUTION_H
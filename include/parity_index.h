@@ -0,0 +1,48 @@
+/*
+ * FT-DFRP: Parity Holder Index
+ *
+ * Dual Licensed:
+ * 1. AGPL-3.0 for research/academic use
+ * 2. Commercial license: contact michael.doran.808@gmail.com
+ *
+ * Copyright (C) 2025 Michael Doran
+ */
+
+#ifndef PARITY_INDEX_H
+#define PARITY_INDEX_H
+
+#include "tag_intern.h"
+
+// Inverted index from parity tag to the set of nodes holding it. Kept up to
+// date by assign_parity_tag and by incoming parity announcements, so
+// holder lookups never scan the network. Keyed by interned tag id, so a
+// lookup is a bounds check and an array load.
+
+// Borrowed view into the index. Valid until the next mutation of that tag;
+// callers that hold on to holders across assign/announce must copy it.
+typedef struct {
+    const int *holders;
+    int count;
+} parity_holder_view_t;
+
+void parity_index_add(parity_tag_id_t tag, int node_id);
+void parity_index_remove(parity_tag_id_t tag, int node_id);
+
+// Replaces everything the index believes node_id holds with tags[0..count).
+void parity_index_set_node_tags(int node_id, const parity_tag_id_t *tags, int count);
+
+parity_holder_view_t parity_index_lookup(parity_tag_id_t tag);
+void parity_index_lookup_batch(const parity_tag_id_t *tags, int count, parity_holder_view_t *views);
+// Checked against node_id's own tags, so it costs the same however many
+// holders tag has; so does removal.
+int parity_index_holds(parity_tag_id_t tag, int node_id);
+// Changes whenever tag's holder set does; lets callers cache per-tag results.
+uint32_t parity_index_version(parity_tag_id_t tag);
+// Number of tags node_id is indexed under; its load as far as this rank knows.
+int parity_index_node_count(int node_id);
+// The tags node_id is indexed under, count in *count. Borrowed like a
+// holder view: valid until node_id's tags next change.
+const parity_tag_id_t* parity_index_node_tags(int node_id, int *count);
+void parity_index_clear(void);
+
+#endif // PARITY_INDEX_H
@@ -4,37 +4,48 @@
 #include <stdint.h>
 #include <time.h>
 #include "fractal.h"
+#include "tag_intern.h"
+#ifdef ENABLE_FHE
+#include "fhe_stub.h"
+#endif
+
+#define PARITY_CHANGE_LOG_SIZE 64   // deltas further back than this fall back to full state
 
 typedef struct {
     int node_id;
-    char parity_tags[MAX_PARITY_TAGS][64];
+    uint32_t version;       // announcer's parity_version this state reflects
+    parity_tag_id_t parity_tags[MAX_PARITY_TAGS];
     int parity_count;
     double load_factor;
     time_t timestamp;
     char signature[MAX_HASH_SIZE];
 } parity_announcement_t;
 
+// One entry of a node's change log; the change that produced version.
+typedef struct {
+    uint32_t version;
+    parity_tag_id_t tag;
+    int removed;
+} parity_change_t;
+
 typedef struct {
-    char tag[64];
+    parity_tag_id_t tag;
     int holder_nodes[MAX_PARITY_TAGS];
     int replica_count;
     double distribution_score;
     time_t last_updated;
 } parity_distribution_entry_t;
 
-typedef struct TorusNode {
-    int id;
-    double density;
-    double coherence;
-    int neighbors[MAX_NEIGHBORS];
-    int neighbor_count;
-    char *parity_tags[MAX_PARITY_TAGS];
+struct TorusNode {
+    int id;                         // density, coherence and vector live in node_hot (node_store.h)
+    parity_tag_id_t parity_tags[MAX_PARITY_TAGS];
     int parity_count;
+    uint32_t parity_version;        // bumped on every tag add/remove
+    parity_change_t *change_log;    // ring of PARITY_CHANGE_LOG_SIZE, indexed by version
     char hash[MAX_HASH_SIZE];
-    double vector[VECTOR_DIM];
 
     // Parity broadcast
-    parity_announcement_t *known_parity_map;
+    parity_announcement_t *known_parity_map;   // MAX_PARITY_TAGS; restored nodes get it on first use
     int map_size;
     time_t last_announcement;
     int replication_factor;
@@ -42,6 +53,6 @@ typedef struct TorusNode {
 #ifdef ENABLE_FHE
     fhe_ciphertext_t encrypted_density;
 #endif
-} TorusNode;
+};
 
 #endif // PARITY_TYPES_H
@@ -0,0 +1,88 @@
+/*
+ * FT-DFRP: Fractal Toroidal Density Field Routing Protocol - Announcement Wire Format
+ *
+ * Dual Licensed:
+ * 1. AGPL-3.0 for research/academic use: https://www.gnu.org/licenses/agpl-3.0.html
+ * 2. Commercial license available - contact michael.doran.808@gmail.com for terms
+ *
+ * Copyright (C) 2025 Michael Doran
+ */
+
+#ifndef PARITY_WIRE_H
+#define PARITY_WIRE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "parity_types.h"
+
+// Version 2 layout, all integers unsigned LEB128 varints unless noted.
+// Every message starts with
+//
+//   u8      version
+//   u8      message type
+//   varint  node_id (announcer, or digest sender)
+//
+// FULL:    varint version, u64 load_factor (IEEE-754 bits, little endian),
+//          varint zigzag(timestamp - PARITY_WIRE_EPOCH),
+//          varint parity_count, then per tag: varint length + bytes,
+//          varint signature length + bytes
+// DELTA:   varint version, varint base_version, load_factor, timestamp as
+//          in FULL, added tags and removed tags each as a counted list,
+//          signature
+// DIGEST:  varint flags, varint count, then per entry: varint node_id,
+//          varint version
+//
+// Tags travel as strings because tag ids are local to each process.
+#define PARITY_WIRE_VERSION 2
+#define PARITY_WIRE_EPOCH 1735689600   // 2025-01-01T00:00:00Z
+#define PARITY_WIRE_MAX_BYTES (48 + 2 * MAX_PARITY_TAGS * (2 + MAX_TAG_LENGTH) + MAX_HASH_SIZE)
+#define PARITY_DIGEST_MAX_ENTRIES (MAX_PARITY_TAGS + 1)
+#define PARITY_DIGEST_REPLY 0x1        // answer to a digest; never answered itself
+
+typedef enum {
+    PARITY_MSG_FULL = 1,
+    PARITY_MSG_DELTA = 2,
+    PARITY_MSG_DIGEST = 3
+} parity_msg_type_t;
+
+// Tags added/removed between base_version and version of node_id.
+typedef struct {
+    int node_id;
+    uint32_t version;
+    uint32_t base_version;
+    parity_tag_id_t added[MAX_PARITY_TAGS];
+    int added_count;
+    parity_tag_id_t removed[MAX_PARITY_TAGS];
+    int removed_count;
+    double load_factor;
+    time_t timestamp;
+    char signature[MAX_HASH_SIZE];
+} parity_delta_t;
+
+// Anti-entropy summary: which version of each announcer the sender holds.
+typedef struct {
+    int node_id;
+    uint32_t version;
+} parity_digest_entry_t;
+
+// Encoders return bytes written, or -1 if buf is too small.
+int parity_wire_encode(const parity_announcement_t *a, uint8_t *buf, size_t capacity);
+int parity_wire_encode_delta(const parity_delta_t *d, uint8_t *buf, size_t capacity);
+int parity_wire_encode_digest(int sender, int flags, const parity_digest_entry_t *entries, int count,
+                              uint8_t *buf, size_t capacity);
+
+// Message type of an encoded buffer, or -1 if it is empty or from another version.
+int parity_wire_message_type(const uint8_t *buf, size_t length);
+
+// Decoders write straight into out, interning tags from slices of buf
+// without intermediate copies. They return bytes consumed, or -1 if buf is
+// truncated, malformed, of another type or from another version.
+int parity_wire_decode(const uint8_t *buf, size_t length, parity_announcement_t *out);
+int parity_wire_decode_delta(const uint8_t *buf, size_t length, parity_delta_t *out);
+int parity_wire_decode_digest(const uint8_t *buf, size_t length, int *sender, int *flags,
+                              parity_digest_entry_t *entries, int capacity, int *count);
+
+// Prints bytes/announcement and encode/decode ns/op for several tag counts.
+void parity_wire_bench(int iterations);
+
+#endif // PARITY_WIRE_H
@@ -0,0 +1,178 @@
+/*
+ * FT-DFRP: Sharded Network Ownership
+ *
+ * Dual Licensed:
+ * 1. AGPL-3.0 for research/academic use
+ * 2. Commercial license: contact michael.doran.808@gmail.com
+ *
+ * Copyright (C) 2025 Michael Doran
+ */
+
+#ifndef PARTITION_H
+#define PARTITION_H
+
+#include <stdint.h>
+#include "fractal.h"
+#include "ann.h"
+#include "topology.h"
+#include "transport.h"
+
+// Node ids are split into contiguous blocks, one per transport rank; rank r
+// owns ids [first, first + owned). The local network array holds the owned
+// nodes at [0, owned), followed by read-only ghost copies of every
+// neighbour of an owned node that lives on another rank. Owners push
+// density, coherence and vector changes of boundary nodes to the ranks
+// holding ghosts of them (the halo exchange); everything else that needs a
+// remote node is forwarded to its owner over TRANSPORT_CHANNEL_PARTITION.
+//
+// total_nodes stays the global node count; partition.owned is the size of
+// the local shard.
+
+typedef enum {
+    PARTITION_OP_REPLY,
+    PARTITION_OP_SHUTDOWN,
+    PARTITION_OP_HALO_SUBSCRIBE,
+    PARTITION_OP_HALO_UPDATE,
+    PARTITION_OP_INJECT_VECTOR,
+    PARTITION_OP_ASSIGN_TAG,
+    PARTITION_OP_REMOVE_TAG,
+    PARTITION_OP_ANNOUNCE,
+    PARTITION_OP_GOSSIP,
+    PARTITION_OP_ANTI_ENTROPY,
+    PARTITION_OP_KNN,
+    PARTITION_OP_FETCH_NODE,
+    PARTITION_OP_NEXT_HOP,
+    PARTITION_OP_PARITY_ROUTE,
+    PARTITION_OP_KNN_COLLECTIVE,
+    PARTITION_OP_ASSIGN_TAGS,
+    PARTITION_OP_MERKLE_NODES,
+    PARTITION_OP_MERKLE_RECORDS,
+    PARTITION_OP_SNAPSHOT,
+    PARTITION_OP_PING,
+    PARTITION_OP_RTT_ROW,
+    PARTITION_OPS
+} partition_op_t;
+
+// Request handler run on the owner. Writes at most capacity reply bytes
+// and returns how many, or -1 to fail the call.
+typedef int (*partition_handler_fn)(int source_rank, const uint8_t *request, int length,
+                                    uint8_t *reply, int capacity);
+
+typedef struct {
+    int rank;
+    int size;
+    int first;              // first owned global id
+    int owned;              // network[0, owned) are ours
+    int ghost_count;        // network[owned, owned + ghost_count) are ghosts
+    int *ghost_ids;         // global id of each ghost
+    int *ghost_slots;       // open addressing: global id -> ghost index, -1 empty
+    int ghost_slot_mask;
+    int ghosts_pending;     // ghosts not yet filled by their owner
+
+    int **halo_out;         // per rank: local indices of owned nodes it holds ghosts of
+    int *halo_out_count;
+    int *halo_out_capacity;
+    uint8_t *dirty;         // per owned node: changed since the last halo exchange
+    uint64_t state_epoch;   // bumped when any local node or ghost changes state
+    uint64_t *node_epoch;   // per local slot (owned, then ghosts): state_epoch after its last change
+    int shutdown_requested;
+} partition_t;
+
+extern partition_t partition;
+
+// Splits total nodes over the transport ranks. Call before allocating the
+// local network array.
+void partition_init(int total);
+// Creates ghost entries for the remote neighbours of owned nodes in the
+// global topology (growing network), subscribes to their owners and waits
+// until all are filled. Every rank must call it, after building topology.
+void partition_build_ghosts(void);
+void partition_free(void);
+
+int partition_owner(int node_id);
+
+static inline int partition_owns(int node_id) {
+    return node_id >= partition.first && node_id < partition.first + partition.owned;
+}
+
+// Index of node_id in the local network array if owned, else -1.
+static inline int partition_local_index(int node_id) {
+    return partition_owns(node_id) ? node_id - partition.first : -1;
+}
+
+int partition_ghost_index(int node_id);
+
+// Slot of node_id's local copy in network and node_hot: the owned node,
+// its ghost, or -1 when this rank holds neither.
+static inline int partition_slot(int node_id) {
+    if (partition_owns(node_id)) return node_id - partition.first;
+    int g = partition_ghost_index(node_id);
+    return g < 0 ? -1 : partition.owned + g;
+}
+
+// state_epoch as of node_id's last change here, 0 when this rank holds no
+// copy of it.
+static inline uint64_t partition_node_epoch(int node_id) {
+    int slot = partition_slot(node_id);
+    return slot < 0 ? 0 : partition.node_epoch[slot];
+}
+
+static inline TorusNode* node_ref(int node_id) {
+    int slot = partition_slot(node_id);
+    return slot < 0 ? NULL : &network[slot];
+}
+
+// Queues an owned node for the next halo exchange.
+void partition_mark_dirty(int node_id);
+// Sends every dirty boundary node to the ranks holding ghosts of it.
+void partition_halo_exchange(void);
+
+void partition_register_handler(partition_op_t op, partition_handler_fn handler);
+
+// Periodic work run from partition_poll, and so from partition_serve and
+// every wait on a reply, at most once per interval_ms. A tick that polls
+// does not run ticks again from inside itself.
+#define PARTITION_MAX_TICKS 4
+typedef void (*partition_tick_fn)(void);
+void partition_register_tick(partition_tick_fn tick, double interval_ms);
+// Largest request or reply payload; partition_call and partition_post
+// fail at once on anything longer.
+#define PARTITION_MAX_PAYLOAD (TRANSPORT_BATCH_BYTES / 2)
+
+// Runs op on rank and waits for its reply, serving incoming requests while
+// it waits. Returns the reply length, or -1, immediately when the request
+// cannot be sent.
+int partition_call(int rank, partition_op_t op, const void *request, int length,
+                   void *reply, int capacity);
+// Fire-and-forget variant; requests to one rank run in the order posted.
+// 0 once queued, -1 when the request cannot be sent.
+int partition_post(int rank, partition_op_t op, const void *request, int length);
+
+// Delivers pending records, pushes dirty halo nodes and runs the ticks that
+// are due; returns the number of records delivered.
+int partition_poll(void);
+// Serves requests until rank 0 calls partition_shutdown_peers.
+void partition_serve(void);
+void partition_shutdown_peers(void);
+
+// Forwarding wrappers: run locally when this rank owns node_id, otherwise
+// on the owner. partition_knn searches the owner's shard only; see
+// distributed_knn.h for the whole network.
+int partition_knn(int node_id, int k, similarity_result_t *out);
+// Copies node_id's vector (vector_dim doubles), density and coherence as
+// its owner currently has them.
+int partition_fetch_node(int node_id, double *vector, double *density, double *coherence);
+// Applies on this rank or posts to the owner; -1 when this rank owns the
+// node and refused the change (inject_vector).
+int partition_inject_vector(int node_id, const double *vector);
+
+#define PARTITION_RTT_PROBES 16   // round trips timed per peer; the median counts
+
+// Collective, once every rank polls: times round trips to each peer,
+// shares the results, and sets the weight of every edge of graph to the
+// mean of the two directions' median RTT in ms between the ranks owning
+// its ends, 0 within a rank. Every rank derives the same weights. Leaves
+// graph unweighted on a single rank.
+void partition_measure_link_weights(topology_t *graph, int probes);
+
+#endif // PARTITION_H
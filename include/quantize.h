@@ -0,0 +1,79 @@
+/*
+ * FT-DFRP: Fractal Toroidal Density Field Routing Protocol - Vector Quantization
+ *
+ * Dual Licensed:
+ * 1. AGPL-3.0 for research/academic use: https://www.gnu.org/licenses/agpl-3.0.html
+ * 2. Commercial license available - contact michael.doran.808@gmail.com for terms
+ *
+ * Copyright (C) 2025 Michael Doran
+ */
+
+#ifndef QUANTIZE_H
+#define QUANTIZE_H
+
+#include <stdint.h>
+#include "ann.h"
+#include "hnsw.h"
+
+#define PQ_CENTROIDS 256
+#define PQ_TRAIN_SAMPLES 65536
+#define PQ_TRAIN_ITERATIONS 8
+#define QUANT_DEFAULT_RERANK 4   // exact re-rank pool = k * rerank
+
+typedef enum {
+    QUANT_FP32,     // 4 bytes per dimension
+    QUANT_INT8,     // 1 byte per dimension, per-dimension affine scale
+    QUANT_PQ        // 1 byte per subspace, scored via ADC lookup tables
+} quant_mode_t;
+
+// Compressed copy of the node vectors used for candidate scoring only;
+// the top candidates are re-ranked against the exact TorusNode vectors,
+// which stay resident, so the copy adds memory and saves bandwidth: the
+// HNSW walk (or, without an index, the scan) reads codes, not doubles.
+typedef struct quantized_store {
+    quant_mode_t mode;
+    int dim;
+    int capacity;
+    float *inv_norms;       // exact 1 / ||v||, so cosine stays unbiased by code error
+
+    float *fp32;            // capacity * dim
+
+    int8_t *int8;           // capacity * dim
+    float *int8_scale;      // dim
+    float *int8_offset;     // dim
+
+    int pq_m;               // subspaces; dim must be divisible by pq_m
+    int pq_sub_dim;
+    float *pq_codebooks;    // pq_m * PQ_CENTROIDS * pq_sub_dim
+    uint8_t *pq_codes;      // capacity * pq_m
+} quantized_store_t;
+
+// Trains scales / codebooks on the current network vectors and encodes them.
+quantized_store_t* quantized_store_build(TorusNode *network, int total_nodes, int dim,
+                                         quant_mode_t mode, int pq_m);
+void quantized_store_free(quantized_store_t *store);
+void quantized_store_set(quantized_store_t *store, int id, const double *vector);
+size_t quantized_store_bytes_per_vector(const quantized_store_t *store);
+const char* quant_mode_name(quant_mode_t mode);
+
+// Approximate scoring of every node, exact re-rank of the best k * rerank.
+// Only for shards without an index; see quantized_search_index.
+int quantized_find_k_nearest(quantized_store_t *store, TorusNode *network, int total_nodes,
+                             int query_node, int k, int rerank, similarity_result_t *out);
+int quantized_find_k_nearest_vector(quantized_store_t *store, TorusNode *network, int total_nodes,
+                                    const double *query, double coherence, int exclude, int k,
+                                    int rerank, similarity_result_t *out);
+// Walks index on code similarities with ef = max(ef_search, k * rerank),
+// then re-ranks the best k * rerank exactly; the graph is never bypassed.
+int quantized_search_index(quantized_store_t *store, const hnsw_index_t *index,
+                           hnsw_scratch_t *scratch, const double *query, double coherence,
+                           int exclude, int k, int rerank, similarity_result_t *out);
+
+// Bytes read per vector and the memory held (the codes come on top of
+// the double vectors, which stay for the re-rank), and recall@k lost
+// against the exact scan, with and without re-ranking, for the scan and,
+// when ann.h has an index attached, for the code-scored graph walk.
+void quantized_report(quantized_store_t *store, TorusNode *network, int total_nodes,
+                      int k, int rerank, int samples);
+
+#endif // QUANTIZE_H
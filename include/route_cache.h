@@ -0,0 +1,44 @@
+/*
+ * FT-DFRP: Route Path Cache
+ *
+ * Dual Licensed:
+ * 1. AGPL-3.0 for research/academic use
+ * 2. Commercial license: contact michael.doran.808@gmail.com
+ *
+ * Copyright (C) 2025 Michael Doran
+ */
+
+#ifndef ROUTE_CACHE_H
+#define ROUTE_CACHE_H
+
+#include <stdint.h>
+
+#define ROUTE_CACHE_CAPACITY 4096
+#define ROUTE_CACHE_MAX_PATH 64      // longer paths are not cached
+
+// LRU cache of complete paths, keyed by source node, target (a hash of
+// the quantized target vector, or a parity tag and its holder-set version)
+// and a hash of the routing config. Each entry remembers the partition
+// state epoch it was computed at and is dropped on lookup once a node it
+// depends on - a neighbour of any node the path leaves - has changed since
+// (partition_node_epoch), so unrelated changes keep it; a parity route also
+// misses as soon as its tag's holder set changes, because the version is
+// part of the key. Changes on other ranks are seen once they reach this
+// rank's ghosts.
+
+typedef struct {
+    int source;
+    uint64_t target;
+    uint64_t config;
+} route_key_t;
+
+// Copies the cached path (source first) into path and returns its length,
+// or -1 on a miss or when it does not fit max_length.
+int route_cache_lookup(const route_key_t *key, int *path, int max_length);
+// Same, but left out of the hit rate; for mid-route suffix checks.
+int route_cache_probe(const route_key_t *key, int *path, int max_length);
+void route_cache_store(const route_key_t *key, const int *path, int length);
+void route_cache_clear(void);
+void route_cache_report(void);
+
+#endif // ROUTE_CACHE_H
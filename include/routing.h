@@ -0,0 +1,57 @@
+/*
+ * FT-DFRP: Fractal Toroidal Density Field Routing Protocol - Hybrid Routing
+ *
+ * Dual Licensed:
+ * 1. AGPL-3.0 for research/academic use: https://www.gnu.org/licenses/agpl-3.0.html
+ * 2. Commercial license available - contact michael.doran.808@gmail.com for terms
+ *
+ * Copyright (C) 2025 Michael Doran
+ */
+
+#ifndef ROUTING_H
+#define ROUTING_H
+
+#include "fractal.h"
+
+typedef struct {
+    double density_weight;
+    double similarity_weight;
+    double coherence_weight;
+    double parity_weight;
+    int use_fhe;
+} routing_config_t;
+
+extern routing_config_t default_routing_config;
+
+// Next hop from current_id. A hop is decided by the rank owning current_id,
+// which sees every neighbour through its ghost copies; other ranks forward
+// the request there.
+int compute_hybrid_next_hop(int current_id, const double *target_vector, routing_config_t *config);
+int compute_parity_aware_route(int current_id, const char *parity_tag, routing_config_t *config);
+// Weighted density, coherence and, when target_vector is not NULL,
+// similarity to it, as compute_hybrid_next_hop scores a neighbour.
+double compute_node_hybrid_score(int node_id, const double *target_vector, routing_config_t *config);
+
+// Full greedy paths, served from the route cache (route_cache.h) when the
+// same source, target and config were routed and no node that path
+// depends on has changed since.
+// path receives the visited nodes, source first; returns their count, or
+// -1 on a dead end, a loop, or a path longer than max_length nodes.
+int compute_route(int source, int target_id, const double *target_vector, routing_config_t *config,
+                  int *path, int max_length);
+// Ends at the first node holding parity_tag.
+int compute_parity_route(int source, const char *parity_tag, routing_config_t *config,
+                         int *path, int max_length);
+
+// Routes samples random pairs (0: 32), and from a random source to each
+// tag with holders (up to samples), from an empty route cache and then
+// again from the cache. Checks every path found walks topology edges to
+// its goal on the hops the next-hop functions pick, and that the cached
+// path is the same. Greedy dead ends are counted, not failures. 0 when
+// it holds.
+int route_check(int samples);
+
+// Registers the forwarding handlers; call once after partition_init.
+void routing_init(void);
+
+#endif // ROUTING_H
@@ -0,0 +1,50 @@
+/*
+ * FT-DFRP: Batched SHA-256
+ *
+ * Dual Licensed:
+ * 1. AGPL-3.0 for research/academic use
+ * 2. Commercial license: contact michael.doran.808@gmail.com
+ *
+ * Copyright (C) 2025 Michael Doran
+ */
+
+#ifndef SHA256_MB_H
+#define SHA256_MB_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SHA256_DIGEST_BYTES 32
+#define SHA256_MB_MAX_BYTES 4096   // longer messages take the one-at-a-time path
+
+// Hashes count independent messages. The multi-buffer kernel runs eight
+// messages through the compression function at once, one per 32-bit lane
+// of an AVX2 register; with the SHA extensions a single stream is faster,
+// so those CPUs hash one message at a time in hardware instead.
+typedef void (*sha256_batch_fn)(const uint8_t *const *messages, const size_t *lengths, int count,
+                                uint8_t (*digests)[SHA256_DIGEST_BYTES]);
+
+// One message.
+void sha256_digest(const void *data, size_t length, uint8_t *digest);
+// One message preceded by the byte prefix, without copying it.
+void sha256_digest_prefixed(uint8_t prefix, const void *data, size_t length, uint8_t *digest);
+
+typedef struct {
+    const char *name;
+    sha256_batch_fn hash;
+} sha256_kernels_t;
+
+// Best kernel for this CPU (SHA extensions, AVX2 multi-buffer or scalar),
+// picked once, by whichever thread hashes first.
+const sha256_kernels_t* sha256_kernels(void);
+// Every kernel this CPU can run, best first; returns how many.
+int sha256_available_kernels(const sha256_kernels_t **kernels, int capacity);
+// Overrides the pick (for benchmarks); NULL goes back to the best one.
+void sha256_select_kernels(const sha256_kernels_t *kernels);
+
+static inline void sha256_batch(const uint8_t *const *messages, const size_t *lengths, int count,
+                                uint8_t (*digests)[SHA256_DIGEST_BYTES]) {
+    sha256_kernels()->hash(messages, lengths, count, digests);
+}
+
+#endif // SHA256_MB_H
@@ -0,0 +1,134 @@
+/*
+ * FT-DFRP: Network Snapshots
+ *
+ * Dual Licensed:
+ * 1. AGPL-3.0 for research/academic use
+ * 2. Commercial license: contact michael.doran.808@gmail.com
+ *
+ * Copyright (C) 2025 Michael Doran
+ */
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "fractal.h"
+#include "journal.h"
+#include "merkle.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// One file per rank, <prefix>.<rank>, holding that rank's shard in the
+// layout the process runs on: a fixed header, then page-aligned sections
+// that are the raw arrays of node_hot, the ANN vector store and the
+// topology, plus the cold node records and the tag names. Loading maps
+// the file privately and points the stores at the sections, so nothing
+// is parsed or copied up front; pages fault in as they are touched,
+// processes mapping the same file share them through the page cache, and
+// a write copies just the page it lands on.
+//
+// The bytes are host-native (int widths, doubles, byte order), so a
+// snapshot moves between machines of the same kind only. The HNSW graph
+// is not stored: a restored shard answers k-NN by scanning the vector
+// store until an index is attached again.
+
+#define SNAPSHOT_MAGIC "FTDFSNAP"
+#define SNAPSHOT_VERSION 3                // 2: journal_lsn, 3: domain-separated Merkle root
+#define SNAPSHOT_BYTE_ORDER 0x01020304u   // reads back differently on the other endianness
+#define SNAPSHOT_ALIGNMENT 4096           // sections start on page boundaries
+
+typedef enum {
+    SNAPSHOT_NODES,            // snapshot_node_t per owned node
+    SNAPSHOT_DENSITY,          // hot_slots doubles
+    SNAPSHOT_COHERENCE,        // hot_slots doubles
+    SNAPSHOT_VECTORS,          // hot_slots rows of vector_dim
+    SNAPSHOT_STORE_BLOCKS,     // vector store blocks, store_capacity * vector_dim
+    SNAPSHOT_STORE_NORMS,      // store_capacity doubles
+    SNAPSHOT_TOPOLOGY_OFFSETS, // total_nodes + 1 ints
+    SNAPSHOT_TOPOLOGY_TARGETS, // edges ints
+    SNAPSHOT_TOPOLOGY_WEIGHTS, // edges floats; empty when every edge costs 1
+    SNAPSHOT_TAG_NAMES,        // tag_count NUL-terminated names, in tag id order
+    SNAPSHOT_SECTIONS
+} snapshot_section_id_t;
+
+typedef struct {
+    uint64_t offset;
+    uint64_t bytes;
+} snapshot_section_t;
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t header_bytes;
+    int32_t rank, ranks;
+    int32_t total_nodes;
+    int32_t vector_dim;
+    int32_t first, owned;       // the shard (partition.h)
+    int32_t hot_slots;          // owned plus room for the ghosts the shard had
+    int32_t store_capacity;
+    int32_t topology_kind;
+    int32_t topology_width, topology_height;
+    int32_t tag_count;
+    uint64_t edges;
+    int64_t created;            // seconds since the epoch
+    uint64_t journal_lsn;       // last journal record included; replay starts after it
+    uint8_t merkle_root[MERKLE_DIGEST_SIZE];
+    snapshot_section_t sections[SNAPSHOT_SECTIONS];
+} snapshot_header_t;
+
+// The cold part of a TorusNode; tags are ids into the snapshot's own tag
+// table, remapped on load.
+typedef struct {
+    int32_t id;
+    int32_t parity_count;
+    uint32_t parity_version;
+    int32_t replication_factor;
+    parity_tag_id_t parity_tags[MAX_PARITY_TAGS];
+    char hash[MAX_HASH_SIZE];
+} snapshot_node_t;
+
+typedef struct {
+    const snapshot_header_t *header;
+    uint8_t *base;
+    size_t bytes;
+} snapshot_t;
+
+// Registers the partition handler; call once after partition_init.
+void snapshot_init(void);
+
+// <prefix>.<rank> into path[cap].
+void snapshot_path(const char *prefix, int rank, char *path, size_t cap);
+
+// Writes this rank's shard to path through a temporary file, renamed into
+// place once synced; the directory is synced after the rename. Returns the
+// bytes written, or -1.
+long long snapshot_write(const char *path);
+// Asks every rank to write its shard under prefix; rank 0 drives it. With
+// a journal config each rank then starts journaling next to its snapshot
+// (journal_checkpoint); NULL leaves journaling as it was. Returns the
+// number of ranks that failed.
+int snapshot_write_all(const char *prefix, const journal_config_t *journal);
+
+// Maps and validates a snapshot; NULL with a message when it is not one
+// this build can load.
+snapshot_t* snapshot_open(const char *path);
+void snapshot_close(snapshot_t *snap);
+
+static inline void* snapshot_section(const snapshot_t *snap, snapshot_section_id_t id) {
+    return snap->base + snap->header->sections[id].offset;
+}
+
+// Makes the mapped shard this rank's network, topology included. The
+// network must already be sized and split from the header (total_nodes,
+// vector_dim, partition_init) the way it was when written, and the mapping
+// has to outlive it. Ghosts are not restored; partition_build_ghosts
+// fetches them as usual into the slots kept for them.
+int snapshot_restore(snapshot_t *snap);
+// 1 when the live Merkle root matches the stored one; hashes every record.
+int snapshot_verify(const snapshot_t *snap);
+
+// Writes this rank's shard to path, then times mapping it (alone and with
+// every page touched) against read() of the whole file, cold and warm.
+void snapshot_bench(const char *path);
+
+#endif // SNAPSHOT_H
@@ -0,0 +1,37 @@
+/*
+ * FT-DFRP: Parity Tag Interning
+ *
+ * Dual Licensed:
+ * 1. AGPL-3.0 for research/academic use
+ * 2. Commercial license: contact michael.doran.808@gmail.com
+ *
+ * Copyright (C) 2025 Michael Doran
+ */
+
+#ifndef TAG_INTERN_H
+#define TAG_INTERN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Process-wide parity tag table. Every tag string is stored once and
+// referred to everywhere else by a dense 32-bit id, so tag comparisons are
+// integer compares and per-tag state can live in arrays indexed by id.
+// Ids are local to the process: anything that crosses a rank boundary must
+// carry the tag string (see the announcement wire format).
+
+typedef uint32_t parity_tag_id_t;
+
+#define PARITY_TAG_INVALID UINT32_MAX
+#define MAX_TAG_LENGTH 63
+
+// Both return PARITY_TAG_INVALID for tags longer than MAX_TAG_LENGTH, or
+// once the table is full.
+parity_tag_id_t tag_intern(const char *tag);
+parity_tag_id_t tag_intern_n(const char *tag, size_t length);   // tag need not be NUL-terminated
+parity_tag_id_t tag_lookup(const char *tag);                     // PARITY_TAG_INVALID if unknown
+const char* tag_name(parity_tag_id_t id);                        // stable for the process lifetime
+size_t tag_name_length(parity_tag_id_t id);
+int tag_count(void);
+
+#endif // TAG_INTERN_H
@@ -0,0 +1,34 @@
+/*
+ * FT-DFRP: Worker Thread Pool
+ *
+ * Dual Licensed:
+ * 1. AGPL-3.0 for research/academic use
+ * 2. Commercial license: contact michael.doran.808@gmail.com
+ *
+ * Copyright (C) 2025 Michael Doran
+ */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+// Runs fn over [begin, end) sub-ranges of a parallel_for. worker is in
+// [0, thread_pool_size) and is stable for the call, so tasks can index
+// per-worker scratch with it.
+typedef void (*thread_pool_task_fn)(void *ctx, int begin, int end, int worker);
+
+typedef struct thread_pool thread_pool_t;
+
+thread_pool_t* thread_pool_create(int threads);   // threads <= 0: one per online CPU
+void thread_pool_free(thread_pool_t *pool);
+int thread_pool_size(const thread_pool_t *pool);
+
+// Splits [0, n) into chunks of grain items and blocks until all have run.
+// The calling thread takes part as worker 0. Calls from different threads
+// are serialized; tasks must not call back into the same pool.
+void thread_pool_parallel_for(thread_pool_t *pool, int n, int grain,
+                              thread_pool_task_fn fn, void *ctx);
+
+// Process-wide pool, created on first use.
+thread_pool_t* thread_pool_default(void);
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,72 @@
+/*
+ * FT-DFRP: Network Topology
+ *
+ * Dual Licensed:
+ * 1. AGPL-3.0 for research/academic use
+ * 2. Commercial license: contact michael.doran.808@gmail.com
+ *
+ * Copyright (C) 2025 Michael Doran
+ */
+
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+
+#define TOPOLOGY_MAX_DEGREE 64   // builders never exceed this; callers may size stack arrays by it
+#define TOPOLOGY_RING_FANOUT 16  // "ring" by name
+
+// Neighbour links of the whole network in compressed sparse row form: the
+// neighbours of node v are targets[offsets[v] .. offsets[v + 1]). Walking
+// the graph touches only these two arrays, never the node records, and
+// degree varies per node.
+//
+// Every builder is a pure function of its arguments, so each rank builds
+// the same global graph locally and can list the neighbours of any node,
+// owned or not, without messages.
+
+typedef enum {
+    TOPOLOGY_RING,      // directed ring, id -> id+1 .. id+fanout
+    TOPOLOGY_TORUS,     // 2-D torus, four wrap-around neighbours
+    TOPOLOGY_FRACTAL,   // torus plus wrap-around links 2, 4, 8, ... cells away on each axis
+} topology_kind_t;
+
+typedef struct {
+    topology_kind_t kind;
+    int nodes;
+    int width, height;  // torus grid; the last row may be short
+    int *offsets;       // nodes + 1
+    int *targets;       // offsets[nodes]
+    float *weights;     // per edge, e.g. RTT in ms; NULL when every edge costs 1
+    int borrowed;       // offsets and targets point into a snapshot mapping (snapshot.h)
+} topology_t;
+
+// The graph routing, placement, recovery and partitioning share.
+extern topology_t topology;
+
+int topology_build_ring(topology_t *t, int nodes, int fanout);
+int topology_build_torus(topology_t *t, int nodes);
+// levels long-range scales per axis; 0 picks as many as fit the grid.
+int topology_build_fractal(topology_t *t, int nodes, int levels);
+// Builds by name ("ring", "torus" or "fractal"); returns -1 on an unknown name.
+int topology_build_named(topology_t *t, const char *name, int nodes);
+void topology_free(topology_t *t);
+
+static inline int topology_degree(const topology_t *t, int node_id) {
+    return t->offsets[node_id + 1] - t->offsets[node_id];
+}
+
+static inline const int *topology_neighbors(const topology_t *t, int node_id) {
+    return t->targets + t->offsets[node_id];
+}
+
+static inline double topology_edge_weight(const topology_t *t, int edge) {
+    return t->weights ? t->weights[edge] : 1.0;
+}
+
+// Sets the weight of edge from -> to; returns -1 if there is no such edge.
+int topology_set_weight(topology_t *t, int from, int to, float weight);
+// Mean weight of node_id's outgoing edges.
+double topology_mean_weight(const topology_t *t, int node_id);
+
+void topology_report(const topology_t *t);
+
+#endif // TOPOLOGY_H
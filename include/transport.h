@@ -0,0 +1,83 @@
+/*
+ * FT-DFRP: Asynchronous MPI Transport
+ *
+ * Dual Licensed:
+ * 1. AGPL-3.0 for research/academic use
+ * 2. Commercial license: contact michael.doran.808@gmail.com
+ *
+ * Copyright (C) 2025 Michael Doran
+ */
+
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <stdint.h>
+
+#define TRANSPORT_TAG 7
+#define TRANSPORT_BATCH_BYTES (64 * 1024)   // coalesced message size cap
+#define TRANSPORT_FLUSH_US 200              // max time a record waits in an outbox
+#define TRANSPORT_SEND_SLOTS 16             // in-flight MPI_Issend ring
+#define TRANSPORT_RECV_SLOTS 8              // pre-posted MPI_Irecv ring
+#define TRANSPORT_LATENCY_SAMPLES 65536
+
+// Independent record streams sharing the transport; each has its own
+// handler so layers never see each other's records.
+typedef enum {
+    TRANSPORT_CHANNEL_BENCH,
+    TRANSPORT_CHANNEL_PARITY,       // parity announcements, deltas, digests
+    TRANSPORT_CHANNEL_PARTITION,    // ownership forwarding and halo exchange
+    TRANSPORT_CHANNELS
+} transport_channel_t;
+
+// Records sent to the same rank are coalesced into one batch of up to
+// TRANSPORT_BATCH_BYTES, or whatever has accumulated after
+// TRANSPORT_FLUSH_US. A progress thread owns all MPI traffic: it posts
+// batches on a ring of MPI_Issend slots, keeps a ring of MPI_Irecv slots
+// posted, and queues received batches for transport_poll, which hands each
+// record to the handler of its channel. Once the
+// transport is started no other thread may call MPI until transport_stop,
+// unless MPI provides MPI_THREAD_MULTIPLE; then other communicators (see
+// distributed_knn.h) may be used alongside it.
+// Records addressed to the local rank are looped back without MPI.
+
+typedef void (*transport_handler_fn)(void *ctx, int source_rank, const uint8_t *payload, int length);
+
+// Requires MPI initialized with at least MPI_THREAD_SERIALIZED.
+int transport_start(void);
+// Flushes outstanding records, waits until every rank has stopped sending
+// and all batches have been delivered, then joins the progress thread.
+// Collective: every rank must call it.
+void transport_stop(void);
+
+int transport_rank(void);
+int transport_size(void);
+
+// Copies payload into the outbox for dest_rank; thread-safe, never blocks
+// on the network. Returns -1 for payloads larger than a batch.
+int transport_send(int dest_rank, transport_channel_t channel, const uint8_t *payload, int length);
+// Sends payload to every rank, including the local one.
+int transport_broadcast(transport_channel_t channel, const uint8_t *payload, int length);
+// Pushes partially filled outboxes to the progress thread immediately.
+void transport_flush(void);
+// Collective, carried out by the progress thread, so it is safe at any
+// thread level. Returns the minimum of value over all ranks once every
+// record any rank sent before calling it has reached its destination's
+// inbox: a transport_poll afterwards delivers all of them.
+long transport_agree(long value);
+
+void transport_set_handler(transport_channel_t channel, transport_handler_fn handler, void *ctx);
+
+// Runs the channel handlers on every record received so far, on the
+// calling thread; records on channels without a handler are dropped.
+// Returns the number of records delivered.
+int transport_poll(void);
+
+// Delivered records/sec and p50/p99 enqueue-to-arrival latency. Latencies
+// use CLOCK_MONOTONIC, so they are only meaningful with all ranks on one host.
+void transport_report(void);
+
+// Each rank sends messages records of payload_bytes round-robin to the
+// other ranks and waits for the same number back, then reports. Collective.
+void transport_bench(int messages, int payload_bytes);
+
+#endif // TRANSPORT_H
@@ -0,0 +1,63 @@
+/*
+ * FT-DFRP: Fractal Toroidal Density Field Routing Protocol - Vector Store
+ *
+ * Dual Licensed:
+ * 1. AGPL-3.0 for research/academic use: https://www.gnu.org/licenses/agpl-3.0.html
+ * 2. Commercial license available - contact michael.doran.808@gmail.com for terms
+ *
+ * Copyright (C) 2025 Michael Doran
+ */
+
+#ifndef VECTOR_STORE_H
+#define VECTOR_STORE_H
+
+#include <stddef.h>
+
+#define VECTOR_LANES 8        // candidates scored per kernel call
+#define VECTOR_ALIGNMENT 64
+
+// Scores one block against query, writing VECTOR_LANES results.
+typedef void (*vector_block_kernel_fn)(const double *block, const double *query, int dim, double *out);
+
+typedef struct {
+    const char *name;
+    vector_block_kernel_fn dot;      // <query, v>
+} vector_kernels_t;
+
+// AoSoA arena: node ids are grouped into blocks of VECTOR_LANES, and each
+// block stores dimension d of all its nodes contiguously
+// (blocks[b][d][lane]). One broadcast query element then feeds a full
+// SIMD register of candidates.
+typedef struct {
+    int dim;
+    int capacity;         // always a multiple of VECTOR_LANES
+    double *blocks;       // capacity * dim doubles, 64-byte aligned
+    double *inv_norms;    // 1 / ||v|| per node, 0 for empty or zero vectors
+    const vector_kernels_t *kernels;
+    int borrowed;         // blocks and inv_norms belong to the caller (vector_store_wrap)
+} vector_store_t;
+
+// Best kernels for this CPU (AVX-512, AVX2+FMA or scalar), picked once.
+const vector_kernels_t* vector_kernels(void);
+// Same ISA, unrolled for dim when it is 8, 64, 128, 384 or 768.
+const vector_kernels_t* vector_kernels_for_dim(int dim);
+
+vector_store_t* vector_store_create(int capacity, int dim);
+// A store over existing arrays laid out as above, e.g. from a mapped
+// snapshot; capacity must be a multiple of VECTOR_LANES and blocks 64-byte
+// aligned. Nothing is copied until a set past capacity grows the store.
+vector_store_t* vector_store_wrap(int capacity, int dim, double *blocks, double *inv_norms);
+void vector_store_free(vector_store_t *store);
+void vector_store_set(vector_store_t *store, int id, const double *vector);
+void vector_store_get(const vector_store_t *store, int id, double *out);
+
+// Cosine similarity of query against ids [first, first + n).
+void vector_store_cosine_range(const vector_store_t *store, const double *query,
+                               int first, int n, double *out);
+
+// Same for an arbitrary id list (e.g. a node's neighbours); candidates are
+// packed into a scratch block so they still go through the batch kernel.
+void vector_store_cosine_gather(const vector_store_t *store, const double *query,
+                                const int *ids, int n, double *out);
+
+#endif // VECTOR_STORE_H
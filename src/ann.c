@@ -9,32 +9,121 @@
  */
 
 #include "ann.h"
+#include "hnsw.h"
+#include "journal.h"
+#include "node_store.h"
+#include "partition.h"
+#include "quantize.h"
+#include "thread_pool.h"
+#include <stdio.h>
 #include <string.h>
+#include <time.h>
+
+#define ANN_SCAN_CHUNK 256
+#define ANN_BATCH_TILE 8     // queries sharing one pass over the vector store
+
+static hnsw_index_t *ann_index = NULL;
+static vector_store_t *ann_store = NULL;
+static quantized_store_t *ann_quantized = NULL;
+static int ann_rerank = QUANT_DEFAULT_RERANK;
+
+void ann_attach_index(hnsw_index_t *index) {
+    ann_index = index;
+}
+
+hnsw_index_t* ann_get_index(void) {
+    return ann_index;
+}
+
+void ann_attach_vector_store(vector_store_t *store) {
+    ann_store = store;
+}
+
+vector_store_t* ann_get_vector_store(void) {
+    return ann_store;
+}
+
+void ann_attach_quantized_store(quantized_store_t *store, int rerank) {
+    ann_quantized = store;
+    ann_rerank = rerank;
+}
+
+quantized_store_t* ann_get_quantized_store(void) {
+    return ann_quantized;
+}
+
+// Stores and index cover this rank's shard, keyed by local index; ghost
+// copies are refreshed by the halo exchange and never indexed here.
+static int ann_index_update(TorusNode *node) {
+    int local = partition_local_index(node->id);
+    if (local < 0) return 0;
+    const double *vector = node_vector(local);
+    if (ann_store) vector_store_set(ann_store, local, vector);
+    if (ann_quantized) quantized_store_set(ann_quantized, local, vector);
+    if (ann_index) hnsw_upsert(ann_index, local, vector);
+    partition_mark_dirty(node->id);
+    return journal_log_vector(node->id, local);
+}
 
 similarity_heap_t* create_similarity_heap(int capacity) {
     similarity_heap_t *heap = (similarity_heap_t*)malloc(sizeof(similarity_heap_t));
-    heap->results = (similarity_result_t*)malloc(sizeof(similarity_result_t) * capacity);
+    similarity_heap_init(heap, (similarity_result_t*)malloc(sizeof(similarity_result_t) * capacity), capacity);
+    return heap;
+}
+
+void similarity_heap_init(similarity_heap_t *heap, similarity_result_t *storage, int capacity) {
+    heap->results = storage;
     heap->count = 0;
     heap->capacity = capacity;
-    return heap;
+}
+
+// Binary min-heap on combined_score: results[0] is always the weakest kept
+// result, so a full heap rejects most candidates with a single compare.
+static void heap_sift_down(similarity_result_t *h, int count, int i) {
+    similarity_result_t item = h[i];
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= count) break;
+        if (child + 1 < count && h[child + 1].combined_score < h[child].combined_score) child++;
+        if (item.combined_score <= h[child].combined_score) break;
+        h[i] = h[child];
+        i = child;
+    }
+    h[i] = item;
 }
 
 void heap_insert(similarity_heap_t *heap, int node_id, double similarity, double combined_score) {
+    similarity_result_t *h = heap->results;
     if (heap->count < heap->capacity) {
-        heap->results[heap->count++] = (similarity_result_t){ node_id, similarity, combined_score };
-    } else {
-        int min_idx = 0;
-        for (int i = 1; i < heap->count; i++) {
-            if (heap->results[i].combined_score < heap->results[min_idx].combined_score) {
-                min_idx = i;
-            }
-        }
-        if (combined_score > heap->results[min_idx].combined_score) {
-            heap->results[min_idx] = (similarity_result_t){ node_id, similarity, combined_score };
+        int i = heap->count++;
+        while (i > 0) {
+            int parent = (i - 1) / 2;
+            if (h[parent].combined_score <= combined_score) break;
+            h[i] = h[parent];
+            i = parent;
         }
+        h[i] = (similarity_result_t){ node_id, similarity, combined_score };
+    } else if (heap->capacity > 0 && combined_score > h[0].combined_score) {
+        h[0] = (similarity_result_t){ node_id, similarity, combined_score };
+        heap_sift_down(h, heap->count, 0);
     }
 }
 
+int heap_drain_sorted(similarity_heap_t *heap) {
+    // In-place heapsort: each popped minimum lands at the tail, leaving the
+    // array in descending combined_score order.
+    int n = heap->count;
+    similarity_result_t *h = heap->results;
+    for (int end = n - 1; end > 0; end--) {
+        similarity_result_t min = h[0];
+        h[0] = h[end];
+        heap_sift_down(h, end, 0);
+        h[end] = min;
+    }
+    heap->count = 0;
+    return n;
+}
+
 void heap_free(similarity_heap_t *heap) {
     if (heap) {
         free(heap->results);
@@ -42,39 +131,299 @@ void heap_free(similarity_heap_t *heap) {
     }
 }
 
-similarity_result_t* find_k_nearest(TorusNode *network, int total_nodes, int query_node, int k) {
-    similarity_heap_t *heap = create_similarity_heap(k);
-    TorusNode *query = &network[query_node];
+// Rescores the index's ef_search nearest candidates by combined score.
+static int knn_from_index(const double *query, double coherence, int exclude,
+                          int k, hnsw_scratch_t *scratch, similarity_result_t *out) {
+    similarity_heap_t heap;
+    similarity_heap_init(&heap, out, k);
+
+    int ef = ann_index->ef_search > k ? ann_index->ef_search : k;
+    similarity_result_t *candidates = malloc(sizeof(similarity_result_t) * ef);
+    int n = hnsw_search_with_scratch(ann_index, scratch, query, ef, ef, exclude, candidates);
+    for (int i = 0; i < n; i++) {
+        int id = candidates[i].node_id;
+        double score = candidates[i].similarity * coherence + node_hot.density[id];
+        heap_insert(&heap, id, candidates[i].similarity, score);
+    }
+    free(candidates);
+    return heap_drain_sorted(&heap);
+}
+
+int find_k_nearest_vector(TorusNode *network, int total_nodes, const double *query, double coherence,
+                          int exclude, int k, hnsw_scratch_t *scratch, similarity_result_t *out) {
+    if (k <= 0) return 0;   // an empty heap would read as full
+    similarity_heap_t heap;
+    similarity_heap_init(&heap, out, k);
+
+    // A quantized store scores the candidates: the graph is walked on its
+    // codes when there is one, all codes are scanned otherwise, and the
+    // best k * rerank are re-ranked exactly either way.
+    if (ann_quantized && ann_index && ann_index->count > 1) {
+        return quantized_search_index(ann_quantized, ann_index,
+                                      scratch ? scratch : &ann_index->scratch, query, coherence,
+                                      exclude, k, ann_rerank, out);
+    }
+    if (ann_quantized) {
+        return quantized_find_k_nearest_vector(ann_quantized, network, total_nodes, query, coherence,
+                                               exclude, k, ann_rerank, out);
+    }
+
+    if (ann_index && ann_index->count > 1) {
+        return knn_from_index(query, coherence, exclude, k,
+                              scratch ? scratch : &ann_index->scratch, out);
+    }
+
+    // Fused scan + select: once the heap is full, only candidates beating the
+    // current minimum pay for a sift.
+    if (ann_store) {
+        double similarities[ANN_SCAN_CHUNK];
+        for (int base = 0; base < total_nodes; base += ANN_SCAN_CHUNK) {
+            int n = total_nodes - base < ANN_SCAN_CHUNK ? total_nodes - base : ANN_SCAN_CHUNK;
+            vector_store_cosine_range(ann_store, query, base, n, similarities);
+            for (int j = 0; j < n; j++) {
+                int i = base + j;
+                if (i == exclude) continue;
+                double score = similarities[j] * coherence + node_hot.density[i];
+                if (heap.count == k && score <= out[0].combined_score) continue;
+                heap_insert(&heap, i, similarities[j], score);
+            }
+        }
+        return heap_drain_sorted(&heap);
+    }
 
     for (int i = 0; i < total_nodes; i++) {
-        if (i == query_node) continue;
-        double similarity = cosine_similarity(query->vector, network[i].vector, VECTOR_DIM);
-        double score = similarity * query->coherence + network[i].density;
-        heap_insert(heap, i, similarity, score);
+        if (i == exclude) continue;
+        double similarity = cosine_similarity(query, node_vector(i), vector_dim);
+        double score = similarity * coherence + node_hot.density[i];
+        if (heap.count == k && score <= out[0].combined_score) continue;
+        heap_insert(&heap, i, similarity, score);
+    }
+
+    return heap_drain_sorted(&heap);
+}
+
+int find_k_nearest_into(TorusNode *network, int total_nodes, int query_node, int k,
+                        similarity_result_t *out) {
+    return find_k_nearest_vector(network, total_nodes, node_vector(query_node),
+                                 node_hot.coherence[query_node], query_node, k, NULL, out);
+}
+
+similarity_result_t* find_k_nearest(TorusNode *network, int total_nodes, int query_node, int k) {
+    if (k <= 0) return NULL;
+    similarity_result_t *results = malloc(sizeof(similarity_result_t) * k);
+    int n = find_k_nearest_into(network, total_nodes, query_node, k, results);
+    for (int i = n; i < k; i++) {
+        results[i] = (similarity_result_t){ -1, 0.0, -INFINITY };
+    }
+    return results;
+}
+
+typedef struct {
+    TorusNode *network;
+    int total_nodes;
+    const int *queries;
+    int query_count;
+    int k;
+    similarity_result_t *out;   // query_count * k
+    int *counts;
+    hnsw_scratch_t *scratch;    // one per pool worker
+} knn_batch_t;
+
+// One tile of up to ANN_BATCH_TILE queries against the vector store: each
+// chunk of candidates is loaded once and scored for every query in the tile
+// while it is still in cache.
+static void knn_batch_tile_scan(knn_batch_t *b, int first, int count) {
+    similarity_heap_t heaps[ANN_BATCH_TILE];
+    double similarities[ANN_SCAN_CHUNK];
+
+    for (int t = 0; t < count; t++) {
+        similarity_heap_init(&heaps[t], b->out + (size_t)(first + t) * b->k, b->k);
+    }
+
+    for (int base = 0; base < b->total_nodes; base += ANN_SCAN_CHUNK) {
+        int n = b->total_nodes - base < ANN_SCAN_CHUNK ? b->total_nodes - base : ANN_SCAN_CHUNK;
+        for (int t = 0; t < count; t++) {
+            int query_node = b->queries[first + t];
+            double coherence = node_hot.coherence[query_node];
+            similarity_heap_t *heap = &heaps[t];
+
+            vector_store_cosine_range(ann_store, node_vector(query_node), base, n, similarities);
+            for (int j = 0; j < n; j++) {
+                int i = base + j;
+                if (i == query_node) continue;
+                double score = similarities[j] * coherence + node_hot.density[i];
+                if (heap->count == b->k && score <= heap->results[0].combined_score) continue;
+                heap_insert(heap, i, similarities[j], score);
+            }
+        }
+    }
+
+    for (int t = 0; t < count; t++) {
+        b->counts[first + t] = heap_drain_sorted(&heaps[t]);
+    }
+}
+
+static void knn_batch_task(void *ctx, int begin, int end, int worker) {
+    knn_batch_t *b = ctx;
+    for (int tile = begin; tile < end; tile++) {
+        int first = tile * ANN_BATCH_TILE;
+        int count = b->query_count - first < ANN_BATCH_TILE ? b->query_count - first : ANN_BATCH_TILE;
+
+        if (!ann_quantized && !(ann_index && ann_index->count > 1) && ann_store) {
+            knn_batch_tile_scan(b, first, count);
+            continue;
+        }
+
+        for (int t = first; t < first + count; t++) {
+            similarity_result_t *row = b->out + (size_t)t * b->k;
+            int query_node = b->queries[t];
+            b->counts[t] = find_k_nearest_vector(b->network, b->total_nodes, node_vector(query_node),
+                                                 node_hot.coherence[query_node], query_node, b->k,
+                                                 &b->scratch[worker], row);
+        }
+    }
+}
+
+int find_k_nearest_batch(TorusNode *network, int total_nodes, const int *query_nodes,
+                         int query_count, int k, similarity_result_t *out, int *counts) {
+    if (k <= 0 || query_count <= 0) {
+        for (int q = 0; counts && q < query_count; q++) counts[q] = 0;
+        return 0;
+    }
+    thread_pool_t *pool = thread_pool_default();
+    int workers = thread_pool_size(pool);
+
+    knn_batch_t batch = {
+        .network = network,
+        .total_nodes = total_nodes,
+        .queries = query_nodes,
+        .query_count = query_count,
+        .k = k,
+        .out = out,
+        .counts = counts ? counts : malloc(sizeof(int) * query_count),
+        .scratch = calloc(workers, sizeof(hnsw_scratch_t)),
+    };
+
+    int tiles = (query_count + ANN_BATCH_TILE - 1) / ANN_BATCH_TILE;
+    thread_pool_parallel_for(pool, tiles, 1, knn_batch_task, &batch);
+
+    int found = 0;
+    for (int q = 0; q < query_count; q++) {
+        for (int i = batch.counts[q]; i < k; i++) {
+            out[(size_t)q * k + i] = (similarity_result_t){ -1, 0.0, -INFINITY };
+        }
+        found += batch.counts[q];
     }
 
-    return heap->results;
+    for (int w = 0; w < workers; w++) hnsw_scratch_free(&batch.scratch[w]);
+    free(batch.scratch);
+    if (!counts) free(batch.counts);
+    return found;
 }
 
-void inject_vector(TorusNode *node, const double *vector, int dim) {
-    if (!node->vector) node->vector = (double*)malloc(sizeof(double) * dim);
-    memcpy(node->vector, vector, sizeof(double) * dim);
-    node->density = 1.0;  // assume injected vectors are dense
+// A failed journal (journal.h) refuses every vector change from then on.
+int inject_vector(TorusNode *node, const double *vector, int dim) {
+    if (journal_failed()) return -1;
+    int slot = node_slot(node);
+    memcpy(node_vector(slot), vector, sizeof(double) * dim);
+    node_hot.density[slot] = 1.0;  // assume injected vectors are dense
+    return ann_index_update(node);
 }
 
-void randomize_vector(TorusNode *node, int dim, double range) {
-    if (!node->vector) node->vector = (double*)malloc(sizeof(double) * dim);
+int randomize_vector(TorusNode *node, int dim, double range) {
+    if (journal_failed()) return -1;
+    int slot = node_slot(node);
+    double *v = node_vector(slot);
     for (int i = 0; i < dim; i++) {
-        node->vector[i] = ((double)rand() / RAND_MAX) * range - (range / 2.0);
+        v[i] = ((double)rand() / RAND_MAX) * range - (range / 2.0);
     }
-    vector_normalize(node->vector, dim);
-    node->density = 1.0;
+    vector_normalize(v, dim);
+    node_hot.density[slot] = 1.0;
+    return ann_index_update(node);
 }
 
-void evolve_vector(TorusNode *node, double learning_rate, const double *target) {
-    if (!node->vector) return;
-    for (int i = 0; i < VECTOR_DIM; i++) {
-        node->vector[i] += learning_rate * (target[i] - node->vector[i]);
+int evolve_vector(TorusNode *node, double learning_rate, const double *target) {
+    if (journal_failed()) return -1;
+    double *v = node_vector(node_slot(node));
+    for (int i = 0; i < vector_dim; i++) {
+        v[i] += learning_rate * (target[i] - v[i]);
+    }
+    vector_normalize(v, vector_dim);
+    return ann_index_update(node);
+}
+
+// Exact nearest neighbours by cosine similarity alone; ground truth for the
+// recall report.
+int brute_force_nearest(TorusNode *network, int total_nodes, const double *query, int k,
+                        int exclude_id, similarity_result_t *out) {
+    (void)network;
+    similarity_heap_t heap;
+    similarity_heap_init(&heap, out, k);
+    if (ann_store) {
+        double similarities[ANN_SCAN_CHUNK];
+        for (int base = 0; base < total_nodes; base += ANN_SCAN_CHUNK) {
+            int n = total_nodes - base < ANN_SCAN_CHUNK ? total_nodes - base : ANN_SCAN_CHUNK;
+            vector_store_cosine_range(ann_store, query, base, n, similarities);
+            for (int j = 0; j < n; j++) {
+                if (base + j == exclude_id) continue;
+                heap_insert(&heap, base + j, similarities[j], similarities[j]);
+            }
+        }
+        return heap_drain_sorted(&heap);
     }
-    vector_normalize(node->vector, VECTOR_DIM);
+
+    for (int i = 0; i < total_nodes; i++) {
+        if (i == exclude_id) continue;
+        double similarity = cosine_similarity(query, node_vector(i), vector_dim);
+        heap_insert(&heap, i, similarity, similarity);
+    }
+    return heap_drain_sorted(&heap);
+}
+
+static double elapsed_us(const struct timespec *start, const struct timespec *end) {
+    return (end->tv_sec - start->tv_sec) * 1e6 + (end->tv_nsec - start->tv_nsec) / 1e3;
+}
+
+void ann_recall_report(TorusNode *network, int total_nodes, int k, int ef_search, int samples) {
+    if (!ann_index || total_nodes < 2) {
+        printf("[ANN] No index attached\n");
+        return;
+    }
+    if (samples > total_nodes) samples = total_nodes;
+
+    similarity_result_t *exact = malloc(sizeof(similarity_result_t) * k);
+    similarity_result_t *approx = malloc(sizeof(similarity_result_t) * k);
+    double hnsw_us = 0.0, brute_us = 0.0;
+    long hits = 0, expected = 0;
+
+    for (int s = 0; s < samples; s++) {
+        int q = rand() % total_nodes;
+        struct timespec t0, t1, t2;
+
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        int n_exact = brute_force_nearest(network, total_nodes, node_vector(q), k, q, exact);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        int n_approx = hnsw_search(ann_index, node_vector(q), k, ef_search, q, approx);
+        clock_gettime(CLOCK_MONOTONIC, &t2);
+
+        brute_us += elapsed_us(&t0, &t1);
+        hnsw_us += elapsed_us(&t1, &t2);
+
+        for (int i = 0; i < n_exact; i++) {
+            for (int j = 0; j < n_approx; j++) {
+                if (approx[j].node_id == exact[i].node_id) {
+                    hits++;
+                    break;
+                }
+            }
+        }
+        expected += n_exact;
+    }
+
+    printf("[ANN] recall@%d = %.4f | ef_search=%d | hnsw %.1f us/query | brute force %.1f us/query (%d samples)\n",
+           k, expected ? (double)hits / expected : 1.0, ef_search,
+           hnsw_us / samples, brute_us / samples, samples);
+
+    free(exact);
+    free(approx);
 }
@@ -10,8 +10,24 @@
 
 #include "fractal.h"
 #include "ann.h"
+#include "distance_field.h"
+#include "distributed_knn.h"
+#include "fault_recovery.h"
+#include "hnsw.h"
+#include "journal.h"
+#include "quantize.h"
 #include "memory_guard.h"
+#include "merkle.h"
+#include "merkle_sync.h"
 #include "parity_types.h"
+#include "parity_wire.h"
+#include "parity_broadcast.h"
+#include "parity_distribution.h"
+#include "partition.h"
+#include "route_cache.h"
+#include "snapshot.h"
+#include "routing.h"
+#include "topology.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -22,33 +38,223 @@ void run_cli(int argc, char **argv) {
         return;
     }
 
-    if (strcmp(argv[1], "injectvec") == 0 && argc >= 11) {
+    if (strcmp(argv[1], "injectvec") == 0 && argc >= 3 + vector_dim) {
         int id = atoi(argv[2]);
-        double vec[VECTOR_DIM];
-        for (int i = 0; i < VECTOR_DIM; i++) {
+        double *vec = malloc(sizeof(double) * vector_dim);
+        for (int i = 0; i < vector_dim; i++) {
             vec[i] = atof(argv[3 + i]);
         }
-        inject_vector(&network[id], vec, VECTOR_DIM);
-        printf("[OK] Vector injected into node %d\n", id);
+        int status = partition_inject_vector(id, vec);
+        free(vec);
+        if (status == 0) printf("[OK] Vector injected into node %d\n", id);
+        else printf("[ERROR] Node %d refused the vector: journal failed\n", id);
     } 
+    else if (strcmp(argv[1], "findnearest") == 0 && argc == 4 && atoi(argv[3]) <= 0) {
+        printf("[ERROR] k must be positive\n");
+    }
     else if (strcmp(argv[1], "findnearest") == 0 && argc == 4) {
         int id = atoi(argv[2]);
         int k = atoi(argv[3]);
-        similarity_result_t *res = find_k_nearest(network, total_nodes, id, k);
+        similarity_result_t *res = malloc(sizeof(similarity_result_t) * k);
+        int found = distributed_knn(&id, 1, k, res, NULL);
+        if (found < 0) found = partition_knn(id, k, res);
         printf("[RESULT] Nearest to %d:\n", id);
-        for (int i = 0; i < k; i++) {
+        for (int i = 0; i < found; i++) {
             printf("  #%d -> Node %d | Similarity: %.4f | Score: %.4f\n",
                    i, res[i].node_id, res[i].similarity, res[i].combined_score);
         }
         free(res);
     }
+    else if (strcmp(argv[1], "benchknn") == 0) {
+        // Same arguments as the standalone "fractal benchknn", which builds
+        // the network; here it must match the one running.
+        int weak = argc >= 3 && strcmp(argv[2], "weak") == 0;
+        if (argc < 4 || (!weak && strcmp(argv[2], "strong") != 0)) {
+            printf("[ERROR] Usage: benchknn strong|weak <nodes> [queries] [k] [batch]\n");
+        } else if (atoi(argv[3]) * (weak ? partition.size : 1) != total_nodes) {
+            printf("[ERROR] The running network has %d nodes over %d ranks\n", total_nodes, partition.size);
+        } else {
+            distributed_knn_bench(argc >= 5 ? atoi(argv[4]) : 0, argc >= 6 ? atoi(argv[5]) : 0,
+                                  argc >= 7 ? atoi(argv[6]) : 0);
+        }
+    }
+    else if (strcmp(argv[1], "route") == 0 && argc >= 4) {
+        int from = atoi(argv[2]);
+        int to = atoi(argv[3]);
+        int max = argc >= 5 ? atoi(argv[4]) : ROUTE_CACHE_MAX_PATH;
+        if (max <= 0) max = ROUTE_CACHE_MAX_PATH;
+        double *target = malloc(sizeof(double) * vector_dim);
+        int *path = malloc(sizeof(int) * max);
+        int length = -1;
+        if (partition_fetch_node(to, target, NULL, NULL) == 0) {
+            length = compute_route(from, to, target, &default_routing_config, path, max);
+        }
+        if (length < 0) {
+            printf("[ERROR] No route from %d to %d within %d hops\n", from, to, max);
+        } else {
+            printf("[RESULT] Route %d -> %d (%d hops):", from, to, length - 1);
+            for (int i = 0; i < length; i++) printf(" %d", path[i]);
+            printf("\n");
+        }
+        free(target);
+        free(path);
+    }
+    else if (strcmp(argv[1], "testroute") == 0) {
+        route_check(argc >= 3 ? atoi(argv[2]) : 0);
+    }
+    else if (strcmp(argv[1], "routestats") == 0) {
+        route_cache_report();
+        distance_field_report();
+    }
+    else if (strcmp(argv[1], "fieldlimit") == 0 && argc == 3) {
+        distance_field_set_limit(atoi(argv[2]));
+        distance_field_report();
+    }
+    else if (strcmp(argv[1], "topology") == 0) {
+        topology_report(&topology);
+    }
+    else if (strcmp(argv[1], "annef") == 0 && argc == 3) {
+        hnsw_index_t *index = ann_get_index();
+        if (index) {
+            hnsw_set_ef_search(index, atoi(argv[2]));
+            printf("[OK] ef_search set to %d\n", index->ef_search);
+        }
+    }
+    else if (strcmp(argv[1], "annrecall") == 0 && argc >= 4) {
+        int k = atoi(argv[2]);
+        int ef = atoi(argv[3]);
+        int samples = argc >= 5 ? atoi(argv[4]) : 100;
+        ann_recall_report(network, partition.owned, k, ef, samples);
+    }
+    else if (strcmp(argv[1], "annquant") == 0 && argc >= 3) {
+        quantized_store_free(ann_get_quantized_store());
+        ann_attach_quantized_store(NULL, 0);
+        if (strcmp(argv[2], "off") != 0) {
+            quant_mode_t mode = strcmp(argv[2], "int8") == 0 ? QUANT_INT8 :
+                                strcmp(argv[2], "pq") == 0 ? QUANT_PQ : QUANT_FP32;
+            int rerank = argc >= 4 ? atoi(argv[3]) : QUANT_DEFAULT_RERANK;
+            quantized_store_t *store = quantized_store_build(network, partition.owned, vector_dim, mode, 0);
+            quantized_report(store, network, partition.owned, 10, rerank, 100);
+            ann_attach_quantized_store(store, rerank);
+        }
+    }
     else if (strcmp(argv[1], "announce") == 0 && argc == 3) {
         int id = atoi(argv[2]);
         announce_parity_holdings(id);
+        parity_broadcast_poll();
     } 
+    else if (strcmp(argv[1], "gossip") == 0 && argc == 3) {
+        gossip_parity_announcement(atoi(argv[2]));
+        parity_broadcast_poll();
+    }
+    else if (strcmp(argv[1], "antientropy") == 0 && argc == 3) {
+        parity_anti_entropy_round(atoi(argv[2]));
+        parity_broadcast_poll();
+    }
+    else if (strcmp(argv[1], "gossipstats") == 0) {
+        parity_gossip_report();
+    }
+    else if (strcmp(argv[1], "benchwire") == 0) {
+        parity_wire_bench(argc >= 3 ? atoi(argv[2]) : 0);
+    }
+    else if (strcmp(argv[1], "distribute") == 0 && argc >= 3) {
+        williams_distribution_policy_t policy = default_williams_policy;
+        if (argc >= 4) policy.min_replicas = atoi(argv[3]);
+        free(distribute_parity_with_tree_evaluation(argv[2], &policy));
+        parity_broadcast_poll();
+    }
+    else if (strcmp(argv[1], "distributebatch") == 0 && argc >= 4) {
+        int count = atoi(argv[3]);
+        int replicas = argc >= 5 ? atoi(argv[4]) : 0;
+        if (count > 0) {
+            char (*names)[MAX_TAG_LENGTH + 1] = malloc(sizeof(*names) * count);
+            const char **tags = malloc(sizeof(char *) * count);
+            for (int i = 0; i < count; i++) {
+                snprintf(names[i], sizeof(names[i]), "%s%d", argv[2], i);
+                tags[i] = names[i];
+            }
+            int *placements = malloc(sizeof(int) * count * (replicas > 0 ? replicas : default_williams_policy.max_replicas));
+            placement_batch_stats_t stats;
+            distribute_parity_batch(tags, count, replicas, &default_williams_policy, placements, &stats);
+            placement_batch_report(&stats);
+            parity_broadcast_poll();
+            free(names);
+            free(tags);
+            free(placements);
+        }
+    }
+    else if (strcmp(argv[1], "testplace") == 0) {
+        placement_batch_check(argc >= 3 ? atoi(argv[2]) : 0, argc >= 4 ? atoi(argv[3]) : 0);
+    }
+    else if (strcmp(argv[1], "benchplace") == 0) {
+        placement_bench(argc >= 3 ? atoi(argv[2]) : 0);
+    }
     else if (strcmp(argv[1], "recovery") == 0 && argc == 3) {
         recover_parity_tag(argv[2]);
     } 
+    else if (strcmp(argv[1], "failnodes") == 0 && argc >= 4) {
+        int first = atoi(argv[2]);
+        int count = atoi(argv[3]);
+        if (count > 0) {
+            int *failed = malloc(sizeof(int) * count);
+            for (int i = 0; i < count; i++) failed[i] = first + i;
+            recovery_stats_t stats;
+            if (recover_failed_nodes(failed, count, &default_williams_policy, &stats) >= 0) {
+                recovery_report(&stats);
+            }
+            parity_broadcast_poll();
+            free(failed);
+        }
+    }
+    else if (strcmp(argv[1], "recoveryrate") == 0 && argc >= 3) {
+        recovery_set_rate(atof(argv[2]), argc >= 4 ? atoi(argv[3]) : 0);
+    }
+    else if (strcmp(argv[1], "benchrecovery") == 0) {
+        recovery_bench(argc >= 3 ? atoi(argv[2]) : 0, argc >= 4 ? atoi(argv[3]) : 0);
+    }
+    else if (strcmp(argv[1], "merkleroot") == 0) {
+        char root[MAX_HASH_SIZE];
+        printf("[MERKLE] Root: %s\n", merkle_network_root_hex(root) == 0 ? root : "(none)");
+    }
+    else if (strcmp(argv[1], "merkleverify") == 0 && argc == 3) {
+        int id = atoi(argv[2]);
+        const uint8_t *root = merkle_network_root();
+        printf("[MERKLE] Node %d %s\n", id, root && verify_merkle_path(id, root) ? "verified" : "not verified");
+    }
+    else if (strcmp(argv[1], "merklesync") == 0 && argc >= 3) {
+        int peer = atoi(argv[2]);
+        merkle_sync_stats_t stats;
+        if (merkle_sync(peer, argc >= 4 ? atoi(argv[3]) : peer, &stats) < 0) {
+            printf("[SYNC] Rank %d cannot serve that shard\n", peer);
+        } else {
+            merkle_sync_report(&stats);
+        }
+    }
+    else if (strcmp(argv[1], "benchsync") == 0) {
+        merkle_sync_bench(argc >= 3 ? atof(argv[2]) : 0, argc >= 4 ? atoi(argv[3]) : 0);
+    }
+    else if (strcmp(argv[1], "snapshot") == 0 && argc >= 3) {
+        // The journal restarts next to the snapshot unless told "off".
+        journal_config_t journal = journal_default_config();
+        int journaled = !(argc >= 4 && strcmp(argv[3], "off") == 0);
+        if (argc >= 4 && journaled && journal_parse_sync(argv[3], &journal.sync) != 0) {
+            printf("[ERROR] Durability must be none, batch, every or off\n");
+        } else {
+            int failed = snapshot_write_all(argv[2], journaled ? &journal : NULL);
+            printf("[SNAPSHOT] %s\n", failed ? "Incomplete; do not restore from it" : "Written");
+        }
+    }
+    else if (strcmp(argv[1], "journalsync") == 0) {
+        if (journal_sync() == 0) printf("[JOURNAL] Synced\n");
+        else if (journal_failed()) printf("[JOURNAL] Failed: %s\n", strerror(journal_failed()));
+        else printf("[JOURNAL] No journal open\n");
+    }
+    else if (strcmp(argv[1], "benchsnapshot") == 0) {
+        snapshot_bench(argc >= 3 ? argv[2] : "/tmp/ftdfrp_bench.snap");
+    }
+    else if (strcmp(argv[1], "benchjournal") == 0) {
+        journal_bench(argc >= 3 ? atoi(argv[2]) : 0, argc >= 4 ? argv[3] : "/tmp/ftdfrp_bench.wal");
+    }
     else if (strcmp(argv[1], "testann") == 0) {
         run_ann_tests();
     } 
@@ -0,0 +1,250 @@
+/*
+ * FT-DFRP: Parity Distance Fields
+ *
+ * Dual Licensed:
+ * 1. AGPL-3.0 for research/academic use
+ * 2. Commercial license: contact michael.doran.808@gmail.com
+ *
+ * Copyright (C) 2025 Michael Doran
+ */
+
+#include "distance_field.h"
+#include "parity_index.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Forward adjacency is the topology's; distances run from a node to a
+// holder, so searches from the holders walk the reverse edges.
+static struct {
+    int nodes;
+    const int *out_offsets, *out_targets;
+    int *in_offsets, *in_targets;
+    uint16_t **fields;       // by tag id; NULL until first lookup or once evicted
+    uint64_t *last_used;     // by tag id: clock at the last lookup
+    int field_capacity;
+    uint64_t clock;
+    int resident;
+    int limit;               // 0 until the first init: DISTANCE_FIELD_DEFAULT_LIMIT
+    long builds, evictions;
+    int *queue;              // scratch, nodes entries
+    int *seeds;
+    uint8_t *affected;
+} df;
+
+static void build_reverse(void) {
+    int edges = df.out_offsets[df.nodes];
+    df.in_offsets = calloc(df.nodes + 1, sizeof(int));
+    df.in_targets = malloc(sizeof(int) * (edges > 0 ? edges : 1));
+    for (int e = 0; e < edges; e++) df.in_offsets[df.out_targets[e] + 1]++;
+    for (int v = 0; v < df.nodes; v++) df.in_offsets[v + 1] += df.in_offsets[v];
+    int *fill = malloc(sizeof(int) * (df.nodes > 0 ? df.nodes : 1));
+    memcpy(fill, df.in_offsets, sizeof(int) * df.nodes);
+    for (int u = 0; u < df.nodes; u++) {
+        for (int e = df.out_offsets[u]; e < df.out_offsets[u + 1]; e++) {
+            df.in_targets[fill[df.out_targets[e]]++] = u;
+        }
+    }
+    free(fill);
+}
+
+void distance_field_init(const topology_t *graph) {
+    int limit = df.limit;
+    distance_field_free();
+    df.limit = limit ? limit : DISTANCE_FIELD_DEFAULT_LIMIT;
+    int nodes = graph->nodes;
+    df.nodes = nodes;
+    df.out_offsets = graph->offsets;
+    df.out_targets = graph->targets;
+    build_reverse();
+    df.queue = malloc(sizeof(int) * (nodes > 0 ? nodes : 1));
+    df.seeds = malloc(sizeof(int) * (nodes > 0 ? nodes : 1));
+    df.affected = calloc(nodes > 0 ? nodes : 1, 1);
+}
+
+void distance_field_free(void) {
+    for (int t = 0; t < df.field_capacity; t++) free(df.fields[t]);
+    free(df.fields);
+    free(df.last_used);
+    free(df.in_offsets);
+    free(df.in_targets);
+    free(df.queue);
+    free(df.seeds);
+    free(df.affected);
+    memset(&df, 0, sizeof(df));
+}
+
+void distance_field_reset(void) {
+    for (int t = 0; t < df.field_capacity; t++) {
+        free(df.fields[t]);
+        df.fields[t] = NULL;
+    }
+    df.resident = 0;
+}
+
+static void evict_oldest(void) {
+    int oldest = -1;
+    for (int t = 0; t < df.field_capacity; t++) {
+        if (df.fields[t] && (oldest < 0 || df.last_used[t] < df.last_used[oldest])) oldest = t;
+    }
+    if (oldest < 0) return;
+    free(df.fields[oldest]);
+    df.fields[oldest] = NULL;
+    df.resident--;
+    df.evictions++;
+}
+
+void distance_field_set_limit(int max_fields) {
+    df.limit = max_fields > 0 ? max_fields : 1;
+    while (df.resident > df.limit) evict_oldest();
+}
+
+void distance_field_report(void) {
+    size_t field_bytes = (size_t)df.resident * df.nodes * sizeof(uint16_t);
+    size_t graph_bytes = df.in_offsets ? sizeof(int) * ((size_t)df.nodes * 3 + 1 + df.in_offsets[df.nodes]) : 0;
+    printf("[ROUTE] distance fields %d/%d resident, %.1f MB (+%.1f MB reverse edges and scratch) | built %ld | evicted %ld\n",
+           df.resident, df.limit, field_bytes / 1e6, graph_bytes / 1e6, df.builds, df.evictions);
+}
+
+// Lowers distances outward (against edge direction) from queue[0..tail),
+// whose entries must already be final and in nondecreasing order.
+static void relax(uint16_t *dist, int tail) {
+    for (int head = 0; head < tail; head++) {
+        int v = df.queue[head];
+        if (dist[v] + 1 >= DISTANCE_UNREACHABLE) continue;
+        uint16_t next = dist[v] + 1;
+        for (int e = df.in_offsets[v]; e < df.in_offsets[v + 1]; e++) {
+            int u = df.in_targets[e];
+            if (dist[u] > next) {
+                dist[u] = next;
+                df.queue[tail++] = u;
+            }
+        }
+    }
+}
+
+static uint16_t *build(parity_tag_id_t tag) {
+    uint16_t *dist = malloc(sizeof(uint16_t) * (df.nodes > 0 ? df.nodes : 1));
+    memset(dist, 0xff, sizeof(uint16_t) * df.nodes);
+    parity_holder_view_t holders = parity_index_lookup(tag);
+    int tail = 0;
+    for (int i = 0; i < holders.count; i++) {
+        int h = holders.holders[i];
+        if (h >= 0 && h < df.nodes && dist[h] != 0) {
+            dist[h] = 0;
+            df.queue[tail++] = h;
+        }
+    }
+    relax(dist, tail);
+    return dist;
+}
+
+static uint16_t *field_for(parity_tag_id_t tag, int create) {
+    if (tag == PARITY_TAG_INVALID || !df.out_offsets) return NULL;
+    if (tag >= (parity_tag_id_t)df.field_capacity) {
+        if (!create) return NULL;
+        int capacity = df.field_capacity ? df.field_capacity : 64;
+        while ((parity_tag_id_t)capacity <= tag) capacity *= 2;
+        df.fields = realloc(df.fields, sizeof(uint16_t *) * capacity);
+        df.last_used = realloc(df.last_used, sizeof(uint64_t) * capacity);
+        memset(df.fields + df.field_capacity, 0, sizeof(uint16_t *) * (capacity - df.field_capacity));
+        memset(df.last_used + df.field_capacity, 0, sizeof(uint64_t) * (capacity - df.field_capacity));
+        df.field_capacity = capacity;
+    }
+    if (!create) return df.fields[tag];
+    if (!df.fields[tag]) {
+        while (df.resident >= df.limit) evict_oldest();
+        df.fields[tag] = build(tag);
+        df.resident++;
+        df.builds++;
+    }
+    df.last_used[tag] = ++df.clock;
+    return df.fields[tag];
+}
+
+uint16_t distance_field_get(parity_tag_id_t tag, int node_id) {
+    if (node_id < 0 || node_id >= df.nodes) return DISTANCE_UNREACHABLE;
+    uint16_t *dist = field_for(tag, 1);
+    return dist ? dist[node_id] : DISTANCE_UNREACHABLE;
+}
+
+void distance_field_holder_added(parity_tag_id_t tag, int node_id) {
+    uint16_t *dist = field_for(tag, 0);
+    if (!dist || node_id < 0 || node_id >= df.nodes || dist[node_id] == 0) return;
+    dist[node_id] = 0;
+    df.queue[0] = node_id;
+    relax(dist, 1);
+}
+
+static int supported(const uint16_t *dist, int u) {
+    for (int e = df.out_offsets[u]; e < df.out_offsets[u + 1]; e++) {
+        int w = df.out_targets[e];
+        if (!df.affected[w] && dist[w] + 1 == dist[u]) return 1;
+    }
+    return 0;
+}
+
+static const uint16_t *sort_dist;   // qsort has no context argument
+
+static int compare_seeds(const void *a, const void *b) {
+    return sort_dist[*(const int *)a] - sort_dist[*(const int *)b];
+}
+
+void distance_field_holder_removed(parity_tag_id_t tag, int node_id) {
+    uint16_t *dist = field_for(tag, 0);
+    if (!dist || node_id < 0 || node_id >= df.nodes || dist[node_id] != 0) return;
+
+    // Find every node that loses its last shortest path. Going level by
+    // level, a node at level L+1 is checked only once all of level L is
+    // known, so its remaining support is final when it is checked.
+    int affected = 0;
+    df.affected[node_id] = 1;
+    df.queue[affected++] = node_id;
+    for (int head = 0; head < affected; head++) {
+        int v = df.queue[head];
+        for (int e = df.in_offsets[v]; e < df.in_offsets[v + 1]; e++) {
+            int u = df.in_targets[e];
+            if (df.affected[u] || dist[u] != dist[v] + 1) continue;
+            if (!supported(dist, u)) {
+                df.affected[u] = 1;
+                df.queue[affected++] = u;
+            }
+        }
+    }
+
+    // Re-derive them from their unaffected neighbours, then spread in
+    // distance order by merging the sorted seeds with the BFS queue.
+    int seeds = 0;
+    for (int i = 0; i < affected; i++) {
+        int u = df.queue[i];
+        uint16_t best = DISTANCE_UNREACHABLE;
+        for (int e = df.out_offsets[u]; e < df.out_offsets[u + 1]; e++) {
+            int w = df.out_targets[e];
+            if (!df.affected[w] && dist[w] + 1 < best) best = dist[w] + 1;
+        }
+        dist[u] = best;
+        if (best != DISTANCE_UNREACHABLE) df.seeds[seeds++] = u;
+    }
+    sort_dist = dist;
+    qsort(df.seeds, seeds, sizeof(int), compare_seeds);
+    for (int i = 0; i < affected; i++) df.affected[df.queue[i]] = 0;
+
+    int head = 0, tail = 0, next_seed = 0;
+    while (next_seed < seeds || head < tail) {
+        int v;
+        if (head == tail || (next_seed < seeds && dist[df.seeds[next_seed]] <= dist[df.queue[head]])) {
+            v = df.seeds[next_seed++];
+        } else {
+            v = df.queue[head++];
+        }
+        if (dist[v] + 1 >= DISTANCE_UNREACHABLE) continue;
+        uint16_t next = dist[v] + 1;
+        for (int e = df.in_offsets[v]; e < df.in_offsets[v + 1]; e++) {
+            int u = df.in_targets[e];
+            if (dist[u] > next) {
+                dist[u] = next;
+                df.queue[tail++] = u;
+            }
+        }
+    }
+}
@@ -0,0 +1,264 @@
+/*
+ * FT-DFRP: Distributed k-NN Queries
+ *
+ * Dual Licensed:
+ * 1. AGPL-3.0 for research/academic use
+ * 2. Commercial license: contact michael.doran.808@gmail.com
+ *
+ * Copyright (C) 2025 Michael Doran
+ */
+
+#include "distributed_knn.h"
+#include "hnsw.h"
+#include "partition.h"
+#include "thread_pool.h"
+#include "transport.h"
+#include <mpi.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+static struct {
+    int ready;
+    MPI_Comm comm;
+    MPI_Datatype result_type;   // one similarity_result_t
+    MPI_Op merge_op;
+    double local_us;            // querying rank: time in its own shard search
+    double merge_us;            // querying rank: time in the reduction
+} dk;
+
+typedef struct {
+    int count;
+    int k;
+} dknn_header_t;
+
+typedef struct {
+    const double *payload;      // count rows of vector_dim + 2 doubles
+    int k;
+    similarity_result_t *rows;  // count * k
+    hnsw_scratch_t *scratch;    // one per pool worker
+} dknn_local_t;
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static int better(const similarity_result_t *a, const similarity_result_t *b) {
+    if (a->combined_score != b->combined_score) return a->combined_score > b->combined_score;
+    return a->node_id > b->node_id;
+}
+
+// MPI_Op over rows of k results, each sorted best first and padded with
+// node_id -1: inout = top-k of (in, inout). k comes from the row type.
+static void merge_rows(void *in, void *inout, int *len, MPI_Datatype *type) {
+    MPI_Aint lb, extent;
+    MPI_Type_get_extent(*type, &lb, &extent);
+    int k = (int)(extent / (MPI_Aint)sizeof(similarity_result_t));
+    similarity_result_t merged[k];
+
+    for (int r = 0; r < *len; r++) {
+        const similarity_result_t *a = (const similarity_result_t *)in + (size_t)r * k;
+        similarity_result_t *b = (similarity_result_t *)inout + (size_t)r * k;
+        int i = 0, j = 0;
+        for (int out = 0; out < k; out++) {
+            int take_a = b[j].node_id < 0 ||
+                         (a[i].node_id >= 0 && better(&a[i], &b[j]));
+            merged[out] = take_a ? a[i++] : b[j++];
+        }
+        memcpy(b, merged, sizeof(merged));
+    }
+}
+
+static void local_task(void *ctx, int begin, int end, int worker) {
+    dknn_local_t *l = ctx;
+    int stride = vector_dim + 2;
+    for (int q = begin; q < end; q++) {
+        const double *row = l->payload + (size_t)q * stride;
+        int exclude = partition_local_index((int)row[vector_dim + 1]);
+        similarity_result_t *out = l->rows + (size_t)q * l->k;
+        int found = find_k_nearest_vector(network, partition.owned, row, row[vector_dim], exclude,
+                                          l->k, &l->scratch[worker], out);
+        for (int i = 0; i < found; i++) out[i].node_id = network[out[i].node_id].id;
+        for (int i = found; i < l->k; i++) out[i] = (similarity_result_t){ -1, 0.0, -INFINITY };
+    }
+}
+
+// The part every rank runs. The root passes its payload and a result
+// buffer; the others learn both sizes from the broadcast header.
+static void run_collective(int root, dknn_header_t header, double *payload, similarity_result_t *merged) {
+    int is_root = root == partition.rank;
+    MPI_Bcast(&header, sizeof(header), MPI_BYTE, root, dk.comm);
+    int stride = vector_dim + 2;
+    if (!is_root) payload = malloc(sizeof(double) * (size_t)header.count * stride);
+    MPI_Bcast(payload, header.count * stride, MPI_DOUBLE, root, dk.comm);
+
+    double t0 = now_us();
+    thread_pool_t *pool = thread_pool_default();
+    int workers = thread_pool_size(pool);
+    dknn_local_t local = {
+        .payload = payload,
+        .k = header.k,
+        .rows = malloc(sizeof(similarity_result_t) * (size_t)header.count * header.k),
+        .scratch = calloc(workers, sizeof(hnsw_scratch_t)),
+    };
+    thread_pool_parallel_for(pool, header.count, 1, local_task, &local);
+    double t1 = now_us();
+
+    MPI_Datatype row_type;
+    MPI_Type_contiguous(header.k, dk.result_type, &row_type);
+    MPI_Type_commit(&row_type);
+    MPI_Reduce(local.rows, merged, header.count, row_type, dk.merge_op, root, dk.comm);
+    MPI_Type_free(&row_type);
+
+    if (is_root) {
+        dk.local_us += t1 - t0;
+        dk.merge_us += now_us() - t1;
+    } else {
+        free(payload);
+    }
+    for (int w = 0; w < workers; w++) hnsw_scratch_free(&local.scratch[w]);
+    free(local.scratch);
+    free(local.rows);
+}
+
+static int handle_join(int source, const uint8_t *req, int length, uint8_t *reply, int cap) {
+    (void)req; (void)length; (void)reply; (void)cap;
+    if (!dk.ready) return -1;
+    run_collective(source, (dknn_header_t){ 0, 0 }, NULL, NULL);
+    return 0;
+}
+
+int distributed_knn_start(void) {
+    if (mpi_thread_level < MPI_THREAD_MULTIPLE) {
+        if (transport_rank() == 0) {
+            fprintf(stderr, "[DKNN] MPI thread support too low (%d), need MPI_THREAD_MULTIPLE\n",
+                    mpi_thread_level);
+        }
+        return -1;
+    }
+    MPI_Comm_dup(MPI_COMM_WORLD, &dk.comm);
+
+    int lengths[3] = { 1, 1, 1 };
+    MPI_Aint offsets[3] = {
+        offsetof(similarity_result_t, node_id),
+        offsetof(similarity_result_t, similarity),
+        offsetof(similarity_result_t, combined_score),
+    };
+    MPI_Datatype types[3] = { MPI_INT, MPI_DOUBLE, MPI_DOUBLE };
+    MPI_Datatype packed;
+    MPI_Type_create_struct(3, lengths, offsets, types, &packed);
+    MPI_Type_create_resized(packed, 0, sizeof(similarity_result_t), &dk.result_type);
+    MPI_Type_free(&packed);
+    MPI_Type_commit(&dk.result_type);
+    MPI_Op_create(merge_rows, 1, &dk.merge_op);
+
+    partition_register_handler(PARTITION_OP_KNN_COLLECTIVE, handle_join);
+    dk.ready = 1;
+    return 0;
+}
+
+void distributed_knn_stop(void) {
+    if (!dk.ready) return;
+    partition_register_handler(PARTITION_OP_KNN_COLLECTIVE, NULL);
+    MPI_Op_free(&dk.merge_op);
+    MPI_Type_free(&dk.result_type);
+    MPI_Comm_free(&dk.comm);
+    dk.ready = 0;
+}
+
+int distributed_knn_ready(void) {
+    return dk.ready;
+}
+
+int distributed_knn_vectors(const double *vectors, const double *coherence, const int *exclude,
+                            int count, int k, similarity_result_t *out, int *counts) {
+    if (!dk.ready || count <= 0 || k <= 0) return -1;
+    int stride = vector_dim + 2;
+    double *payload = malloc(sizeof(double) * (size_t)DKNN_MAX_BATCH * stride);
+    int found = 0;
+
+    for (int first = 0; first < count; first += DKNN_MAX_BATCH) {
+        int n = count - first < DKNN_MAX_BATCH ? count - first : DKNN_MAX_BATCH;
+        for (int q = 0; q < n; q++) {
+            double *row = payload + (size_t)q * stride;
+            memcpy(row, vectors + (size_t)(first + q) * vector_dim, sizeof(double) * vector_dim);
+            row[vector_dim] = coherence[first + q];
+            row[vector_dim + 1] = exclude ? exclude[first + q] : -1;
+        }
+
+        for (int r = 0; r < partition.size; r++) {
+            if (r != partition.rank) partition_post(r, PARTITION_OP_KNN_COLLECTIVE, NULL, 0);
+        }
+        transport_flush();
+        run_collective(partition.rank, (dknn_header_t){ n, k }, payload, out + (size_t)first * k);
+
+        for (int q = first; q < first + n; q++) {
+            int c = 0;
+            while (c < k && out[(size_t)q * k + c].node_id >= 0) c++;
+            if (counts) counts[q] = c;
+            found += c;
+        }
+    }
+    free(payload);
+    return found;
+}
+
+int distributed_knn(const int *node_ids, int count, int k, similarity_result_t *out, int *counts) {
+    if (!dk.ready || count <= 0 || k <= 0) return -1;
+    double *vectors = malloc(sizeof(double) * (size_t)count * vector_dim);
+    double *coherence = malloc(sizeof(double) * count);
+    int found = 0;
+    for (int q = 0; q < count && found == 0; q++) {
+        if (partition_fetch_node(node_ids[q], vectors + (size_t)q * vector_dim, NULL, &coherence[q]) < 0) {
+            found = -1;
+        }
+    }
+    if (found == 0) found = distributed_knn_vectors(vectors, coherence, node_ids, count, k, out, counts);
+    free(vectors);
+    free(coherence);
+    return found;
+}
+
+void distributed_knn_bench(int queries, int k, int batch) {
+    if (!dk.ready) {
+        printf("[DKNN] Not available\n");
+        return;
+    }
+    if (queries <= 0) queries = 1024;
+    if (k <= 0) k = 10;
+    if (batch <= 0 || batch > DKNN_MAX_BATCH) batch = DKNN_MAX_BATCH;
+
+    int *ids = malloc(sizeof(int) * queries);
+    for (int q = 0; q < queries; q++) ids[q] = rand() % total_nodes;
+    similarity_result_t *out = malloc(sizeof(similarity_result_t) * (size_t)batch * k);
+    double *vectors = malloc(sizeof(double) * (size_t)queries * vector_dim);
+    double *coherence = malloc(sizeof(double) * queries);
+    for (int q = 0; q < queries; q++) {
+        partition_fetch_node(ids[q], vectors + (size_t)q * vector_dim, NULL, &coherence[q]);
+    }
+
+    dk.local_us = dk.merge_us = 0.0;
+    double start = now_us();
+    int collectives = 0;
+    for (int first = 0; first < queries; first += batch) {
+        int n = queries - first < batch ? queries - first : batch;
+        distributed_knn_vectors(vectors + (size_t)first * vector_dim, coherence + first, ids + first,
+                                n, k, out, NULL);
+        collectives++;
+    }
+    double elapsed = now_us() - start;
+
+    printf("[DKNN] np=%d nodes=%d (%d/rank) k=%d batch=%d: %.0f queries/s | %.1f us/collective "
+           "(local %.1f, merge %.1f)\n",
+           partition.size, total_nodes, partition.owned, k, batch,
+           queries / (elapsed / 1e6), elapsed / collectives,
+           dk.local_us / collectives, dk.merge_us / collectives);
+
+    free(ids);
+    free(out);
+    free(vectors);
+    free(coherence);
+}
@@ -10,87 +10,545 @@
 
 #include "parity_types.h"
 #include "distribution_policy.h"
+#include "fault_recovery.h"
+#include "journal.h"
+#include "parity_distribution.h"
 #include "routing.h"
+#include "parity_index.h"
+#include "parity_broadcast.h"
+#include "partition.h"
+#include "tag_intern.h"
+#include "thread_pool.h"
+#include "topology.h"
+#include <stdatomic.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <math.h>
+#include <time.h>
+#include <unistd.h>
 
-void recover_parity_tag(const char *tag) {
-    printf("[RECOVERY] Triggering recovery for parity: %s\n", tag);
+#define RECOVERY_GRAIN 32   // tags per planning task
 
-    // Step 1: Find all surviving holders
-    int *holders = find_nodes_with_parity(tag);
-    int count = 0;
-    while (holders[count] != -1) count++;
-    if (count == 0) {
-        printf("[ERROR] No surviving copies for parity '%s'\n", tag);
-        return;
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+// ---- Transfer pacing ------------------------------------------------------
+
+static struct {
+    double rate;        // tokens per second; <= 0 means unpaced
+    double burst;
+    double tokens;
+    double last_us;
+} bucket = { RECOVERY_DEFAULT_RATE, RECOVERY_DEFAULT_BURST, RECOVERY_DEFAULT_BURST, 0.0 };
+
+void recovery_set_rate(double per_second, int burst) {
+    bucket.rate = per_second;
+    bucket.burst = burst > 0 ? burst : RECOVERY_DEFAULT_BURST;
+    bucket.tokens = bucket.burst;
+    bucket.last_us = 0.0;
+}
+
+static void refill(double now) {
+    if (bucket.last_us > 0.0) {
+        bucket.tokens += (now - bucket.last_us) / 1e6 * bucket.rate;
+        if (bucket.tokens > bucket.burst) bucket.tokens = bucket.burst;
+    }
+    bucket.last_us = now;
+}
+
+// Takes n tokens, serving requests while it waits; a request larger than
+// the burst waits for a full bucket and leaves it in debt. Returns the
+// microseconds spent waiting.
+static double take_tokens(int n) {
+    if (bucket.rate <= 0.0) return 0.0;
+    double start = now_us();
+    refill(start);
+    double want = n < bucket.burst ? n : bucket.burst;
+    while (bucket.tokens < want) {
+        if (partition_poll() == 0) usleep(100);
+        refill(now_us());
     }
+    bucket.tokens -= n;
+    return now_us() - start;
+}
+
+// ---- Planning -------------------------------------------------------------
 
-    // Step 2: Build minimal recovery tree
-    parity_tree_evaluation_t *tree = build_recovery_tree_from_holders(holders, count);
+typedef struct {
+    int node_id;
+    double score;
+} candidate_t;
 
-    // Step 3: Evaluate tree for optimal new placement
-    int *recovery_targets = evaluate_recovery_tree_efficient(tree);
+typedef struct {
+    uint32_t *seen;     // stamp per node, allocated on the worker's first tag
+    uint32_t stamp;
+    int *queue;
+    int *root;          // per queue entry: the survivor it was reached from
+    candidate_t candidates[RECOVERY_CANDIDATES];
+} recovery_scratch_t;
 
-    // Step 4: Copy parity to targets
-    for (int i = 0; i < tree->policy->min_replicas; i++) {
-        int target = recovery_targets[i];
-        assign_parity_tag(target, tag);
-        printf("[RECOVERY] Restored parity '%s' to node %d\n", tag, target);
+typedef struct {
+    const williams_distribution_policy_t *policy;
+    const parity_tag_id_t *tags;
+    int count;
+    int k;
+    const double *scores;       // placement scores, -INFINITY at the cap
+    const int *load;
+    const uint8_t *failed;
+    atomic_int *reserved;       // replicas promised to each node by this plan
+    int cap;
+    double penalty;             // score lost per promised replica
+    int *targets;               // count rows of k, padded with -1
+    int *sources;               // nearest surviving holder of each target
+    uint8_t *lost;
+    recovery_scratch_t *scratch;
+} recovery_plan_t;
+
+static int candidate_before(const candidate_t *a, const candidate_t *b) {
+    return a->score > b->score || (a->score == b->score && a->node_id < b->node_id);
+}
+
+// Fills row with up to k - survivors targets for one tag; returns how many.
+static int plan_tag(recovery_plan_t *p, int t, recovery_scratch_t *s) {
+    int *row = p->targets + (size_t)t * p->k;
+    int *sources = p->sources + (size_t)t * p->k;
+    for (int i = 0; i < p->k; i++) row[i] = sources[i] = -1;
+    parity_holder_view_t holders = parity_index_lookup(p->tags[t]);
+    if (holders.count == 0) {
+        p->lost[t] = 1;
+        return 0;
     }
+    int need = p->k - holders.count;
+    if (need <= 0) return 0;
 
-    // Step 5: Broadcast update
-    for (int i = 0; i < tree->policy->min_replicas; i++) {
-        announce_parity_holdings(recovery_targets[i]);
+    int n = topology.nodes;
+    if (!s->seen) {
+        s->seen = calloc(n, sizeof(uint32_t));
+        s->queue = malloc(sizeof(int) * n);
+        s->root = malloc(sizeof(int) * n);
+    }
+    if (++s->stamp == 0) {
+        memset(s->seen, 0, sizeof(uint32_t) * n);
+        s->stamp = 1;
     }
 
-    free(holders);
-    free(recovery_targets);
-    free(tree);
+    // Multi-source BFS from the survivors, nearest levels first.
+    int head = 0, tail = 0, found = 0;
+    for (int i = 0; i < holders.count; i++) {
+        int h = holders.holders[i];
+        if (h < 0 || h >= n || s->seen[h] == s->stamp) continue;
+        s->seen[h] = s->stamp;
+        s->root[tail] = h;
+        s->queue[tail++] = h;
+    }
+    int origin[RECOVERY_CANDIDATES];
+    for (int depth = 1; depth <= RECOVERY_MAX_HOPS && head < tail && found < RECOVERY_CANDIDATES; depth++) {
+        int level_end = tail;
+        double proximity = p->policy->rtt_weight / (1 + depth);
+        for (; head < level_end && found < RECOVERY_CANDIDATES; head++) {
+            int v = s->queue[head];
+            const int *neighbors = topology_neighbors(&topology, v);
+            for (int e = 0; e < topology_degree(&topology, v) && found < RECOVERY_CANDIDATES; e++) {
+                int u = neighbors[e];
+                if (s->seen[u] == s->stamp) continue;
+                s->seen[u] = s->stamp;
+                s->root[tail] = s->root[head];
+                s->queue[tail++] = u;
+                if (p->failed[u] || p->scores[u] == -INFINITY) continue;
+                double score = p->scores[u] + proximity -
+                               p->penalty * atomic_load_explicit(&p->reserved[u], memory_order_relaxed);
+                s->candidates[found] = (candidate_t){ u, score };
+                origin[found++] = s->root[head];
+            }
+        }
+    }
+
+    // Best first; origins travel with their candidates.
+    for (int i = 1; i < found; i++) {
+        candidate_t c = s->candidates[i];
+        int o = origin[i], j = i;
+        while (j > 0 && candidate_before(&c, &s->candidates[j - 1])) {
+            s->candidates[j] = s->candidates[j - 1];
+            origin[j] = origin[j - 1];
+            j--;
+        }
+        s->candidates[j] = c;
+        origin[j] = o;
+    }
+
+    int got = 0;
+    for (int i = 0; i < found && got < need; i++) {
+        int u = s->candidates[i].node_id;
+        int promised = atomic_fetch_add(&p->reserved[u], 1);
+        if (p->load[u] + promised >= p->cap) {
+            atomic_fetch_sub(&p->reserved[u], 1);
+            continue;
+        }
+        row[got] = u;
+        sources[got++] = origin[i];
+    }
+    return got;
 }
 
-int* find_nodes_with_parity(const char *tag) {
-    int *results = malloc(sizeof(int) * total_nodes);
-    int count = 0;
-    for (int i = 0; i < total_nodes; i++) {
-        for (int j = 0; j < network[i].parity_count; j++) {
-            if (strcmp(network[i].parity_tags[j], tag) == 0) {
-                results[count++] = i;
-                break;
+static void plan_task(void *ctx, int begin, int end, int worker) {
+    recovery_plan_t *p = ctx;
+    for (int t = begin; t < end; t++) plan_tag(p, t, &p->scratch[worker]);
+}
+
+static int compare_tags(const void *a, const void *b) {
+    parity_tag_id_t x = *(const parity_tag_id_t *)a, y = *(const parity_tag_id_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+// Re-replicates tags (sorted, unique) away from the failed nodes.
+static int recover_tags(const parity_tag_id_t *tags, int count, const uint8_t *failed,
+                        const williams_distribution_policy_t *policy, recovery_stats_t *stats) {
+    int k = policy->min_replicas;
+    int n = topology.nodes;
+    stats->affected_tags = count;
+    if (count == 0 || k <= 0) return 0;
+
+    double t0 = now_us();
+    thread_pool_t *pool = thread_pool_default();
+    int workers = thread_pool_size(pool);
+    recovery_plan_t plan = {
+        .policy = policy,
+        .tags = tags,
+        .count = count,
+        .k = k,
+        .scores = placement_scores(policy),
+        .load = placement_graph()->load,
+        .failed = failed,
+        .reserved = calloc(n, sizeof(atomic_int)),
+        .cap = placement_load_cap(policy),
+        .penalty = policy->load_balance_weight / MAX_PARITY_TAGS,
+        .targets = malloc(sizeof(int) * (size_t)count * k),
+        .sources = malloc(sizeof(int) * (size_t)count * k),
+        .lost = calloc(count, 1),
+        .scratch = calloc(workers, sizeof(recovery_scratch_t)),
+    };
+    thread_pool_parallel_for(pool, count, RECOVERY_GRAIN, plan_task, &plan);
+
+    // Group by target so each node takes its replicas in one request.
+    int *offsets = calloc(n + 1, sizeof(int));
+    for (int t = 0; t < count; t++) {
+        parity_holder_view_t holders = parity_index_lookup(tags[t]);
+        if (!plan.lost[t] && holders.count < k) stats->replicas_needed += k - holders.count;
+        stats->lost_tags += plan.lost[t];
+        const int *row = plan.targets + (size_t)t * k;
+        for (int i = 0; i < k && row[i] >= 0; i++) offsets[row[i] + 1]++;
+    }
+    for (int v = 0; v < n; v++) offsets[v + 1] += offsets[v];
+    int placed = offsets[n];
+    parity_tag_id_t *by_node = malloc(sizeof(parity_tag_id_t) * (placed > 0 ? placed : 1));
+    int *fill = malloc(sizeof(int) * (n > 0 ? n : 1));
+    memcpy(fill, offsets, sizeof(int) * n);
+    for (int t = 0; t < count; t++) {
+        const int *row = plan.targets + (size_t)t * k;
+        for (int i = 0; i < k && row[i] >= 0; i++) by_node[fill[row[i]]++] = tags[t];
+    }
+    double t1 = now_us();
+
+    for (int v = 0; v < n; v++) {
+        int received = offsets[v + 1] - offsets[v];
+        if (received == 0) continue;
+        stats->throttled_ms += take_tokens(received) / 1e3;
+        assign_parity_tag_batch(v, by_node + offsets[v], received);
+        stats->target_nodes++;
+    }
+    double t2 = now_us();
+
+    stats->replicas_placed = placed;
+    stats->plan_ms = (t1 - t0) / 1e3;
+    stats->transfer_ms = (t2 - t1) / 1e3;
+    if (count == 1) {
+        for (int i = 0; i < k && plan.targets[i] >= 0; i++) {
+            printf("[RECOVERY] Restored parity '%s' to node %d (from node %d)\n", tag_name(tags[0]),
+                   plan.targets[i], plan.sources[i]);
+        }
+    }
+
+    for (int w = 0; w < workers; w++) {
+        free(plan.scratch[w].seen);
+        free(plan.scratch[w].queue);
+        free(plan.scratch[w].root);
+    }
+    free(plan.scratch);
+    free(plan.reserved);
+    free(plan.targets);
+    free(plan.sources);
+    free(plan.lost);
+    free(offsets);
+    free(by_node);
+    free(fill);
+    return placed;
+}
+
+int recover_failed_nodes(const int *failed, int count, const williams_distribution_policy_t *policy,
+                         recovery_stats_t *stats) {
+    recovery_stats_t local;
+    if (!stats) stats = &local;
+    memset(stats, 0, sizeof(*stats));
+    // Owned nodes cannot drop their tags once the journal has failed.
+    if (journal_failed()) {
+        printf("[RECOVERY] Journal failed; not recovering %d nodes\n", count);
+        return -1;
+    }
+    int n = topology.nodes;
+    uint8_t *mark = calloc(n > 0 ? n : 1, 1);
+
+    // Everything the failed nodes held, copied out before they are
+    // dropped from the index.
+    parity_tag_id_t *tags = NULL;
+    int tag_count = 0, capacity = 0;
+    for (int i = 0; i < count; i++) {
+        int f = failed[i];
+        if (f < 0 || f >= n || mark[f]) continue;
+        mark[f] = 1;
+        stats->failed_nodes++;
+        int held;
+        const parity_tag_id_t *node_tags = parity_index_node_tags(f, &held);
+        if (tag_count + held > capacity) {
+            while (tag_count + held > capacity) capacity = capacity ? capacity * 2 : 256;
+            tags = realloc(tags, sizeof(parity_tag_id_t) * capacity);
+        }
+        memcpy(tags + tag_count, node_tags, sizeof(parity_tag_id_t) * held);
+        tag_count += held;
+    }
+    for (int f = 0; f < n; f++) {
+        if (!mark[f]) continue;
+        // The owner drops the tags and announces the node empty, which
+        // clears it from every rank's index; this rank's copy goes at once
+        // so the plan below already sees it.
+        if (partition_owns(f)) {
+            TorusNode *node = node_ref(f);
+            while (node->parity_count > 0) {
+                if (remove_parity_tag_id(f, node->parity_tags[0]) < 0) {
+                    // The journal failed mid-way; nothing more can be removed.
+                    free(tags);
+                    free(mark);
+                    return -1;
+                }
             }
+        } else {
+            int held;
+            const parity_tag_id_t *node_tags = parity_index_node_tags(f, &held);
+            for (int i = 0; i < held; i++) parity_forward_tag_change(f, node_tags[i], 1);
         }
+        announce_parity_holdings(f);
+        parity_index_set_node_tags(f, NULL, 0);
+    }
+    if (tag_count > 0) qsort(tags, tag_count, sizeof(parity_tag_id_t), compare_tags);
+    int unique = 0;
+    for (int i = 0; i < tag_count; i++) {
+        if (unique == 0 || tags[i] != tags[unique - 1]) tags[unique++] = tags[i];
+    }
+
+    int placed = recover_tags(tags, unique, mark, policy, stats);
+    free(tags);
+    free(mark);
+    return placed;
+}
+
+void recovery_report(const recovery_stats_t *stats) {
+    double total = stats->plan_ms + stats->transfer_ms;
+    printf("[RECOVERY] %d failed nodes: %d tags affected, %d lost | %d of %d replicas to %d nodes\n",
+           stats->failed_nodes, stats->affected_tags, stats->lost_tags, stats->replicas_placed,
+           stats->replicas_needed, stats->target_nodes);
+    printf("[RECOVERY] plan %.1f ms, transfer %.1f ms (throttled %.1f ms) | %.0f tags/s\n",
+           stats->plan_ms, stats->transfer_ms, stats->throttled_ms,
+           total > 0 ? stats->affected_tags / (total / 1e3) : 0.0);
+}
+
+void recover_parity_tag_id(parity_tag_id_t tag_id) {
+    const char *tag = tag_name(tag_id);
+    printf("[RECOVERY] Triggering recovery for parity: %s\n", tag);
+    if (parity_index_lookup(tag_id).count == 0) {
+        printf("[ERROR] No surviving copies for parity '%s'\n", tag);
+        return;
+    }
+    uint8_t *none = calloc(topology.nodes > 0 ? topology.nodes : 1, 1);
+    recovery_stats_t stats = { 0 };
+    recover_tags(&tag_id, 1, none, &default_williams_policy, &stats);
+    free(none);
+}
+
+void recover_parity_tag(const char *tag) {
+    parity_tag_id_t tag_id = tag_lookup(tag);
+    if (tag_id == PARITY_TAG_INVALID) {
+        printf("[ERROR] No surviving copies for parity '%s'\n", tag);
+        return;
     }
-    results[count] = -1;
+    recover_parity_tag_id(tag_id);
+}
+
+int* find_nodes_with_parity(const char *tag) {
+    parity_holder_view_t view = parity_index_lookup(tag_lookup(tag));
+    int *results = malloc(sizeof(int) * (view.count + 1));
+    memcpy(results, view.holders, sizeof(int) * view.count);
+    results[view.count] = -1;
     return results;
 }
 
-parity_tree_evaluation_t* build_recovery_tree_from_holders(int *holders, int count) {
-    parity_tree_evaluation_t *tree = malloc(sizeof(parity_tree_evaluation_t));
-    tree->height = log2(count);
-    tree->fanout = 2;
-    tree->tree_nodes = malloc(sizeof(parity_node_t*) * count);
+// What the holder index says every node holds, as offsets into one array.
+typedef struct {
+    int *offsets;
+    parity_tag_id_t *tags;
+} holdings_t;
+
+static void holdings_save(holdings_t *h) {
+    int n = topology.nodes;
+    h->offsets = malloc(sizeof(int) * (n + 1));
+    h->offsets[0] = 0;
+    for (int v = 0; v < n; v++) h->offsets[v + 1] = h->offsets[v] + parity_index_node_count(v);
+    h->tags = malloc(sizeof(parity_tag_id_t) * (h->offsets[n] > 0 ? h->offsets[n] : 1));
+    for (int v = 0; v < n; v++) {
+        int held;
+        const parity_tag_id_t *node_tags = parity_index_node_tags(v, &held);
+        memcpy(h->tags + h->offsets[v], node_tags, sizeof(parity_tag_id_t) * held);
+    }
+}
+
+static int contains_tag(const parity_tag_id_t *tags, int count, parity_tag_id_t tag) {
     for (int i = 0; i < count; i++) {
-        tree->tree_nodes[i] = &network[holders[i]];
+        if (tags[i] == tag) return 1;
     }
-    tree->eval_function = NULL;
-    tree->policy = &default_williams_policy;
-    return tree;
+    return 0;
 }
 
-int* evaluate_recovery_tree_efficient(parity_tree_evaluation_t *tree) {
-    int *targets = malloc(sizeof(int) * tree->policy->min_replicas);
-    for (int i = 0; i < tree->policy->min_replicas; i++) {
-        targets[i] = tree->tree_nodes[i % tree->fanout]->id;
+// Puts every node back to its saved tags: drops what it gained, re-adds
+// what it lost, and announces each node that changed. Returns how many did.
+static int holdings_restore(const holdings_t *h) {
+    int restored = 0;
+    for (int v = 0; v < topology.nodes; v++) {
+        const parity_tag_id_t *saved = h->tags + h->offsets[v];
+        int saved_count = h->offsets[v + 1] - h->offsets[v];
+        int held;
+        const parity_tag_id_t *view = parity_index_node_tags(v, &held);
+        parity_tag_id_t current[MAX_PARITY_TAGS];
+        if (held > MAX_PARITY_TAGS) held = MAX_PARITY_TAGS;
+        memcpy(current, view, sizeof(parity_tag_id_t) * held);
+
+        int removed = 0;
+        for (int i = 0; i < held; i++) {
+            if (contains_tag(saved, saved_count, current[i])) continue;
+            remove_parity_tag_id(v, current[i]);
+            removed++;
+        }
+        parity_tag_id_t missing[MAX_PARITY_TAGS];
+        int missing_count = 0;
+        for (int i = 0; i < saved_count && missing_count < MAX_PARITY_TAGS; i++) {
+            if (!contains_tag(current, held, saved[i])) missing[missing_count++] = saved[i];
+        }
+        if (missing_count > 0) {
+            assign_parity_tag_batch(v, missing, missing_count);
+        } else if (removed > 0) {
+            announce_parity_holdings(v);
+        }
+        restored += missing_count > 0 || removed > 0;
     }
-    return targets;
+    return restored;
 }
 
-void assign_parity_tag(int node_id, const char *tag) {
-    TorusNode *node = &network[node_id];
+void recovery_bench(int tags, int max_failed) {
+    if (tags <= 0) tags = 10000;
+    if (max_failed <= 0) max_failed = 64;
+    williams_distribution_policy_t policy = default_williams_policy;
+    int k = policy.min_replicas;
+
+    // The rounds strip real tags from the failed racks and leave bench tags
+    // and extra replicas behind; the network goes back to this afterwards.
+    holdings_t before;
+    holdings_save(&before);
+
+    char (*names)[MAX_TAG_LENGTH + 1] = malloc(sizeof(*names) * tags);
+    const char **list = malloc(sizeof(char *) * tags);
+    for (int i = 0; i < tags; i++) {
+        snprintf(names[i], sizeof(names[i]), "recovery-bench-%d", i);
+        list[i] = names[i];
+    }
+    int *placements = malloc(sizeof(int) * (size_t)tags * k);
+    distribute_parity_batch(list, tags, k, &policy, placements, NULL);
+    for (int i = 0; i < 200; i++) {
+        if (parity_broadcast_poll() == 0) usleep(1000);
+    }
+
+    printf("[RECOVERY] %d nodes, %d bench tags x %d replicas, %d threads\n", topology.nodes, tags, k,
+           thread_pool_size(thread_pool_default()));
+    printf("[RECOVERY] %8s %10s %8s %10s %10s %10s %12s\n", "failed", "tags lost", "unrec.",
+           "replicas", "plan ms", "total ms", "tags/s");
+    int *failed = malloc(sizeof(int) * max_failed);
+    for (int f = 1; f <= max_failed && f <= topology.nodes; f *= 2) {
+        int start = rand() % topology.nodes;
+        for (int i = 0; i < f; i++) failed[i] = (start + i) % topology.nodes;
+        recovery_stats_t stats;
+        if (recover_failed_nodes(failed, f, &policy, &stats) < 0) break;
+        double total = stats.plan_ms + stats.transfer_ms;
+        printf("[RECOVERY] %8d %10d %8d %10d %10.2f %10.2f %12.0f\n", f, stats.affected_tags,
+               stats.lost_tags, stats.replicas_placed, stats.plan_ms, total,
+               total > 0 ? stats.affected_tags / (total / 1e3) : 0.0);
+        for (int i = 0; i < 20; i++) parity_broadcast_poll();
+    }
+    free(failed);
+
+    for (int i = 0; i < 200; i++) {
+        if (parity_broadcast_poll() == 0) usleep(1000);
+    }
+    printf("[RECOVERY] Restored the holdings of %d nodes\n", holdings_restore(&before));
+    free(before.offsets);
+    free(before.tags);
+    free(names);
+    free(list);
+    free(placements);
+}
+
+int assign_parity_tag_id(int node_id, parity_tag_id_t tag_id) {
+    if (tag_id == PARITY_TAG_INVALID) return -1;
+    if (!partition_owns(node_id)) {
+        parity_forward_tag_change(node_id, tag_id, 0);
+        return 0;
+    }
+    if (journal_failed()) return -1;
+    TorusNode *node = node_ref(node_id);
+    for (int i = 0; i < node->parity_count; i++) {
+        if (node->parity_tags[i] == tag_id) return 0;
+    }
     if (node->parity_count < MAX_PARITY_TAGS) {
-        node->parity_tags[node->parity_count] = strdup(tag);
+        node->parity_tags[node->parity_count] = tag_id;
         node->parity_count++;
+        parity_index_add(tag_id, node_id);
+        return parity_record_change(node_id, tag_id, 0);
+    }
+    return 0;
+}
+
+int remove_parity_tag_id(int node_id, parity_tag_id_t tag_id) {
+    if (tag_id == PARITY_TAG_INVALID) return -1;
+    if (!partition_owns(node_id)) {
+        parity_forward_tag_change(node_id, tag_id, 1);
+        return 0;
+    }
+    if (journal_failed()) return -1;
+    TorusNode *node = node_ref(node_id);
+    for (int i = 0; i < node->parity_count; i++) {
+        if (node->parity_tags[i] == tag_id) {
+            node->parity_tags[i] = node->parity_tags[--node->parity_count];
+            parity_index_remove(tag_id, node_id);
+            return parity_record_change(node_id, tag_id, 1);
+        }
     }
+    return 0;
+}
+
+void assign_parity_tag(int node_id, const char *tag) {
+    assign_parity_tag_id(node_id, tag_intern(tag));
+}
+
+void remove_parity_tag(int node_id, const char *tag) {
+    parity_tag_id_t tag_id = tag_lookup(tag);
+    if (tag_id != PARITY_TAG_INVALID) remove_parity_tag_id(node_id, tag_id);
 }
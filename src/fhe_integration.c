@@ -9,6 +9,7 @@
  */
 
 #include "fhe_stub.h"
+#include "node_store.h"
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -43,5 +44,5 @@ fhe_ciphertext_t fhe_mul(fhe_ciphertext_t a, double scalar) {
 }
 
 void attach_encrypted_density(TorusNode *n) {
-    n->encrypted_density = fhe_encrypt(n->density);
+    n->encrypted_density = fhe_encrypt(node_hot.density[node_slot(n)]);
 }
@@ -6,6 +6,7 @@
  * 2. Commercial license available - contact michael.doran.808@gmail.com
  */
 
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -14,80 +15,277 @@
 #include <mpi.h>
 #include "fractal.h"
 #include "ann.h"
+#include "distance_field.h"
+#include "distributed_knn.h"
+#include "hnsw.h"
+#include "journal.h"
 #include "memory_guard.h"
+#include "node_store.h"
 #include "routing.h"
 #include "parity_types.h"
 #include "parity_distribution.h"
 #include "parity_broadcast.h"
 #include "fhe_stub.h"
 #include "merkle.h"
+#include "merkle_sync.h"
+#include "partition.h"
+#include "snapshot.h"
+#include "topology.h"
+#include "transport.h"
 
 TorusNode *network;
 int total_nodes;
+int vector_dim = DEFAULT_VECTOR_DIM;
 int world_rank;
 int world_size;
+int mpi_thread_level;
 int running = 1;
 
+#define DEFAULT_TOPOLOGY "fractal"
+
 pthread_t daemon_thread;
+int daemon_started = 0;
 
-// Initialization routine for nodes
-void initialize_network(int count, int dim) {
+static snapshot_t *restored_snapshot;   // backs node_hot, the vector store and topology when set
+
+// Sizes and splits the network and registers the request handlers, before
+// any node exists.
+static void init_network_state(int count, int dim) {
     total_nodes = count;
-    network = SAFE_MALLOC(sizeof(TorusNode) * count);
-    for (int i = 0; i < count; i++) {
-        network[i].id = i;
-        network[i].density = drand48();
-        network[i].coherence = drand48();
-        network[i].vector = SAFE_MALLOC(sizeof(double) * dim);
+    vector_dim = dim;
+    partition_init(count);
+    parity_broadcast_init();
+    merkle_sync_init();
+    snapshot_init();
+    routing_init();
+}
+
+// Initialization routine for nodes. Each rank allocates only the nodes it
+// owns (partition.h); total_nodes stays the size of the whole network.
+void initialize_network(int count, int dim) {
+    init_network_state(count, dim);
+
+    int owned = partition.owned;
+    network = SAFE_MALLOC(sizeof(TorusNode) * (owned > 0 ? owned : 1));
+    node_store_init(owned, dim);
+    ann_attach_vector_store(vector_store_create(owned, dim));
+    ann_attach_index(hnsw_create(owned, dim, HNSW_DEFAULT_M, HNSW_DEFAULT_EF_CONSTRUCTION));
+    for (int i = 0; i < owned; i++) {
+        int id = partition.first + i;
+        network[i].id = id;
+        node_hot.density[i] = drand48();
+        node_hot.coherence[i] = drand48();
         randomize_vector(&network[i], dim, 1.0);
-        network[i].neighbor_count = 0;
         network[i].parity_count = 0;
+        network[i].parity_version = 0;
+        network[i].change_log = NULL;
+        network[i].known_parity_map = SAFE_MALLOC(sizeof(parity_announcement_t) * MAX_PARITY_TAGS);
+        network[i].map_size = 0;
         network[i].replication_factor = 3;
-        sprintf(network[i].hash, "node%dhash", i);
+        sprintf(network[i].hash, "node%dhash", id);
     }
 }
 
-void connect_neighbors(int id, int fanout) {
-    TorusNode *node = &network[id];
-    for (int i = 0; i < fanout; i++) {
-        int neighbor = (id + i + 1) % total_nodes;
-        node->neighbors[node->neighbor_count++] = neighbor;
+// Collective: shard, build the topology (the same on every rank) and the
+// ghosts it implies, join the k-NN group.
+static int setup_network(int count, int dim, const char *shape) {
+    if (count <= 0 || topology_build_named(&topology, shape, count) != 0) {
+        if (world_rank == 0) fprintf(stderr, "[ERROR] Bad network size %d or topology '%s'\n", count, shape);
+        return -1;
+    }
+    initialize_network(count, dim);
+    partition_build_ghosts();
+    partition_measure_link_weights(&topology, 0);
+    distance_field_init(&topology);
+    distributed_knn_start();
+    return 0;
+}
+
+// Collective like setup_network, but each rank maps its shard, topology
+// and state from <prefix>.<rank> (snapshot.h) instead of building them,
+// then replays its journal on top and keeps journaling (journal.h).
+static int restore_network(const char *prefix, int verify, const journal_config_t *journal) {
+    char path[PATH_MAX];
+    snapshot_path(prefix, world_rank, path, sizeof(path));
+    double start = MPI_Wtime();
+    snapshot_t *snap = snapshot_open(path);
+    int ok = snap != NULL;
+    if (ok) {
+        init_network_state(snap->header->total_nodes, snap->header->vector_dim);
+        ok = snapshot_restore(snap) == 0;
     }
+    double mapped = MPI_Wtime();
+    if (ok && verify) {
+        printf("[SNAPSHOT] Rank %d Merkle root %s the snapshot's\n", world_rank,
+               snapshot_verify(snap) ? "matches" : "DIFFERS from");
+    }
+    journal_replay_stats_t replayed;
+    if (ok) ok = journal_recover(prefix, snap->header->journal_lsn, journal, &replayed) == 0;
+    // A rank missing its file must not leave the others in the collective
+    // steps below. The transport is running, so the vote goes through it.
+    if (!transport_agree(ok)) {
+        if (world_rank == 0) fprintf(stderr, "[ERROR] Cannot restore from %s.*\n", prefix);
+        return -1;
+    }
+    restored_snapshot = snap;
+    partition_build_ghosts();
+    partition_measure_link_weights(&topology, 0);   // this run's links, not the snapshot's
+    placement_graph_invalidate();
+    // The snapshot seeded the parity index with this rank's own holders
+    // only. Everyone announces theirs, and once the agreement says all of
+    // it has arrived one poll applies it, before anything places or routes.
+    int announced = announce_owned_holdings();
+    transport_agree(1);
+    parity_broadcast_poll();
+    distance_field_init(&topology);
+    distributed_knn_start();
+    printf("[SNAPSHOT] Rank %d restored %d nodes (%.1f MB mapped) in %.2f ms, %.2f ms with ghosts and routing\n",
+           world_rank, partition.owned, snap->bytes / 1e6, (mapped - start) * 1e3,
+           (MPI_Wtime() - start) * 1e3);
+    printf("[SNAPSHOT] Rank %d announced %d nodes holding parity\n", world_rank, announced);
+    printf("[JOURNAL] Rank %d replayed %lld of %lld records in %.2f ms (%lld torn bytes dropped); journaling (%s)\n",
+           world_rank, replayed.applied, replayed.records, replayed.elapsed_ms, replayed.torn_bytes,
+           journal_sync_name(journal->sync));
+    return 0;
 }
 
 void graceful_shutdown() {
     running = 0;
-    pthread_join(daemon_thread, NULL);
-    for (int i = 0; i < total_nodes; i++) {
-        SAFE_FREE(network[i].vector);
+    if (daemon_started) pthread_join(daemon_thread, NULL);
+    if (world_rank == 0) partition_shutdown_peers();
+    journal_close();
+    for (int i = 0; i < partition.owned + partition.ghost_count; i++) {
+        if (network[i].known_parity_map) SAFE_FREE(network[i].known_parity_map);   // ghosts have none
+        free(network[i].change_log);
     }
     SAFE_FREE(network);
+    node_store_free();
+    hnsw_free(ann_get_index());
+    ann_attach_index(NULL);
+    vector_store_free(ann_get_vector_store());
+    ann_attach_vector_store(NULL);
+    distributed_knn_stop();
+    distance_field_free();
+    placement_graph_free();
+    merkle_sync_free();
+    merkle_network_free();
+    transport_report();
+    transport_stop();
+    partition_free();
+    topology_free(&topology);
+    snapshot_close(restored_snapshot);
+    restored_snapshot = NULL;
     print_memory_report();
 }
 
 int main(int argc, char **argv) {
-    MPI_Init(&argc, &argv);
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &mpi_thread_level);
     MPI_Comm_rank(MPI_COMM_WORLD, &world_rank);
     MPI_Comm_size(MPI_COMM_WORLD, &world_size);
 
+    // The transport's progress thread needs SERIALIZED. The k-NN
+    // collectives run beside it and need MULTIPLE; distributed_knn_start
+    // leaves them off without, and queries fall back to one shard.
+    if (mpi_thread_level < MPI_THREAD_SERIALIZED) {
+        if (world_rank == 0) {
+            fprintf(stderr, "[ERROR] MPI provides thread level %d, need at least MPI_THREAD_SERIALIZED\n",
+                    mpi_thread_level);
+        }
+        MPI_Finalize();
+        return 1;
+    }
+
     if (argc < 2) {
         if (world_rank == 0) {
-            fprintf(stderr, "Usage: %s <total_nodes>\n", argv[0]);
+            fprintf(stderr, "Usage: %s <total_nodes> [vector_dim] [ring|torus|fractal]\n", argv[0]);
+            fprintf(stderr, "       %s restore <prefix> [verify] [none|batch|every]\n", argv[0]);
+            fprintf(stderr, "       %s benchtransport [messages] [payload_bytes]\n", argv[0]);
+            fprintf(stderr, "       %s benchknn strong|weak <nodes> [queries] [k] [batch]\n", argv[0]);
+            fprintf(stderr, "       %s benchlayout [nodes] [queries]\n", argv[0]);
+            fprintf(stderr, "       %s benchmerkle [leaves] [updates]\n", argv[0]);
         }
         MPI_Finalize();
         return 1;
     }
 
-    int dim = VECTOR_DIM;
-    initialize_network(atoi(argv[1]), dim);
-    for (int i = 0; i < total_nodes; i++) connect_neighbors(i, MAX_NEIGHBORS);
+    if (transport_start() != 0) {
+        MPI_Finalize();
+        return 1;
+    }
+
+    if (strcmp(argv[1], "benchtransport") == 0) {
+        transport_bench(argc >= 3 ? atoi(argv[2]) : 0, argc >= 4 ? atoi(argv[3]) : 0);
+        transport_stop();
+        MPI_Finalize();
+        return 0;
+    }
+
+    if (strcmp(argv[1], "benchmerkle") == 0) {
+        if (world_rank == 0) merkle_bench(argc >= 3 ? atoi(argv[2]) : 0, argc >= 4 ? atoi(argv[3]) : 0);
+        transport_stop();
+        MPI_Finalize();
+        return 0;
+    }
+
+    if (strcmp(argv[1], "benchlayout") == 0) {
+        if (world_rank == 0) node_layout_bench(argc >= 3 ? atoi(argv[2]) : 0, argc >= 4 ? atoi(argv[3]) : 0);
+        transport_stop();
+        MPI_Finalize();
+        return 0;
+    }
+
+    // Distributed k-NN scaling: <nodes> is the whole network for strong
+    // scaling and the per-rank share for weak scaling. Sweep -np outside.
+    if (strcmp(argv[1], "benchknn") == 0 && argc >= 4) {
+        int nodes = atoi(argv[3]);
+        if (strcmp(argv[2], "weak") == 0) nodes *= world_size;
+        if (setup_network(nodes, DEFAULT_VECTOR_DIM, DEFAULT_TOPOLOGY) != 0) {
+            transport_stop();
+            MPI_Finalize();
+            return 1;
+        }
+        if (world_rank == 0) {
+            distributed_knn_bench(argc >= 5 ? atoi(argv[4]) : 0, argc >= 6 ? atoi(argv[5]) : 0,
+                                  argc >= 7 ? atoi(argv[6]) : 0);
+        } else {
+            partition_serve();
+        }
+        graceful_shutdown();
+        MPI_Finalize();
+        return 0;
+    }
+
+    int status;
+    if (strcmp(argv[1], "restore") == 0 && argc >= 3) {
+        int verify = 0;
+        journal_config_t journal = journal_default_config();
+        for (int i = 3; i < argc; i++) {
+            if (strcmp(argv[i], "verify") == 0) verify = 1;
+            else journal_parse_sync(argv[i], &journal.sync);
+        }
+        status = restore_network(argv[2], verify, &journal);
+    } else {
+        int dim = argc >= 3 ? atoi(argv[2]) : DEFAULT_VECTOR_DIM;
+        if (dim <= 0) dim = DEFAULT_VECTOR_DIM;
+        status = setup_network(atoi(argv[1]), dim, argc >= 4 ? argv[3] : DEFAULT_TOPOLOGY);
+    }
+    if (status != 0) {
+        transport_stop();
+        MPI_Finalize();
+        return 1;
+    }
 
     pthread_create(&daemon_thread, NULL, parity_management_daemon, NULL);
+    daemon_started = 1;
 
-    // Main loop placeholder (CLI or message queue)
+    // Rank 0 drives the CLI; the other ranks serve requests for their
+    // shards until it shuts them down.
     if (world_rank == 0) {
-        printf("[FT-DFRP] Node initialized. Running CLI interface...\n");
+        printf("[FT-DFRP] Node initialized (%s vector kernels). Running CLI interface...\n",
+               vector_kernels_for_dim(vector_dim)->name);
         run_cli_interface();
+    } else {
+        partition_serve();
     }
 
     graceful_shutdown();
@@ -0,0 +1,118 @@
+/*
+ * FT-DFRP: Foreign Function Interface
+ *
+ * Dual Licensed:
+ * 1. AGPL-3.0 for research/academic use
+ * 2. Commercial license: contact michael.doran.808@gmail.com
+ *
+ * Copyright (C) 2025 Michael Doran
+ */
+
+#include "fractal_ffi.h"
+#include "fractal.h"
+#include "ann.h"
+#include "distributed_knn.h"
+#include "merkle.h"
+#include "parity_distribution.h"
+#include "partition.h"
+#include "routing.h"
+#include <stdlib.h>
+#include <string.h>
+
+static int valid_node(int id) {
+    return network && id >= 0 && id < total_nodes;
+}
+
+int ffi_get_node(int id, double *density, double *coherence, double *vector) {
+    if (!valid_node(id) || !vector) return -1;
+    return partition_fetch_node(id, vector, density, coherence);
+}
+
+double ffi_vector_similarity(int node_a, int node_b) {
+    if (!valid_node(node_a) || !valid_node(node_b)) return 0.0;
+    double *a = malloc(sizeof(double) * vector_dim);
+    double *b = malloc(sizeof(double) * vector_dim);
+    double similarity = 0.0;
+    if (partition_fetch_node(node_a, a, NULL, NULL) == 0 &&
+        partition_fetch_node(node_b, b, NULL, NULL) == 0) {
+        similarity = cosine_similarity(a, b, vector_dim);
+    }
+    free(a);
+    free(b);
+    return similarity;
+}
+
+int ffi_compute_route(int from, int to, int *path, int max_hops) {
+    if (!valid_node(from) || !valid_node(to) || !path || max_hops <= 0) return -1;
+    double *target = malloc(sizeof(double) * vector_dim);
+    int length = -1;
+    if (partition_fetch_node(to, target, NULL, NULL) == 0) {
+        length = compute_route(from, to, target, &default_routing_config, path, max_hops);
+    }
+    free(target);
+    return length;
+}
+
+int ffi_distribute_parity(const char *tag, int replicas) {
+    if (!network || !tag || replicas <= 0) return -1;
+    williams_distribution_policy_t policy = default_williams_policy;
+    policy.min_replicas = replicas;
+    int *chosen = distribute_parity_with_tree_evaluation(tag, &policy);
+    if (!chosen) return -1;
+    int placed = 0;
+    while (placed < replicas && chosen[placed] >= 0) placed++;
+    free(chosen);
+    return placed;
+}
+
+int ffi_find_k_nearest(int query_node, int k, int *results) {
+    if (!valid_node(query_node) || k <= 0 || !results) return -1;
+    similarity_result_t *res = malloc(sizeof(similarity_result_t) * k);
+    int found = distributed_knn(&query_node, 1, k, res, NULL);
+    if (found < 0) found = partition_knn(query_node, k, res);
+    for (int i = 0; i < k; i++) {
+        results[i] = i < found ? res[i].node_id : -1;
+    }
+    free(res);
+    return found;
+}
+
+int ffi_find_k_nearest_batch(const int *query_nodes, int query_count, int k, int *results) {
+    if (!query_nodes || !results || query_count <= 0 || k <= 0) return -1;
+    int local_batch = 1;
+    for (int q = 0; q < query_count; q++) {
+        if (!valid_node(query_nodes[q])) return -1;
+        if (!partition_owns(query_nodes[q])) local_batch = 0;
+    }
+
+    similarity_result_t *res = malloc(sizeof(similarity_result_t) * (size_t)query_count * k);
+    int found = distributed_knn(query_nodes, query_count, k, res, NULL);
+    if (found >= 0) {
+        for (size_t i = 0; i < (size_t)query_count * k; i++) results[i] = res[i].node_id;
+    } else if (local_batch) {
+        // All queries in this shard: one pass on the thread pool.
+        int *locals = malloc(sizeof(int) * query_count);
+        for (int q = 0; q < query_count; q++) locals[q] = partition_local_index(query_nodes[q]);
+        found = find_k_nearest_batch(network, partition.owned, locals, query_count, k, res, NULL);
+        free(locals);
+        for (size_t i = 0; i < (size_t)query_count * k; i++) {
+            results[i] = res[i].node_id < 0 ? -1 : network[res[i].node_id].id;
+        }
+    } else {
+        found = 0;
+        for (int q = 0; q < query_count; q++) {
+            int n = partition_knn(query_nodes[q], k, res);
+            for (int i = 0; i < k; i++) {
+                results[(size_t)q * k + i] = i < n ? res[i].node_id : -1;
+            }
+            if (n > 0) found += n;
+        }
+    }
+    free(res);
+    return found;
+}
+
+char* ffi_get_merkle_root() {
+    char root[MAX_HASH_SIZE];
+    return merkle_network_root_hex(root) == 0 ? strdup(root) : NULL;
+}
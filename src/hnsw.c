@@ -0,0 +1,423 @@
+/*
+ * FT-DFRP: Fractal Toroidal Density Field Routing Protocol - HNSW Index
+ *
+ * Dual Licensed:
+ * 1. AGPL-3.0 for research/academic use: https://www.gnu.org/licenses/agpl-3.0.html
+ * 2. Commercial license available - contact michael.doran.808@gmail.com for terms
+ *
+ * Copyright (C) 2025 Michael Doran
+ */
+
+#include "hnsw.h"
+#include <string.h>
+
+typedef struct {
+    int id;
+    double key;
+} hnsw_cand_t;
+
+// Max-heap on key; min-heaps push negated keys.
+typedef struct {
+    hnsw_cand_t *items;
+    int count;
+    int capacity;
+} hnsw_queue_t;
+
+static void queue_push(hnsw_queue_t *q, int id, double key) {
+    if (q->count == q->capacity) {
+        q->capacity = q->capacity ? q->capacity * 2 : 64;
+        q->items = realloc(q->items, sizeof(hnsw_cand_t) * q->capacity);
+    }
+    int i = q->count++;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (q->items[parent].key >= key) break;
+        q->items[i] = q->items[parent];
+        i = parent;
+    }
+    q->items[i] = (hnsw_cand_t){ id, key };
+}
+
+static hnsw_cand_t queue_pop(hnsw_queue_t *q) {
+    hnsw_cand_t top = q->items[0];
+    hnsw_cand_t last = q->items[--q->count];
+    int i = 0;
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= q->count) break;
+        if (child + 1 < q->count && q->items[child + 1].key > q->items[child].key) child++;
+        if (last.key >= q->items[child].key) break;
+        q->items[i] = q->items[child];
+        i = child;
+    }
+    if (q->count > 0) q->items[i] = last;
+    return top;
+}
+
+static inline int* links_at(const hnsw_index_t *index, int id, int level) {
+    int *base = index->links[id];
+    return level == 0 ? base : base + (index->M0 + 1) + (level - 1) * (index->M + 1);
+}
+
+static inline const double* vector_at(const hnsw_index_t *index, int id) {
+    return index->vectors + (size_t)id * index->dim;
+}
+
+static inline double dot(const double *a, const double *b, int dim) {
+    double sum = 0.0;
+    for (int i = 0; i < dim; i++) sum += a[i] * b[i];
+    return sum;
+}
+
+// What a search scores stored nodes against: the query vector and the
+// index's own unit-normalized copies, or a caller's scorer over ids.
+typedef struct {
+    const hnsw_index_t *index;
+    const double *vector;
+    hnsw_score_fn score;
+    const void *ctx;
+} hnsw_query_t;
+
+static inline double query_score(const hnsw_query_t *q, int id) {
+    if (q->score) return q->score(q->ctx, id);
+    return dot(q->vector, vector_at(q->index, id), q->index->dim);
+}
+
+static int compare_results_desc(const void *a, const void *b) {
+    double sa = ((const similarity_result_t*)a)->similarity;
+    double sb = ((const similarity_result_t*)b)->similarity;
+    return (sa < sb) - (sa > sb);
+}
+
+static void ensure_capacity(hnsw_index_t *index, int needed) {
+    if (needed <= index->capacity) return;
+    int capacity = index->capacity ? index->capacity : 64;
+    while (capacity < needed) capacity *= 2;
+
+    index->levels = realloc(index->levels, sizeof(int) * capacity);
+    index->links = realloc(index->links, sizeof(int*) * capacity);
+    index->vectors = realloc(index->vectors, sizeof(double) * (size_t)capacity * index->dim);
+    for (int i = index->capacity; i < capacity; i++) {
+        index->levels[i] = -1;
+        index->links[i] = NULL;
+    }
+    index->capacity = capacity;
+}
+
+static unsigned int next_visit_epoch(const hnsw_index_t *index, hnsw_scratch_t *scratch) {
+    if (scratch->capacity < index->capacity) {
+        scratch->visited = realloc(scratch->visited, sizeof(unsigned int) * index->capacity);
+        memset(scratch->visited + scratch->capacity, 0,
+               sizeof(unsigned int) * (index->capacity - scratch->capacity));
+        scratch->capacity = index->capacity;
+    }
+    if (++scratch->epoch == 0) {
+        memset(scratch->visited, 0, sizeof(unsigned int) * scratch->capacity);
+        scratch->epoch = 1;
+    }
+    return scratch->epoch;
+}
+
+void hnsw_scratch_free(hnsw_scratch_t *scratch) {
+    free(scratch->visited);
+    *scratch = (hnsw_scratch_t){ 0 };
+}
+
+static int random_level(const hnsw_index_t *index) {
+    double u = (rand() + 1.0) / ((double)RAND_MAX + 2.0);
+    int level = (int)(-log(u) * index->level_mult);
+    return level > HNSW_MAX_LEVEL ? HNSW_MAX_LEVEL : level;
+}
+
+// Hill-climbs on one level from entry towards query (ef = 1).
+static int greedy_closest(const hnsw_index_t *index, const hnsw_query_t *query, int entry, int level) {
+    double best = query_score(query, entry);
+    int changed = 1;
+    while (changed) {
+        changed = 0;
+        int *links = links_at(index, entry, level);
+        for (int i = 1; i <= links[0]; i++) {
+            double s = query_score(query, links[i]);
+            if (s > best) {
+                best = s;
+                entry = links[i];
+                changed = 1;
+            }
+        }
+    }
+    return entry;
+}
+
+// Beam search on one level. Leaves up to ef nodes in results as a min-heap
+// (keys are negated similarities).
+static void search_layer(const hnsw_index_t *index, hnsw_scratch_t *scratch, const hnsw_query_t *query,
+                         int entry, int ef, int level,
+                         hnsw_queue_t *candidates, hnsw_queue_t *results) {
+    unsigned int epoch = next_visit_epoch(index, scratch);
+    unsigned int *visited = scratch->visited;
+    candidates->count = 0;
+    results->count = 0;
+
+    double s = query_score(query, entry);
+    visited[entry] = epoch;
+    queue_push(candidates, entry, s);
+    queue_push(results, entry, -s);
+
+    while (candidates->count > 0) {
+        hnsw_cand_t c = queue_pop(candidates);
+        double worst = -results->items[0].key;
+        if (c.key < worst && results->count >= ef) break;
+
+        int *links = links_at(index, c.id, level);
+        for (int i = 1; i <= links[0]; i++) {
+            int n = links[i];
+            if (visited[n] == epoch) continue;
+            visited[n] = epoch;
+
+            double sn = query_score(query, n);
+            if (results->count < ef || sn > worst) {
+                queue_push(candidates, n, sn);
+                queue_push(results, n, -sn);
+                if (results->count > ef) queue_pop(results);
+                worst = -results->items[0].key;
+            }
+        }
+    }
+}
+
+// HNSW neighbour heuristic: keep a candidate only if it is closer to the base
+// than to any neighbour already kept, then top up with the pruned ones so
+// sparse regions still get m links. cands must be sorted by descending key.
+static int select_neighbors(const hnsw_index_t *index, hnsw_cand_t *cands, int count,
+                            int m, int *out) {
+    int selected = 0;
+    int pruned = 0;
+    for (int i = 0; i < count && selected < m; i++) {
+        const double *v = vector_at(index, cands[i].id);
+        int keep = 1;
+        for (int j = 0; j < selected; j++) {
+            if (dot(v, vector_at(index, out[j]), index->dim) > cands[i].key) {
+                keep = 0;
+                break;
+            }
+        }
+        if (keep) out[selected++] = cands[i].id;
+        else cands[pruned++] = cands[i];
+    }
+    for (int i = 0; i < pruned && selected < m; i++) {
+        out[selected++] = cands[i].id;
+    }
+    return selected;
+}
+
+static int compare_cands_desc(const void *a, const void *b) {
+    double ka = ((const hnsw_cand_t*)a)->key;
+    double kb = ((const hnsw_cand_t*)b)->key;
+    return (ka < kb) - (ka > kb);
+}
+
+// Adds a back-link from node to new_id, shrinking node's list with the
+// heuristic when it is already full.
+static void add_link(hnsw_index_t *index, int node, int new_id, int level) {
+    int max_links = level == 0 ? index->M0 : index->M;
+    int *links = links_at(index, node, level);
+    for (int i = 1; i <= links[0]; i++) {
+        if (links[i] == new_id) return;
+    }
+    if (links[0] < max_links) {
+        links[++links[0]] = new_id;
+        return;
+    }
+
+    hnsw_cand_t cands[4 * HNSW_DEFAULT_M + 1];
+    hnsw_cand_t *pool = (max_links + 1 <= (int)(sizeof(cands) / sizeof(cands[0]))) ?
+        cands : malloc(sizeof(hnsw_cand_t) * (max_links + 1));
+    const double *base = vector_at(index, node);
+    int n = 0;
+    for (int i = 1; i <= links[0]; i++) {
+        pool[n++] = (hnsw_cand_t){ links[i], dot(base, vector_at(index, links[i]), index->dim) };
+    }
+    pool[n++] = (hnsw_cand_t){ new_id, dot(base, vector_at(index, new_id), index->dim) };
+    qsort(pool, n, sizeof(hnsw_cand_t), compare_cands_desc);
+    links[0] = select_neighbors(index, pool, n, max_links, links + 1);
+    if (pool != cands) free(pool);
+}
+
+// Links node_id into every level up to its own, starting from the current
+// entry point. Shared by fresh inserts and in-place vector updates. With
+// keep_links no existing edge is removed: the node's own out-links stay as
+// they are and new neighbours with a free slot gain a back-link to it.
+static void link_node(hnsw_index_t *index, int node_id, int keep_links) {
+    hnsw_query_t query = { index, vector_at(index, node_id), NULL, NULL };
+    int level = index->levels[node_id];
+    int entry = index->entry_point;
+
+    for (int l = index->max_level; l > level; l--) {
+        entry = greedy_closest(index, &query, entry, l);
+    }
+
+    hnsw_queue_t candidates = { 0 };
+    hnsw_queue_t results = { 0 };
+    int *selected = NULL;
+    int selected_capacity = 0;
+    int top = level < index->max_level ? level : index->max_level;
+    for (int l = top; l >= 0; l--) {
+        search_layer(index, &index->scratch, &query, entry, index->ef_construction, l,
+                     &candidates, &results);
+
+        int n = 0;
+        for (int i = 0; i < results.count; i++) {
+            if (results.items[i].id == node_id) continue;
+            results.items[n++] = (hnsw_cand_t){ results.items[i].id, -results.items[i].key };
+        }
+        qsort(results.items, n, sizeof(hnsw_cand_t), compare_cands_desc);
+        if (n > 0) entry = results.items[0].id;
+
+        int max_links = l == 0 ? index->M0 : index->M;
+        int *links = links_at(index, node_id, l);
+        if (keep_links) {
+            if (selected_capacity < max_links) {
+                selected_capacity = max_links;
+                selected = realloc(selected, sizeof(int) * selected_capacity);
+            }
+            // Back-links only where there is room: pruning to make room
+            // would drop edges too, one relink of the entry after another.
+            int count = select_neighbors(index, results.items, n, max_links, selected);
+            for (int i = 0; i < count; i++) {
+                if (links_at(index, selected[i], l)[0] < max_links) {
+                    add_link(index, selected[i], node_id, l);
+                }
+            }
+            continue;
+        }
+        links[0] = select_neighbors(index, results.items, n, max_links, links + 1);
+        for (int i = 1; i <= links[0]; i++) {
+            add_link(index, links[i], node_id, l);
+        }
+    }
+
+    free(selected);
+    free(candidates.items);
+    free(results.items);
+}
+
+hnsw_index_t* hnsw_create(int capacity, int dim, int M, int ef_construction) {
+    hnsw_index_t *index = calloc(1, sizeof(hnsw_index_t));
+    index->dim = dim;
+    index->M = M > 1 ? M : HNSW_DEFAULT_M;
+    index->M0 = 2 * index->M;
+    index->ef_construction = ef_construction > index->M ? ef_construction : index->M;
+    index->ef_search = HNSW_DEFAULT_EF_SEARCH;
+    index->level_mult = 1.0 / log((double)index->M);
+    index->entry_point = -1;
+    index->max_level = -1;
+    ensure_capacity(index, capacity > 0 ? capacity : 64);
+    return index;
+}
+
+void hnsw_free(hnsw_index_t *index) {
+    if (!index) return;
+    for (int i = 0; i < index->capacity; i++) free(index->links[i]);
+    free(index->links);
+    free(index->levels);
+    free(index->vectors);
+    hnsw_scratch_free(&index->scratch);
+    free(index);
+}
+
+void hnsw_set_ef_search(hnsw_index_t *index, int ef_search) {
+    index->ef_search = ef_search > 1 ? ef_search : 1;
+}
+
+void hnsw_upsert(hnsw_index_t *index, int node_id, const double *vector) {
+    ensure_capacity(index, node_id + 1);
+
+    double *slot = index->vectors + (size_t)node_id * index->dim;
+    double norm = sqrt(dot(vector, vector, index->dim));
+    for (int i = 0; i < index->dim; i++) {
+        slot[i] = norm > 0.0 ? vector[i] / norm : 0.0;
+    }
+
+    if (index->levels[node_id] >= 0) {
+        // Existing node: keep its level, rebuild its out-links around the new
+        // position. Stale in-links stay valid edges and get pruned over time.
+        // Not so for the entry point: every search starts there, so replacing
+        // its out-links strands whatever was only reachable through them.
+        // It keeps them and just gains back-links from its new neighbours.
+        if (index->count > 1) link_node(index, node_id, node_id == index->entry_point);
+        return;
+    }
+
+    int level = random_level(index);
+    index->levels[node_id] = level;
+    index->links[node_id] = calloc((index->M0 + 1) + level * (index->M + 1), sizeof(int));
+    index->count++;
+
+    if (index->entry_point < 0) {
+        index->entry_point = node_id;
+        index->max_level = level;
+        return;
+    }
+
+    link_node(index, node_id, 0);
+    if (level > index->max_level) {
+        index->max_level = level;
+        index->entry_point = node_id;
+    }
+}
+
+int hnsw_search(hnsw_index_t *index, const double *query, int k, int ef_search,
+                int exclude_id, similarity_result_t *out) {
+    return hnsw_search_with_scratch(index, &index->scratch, query, k, ef_search, exclude_id, out);
+}
+
+// Walks the upper levels greedily, then beam-searches level 0 with ef and
+// writes the best k as similarities (keys scaled by 1 / qnorm).
+static int search(const hnsw_index_t *index, hnsw_scratch_t *scratch, const hnsw_query_t *query,
+                  double qnorm, int k, int ef_search, int exclude_id, similarity_result_t *out) {
+    if (index->entry_point < 0 || k <= 0) return 0;
+
+    int entry = index->entry_point;
+    for (int l = index->max_level; l > 0; l--) {
+        entry = greedy_closest(index, query, entry, l);
+    }
+
+    int ef = ef_search > k ? ef_search : k;
+    if (exclude_id >= 0) ef++;
+
+    hnsw_queue_t candidates = { 0 };
+    hnsw_queue_t results = { 0 };
+    search_layer(index, scratch, query, entry, ef, 0, &candidates, &results);
+
+    int n = 0;
+    similarity_result_t *all = malloc(sizeof(similarity_result_t) * results.count);
+    for (int i = 0; i < results.count; i++) {
+        if (results.items[i].id == exclude_id) continue;
+        all[n++] = (similarity_result_t){ results.items[i].id, -results.items[i].key / qnorm, 0.0 };
+    }
+    qsort(all, n, sizeof(similarity_result_t), compare_results_desc);
+
+    if (n > k) n = k;
+    memcpy(out, all, sizeof(similarity_result_t) * n);
+
+    free(all);
+    free(candidates.items);
+    free(results.items);
+    return n;
+}
+
+int hnsw_search_with_scratch(const hnsw_index_t *index, hnsw_scratch_t *scratch,
+                             const double *query, int k, int ef_search,
+                             int exclude_id, similarity_result_t *out) {
+    double qnorm = sqrt(dot(query, query, index->dim));
+    if (qnorm == 0.0) qnorm = 1.0;
+    hnsw_query_t q = { index, query, NULL, NULL };
+    return search(index, scratch, &q, qnorm, k, ef_search, exclude_id, out);
+}
+
+int hnsw_search_scored(const hnsw_index_t *index, hnsw_scratch_t *scratch,
+                       hnsw_score_fn score, const void *ctx, int k, int ef_search,
+                       int exclude_id, similarity_result_t *out) {
+    hnsw_query_t q = { index, NULL, score, ctx };
+    return search(index, scratch, &q, 1.0, k, ef_search, exclude_id, out);
+}
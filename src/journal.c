@@ -0,0 +1,604 @@
+/*
+ * FT-DFRP: Mutation Journal
+ *
+ * Dual Licensed:
+ * 1. AGPL-3.0 for research/academic use
+ * 2. Commercial license: contact michael.doran.808@gmail.com
+ *
+ * Copyright (C) 2025 Michael Doran
+ */
+
+#include "journal.h"
+#include "ann.h"
+#include "node_store.h"
+#include "parity_broadcast.h"
+#include "partition.h"
+#include "tag_intern.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define JOURNAL_CRC_X86 1
+#include <immintrin.h>
+#endif
+
+#define JOURNAL_BYTE_ORDER 0x01020304u
+#define JOURNAL_BENCH_MUTATIONS 20000
+#define JOURNAL_BENCH_SECONDS 2.0       // per row; synced rows stop early on slow disks
+#define JOURNAL_BENCH_MAX_WRITERS 8
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    int32_t vector_dim;
+    int32_t rank;
+    uint64_t reserved;
+} journal_file_header_t;
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+// ---- CRC-32C --------------------------------------------------------------
+
+static uint32_t crc_table[256];
+static uint32_t (*crc_update)(uint32_t crc, const uint8_t *p, size_t n);
+static pthread_once_t crc_once = PTHREAD_ONCE_INIT;
+
+static uint32_t crc_update_table(uint32_t crc, const uint8_t *p, size_t n) {
+    while (n--) crc = crc_table[(crc ^ *p++) & 0xff] ^ (crc >> 8);
+    return crc;
+}
+
+#ifdef JOURNAL_CRC_X86
+__attribute__((target("sse4.2")))
+static uint32_t crc_update_sse42(uint32_t crc, const uint8_t *p, size_t n) {
+    uint64_t c = crc;
+    for (; n >= 8; n -= 8, p += 8) {
+        uint64_t word;
+        memcpy(&word, p, sizeof(word));
+        c = _mm_crc32_u64(c, word);
+    }
+    crc = (uint32_t)c;
+    while (n--) crc = _mm_crc32_u8(crc, *p++);
+    return crc;
+}
+#endif
+
+static void crc_init(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++) c = c & 1 ? (c >> 1) ^ 0x82F63B78u : c >> 1;
+        crc_table[i] = c;
+    }
+    crc_update = crc_update_table;
+#ifdef JOURNAL_CRC_X86
+    if (__builtin_cpu_supports("sse4.2")) crc_update = crc_update_sse42;
+#endif
+}
+
+static uint32_t crc32c(const void *data, size_t n) {
+    pthread_once(&crc_once, crc_init);
+    return ~crc_update(~0u, data, n);
+}
+
+// ---- Appending ------------------------------------------------------------
+
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t flushed;     // a flush finished
+    pthread_cond_t wake;        // the flusher's timer
+    int fd;
+    journal_config_t config;
+    uint8_t *buffer;            // records appended since the last flush began
+    uint8_t *spare;             // the buffer a flush in progress is writing
+    size_t used;
+    size_t capacity;
+    uint64_t next_lsn;          // kept across close, so numbering never restarts
+    uint64_t written_lsn;
+    uint64_t durable_lsn;
+    int flushing;
+    int running;
+    int error;                  // errno of the write or sync that failed; sticky until reopened
+    pthread_t flusher;
+    journal_stats_t stats;
+} wal = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .flushed = PTHREAD_COND_INITIALIZER,
+    .wake = PTHREAD_COND_INITIALIZER,
+    .fd = -1,
+    .next_lsn = 1,
+};
+
+static atomic_int wal_open;     // lets the hooks skip the lock while no journal is open
+
+journal_config_t journal_default_config(void) {
+    return (journal_config_t){ JOURNAL_SYNC_BATCH, JOURNAL_DEFAULT_INTERVAL_MS };
+}
+
+static const char *sync_names[] = { "none", "batch", "every" };
+
+int journal_parse_sync(const char *name, journal_sync_t *sync) {
+    for (int s = JOURNAL_SYNC_NONE; s <= JOURNAL_SYNC_EVERY; s++) {
+        if (strcmp(name, sync_names[s]) == 0) {
+            *sync = (journal_sync_t)s;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+const char* journal_sync_name(journal_sync_t sync) {
+    return sync >= JOURNAL_SYNC_NONE && sync <= JOURNAL_SYNC_EVERY ? sync_names[sync] : "?";
+}
+
+void journal_path(const char *prefix, int rank, char *path, size_t cap) {
+    snprintf(path, cap, "%s.%d.wal", prefix, rank);
+}
+
+static int write_all(int fd, const void *data, size_t bytes) {
+    const uint8_t *p = data;
+    while (bytes > 0) {
+        ssize_t n = write(fd, p, bytes);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += n;
+        bytes -= n;
+    }
+    return 0;
+}
+
+int journal_sync_directory(const char *path) {
+    char dir[PATH_MAX];
+    snprintf(dir, sizeof(dir), "%s", path);
+    char *slash = strrchr(dir, '/');
+    if (!slash) snprintf(dir, sizeof(dir), ".");
+    else if (slash == dir) dir[1] = '\0';
+    else *slash = '\0';
+    int fd = open(dir, O_RDONLY | O_DIRECTORY);
+    if (fd < 0) return -1;
+    int status = fsync(fd);
+    int error = errno;
+    close(fd);
+    errno = error;
+    return status;
+}
+
+static size_t max_payload(void) {
+    size_t vector = sizeof(double) * (1 + (size_t)vector_dim);
+    return vector > MAX_TAG_LENGTH ? vector : MAX_TAG_LENGTH;
+}
+
+// Writes out everything appended so far, and syncs it when asked, with
+// the lock dropped; appends carry on into the other buffer meanwhile. One
+// flush runs at a time. A failed write or sync leaves written_lsn and
+// durable_lsn where they were and sets wal.error, which every waiter and
+// every later append sees: nothing after the last good sync is reported
+// durable. Returns 0, or -1 once the journal has failed.
+static int flush_locked(int sync) {
+    while (wal.flushing) pthread_cond_wait(&wal.flushed, &wal.lock);
+    if (wal.error) return -1;
+    if (wal.fd < 0) return 0;
+    uint64_t upto = wal.next_lsn - 1;
+    if (wal.used == 0 && (!sync || wal.durable_lsn >= upto)) return 0;
+
+    wal.flushing = 1;
+    uint8_t *data = wal.buffer;
+    size_t bytes = wal.used;
+    wal.buffer = wal.spare;
+    wal.spare = data;
+    wal.used = 0;
+    int fd = wal.fd;
+    pthread_mutex_unlock(&wal.lock);
+    int status = write_all(fd, data, bytes);
+    if (status == 0 && sync) status = fdatasync(fd);
+    int error = errno;
+    pthread_mutex_lock(&wal.lock);
+
+    if (status != 0) {
+        fprintf(stderr, "[JOURNAL] Write failed: %s; refusing mutations until the next checkpoint\n",
+                strerror(error));
+        wal.error = error ? error : EIO;
+    } else {
+        wal.written_lsn = upto;
+        if (sync) wal.durable_lsn = upto;
+        wal.stats.flushes++;
+        wal.stats.syncs += sync;
+        wal.stats.bytes += bytes;
+    }
+    wal.flushing = 0;
+    pthread_cond_broadcast(&wal.flushed);
+    return status != 0 ? -1 : 0;
+}
+
+static void* flusher_main(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&wal.lock);
+    while (wal.running) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        long long ns = deadline.tv_nsec + (long long)wal.config.interval_ms * 1000000LL;
+        deadline.tv_sec += ns / 1000000000LL;
+        deadline.tv_nsec = ns % 1000000000LL;
+        pthread_cond_timedwait(&wal.wake, &wal.lock, &deadline);
+        if (!wal.running || wal.error) break;
+        flush_locked(wal.config.sync == JOURNAL_SYNC_BATCH);
+    }
+    pthread_mutex_unlock(&wal.lock);
+    return NULL;
+}
+
+static int append(journal_record_type_t type, int node_id, const void *a, uint32_t a_bytes,
+                  const void *b, uint32_t b_bytes) {
+    if (!atomic_load_explicit(&wal_open, memory_order_acquire)) return 0;
+    size_t bytes = sizeof(journal_record_t) + a_bytes + b_bytes;
+    pthread_mutex_lock(&wal.lock);
+    int status = 0;
+    while (status == 0 && wal.fd >= 0 && wal.used + bytes > wal.capacity) status = flush_locked(0);
+    if (status != 0 || wal.error || wal.fd < 0) {
+        status = wal.error ? -1 : 0;
+        pthread_mutex_unlock(&wal.lock);
+        return status;
+    }
+    uint8_t *p = wal.buffer + wal.used;
+    journal_record_t r = { 0, a_bytes + b_bytes, wal.next_lsn++, (uint16_t)type, 0, node_id };
+    memcpy(p, &r, sizeof(r));
+    memcpy(p + sizeof(r), a, a_bytes);
+    if (b_bytes) memcpy(p + sizeof(r) + a_bytes, b, b_bytes);
+    uint32_t crc = crc32c(p + sizeof(crc), bytes - sizeof(crc));
+    memcpy(p, &crc, sizeof(crc));
+    wal.used += bytes;
+    wal.stats.appended++;
+    if (wal.config.sync == JOURNAL_SYNC_EVERY) {
+        // Whoever finds no flush running leads the next one; the rest wait
+        // for it and are covered by the same sync.
+        while (wal.durable_lsn < r.lsn && !wal.error) {
+            if (wal.flushing) pthread_cond_wait(&wal.flushed, &wal.lock);
+            else flush_locked(1);
+        }
+        if (wal.durable_lsn < r.lsn) status = -1;
+    }
+    pthread_mutex_unlock(&wal.lock);
+    return status;
+}
+
+int journal_log_tag(int node_id, parity_tag_id_t tag, int removed) {
+    if (!atomic_load_explicit(&wal_open, memory_order_relaxed)) return 0;
+    const char *name = tag_name(tag);
+    if (!name) return 0;
+    return append(removed ? JOURNAL_TAG_REMOVE : JOURNAL_TAG_ADD, node_id, name,
+                  (uint32_t)tag_name_length(tag), NULL, 0);
+}
+
+int journal_log_vector(int node_id, int slot) {
+    if (!atomic_load_explicit(&wal_open, memory_order_relaxed)) return 0;
+    return append(JOURNAL_VECTOR, node_id, &node_hot.density[slot], sizeof(double), node_vector(slot),
+                  sizeof(double) * vector_dim);
+}
+
+int journal_failed(void) {
+    pthread_mutex_lock(&wal.lock);
+    int error = wal.error;
+    pthread_mutex_unlock(&wal.lock);
+    return error;
+}
+
+// Takes over fd, positioned at the end of its valid records.
+static void start(int fd, const journal_config_t *config, uint64_t next_lsn) {
+    pthread_mutex_lock(&wal.lock);
+    wal.fd = fd;
+    wal.config = config ? *config : journal_default_config();
+    if (wal.config.interval_ms <= 0) wal.config.interval_ms = JOURNAL_DEFAULT_INTERVAL_MS;
+    size_t record = sizeof(journal_record_t) + max_payload();
+    wal.capacity = JOURNAL_BUFFER_BYTES > 4 * record ? JOURNAL_BUFFER_BYTES : 4 * record;
+    wal.buffer = malloc(wal.capacity);
+    wal.spare = malloc(wal.capacity);
+    wal.used = 0;
+    if (next_lsn > wal.next_lsn) wal.next_lsn = next_lsn;
+    wal.written_lsn = wal.durable_lsn = wal.next_lsn - 1;
+    memset(&wal.stats, 0, sizeof(wal.stats));
+    wal.error = 0;
+    wal.running = wal.config.sync != JOURNAL_SYNC_EVERY;
+    if (wal.running) pthread_create(&wal.flusher, NULL, flusher_main, NULL);
+    atomic_store(&wal_open, 1);
+    pthread_mutex_unlock(&wal.lock);
+}
+
+void journal_close(void) {
+    pthread_mutex_lock(&wal.lock);
+    atomic_store(&wal_open, 0);
+    if (wal.running) {
+        wal.running = 0;
+        pthread_cond_signal(&wal.wake);
+        pthread_mutex_unlock(&wal.lock);
+        pthread_join(wal.flusher, NULL);
+        pthread_mutex_lock(&wal.lock);
+    }
+    // A writer that saw the journal open just before may still append.
+    // After a failure whatever is still buffered cannot be made durable.
+    while (flush_locked(1) == 0 && wal.fd >= 0 && wal.used > 0) {}
+    if (wal.fd >= 0) close(wal.fd);
+    wal.fd = -1;
+    free(wal.buffer);
+    free(wal.spare);
+    wal.buffer = wal.spare = NULL;
+    wal.used = wal.capacity = 0;
+    pthread_mutex_unlock(&wal.lock);
+}
+
+// The new journal is built beside the old one and renamed over it, so a
+// crash at any point leaves one complete file: the old journal until the
+// rename is durable, the empty new one after. The old journal keeps
+// running when the new one cannot be created.
+int journal_open(const char *path, const journal_config_t *config, uint64_t next_lsn) {
+    char tmp[PATH_MAX];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+    journal_file_header_t h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, JOURNAL_MAGIC, sizeof(h.magic));
+    h.version = JOURNAL_VERSION;
+    h.byte_order = JOURNAL_BYTE_ORDER;
+    h.vector_dim = vector_dim;
+    h.rank = partition.rank;
+    if (fd < 0 || write_all(fd, &h, sizeof(h)) != 0 || fdatasync(fd) != 0 || rename(tmp, path) != 0) {
+        fprintf(stderr, "[JOURNAL] Cannot create %s: %s\n", path, strerror(errno));
+        if (fd >= 0) close(fd);
+        unlink(tmp);
+        return -1;
+    }
+    // Renamed: the old file is gone, so its journal ends here either way.
+    int status = journal_sync_directory(path);
+    if (status != 0) fprintf(stderr, "[JOURNAL] Cannot sync the directory of %s: %s\n", path, strerror(errno));
+    journal_close();
+    start(fd, config, next_lsn);
+    return status;
+}
+
+int journal_is_open(void) {
+    return atomic_load(&wal_open);
+}
+
+int journal_sync(void) {
+    pthread_mutex_lock(&wal.lock);
+    int status = wal.fd >= 0 ? flush_locked(1) : -1;
+    pthread_mutex_unlock(&wal.lock);
+    return status;
+}
+
+uint64_t journal_last_lsn(void) {
+    pthread_mutex_lock(&wal.lock);
+    uint64_t lsn = wal.next_lsn - 1;
+    pthread_mutex_unlock(&wal.lock);
+    return lsn;
+}
+
+void journal_get_stats(journal_stats_t *stats) {
+    pthread_mutex_lock(&wal.lock);
+    *stats = wal.stats;
+    pthread_mutex_unlock(&wal.lock);
+}
+
+int journal_checkpoint(const char *prefix, const journal_config_t *config) {
+    char path[PATH_MAX];
+    journal_path(prefix, partition.rank, path, sizeof(path));
+    return journal_open(path, config, journal_last_lsn() + 1);
+}
+
+// ---- Replay ---------------------------------------------------------------
+
+// Applies one record through the same paths a live mutation takes; the
+// journal is not open yet, so nothing is logged again.
+static void apply_record(const journal_record_t *r, const uint8_t *payload, double *vector) {
+    if (!partition_owns(r->node_id)) return;
+    if (r->type == JOURNAL_TAG_ADD || r->type == JOURNAL_TAG_REMOVE) {
+        if (r->length == 0 || r->length > MAX_TAG_LENGTH) return;
+        parity_tag_id_t tag = tag_intern_n((const char *)payload, r->length);
+        if (tag == PARITY_TAG_INVALID) return;
+        if (r->type == JOURNAL_TAG_ADD) assign_parity_tag_id(r->node_id, tag);
+        else remove_parity_tag_id(r->node_id, tag);
+    } else if (r->type == JOURNAL_VECTOR) {
+        if (r->length != sizeof(double) * (1 + (size_t)vector_dim)) return;
+        double density;
+        memcpy(&density, payload, sizeof(density));
+        memcpy(vector, payload + sizeof(density), sizeof(double) * vector_dim);
+        int slot = partition_local_index(r->node_id);
+        inject_vector(&network[slot], vector, vector_dim);
+        node_hot.density[slot] = density;
+    }
+}
+
+// Replays path and truncates it after its last valid record. Returns 1
+// when there is a journal to append to, 0 when it is missing, -1 when it
+// belongs to another network shape.
+static int replay(const char *path, uint64_t after_lsn, journal_replay_stats_t *stats) {
+    int fd = open(path, O_RDWR);
+    if (fd < 0) return errno == ENOENT ? 0 : -1;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(journal_file_header_t)) {
+        close(fd);
+        return 0;   // torn before the header was complete: start over
+    }
+    size_t size = st.st_size;
+    uint8_t *base = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (base == MAP_FAILED) {
+        close(fd);
+        return -1;
+    }
+    journal_file_header_t h;
+    memcpy(&h, base, sizeof(h));
+    if (memcmp(h.magic, JOURNAL_MAGIC, sizeof(h.magic)) != 0 || h.version != JOURNAL_VERSION ||
+        h.byte_order != JOURNAL_BYTE_ORDER || h.vector_dim != vector_dim || h.rank != partition.rank) {
+        fprintf(stderr, "[JOURNAL] %s was not written by this shard\n", path);
+        munmap(base, size);
+        close(fd);
+        return -1;
+    }
+
+    double *vector = malloc(sizeof(double) * vector_dim);
+    size_t limit = max_payload();
+    size_t at = sizeof(h);
+    uint64_t previous = 0;
+    while (at + sizeof(journal_record_t) <= size) {
+        journal_record_t r;
+        memcpy(&r, base + at, sizeof(r));
+        size_t bytes = sizeof(r) + r.length;
+        if (r.length > limit || bytes > size - at) break;
+        if (crc32c(base + at + sizeof(r.crc), bytes - sizeof(r.crc)) != r.crc) break;
+        if (r.lsn <= previous) break;
+        if (r.lsn > after_lsn) {
+            apply_record(&r, base + at + sizeof(r), vector);
+            stats->applied++;
+        }
+        previous = r.lsn;
+        stats->records++;
+        at += bytes;
+    }
+    free(vector);
+    munmap(base, size);
+
+    stats->last_lsn = previous;
+    stats->torn_bytes = size - at;
+    if (at < size && (ftruncate(fd, (off_t)at) != 0 || fdatasync(fd) != 0)) {
+        fprintf(stderr, "[JOURNAL] Cannot cut the torn tail of %s: %s\n", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    close(fd);
+    return 1;
+}
+
+int journal_recover(const char *prefix, uint64_t snapshot_lsn, const journal_config_t *config,
+                    journal_replay_stats_t *stats) {
+    journal_replay_stats_t local;
+    if (!stats) stats = &local;
+    memset(stats, 0, sizeof(*stats));
+    journal_close();
+    // The restored snapshot and this replay replace whatever a failed
+    // journal left in memory.
+    pthread_mutex_lock(&wal.lock);
+    wal.error = 0;
+    pthread_mutex_unlock(&wal.lock);
+
+    char path[PATH_MAX];
+    journal_path(prefix, partition.rank, path, sizeof(path));
+    double start_ms = now_ms();
+    int found = replay(path, snapshot_lsn, stats);
+    stats->elapsed_ms = now_ms() - start_ms;
+    if (found < 0) return -1;
+
+    uint64_t next_lsn = (stats->last_lsn > snapshot_lsn ? stats->last_lsn : snapshot_lsn) + 1;
+    if (found == 0) return journal_open(path, config, next_lsn);
+    int fd = open(path, O_WRONLY | O_APPEND);
+    if (fd < 0) {
+        fprintf(stderr, "[JOURNAL] Cannot reopen %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    start(fd, config, next_lsn);
+    return 0;
+}
+
+// ---- Benchmark ------------------------------------------------------------
+
+typedef struct {
+    int count;
+    unsigned seed;
+} bench_writer_t;
+
+static void* bench_writer(void *arg) {
+    bench_writer_t *w = arg;
+    double deadline = now_ms() + JOURNAL_BENCH_SECONDS * 1e3;
+    int done = 0;
+    for (; done < w->count && now_ms() < deadline; done++) {
+        int slot = rand_r(&w->seed) % partition.owned;
+        journal_log_vector(network[slot].id, slot);
+    }
+    w->count = done;
+    return NULL;
+}
+
+static void bench_row(const char *level, int writers, int done, double ms) {
+    journal_stats_t stats;
+    journal_get_stats(&stats);
+    printf("  %-6s %8d %10d %14.0f %8lld %14.1f\n", level, writers, done, done / (ms / 1e3),
+           stats.syncs, stats.syncs ? (double)stats.appended / stats.syncs : 0.0);
+}
+
+void journal_bench(int mutations, const char *path) {
+    if (journal_is_open()) {
+        printf("[JOURNAL BENCH] A journal is open; benchmark before the first checkpoint\n");
+        return;
+    }
+    if (partition.owned <= 0) return;
+    struct stat st;
+    if (lstat(path, &st) == 0) {
+        printf("[JOURNAL BENCH] %s exists; pass a path the benchmark may create and delete\n", path);
+        return;
+    }
+    if (mutations <= 0) mutations = JOURNAL_BENCH_MUTATIONS;
+    parity_tag_id_t tag = tag_intern("journal-bench");
+
+    // One writer logging the records a busy node produces, three vector
+    // updates to every tag toggle. Only records are appended: the nodes'
+    // vectors and tags are left as they are, and the file is never
+    // replayed.
+    printf("[JOURNAL BENCH] %d nodes, dim %d, %d mutations per level, %s\n", partition.owned, vector_dim,
+           mutations, path);
+    printf("  %-6s %8s %10s %14s %8s %14s\n", "sync", "writers", "mutations", "mutations/s", "syncs",
+           "records/sync");
+    for (int level = JOURNAL_SYNC_NONE; level <= JOURNAL_SYNC_EVERY; level++) {
+        journal_config_t config = { (journal_sync_t)level, JOURNAL_DEFAULT_INTERVAL_MS };
+        if (journal_open(path, &config, journal_last_lsn() + 1) != 0) break;
+        srand(7);
+        double start = now_ms();
+        double deadline = start + JOURNAL_BENCH_SECONDS * 1e3;
+        int done = 0;
+        for (; done < mutations && now_ms() < deadline; done++) {
+            int slot = rand() % partition.owned;
+            if (done % 4 == 3) journal_log_tag(network[slot].id, tag, (done / 4) % 2);
+            else journal_log_vector(network[slot].id, slot);
+        }
+        journal_sync();
+        bench_row(journal_sync_name(config.sync), 1, done, now_ms() - start);
+        journal_close();
+    }
+
+    // Writers logging concurrently with every mutation synced: a sync
+    // started by one covers the records the others appended meanwhile.
+    printf("  concurrent writers:\n");
+    journal_config_t every = { JOURNAL_SYNC_EVERY, JOURNAL_DEFAULT_INTERVAL_MS };
+    for (int writers = 2; writers <= JOURNAL_BENCH_MAX_WRITERS; writers *= 2) {
+        if (journal_open(path, &every, journal_last_lsn() + 1) != 0) break;
+        pthread_t threads[JOURNAL_BENCH_MAX_WRITERS];
+        bench_writer_t w[JOURNAL_BENCH_MAX_WRITERS];
+        double start = now_ms();
+        for (int t = 0; t < writers; t++) {
+            w[t] = (bench_writer_t){ mutations / writers, 11u + t };
+            pthread_create(&threads[t], NULL, bench_writer, &w[t]);
+        }
+        int done = 0;
+        for (int t = 0; t < writers; t++) {
+            pthread_join(threads[t], NULL);
+            done += w[t].count;
+        }
+        bench_row("every", writers, done, now_ms() - start);
+        journal_close();
+    }
+
+    unlink(path);
+}
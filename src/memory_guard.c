@@ -31,6 +31,12 @@ void* tracked_malloc(size_t size, const char *file, int line) {
     void *ptr = malloc(size);
     if (!ptr) return NULL;
 
+    // One record per node map on large shards; grow rather than run off the end.
+    if (tracker.count == tracker.capacity) {
+        tracker.capacity *= 2;
+        tracker.records = realloc(tracker.records, tracker.capacity * sizeof(alloc_record_t));
+    }
+
     tracker.records[tracker.count++] = (alloc_record_t){ ptr, size, file, line, 0 };
     tracker.total_allocations++;
     tracker.current_memory += size;
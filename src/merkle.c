@@ -9,77 +9,517 @@
  */
 
 #include "merkle.h"
+#include "node_store.h"
+#include "parity_types.h"
+#include "partition.h"
+#include "sha256_mb.h"
+#include "tag_intern.h"
+#include "thread_pool.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <openssl/sha.h>
+#include <time.h>
 
-static void compute_hash(const char *input, char *output) {
-    unsigned char hash[SHA256_DIGEST_LENGTH];
-    SHA256((const unsigned char *)input, strlen(input), hash);
-    for (int i = 0; i < SHA256_DIGEST_LENGTH; i++) {
-        sprintf(output + (i * 2), "%02x", hash[i]);
+#define MERKLE_BATCH 8        // digests per sha256_batch call; one per AVX2 lane
+#define MERKLE_GRAIN 8192     // entries per parallel task; smaller levels hash on the caller
+
+static const char hex_digits[] = "0123456789abcdef";
+
+void merkle_to_hex(const uint8_t *digest, char *hex) {
+    for (int i = 0; i < MERKLE_DIGEST_SIZE; i++) {
+        hex[2 * i] = hex_digits[digest[i] >> 4];
+        hex[2 * i + 1] = hex_digits[digest[i] & 15];
+    }
+    hex[2 * MERKLE_DIGEST_SIZE] = '\0';
+}
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+int merkle_from_hex(const char *hex, uint8_t *digest) {
+    if (!hex || strlen(hex) != 2 * MERKLE_DIGEST_SIZE) return -1;
+    for (int i = 0; i < MERKLE_DIGEST_SIZE; i++) {
+        int hi = hex_value(hex[2 * i]), lo = hex_value(hex[2 * i + 1]);
+        if (hi < 0 || lo < 0) return -1;
+        digest[i] = (uint8_t)(hi << 4 | lo);
     }
-    output[64] = '\0';
+    return 0;
 }
 
-static merkle_node_t* build_tree(char **hashes, int count) {
-    if (count == 1) {
-        merkle_node_t *leaf = malloc(sizeof(merkle_node_t));
-        strcpy(leaf->hash, hashes[0]);
-        leaf->left = leaf->right = NULL;
-        leaf->is_leaf = 1;
-        leaf->node_id = -1;
-        return leaf;
+#define MERKLE_PAIR_BYTES (1 + 2 * MERKLE_DIGEST_SIZE)   // prefix and both children
+
+static void hash_pair(const uint8_t *left, const uint8_t *right, uint8_t *output) {
+    uint8_t concat[MERKLE_PAIR_BYTES];
+    concat[0] = MERKLE_NODE_PREFIX;
+    memcpy(concat + 1, left, MERKLE_DIGEST_SIZE);
+    memcpy(concat + 1 + MERKLE_DIGEST_SIZE, right, MERKLE_DIGEST_SIZE);
+    sha256_digest(concat, sizeof(concat), output);
+}
+
+void merkle_hash_leaf(const void *data, size_t length, uint8_t *digest) {
+    sha256_digest_prefixed(MERKLE_LEAF_PREFIX, data, length, digest);
+}
+
+// ---- Tree -----------------------------------------------------------------
+
+merkle_tree_t* merkle_tree_create(int leaf_count) {
+    if (leaf_count <= 0) return NULL;
+    merkle_tree_t *tree = calloc(1, sizeof(merkle_tree_t));
+    tree->leaf_count = leaf_count;
+    int total = 0;
+    for (int size = leaf_count;; size = (size + 1) / 2) {
+        tree->level_offset[tree->levels] = total;
+        tree->level_size[tree->levels++] = size;
+        total += size;
+        if (size == 1) break;
     }
+    tree->hashes = calloc(total, MERKLE_DIGEST_SIZE);
+    return tree;
+}
+
+void merkle_tree_free(merkle_tree_t *tree) {
+    if (!tree) return;
+    free(tree->hashes);
+    free(tree);
+}
+
+static inline uint8_t* node_hash(const merkle_tree_t *tree, int level, int index) {
+    return (uint8_t *)merkle_node_hash(tree, level, index);
+}
+
+// Hashes up to MERKLE_BATCH messages into entries targets[] of level.
+static void hash_into(merkle_tree_t *tree, int level, const uint8_t **messages, const size_t *lengths,
+                      const int *targets, int count) {
+    uint8_t digests[MERKLE_BATCH][SHA256_DIGEST_BYTES];
+    sha256_batch(messages, lengths, count, digests);
+    for (int k = 0; k < count; k++) memcpy(node_hash(tree, level, targets[k]), digests[k], MERKLE_DIGEST_SIZE);
+}
+
+// Recomputes entries of level (> 0) from their children: list[i] for i in
+// [begin, end), or the indices begin..end themselves when list is NULL.
+// Children 2i and 2i + 1 are adjacent, so each pair is one copy behind
+// its prefix.
+static void rehash_entries(merkle_tree_t *tree, int level, const int *list, int begin, int end) {
+    int below = tree->level_size[level - 1];
+    uint8_t pairs[MERKLE_BATCH][MERKLE_PAIR_BYTES];
+    const uint8_t *messages[MERKLE_BATCH];
+    size_t lengths[MERKLE_BATCH];
+    int targets[MERKLE_BATCH];
+    int pending = 0;
+    for (int i = begin; i < end; i++) {
+        int index = list ? list[i] : i;
+        int child = 2 * index;
+        if (child + 1 >= below) {
+            memcpy(node_hash(tree, level, index), node_hash(tree, level - 1, child), MERKLE_DIGEST_SIZE);
+            continue;
+        }
+        pairs[pending][0] = MERKLE_NODE_PREFIX;
+        memcpy(pairs[pending] + 1, node_hash(tree, level - 1, child), 2 * MERKLE_DIGEST_SIZE);
+        messages[pending] = pairs[pending];
+        lengths[pending] = MERKLE_PAIR_BYTES;
+        targets[pending++] = index;
+        if (pending == MERKLE_BATCH) {
+            hash_into(tree, level, messages, lengths, targets, pending);
+            pending = 0;
+        }
+    }
+    if (pending > 0) hash_into(tree, level, messages, lengths, targets, pending);
+}
+
+static void rehash(merkle_tree_t *tree, int level, int index) {
+    int child = 2 * index;
+    uint8_t *out = node_hash(tree, level, index);
+    if (child + 1 < tree->level_size[level - 1]) {
+        hash_pair(node_hash(tree, level - 1, child), node_hash(tree, level - 1, child + 1), out);
+    } else {
+        memcpy(out, node_hash(tree, level - 1, child), MERKLE_DIGEST_SIZE);
+    }
+}
+
+void merkle_set_leaf(merkle_tree_t *tree, int index, const void *data, size_t length) {
+    merkle_hash_leaf(data, length, node_hash(tree, 0, index));
+}
+
+typedef struct {
+    merkle_tree_t *tree;
+    int level;
+} level_task_t;
+
+static void level_task(void *ctx, int begin, int end, int worker) {
+    (void)worker;
+    level_task_t *t = ctx;
+    rehash_entries(t->tree, t->level, NULL, begin, end);
+}
+
+// Levels depend on the one below, so each is a parallel pass of its own;
+// the top few are small enough to stay on the caller.
+void merkle_tree_rebuild(merkle_tree_t *tree) {
+    for (int level = 1; level < tree->levels; level++) {
+        int size = tree->level_size[level];
+        if (size < 2 * MERKLE_GRAIN) {
+            rehash_entries(tree, level, NULL, 0, size);
+        } else {
+            level_task_t t = { tree, level };
+            thread_pool_parallel_for(thread_pool_default(), size, MERKLE_GRAIN, level_task, &t);
+        }
+    }
+}
+
+void merkle_update_leaf(merkle_tree_t *tree, int index, const void *data, size_t length) {
+    merkle_set_leaf(tree, index, data, length);
+    for (int level = 1; level < tree->levels; level++) {
+        index /= 2;
+        rehash(tree, level, index);
+    }
+}
+
+void merkle_rehash_paths(merkle_tree_t *tree, int *leaves, int count) {
+    for (int level = 1; level < tree->levels && count > 0; level++) {
+        int parents = 0;
+        for (int i = 0; i < count; i++) {
+            int parent = leaves[i] / 2;
+            if (parents == 0 || leaves[parents - 1] != parent) leaves[parents++] = parent;
+        }
+        count = parents;
+        rehash_entries(tree, level, leaves, 0, count);
+    }
+}
+
+const uint8_t* merkle_root(const merkle_tree_t *tree) {
+    return node_hash(tree, tree->levels - 1, 0);
+}
+
+int merkle_prove(const merkle_tree_t *tree, int index, merkle_proof_t *proof) {
+    if (!tree || index < 0 || index >= tree->leaf_count) return -1;
+    proof->leaf_index = index;
+    proof->length = 0;
+    for (int level = 0; level < tree->levels - 1; level++) {
+        int sibling = index ^ 1;
+        if (sibling < tree->level_size[level]) {
+            memcpy(proof->siblings[proof->length], node_hash(tree, level, sibling), MERKLE_DIGEST_SIZE);
+            proof->sibling_left[proof->length++] = sibling < index;
+        }
+        index /= 2;
+    }
+    return 0;
+}
+
+int merkle_verify_proof(const uint8_t *leaf_hash, const merkle_proof_t *proof, const uint8_t *root) {
+    uint8_t current[MERKLE_DIGEST_SIZE];
+    memcpy(current, leaf_hash, MERKLE_DIGEST_SIZE);
+    for (int i = 0; i < proof->length; i++) {
+        if (proof->sibling_left[i]) {
+            hash_pair(proof->siblings[i], current, current);
+        } else {
+            hash_pair(current, proof->siblings[i], current);
+        }
+    }
+    return memcmp(current, root, MERKLE_DIGEST_SIZE) == 0;
+}
 
-    int mid = count / 2;
-    merkle_node_t *left = build_tree(hashes, mid);
-    merkle_node_t *right = build_tree(hashes + mid, count - mid);
+// ---- Network tree ---------------------------------------------------------
 
-    merkle_node_t *parent = malloc(sizeof(merkle_node_t));
-    char concat[2 * MAX_HASH_SIZE];
-    snprintf(concat, sizeof(concat), "%s%s", left->hash, right->hash);
-    compute_hash(concat, parent->hash);
-    parent->left = left;
-    parent->right = right;
-    parent->is_leaf = 0;
-    parent->node_id = -1;
+static merkle_tree_t *network_tree = NULL;
+static uint8_t *leaf_dirty = NULL;
+static int *dirty_leaves = NULL;
+static int dirty_count = 0;
+static uint8_t *record_scratch = NULL;   // MERKLE_BATCH records per pool worker
+static size_t record_bytes = 0;
+static int record_workers = 0;
 
-    return parent;
+static int compare_names(const void *a, const void *b) {
+    return strcmp(*(const char *const *)a, *(const char *const *)b);
 }
 
+static int compare_ints(const void *a, const void *b) {
+    int x = *(const int *)a, y = *(const int *)b;
+    return x < y ? -1 : x > y;
+}
+
+size_t merkle_record_capacity(void) {
+    return sizeof(int32_t) + MAX_HASH_SIZE + sizeof(double) * (2 + vector_dim) +
+           MAX_PARITY_TAGS * (MAX_TAG_LENGTH + 1);
+}
+
+// Id, hash string, density, coherence, vector, then tag names in sorted
+// order (ids are per process).
+size_t merkle_node_record(int slot, uint8_t *buf) {
+    TorusNode *n = &network[slot];
+    uint8_t *p = buf;
+    int32_t id = n->id;
+    memcpy(p, &id, sizeof(id));
+    p += sizeof(id);
+    size_t length = strnlen(n->hash, MAX_HASH_SIZE - 1);
+    memcpy(p, n->hash, length);
+    p += length;
+    *p++ = 0;
+    memcpy(p, &node_hot.density[slot], sizeof(double));
+    p += sizeof(double);
+    memcpy(p, &node_hot.coherence[slot], sizeof(double));
+    p += sizeof(double);
+    memcpy(p, node_vector(slot), sizeof(double) * vector_dim);
+    p += sizeof(double) * vector_dim;
+
+    const char *names[MAX_PARITY_TAGS];
+    int count = 0;
+    for (int i = 0; i < n->parity_count; i++) {
+        const char *name = tag_name(n->parity_tags[i]);
+        if (name) names[count++] = name;
+    }
+    qsort(names, count, sizeof(char *), compare_names);
+    for (int i = 0; i < count; i++) {
+        length = strlen(names[i]);
+        memcpy(p, names[i], length + 1);
+        p += length + 1;
+    }
+    return (size_t)(p - buf);
+}
+
+static void ensure_record_scratch(void) {
+    int workers = thread_pool_size(thread_pool_default());
+    size_t bytes = 1 + merkle_record_capacity();   // leaf prefix first
+    if (record_scratch && workers <= record_workers && bytes == record_bytes) return;
+    free(record_scratch);
+    record_scratch = malloc((size_t)workers * MERKLE_BATCH * bytes);
+    record_workers = workers;
+    record_bytes = bytes;
+}
+
+// Hashes the leaves of slots list[i] for i in [begin, end) (slot i itself
+// when list is NULL) MERKLE_BATCH records at a time in worker's scratch,
+// each written behind its leaf prefix.
+static void hash_node_leaves(const int *list, int begin, int end, int worker) {
+    uint8_t *scratch = record_scratch + (size_t)worker * MERKLE_BATCH * record_bytes;
+    const uint8_t *messages[MERKLE_BATCH];
+    size_t lengths[MERKLE_BATCH];
+    int targets[MERKLE_BATCH];
+    for (int i = begin; i < end; i += MERKLE_BATCH) {
+        int batch = end - i < MERKLE_BATCH ? end - i : MERKLE_BATCH;
+        for (int k = 0; k < batch; k++) {
+            targets[k] = list ? list[i + k] : i + k;
+            uint8_t *message = scratch + k * record_bytes;
+            message[0] = MERKLE_LEAF_PREFIX;
+            messages[k] = message;
+            lengths[k] = 1 + merkle_node_record(targets[k], message + 1);
+        }
+        hash_into(network_tree, 0, messages, lengths, targets, batch);
+    }
+}
+
+static void leaf_task(void *ctx, int begin, int end, int worker) {
+    hash_node_leaves(ctx, begin, end, worker);
+}
+
+// Builds (or rebuilds from scratch) the tree over this rank's nodes.
 merkle_tree_t* build_network_merkle_tree() {
-    char **leaf_hashes = malloc(sizeof(char*) * total_nodes);
-    for (int i = 0; i < total_nodes; i++) {
-        leaf_hashes[i] = malloc(MAX_HASH_SIZE);
-        compute_hash(network[i].hash, leaf_hashes[i]);
+    merkle_network_free();
+    int count = partition.owned;
+    network_tree = merkle_tree_create(count);
+    if (!network_tree) return NULL;
+    ensure_record_scratch();
+    if (count < 2 * MERKLE_GRAIN) {
+        hash_node_leaves(NULL, 0, count, 0);
+    } else {
+        thread_pool_parallel_for(thread_pool_default(), count, MERKLE_GRAIN, leaf_task, NULL);
     }
+    merkle_tree_rebuild(network_tree);
+    leaf_dirty = calloc(count, 1);
+    dirty_leaves = malloc(sizeof(int) * count);
+    return network_tree;
+}
 
-    merkle_tree_t *tree = malloc(sizeof(merkle_tree_t));
-    tree->leaf_hashes = leaf_hashes;
-    tree->leaf_count = total_nodes;
-    tree->root = build_tree(leaf_hashes, total_nodes);
-    strcpy(tree->global_root, tree->root->hash);
-    return tree;
+void merkle_network_free(void) {
+    merkle_tree_free(network_tree);
+    free(leaf_dirty);
+    free(dirty_leaves);
+    free(record_scratch);
+    network_tree = NULL;
+    leaf_dirty = NULL;
+    dirty_leaves = NULL;
+    record_scratch = NULL;
+    record_workers = 0;
+    record_bytes = 0;
+    dirty_count = 0;
+}
+
+void merkle_note_changed(int node_id) {
+    int local = partition_local_index(node_id);
+    if (!network_tree || local < 0 || leaf_dirty[local]) return;
+    leaf_dirty[local] = 1;
+    dirty_leaves[dirty_count++] = local;
+}
+
+// Rehashes every noted leaf, then each affected ancestor once.
+static merkle_tree_t* network_tree_current(void) {
+    if (!network_tree) {
+        if (!network || partition.owned <= 0) return NULL;
+        return build_network_merkle_tree();
+    }
+    if (dirty_count == 0) return network_tree;
+    qsort(dirty_leaves, dirty_count, sizeof(int), compare_ints);
+    ensure_record_scratch();
+    hash_node_leaves(dirty_leaves, 0, dirty_count, 0);
+    for (int i = 0; i < dirty_count; i++) leaf_dirty[dirty_leaves[i]] = 0;
+    merkle_rehash_paths(network_tree, dirty_leaves, dirty_count);
+    dirty_count = 0;
+    return network_tree;
+}
+
+merkle_tree_t* merkle_network_tree(void) {
+    return network_tree_current();
+}
+
+const uint8_t* merkle_network_root(void) {
+    merkle_tree_t *tree = network_tree_current();
+    return tree ? merkle_root(tree) : NULL;
+}
+
+int merkle_network_root_hex(char *hex) {
+    const uint8_t *root = merkle_network_root();
+    if (!root) return -1;
+    merkle_to_hex(root, hex);
+    return 0;
 }
 
 void export_merkle_journal(const char *filepath) {
-    merkle_tree_t *tree = build_network_merkle_tree();
+    merkle_tree_t *tree = network_tree_current();
+    if (!tree) return;
     FILE *f = fopen(filepath, "w");
-    fprintf(f, "MERKLE_ROOT: %s\n", tree->global_root);
+    if (!f) return;
+    char hex[MAX_HASH_SIZE];
+    merkle_to_hex(merkle_root(tree), hex);
+    fprintf(f, "MERKLE_ROOT: %s\n", hex);
     for (int i = 0; i < tree->leaf_count; i++) {
-        fprintf(f, "Node[%d]: %s\n", i, tree->leaf_hashes[i]);
+        merkle_to_hex(node_hash(tree, 0, i), hex);
+        fprintf(f, "Node[%d]: %s\n", network[i].id, hex);
     }
     fclose(f);
 }
 
-int verify_merkle_path(int node_id, const char *expected_hash) {
-    char computed[MAX_HASH_SIZE];
-    compute_hash(network[node_id].hash, computed);
-    return strcmp(computed, expected_hash) == 0;
+int verify_merkle_path(int node_id, const uint8_t *expected_root) {
+    if (!partition_owns(node_id) || !expected_root) return 0;
+    merkle_tree_t *tree = network_tree_current();
+    if (!tree) return 0;
+    int slot = partition_local_index(node_id);
+    uint8_t leaf[MERKLE_DIGEST_SIZE];
+    ensure_record_scratch();
+    size_t length = merkle_node_record(slot, record_scratch);
+    merkle_hash_leaf(record_scratch, length, leaf);
+    merkle_proof_t proof;
+    if (merkle_prove(tree, slot, &proof) != 0) return 0;
+    return merkle_verify_proof(leaf, &proof, expected_root);
 }
 
 void update_merkle_tree_incremental(int node_id) {
-    compute_hash(network[node_id].hash, network[node_id].hash);
+    int local = partition_local_index(node_id);
+    if (!network_tree || local < 0) return;
+    ensure_record_scratch();
+    size_t length = merkle_node_record(local, record_scratch);
+    merkle_update_leaf(network_tree, local, record_scratch, length);
+}
+
+// ---- Benchmark ------------------------------------------------------------
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+// Synthetic leaf i: a 32-byte record of its index and version.
+static void bench_leaves(void *ctx, int begin, int end, int worker) {
+    (void)worker;
+    merkle_tree_t *tree = ctx;
+    uint8_t records[MERKLE_BATCH][1 + 4 * sizeof(uint64_t)];   // leaf prefix, then the record
+    const uint8_t *messages[MERKLE_BATCH];
+    size_t lengths[MERKLE_BATCH];
+    int targets[MERKLE_BATCH];
+    for (int i = begin; i < end; i += MERKLE_BATCH) {
+        int batch = end - i < MERKLE_BATCH ? end - i : MERKLE_BATCH;
+        for (int k = 0; k < batch; k++) {
+            uint64_t record[4] = { (uint64_t)(i + k), 0, 0, 0 };
+            records[k][0] = MERKLE_LEAF_PREFIX;
+            memcpy(records[k] + 1, record, sizeof(record));
+            messages[k] = records[k];
+            lengths[k] = sizeof(records[k]);
+            targets[k] = i + k;
+        }
+        hash_into(tree, 0, messages, lengths, targets, batch);
+    }
+}
+
+static double bench_build(merkle_tree_t *tree) {
+    double t0 = now_us();
+    thread_pool_parallel_for(thread_pool_default(), tree->leaf_count, MERKLE_GRAIN, bench_leaves, tree);
+    merkle_tree_rebuild(tree);
+    return (now_us() - t0) / 1e3;
+}
+
+void merkle_bench(int leaves, int updates) {
+    if (leaves <= 0) leaves = 1 << 20;
+    if (updates <= 0) updates = 100000;
+    merkle_tree_t *tree = merkle_tree_create(leaves);
+    uint64_t record[4];
+    char hex[MAX_HASH_SIZE];
+
+    printf("[MERKLE] %d leaves, %d levels, %.1f MB, %d threads\n", leaves, tree->levels,
+           (double)(tree->level_offset[tree->levels - 1] + 1) * MERKLE_DIGEST_SIZE / (1 << 20),
+           thread_pool_size(thread_pool_default()));
+    const sha256_kernels_t *kernels[4];
+    int kernel_count = sha256_available_kernels(kernels, 4);
+    double build_ms = 0;
+    for (int k = kernel_count - 1; k >= 0; k--) {
+        sha256_select_kernels(kernels[k]);
+        build_ms = bench_build(tree);
+        merkle_to_hex(merkle_root(tree), hex);
+        printf("[MERKLE] full build (%s): %.1f ms | root %.16s...\n", kernels[k]->name, build_ms, hex);
+    }
+    sha256_select_kernels(NULL);
+
+    double t1 = now_us();
+    for (int u = 0; u < updates; u++) {
+        record[0] = rand() % leaves;
+        record[1] = u + 1;
+        record[2] = record[3] = 0;
+        merkle_update_leaf(tree, (int)record[0], record, sizeof(record));
+    }
+    double t2 = now_us();
+
+    merkle_proof_t proof;
+    int verified = 0, proofs = updates < 10000 ? updates : 10000;
+    for (int p = 0; p < proofs; p++) {
+        int index = rand() % leaves;
+        merkle_prove(tree, index, &proof);
+        verified += merkle_verify_proof(node_hash(tree, 0, index), &proof, merkle_root(tree));
+    }
+    double t3 = now_us();
+
+    // An internal node's two children, handed over as leaf data with the
+    // rest of its path, must not verify.
+    int forged = 0, attempts = 0;
+    for (int p = 0; p < proofs && tree->levels > 2; p++) {
+        int index = rand() % tree->level_size[1];
+        if (2 * index + 1 >= leaves) continue;
+        merkle_prove(tree, 2 * index, &proof);
+        proof.leaf_index = index;
+        proof.length--;
+        memmove(proof.siblings, proof.siblings + 1, sizeof(proof.siblings[0]) * proof.length);
+        memmove(proof.sibling_left, proof.sibling_left + 1, proof.length);
+        uint8_t leaf[MERKLE_DIGEST_SIZE];
+        merkle_hash_leaf(node_hash(tree, 0, 2 * index), 2 * MERKLE_DIGEST_SIZE, leaf);
+        forged += merkle_verify_proof(leaf, &proof, merkle_root(tree));
+        attempts++;
+    }
+
+    double update_us = (t2 - t1) / updates;
+    merkle_to_hex(merkle_root(tree), hex);
+    printf("[MERKLE] leaf updates: %.0f/s (%.2f us each, x%.0f vs rebuilding) | root %.16s...\n",
+           1e6 / update_us, update_us, build_ms * 1e3 / update_us, hex);
+    printf("[MERKLE] proofs: %.0f/s, %d/%d verified | %d/%d internal nodes accepted as leaves\n",
+           proofs / ((t3 - t2) / 1e6), verified, proofs, forged, attempts);
+    merkle_tree_free(tree);
 }
@@ -0,0 +1,519 @@
+/*
+ * FT-DFRP: Merkle-Diff State Sync
+ *
+ * Dual Licensed:
+ * 1. AGPL-3.0 for research/academic use
+ * 2. Commercial license: contact michael.doran.808@gmail.com
+ *
+ * Copyright (C) 2025 Michael Doran
+ */
+
+#include "merkle_sync.h"
+#include "ann.h"
+#include "node_store.h"
+#include "parity_broadcast.h"
+#include "parity_types.h"
+#include "partition.h"
+#include "sha256_mb.h"
+#include "tag_intern.h"
+#include "transport.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Request and reply framing partition.c adds to every call.
+#define SYNC_REQUEST_OVERHEAD 5
+#define SYNC_REPLY_OVERHEAD 6
+#define SYNC_REPLY_BYTES (TRANSPORT_BATCH_BYTES / 2 - 1)   // partition.c's payload limit, less the status byte
+#define SYNC_SHAPE_LEVEL -1
+
+// PARTITION_OP_MERKLE_NODES request, followed by count int32 indices of
+// level. Replies with count digests, or a sync_shape_t for level -1.
+typedef struct {
+    int32_t shard_rank;
+    int32_t level;
+    int32_t count;
+} nodes_request_t;
+
+typedef struct {
+    int32_t first;          // global id of leaf 0
+    int32_t leaf_count;
+    uint8_t root[MERKLE_DIGEST_SIZE];
+} sync_shape_t;
+
+// PARTITION_OP_MERKLE_RECORDS request, followed by count int32 leaf
+// indices. Replies with an int32 count of records served, a prefix of
+// those asked for that fits, each as a u32 length and the record bytes.
+typedef struct {
+    int32_t shard_rank;
+    int32_t count;
+} records_request_t;
+
+// Copy of another rank's shard.
+typedef struct {
+    int first;
+    int leaf_count;
+    uint8_t **records;
+    uint32_t *lengths;
+    merkle_tree_t *tree;
+} merkle_mirror_t;
+
+static merkle_mirror_t **mirrors = NULL;   // per rank; NULL until synced
+static uint8_t *record_buf = NULL;
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static merkle_mirror_t* mirror_create(int first, int leaf_count) {
+    merkle_mirror_t *m = calloc(1, sizeof(merkle_mirror_t));
+    m->first = first;
+    m->leaf_count = leaf_count;
+    m->records = calloc(leaf_count, sizeof(uint8_t *));
+    m->lengths = calloc(leaf_count, sizeof(uint32_t));
+    m->tree = merkle_tree_create(leaf_count);
+    return m;
+}
+
+static void mirror_free(merkle_mirror_t *m) {
+    if (!m) return;
+    for (int i = 0; i < m->leaf_count; i++) free(m->records[i]);
+    free(m->records);
+    free(m->lengths);
+    merkle_tree_free(m->tree);
+    free(m);
+}
+
+static merkle_mirror_t* mirror_of(int shard_rank) {
+    if (!mirrors || shard_rank < 0 || shard_rank >= partition.size) return NULL;
+    return mirrors[shard_rank];
+}
+
+// This rank's copy of shard_rank: the live tree for our own shard, else a
+// mirror. NULL when there is none.
+static merkle_tree_t* shard_tree(int shard_rank, int *first) {
+    if (shard_rank == partition.rank) {
+        *first = partition.first;
+        return merkle_network_tree();
+    }
+    merkle_mirror_t *m = mirror_of(shard_rank);
+    if (!m) return NULL;
+    *first = m->first;
+    return m->tree;
+}
+
+static const uint8_t* ensure_record_buf(void) {
+    if (!record_buf) record_buf = malloc(merkle_record_capacity());
+    return record_buf;
+}
+
+// ---- Serving --------------------------------------------------------------
+
+static int handle_nodes(int source, const uint8_t *req, int length, uint8_t *reply, int cap) {
+    (void)source;
+    nodes_request_t r;
+    if (length < (int)sizeof(r)) return -1;
+    memcpy(&r, req, sizeof(r));
+    int first;
+    merkle_tree_t *tree = shard_tree(r.shard_rank, &first);
+    if (!tree) return -1;
+
+    if (r.level == SYNC_SHAPE_LEVEL) {
+        sync_shape_t shape = { first, tree->leaf_count, { 0 } };
+        memcpy(shape.root, merkle_root(tree), MERKLE_DIGEST_SIZE);
+        if ((int)sizeof(shape) > cap) return -1;
+        memcpy(reply, &shape, sizeof(shape));
+        return sizeof(shape);
+    }
+    if (r.level < 0 || r.level >= tree->levels || r.count < 0 ||
+        length != (int)(sizeof(r) + sizeof(int32_t) * r.count) || r.count * MERKLE_DIGEST_SIZE > cap) {
+        return -1;
+    }
+    for (int i = 0; i < r.count; i++) {
+        int32_t index;
+        memcpy(&index, req + sizeof(r) + sizeof(int32_t) * i, sizeof(index));
+        if (index < 0 || index >= tree->level_size[r.level]) return -1;
+        memcpy(reply + i * MERKLE_DIGEST_SIZE, merkle_node_hash(tree, r.level, index), MERKLE_DIGEST_SIZE);
+    }
+    return r.count * MERKLE_DIGEST_SIZE;
+}
+
+static int handle_records(int source, const uint8_t *req, int length, uint8_t *reply, int cap) {
+    (void)source;
+    records_request_t r;
+    if (length < (int)sizeof(r)) return -1;
+    memcpy(&r, req, sizeof(r));
+    if (r.count < 0 || length != (int)(sizeof(r) + sizeof(int32_t) * r.count)) return -1;
+    int first;
+    merkle_tree_t *tree = shard_tree(r.shard_rank, &first);
+    if (!tree) return -1;
+    merkle_mirror_t *m = r.shard_rank == partition.rank ? NULL : mirror_of(r.shard_rank);
+
+    int32_t served = 0;
+    int used = sizeof(served);
+    for (; served < r.count; served++) {
+        int32_t leaf;
+        memcpy(&leaf, req + sizeof(r) + sizeof(int32_t) * served, sizeof(leaf));
+        if (leaf < 0 || leaf >= tree->leaf_count) return -1;
+        const uint8_t *record;
+        uint32_t bytes;
+        if (m) {
+            record = m->records[leaf];
+            bytes = m->lengths[leaf];
+        } else {
+            record = ensure_record_buf();
+            bytes = (uint32_t)merkle_node_record(leaf, record_buf);
+        }
+        if (used + (int)sizeof(bytes) + (int)bytes > cap) break;
+        memcpy(reply + used, &bytes, sizeof(bytes));
+        memcpy(reply + used + sizeof(bytes), record, bytes);
+        used += sizeof(bytes) + bytes;
+    }
+    memcpy(reply, &served, sizeof(served));
+    return used;
+}
+
+void merkle_sync_init(void) {
+    partition_register_handler(PARTITION_OP_MERKLE_NODES, handle_nodes);
+    partition_register_handler(PARTITION_OP_MERKLE_RECORDS, handle_records);
+}
+
+void merkle_sync_free(void) {
+    if (mirrors) {
+        for (int r = 0; r < partition.size; r++) mirror_free(mirrors[r]);
+    }
+    free(mirrors);
+    free(record_buf);
+    mirrors = NULL;
+    record_buf = NULL;
+}
+
+// ---- Applying records -----------------------------------------------------
+
+// Writes a record into owned slot through the usual mutators, so the ANN
+// index, halo, parity index and announcements all follow. -1 if malformed.
+static int apply_node_record(int slot, const uint8_t *record, uint32_t length) {
+    TorusNode *n = &network[slot];
+    const uint8_t *p = record, *end = record + length;
+    int32_t id;
+    if (end - p < (long)sizeof(id)) return -1;
+    memcpy(&id, p, sizeof(id));
+    p += sizeof(id);
+    if (id != n->id) return -1;
+    const uint8_t *hash_end = memchr(p, 0, end - p);
+    if (!hash_end || hash_end - p >= MAX_HASH_SIZE) return -1;
+    size_t state_bytes = sizeof(double) * (2 + vector_dim);
+    if ((size_t)(end - hash_end - 1) < state_bytes) return -1;
+    memcpy(n->hash, p, hash_end - p + 1);
+    p = hash_end + 1;
+
+    double density, coherence;
+    memcpy(&density, p, sizeof(double));
+    memcpy(&coherence, p + sizeof(double), sizeof(double));
+    double *vector = malloc(sizeof(double) * vector_dim);
+    memcpy(vector, p + 2 * sizeof(double), sizeof(double) * vector_dim);
+    inject_vector(n, vector, vector_dim);
+    free(vector);
+    node_hot.density[slot] = density;
+    node_hot.coherence[slot] = coherence;
+    p += state_bytes;
+
+    parity_tag_id_t wanted[MAX_PARITY_TAGS];
+    int wanted_count = 0;
+    while (p < end && wanted_count < MAX_PARITY_TAGS) {
+        const uint8_t *name_end = memchr(p, 0, end - p);
+        if (!name_end) return -1;
+        wanted[wanted_count++] = tag_intern_n((const char *)p, name_end - p);
+        p = name_end + 1;
+    }
+    for (int i = n->parity_count - 1; i >= 0; i--) {
+        parity_tag_id_t tag = n->parity_tags[i];
+        int keep = 0;
+        for (int k = 0; k < wanted_count && !keep; k++) keep = wanted[k] == tag;
+        if (!keep) remove_parity_tag_id(n->id, tag);
+    }
+    for (int k = 0; k < wanted_count; k++) {
+        int held = 0;
+        for (int i = 0; i < n->parity_count && !held; i++) held = n->parity_tags[i] == wanted[k];
+        if (!held) assign_parity_tag_id(n->id, wanted[k]);
+    }
+    partition_mark_dirty(n->id);
+    return 0;
+}
+
+static int apply_mirror_record(merkle_mirror_t *m, int leaf, const uint8_t *record, uint32_t length) {
+    m->records[leaf] = realloc(m->records[leaf], length > 0 ? length : 1);
+    memcpy(m->records[leaf], record, length);
+    m->lengths[leaf] = length;
+    merkle_set_leaf(m->tree, leaf, record, length);
+    return 0;
+}
+
+// ---- Pulling --------------------------------------------------------------
+
+typedef struct {
+    int peer;
+    int shard;
+    merkle_sync_stats_t *stats;
+    uint8_t *request;
+    uint8_t *reply;
+} sync_session_t;
+
+static int session_call(sync_session_t *s, partition_op_t op, int length) {
+    int n = partition_call(s->peer, op, s->request, length, s->reply, SYNC_REPLY_BYTES);
+    s->stats->rounds++;
+    s->stats->bytes_sent += SYNC_REQUEST_OVERHEAD + length;
+    if (n >= 0) s->stats->bytes_received += SYNC_REPLY_OVERHEAD + n;
+    return n;
+}
+
+// Fetches the peer's digests for indices[0..count) of level and appends
+// those that differ from local to out. Returns the new out count, or -1.
+static int diff_entries(sync_session_t *s, const merkle_tree_t *local, int level,
+                        const int *indices, int count, int *out, int out_count) {
+    for (int begin = 0; begin < count; begin += MERKLE_SYNC_BATCH) {
+        int batch = count - begin < MERKLE_SYNC_BATCH ? count - begin : MERKLE_SYNC_BATCH;
+        nodes_request_t r = { s->shard, level, batch };
+        memcpy(s->request, &r, sizeof(r));
+        for (int i = 0; i < batch; i++) {
+            int32_t index = indices[begin + i];
+            memcpy(s->request + sizeof(r) + sizeof(int32_t) * i, &index, sizeof(index));
+        }
+        int n = session_call(s, PARTITION_OP_MERKLE_NODES, (int)(sizeof(r) + sizeof(int32_t) * batch));
+        if (n != batch * MERKLE_DIGEST_SIZE) return -1;
+        s->stats->entries_compared += batch;
+        for (int i = 0; i < batch; i++) {
+            int index = indices[begin + i];
+            if (memcmp(s->reply + i * MERKLE_DIGEST_SIZE, merkle_node_hash(local, level, index), MERKLE_DIGEST_SIZE)) {
+                out[out_count++] = index;
+            }
+        }
+    }
+    return out_count;
+}
+
+// Walks down from the root, keeping only differing entries at each level.
+// Leaves the differing leaf indices, sorted, in leaves; returns the count.
+static int diff_tree(sync_session_t *s, const merkle_tree_t *local, int *leaves) {
+    int *frontier = malloc(sizeof(int) * local->leaf_count);
+    int *children = malloc(sizeof(int) * local->leaf_count);
+    int count = 1;
+    frontier[0] = 0;
+    for (int level = local->levels - 2; level >= 0 && count > 0; level--) {
+        // A promoted entry equals its parent, which is known to differ.
+        int fetch = 0, promoted = -1;
+        for (int i = 0; i < count; i++) {
+            int child = 2 * frontier[i];
+            if (child + 1 < local->level_size[level]) {
+                children[fetch++] = child;
+                children[fetch++] = child + 1;
+            } else {
+                promoted = child;
+            }
+        }
+        int next = diff_entries(s, local, level, children, fetch, frontier, 0);
+        if (next < 0) {
+            count = -1;
+            break;
+        }
+        if (promoted >= 0) frontier[next++] = promoted;
+        count = next;
+    }
+    if (count > 0) memcpy(leaves, frontier, sizeof(int) * count);
+    free(frontier);
+    free(children);
+    return count;
+}
+
+// Fetches and applies the records of leaves[0..count).
+static int pull_records(sync_session_t *s, merkle_mirror_t *m, const int *leaves, int count) {
+    int applied = 0;
+    int begin = 0;
+    while (begin < count) {
+        int batch = count - begin < MERKLE_SYNC_BATCH ? count - begin : MERKLE_SYNC_BATCH;
+        records_request_t r = { s->shard, batch };
+        memcpy(s->request, &r, sizeof(r));
+        for (int i = 0; i < batch; i++) {
+            int32_t leaf = leaves[begin + i];
+            memcpy(s->request + sizeof(r) + sizeof(int32_t) * i, &leaf, sizeof(leaf));
+        }
+        int n = session_call(s, PARTITION_OP_MERKLE_RECORDS, (int)(sizeof(r) + sizeof(int32_t) * batch));
+        int32_t served;
+        if (n < (int)sizeof(served)) return -1;
+        memcpy(&served, s->reply, sizeof(served));
+        if (served <= 0 || served > batch) return -1;   // a record larger than a reply
+
+        const uint8_t *p = s->reply + sizeof(served), *end = s->reply + n;
+        for (int i = 0; i < served; i++) {
+            uint32_t length;
+            if (end - p < (long)sizeof(length)) return -1;
+            memcpy(&length, p, sizeof(length));
+            p += sizeof(length);
+            if ((uint32_t)(end - p) < length) return -1;
+            int leaf = leaves[begin + i];
+            int ok = m ? apply_mirror_record(m, leaf, p, length) : apply_node_record(leaf, p, length);
+            if (ok != 0) return -1;
+            p += length;
+            applied++;
+        }
+        begin += served;
+    }
+    return applied;
+}
+
+static long long full_sync_bytes(int shard_rank, int leaf_count) {
+    long long bytes = 0;
+    merkle_mirror_t *m = shard_rank == partition.rank ? NULL : mirror_of(shard_rank);
+    if (!m) ensure_record_buf();
+    for (int i = 0; i < leaf_count; i++) {
+        bytes += sizeof(uint32_t) + (m ? m->lengths[i] : merkle_node_record(i, record_buf));
+    }
+    long long messages = (bytes + SYNC_REPLY_BYTES - 1) / SYNC_REPLY_BYTES;
+    return bytes + messages * (SYNC_REQUEST_OVERHEAD + SYNC_REPLY_OVERHEAD);
+}
+
+int merkle_sync(int peer_rank, int shard_rank, merkle_sync_stats_t *stats) {
+    merkle_sync_stats_t local_stats;
+    if (!stats) stats = &local_stats;
+    memset(stats, 0, sizeof(*stats));
+    stats->peer_rank = peer_rank;
+    stats->shard_rank = shard_rank;
+    if (peer_rank < 0 || peer_rank >= partition.size || peer_rank == partition.rank ||
+        shard_rank < 0 || shard_rank >= partition.size) {
+        return -1;
+    }
+    double t0 = now_ms();
+    sync_session_t s = { peer_rank, shard_rank, stats, NULL, NULL };
+    s.request = malloc(sizeof(nodes_request_t) + sizeof(int32_t) * MERKLE_SYNC_BATCH);
+    s.reply = malloc(SYNC_REPLY_BYTES);
+    int applied = -1;
+
+    nodes_request_t r = { shard_rank, SYNC_SHAPE_LEVEL, 0 };
+    memcpy(s.request, &r, sizeof(r));
+    sync_shape_t shape;
+    if (session_call(&s, PARTITION_OP_MERKLE_NODES, sizeof(r)) != (int)sizeof(shape)) goto done;
+    memcpy(&shape, s.reply, sizeof(shape));
+    stats->leaf_count = shape.leaf_count;
+
+    // A new or reshaped mirror starts empty and takes every record.
+    merkle_mirror_t *m = NULL;
+    int fresh = 0;
+    if (shard_rank != partition.rank) {
+        if (!mirrors) mirrors = calloc(partition.size, sizeof(merkle_mirror_t *));
+        m = mirrors[shard_rank];
+        if (!m || m->first != shape.first || m->leaf_count != shape.leaf_count) {
+            mirror_free(m);
+            m = mirrors[shard_rank] = shape.leaf_count > 0 ? mirror_create(shape.first, shape.leaf_count) : NULL;
+            fresh = 1;
+        }
+        if (!m) goto done;
+    }
+    int first;
+    merkle_tree_t *tree = shard_tree(shard_rank, &first);
+    if (!tree || first != shape.first || tree->leaf_count != shape.leaf_count) goto done;
+
+    int *leaves = malloc(sizeof(int) * tree->leaf_count);
+    int count;
+    if (fresh) {
+        for (int i = 0; i < tree->leaf_count; i++) leaves[i] = i;
+        count = tree->leaf_count;
+    } else if (memcmp(merkle_root(tree), shape.root, MERKLE_DIGEST_SIZE) == 0) {
+        count = 0;
+    } else {
+        count = diff_tree(&s, tree, leaves);
+    }
+    stats->leaves_differing = count;
+    if (count >= 0) applied = pull_records(&s, m, leaves, count);
+
+    if (applied > 0 && m) {
+        if (count > tree->leaf_count / 4) {
+            merkle_tree_rebuild(tree);
+        } else {
+            merkle_rehash_paths(tree, leaves, count);
+        }
+    }
+    free(leaves);
+    if (applied >= 0) {
+        tree = shard_tree(shard_rank, &first);   // flushes the live tree's noted changes
+        stats->converged = memcmp(merkle_root(tree), shape.root, MERKLE_DIGEST_SIZE) == 0;
+        stats->records_applied = applied;
+        stats->full_sync_bytes = full_sync_bytes(shard_rank, tree->leaf_count);
+    }
+
+done:
+    free(s.request);
+    free(s.reply);
+    stats->elapsed_ms = now_ms() - t0;
+    return applied;
+}
+
+void merkle_sync_report(const merkle_sync_stats_t *stats) {
+    long long moved = stats->bytes_sent + stats->bytes_received;
+    printf("[SYNC] Shard %d from rank %d: %d/%d leaves differed, %d records applied, %s\n",
+           stats->shard_rank, stats->peer_rank, stats->leaves_differing, stats->leaf_count,
+           stats->records_applied, stats->converged ? "converged" : "NOT converged");
+    printf("[SYNC] %d round trips, %d tree entries compared, %lld bytes (%lld out, %lld in) vs %lld full-state (%.2f%%), %.1f ms\n",
+           stats->rounds, stats->entries_compared, moved, stats->bytes_sent, stats->bytes_received,
+           stats->full_sync_bytes, stats->full_sync_bytes ? 100.0 * moved / stats->full_sync_bytes : 0.0,
+           stats->elapsed_ms);
+}
+
+// ---- Benchmark ------------------------------------------------------------
+
+// Changes count distinct random nodes of [first, first + owned) on their
+// owner. Requests to one rank run in order, so the sync that follows sees
+// all of them.
+static void change_nodes(int first, int owned, int count) {
+    double *vector = malloc(sizeof(double) * vector_dim);
+    uint8_t *picked = calloc(owned, 1);
+    for (int c = 0; c < count; c++) {
+        int local;
+        do {
+            local = rand() % owned;
+        } while (picked[local]);
+        picked[local] = 1;
+        double norm = 0;
+        for (int i = 0; i < vector_dim; i++) {
+            vector[i] = (double)rand() / RAND_MAX - 0.5;
+            norm += vector[i] * vector[i];
+        }
+        norm = sqrt(norm);
+        for (int i = 0; i < vector_dim; i++) vector[i] /= norm > 0 ? norm : 1;
+        partition_inject_vector(first + local, vector);
+    }
+    free(picked);
+    free(vector);
+}
+
+void merkle_sync_bench(double fraction, int shard_rank) {
+    if (partition.size < 2) {
+        printf("[SYNC] Needs at least two ranks\n");
+        return;
+    }
+    if (shard_rank <= 0 || shard_rank >= partition.size || shard_rank == partition.rank) {
+        shard_rank = partition.rank == 1 ? 0 : 1;
+    }
+    merkle_sync_stats_t stats;
+    if (merkle_sync(shard_rank, shard_rank, &stats) < 0) {
+        printf("[SYNC] Rank %d has no tree to sync from\n", shard_rank);
+        return;
+    }
+    printf("[SYNC] Initial mirror:\n");
+    merkle_sync_report(&stats);
+
+    double sweep[] = { 0.001, 0.01, 0.1 };
+    int runs = fraction > 0 ? 1 : (int)(sizeof(sweep) / sizeof(sweep[0]));
+    for (int run = 0; run < runs; run++) {
+        merkle_mirror_t *m = mirror_of(shard_rank);
+        double f = fraction > 0 ? (fraction < 1 ? fraction : 1) : sweep[run];
+        int changed = (int)(f * m->leaf_count + 0.5);
+        change_nodes(m->first, m->leaf_count, changed);
+        merkle_sync(shard_rank, shard_rank, &stats);
+        printf("[SYNC] %d of %d nodes changed (%.2f%%):\n", changed, m->leaf_count, 100.0 * f);
+        merkle_sync_report(&stats);
+    }
+}
@@ -0,0 +1,238 @@
+/*
+ * FT-DFRP: Hot Node State
+ *
+ * Dual Licensed:
+ * 1. AGPL-3.0 for research/academic use
+ * 2. Commercial license: contact michael.doran.808@gmail.com
+ *
+ * Copyright (C) 2025 Michael Doran
+ */
+
+#include "node_store.h"
+#include "ann.h"
+#include "parity_types.h"
+#include "topology.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+node_store_t node_hot;
+
+void node_store_init(int count, int dim) {
+    node_store_free();
+    node_hot.dim = dim;
+    node_store_resize(count);
+}
+
+// Moves attached arrays onto the heap so they can be reallocated.
+static void own_arrays(void) {
+    size_t rows = node_hot.count > 0 ? node_hot.count : 1;
+    double *density = malloc(sizeof(double) * rows);
+    double *coherence = malloc(sizeof(double) * rows);
+    double *vectors = malloc(sizeof(double) * rows * node_hot.dim);
+    memcpy(density, node_hot.density, sizeof(double) * node_hot.count);
+    memcpy(coherence, node_hot.coherence, sizeof(double) * node_hot.count);
+    memcpy(vectors, node_hot.vectors, sizeof(double) * (size_t)node_hot.count * node_hot.dim);
+    node_hot.density = density;
+    node_hot.coherence = coherence;
+    node_hot.vectors = vectors;
+    node_hot.borrowed = 0;
+}
+
+void node_store_resize(int count) {
+    int dim = node_hot.dim;
+    if (count > node_hot.capacity) {
+        if (node_hot.borrowed) own_arrays();
+        node_hot.density = realloc(node_hot.density, sizeof(double) * count);
+        node_hot.coherence = realloc(node_hot.coherence, sizeof(double) * count);
+        node_hot.vectors = realloc(node_hot.vectors, sizeof(double) * (size_t)count * dim);
+        node_hot.capacity = count;
+    }
+    int old = node_hot.count;
+    if (count > old) {
+        memset(node_hot.density + old, 0, sizeof(double) * (count - old));
+        memset(node_hot.coherence + old, 0, sizeof(double) * (count - old));
+        memset(node_hot.vectors + (size_t)old * dim, 0, sizeof(double) * (size_t)(count - old) * dim);
+    }
+    node_hot.count = count;
+}
+
+void node_store_free(void) {
+    if (!node_hot.borrowed) {
+        free(node_hot.density);
+        free(node_hot.coherence);
+        free(node_hot.vectors);
+    }
+    memset(&node_hot, 0, sizeof(node_hot));
+}
+
+void node_store_attach(int count, int capacity, int dim, double *density, double *coherence,
+                       double *vectors) {
+    node_store_free();
+    node_hot.count = count;
+    node_hot.capacity = capacity;
+    node_hot.dim = dim;
+    node_hot.density = density;
+    node_hot.coherence = coherence;
+    node_hot.vectors = vectors;
+    node_hot.borrowed = 1;
+}
+
+// ---- Layout benchmark -----------------------------------------------------
+
+// The node record as it was before the split: hot fields interleaved with
+// the parity state, each vector in its own allocation.
+typedef struct {
+    int id;
+    double density;
+    double coherence;
+    parity_tag_id_t parity_tags[MAX_PARITY_TAGS];
+    int parity_count;
+    uint32_t parity_version;
+    parity_change_t *change_log;
+    char hash[MAX_HASH_SIZE];
+    double *vector;
+    parity_announcement_t *known_parity_map;
+    int map_size;
+    time_t last_announcement;
+    int replication_factor;
+} legacy_node_t;
+
+#define BENCH_K 10
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static double route_aos(const legacy_node_t *legacy, const topology_t *t, const int *queries,
+                        int count, int dim) {
+    double checksum = 0.0;
+    for (int q = 0; q < count; q++) {
+        const double *target = legacy[queries[(q + 1) % count]].vector;
+        const int *neighbors = topology_neighbors(t, queries[q]);
+        double best = -INFINITY;
+        for (int i = 0; i < topology_degree(t, queries[q]); i++) {
+            const legacy_node_t *n = &legacy[neighbors[i]];
+            double score = 0.3 * n->density + 0.5 * cosine_similarity(n->vector, target, dim) +
+                           0.2 * n->coherence;
+            if (score > best) best = score;
+        }
+        checksum += best;
+    }
+    return checksum;
+}
+
+static double route_soa(const node_store_t *s, const topology_t *t, const int *queries, int count) {
+    double checksum = 0.0;
+    for (int q = 0; q < count; q++) {
+        const double *target = s->vectors + (size_t)queries[(q + 1) % count] * s->dim;
+        const int *neighbors = topology_neighbors(t, queries[q]);
+        double best = -INFINITY;
+        for (int i = 0; i < topology_degree(t, queries[q]); i++) {
+            int v = neighbors[i];
+            double score = 0.3 * s->density[v] +
+                           0.5 * cosine_similarity(s->vectors + (size_t)v * s->dim, target, s->dim) +
+                           0.2 * s->coherence[v];
+            if (score > best) best = score;
+        }
+        checksum += best;
+    }
+    return checksum;
+}
+
+static double knn_aos(const legacy_node_t *legacy, int nodes, const int *queries, int count, int dim) {
+    similarity_result_t top[BENCH_K];
+    double checksum = 0.0;
+    for (int q = 0; q < count; q++) {
+        const legacy_node_t *query = &legacy[queries[q]];
+        similarity_heap_t heap;
+        similarity_heap_init(&heap, top, BENCH_K);
+        for (int i = 0; i < nodes; i++) {
+            double similarity = cosine_similarity(query->vector, legacy[i].vector, dim);
+            double score = similarity * query->coherence + legacy[i].density;
+            if (heap.count == BENCH_K && score <= top[0].combined_score) continue;
+            heap_insert(&heap, i, similarity, score);
+        }
+        checksum += top[0].combined_score;
+    }
+    return checksum;
+}
+
+static double knn_soa(const node_store_t *s, int nodes, const int *queries, int count) {
+    similarity_result_t top[BENCH_K];
+    double checksum = 0.0;
+    for (int q = 0; q < count; q++) {
+        const double *query = s->vectors + (size_t)queries[q] * s->dim;
+        double coherence = s->coherence[queries[q]];
+        similarity_heap_t heap;
+        similarity_heap_init(&heap, top, BENCH_K);
+        for (int i = 0; i < nodes; i++) {
+            double similarity = cosine_similarity(query, s->vectors + (size_t)i * s->dim, s->dim);
+            double score = similarity * coherence + s->density[i];
+            if (heap.count == BENCH_K && score <= top[0].combined_score) continue;
+            heap_insert(&heap, i, similarity, score);
+        }
+        checksum += top[0].combined_score;
+    }
+    return checksum;
+}
+
+void node_layout_bench(int nodes, int queries) {
+    if (nodes <= 0) nodes = 100000;
+    if (queries <= 0) queries = 200;
+    int dim = DEFAULT_VECTOR_DIM;
+
+    topology_t t;
+    topology_build_fractal(&t, nodes, 0);
+    legacy_node_t *legacy = calloc(nodes, sizeof(legacy_node_t));
+    node_store_t s = { .count = nodes, .capacity = nodes, .dim = dim };
+    s.density = malloc(sizeof(double) * nodes);
+    s.coherence = malloc(sizeof(double) * nodes);
+    s.vectors = malloc(sizeof(double) * (size_t)nodes * dim);
+    for (int i = 0; i < nodes; i++) {
+        legacy[i].id = i;
+        legacy[i].density = s.density[i] = drand48();
+        legacy[i].coherence = s.coherence[i] = drand48();
+        legacy[i].vector = malloc(sizeof(double) * dim);
+        for (int d = 0; d < dim; d++) legacy[i].vector[d] = drand48() - 0.5;
+        vector_normalize(legacy[i].vector, dim);
+        memcpy(s.vectors + (size_t)i * dim, legacy[i].vector, sizeof(double) * dim);
+    }
+
+    int hops = queries * 1000;
+    int *route_queries = malloc(sizeof(int) * hops);
+    int *knn_queries = malloc(sizeof(int) * queries);
+    for (int i = 0; i < hops; i++) route_queries[i] = rand() % nodes;
+    for (int i = 0; i < queries; i++) knn_queries[i] = rand() % nodes;
+
+    double t0 = now_us();
+    double c0 = route_aos(legacy, &t, route_queries, hops, dim);
+    double t1 = now_us();
+    double c1 = route_soa(&s, &t, route_queries, hops);
+    double t2 = now_us();
+    double c2 = knn_aos(legacy, nodes, knn_queries, queries, dim);
+    double t3 = now_us();
+    double c3 = knn_soa(&s, nodes, knn_queries, queries);
+    double t4 = now_us();
+
+    printf("[LAYOUT] %d nodes, dim %d, mean degree %.1f | record %zu B -> hot row %zu B\n",
+           nodes, dim, (double)t.offsets[nodes] / nodes, sizeof(legacy_node_t),
+           sizeof(double) * (2 + dim));
+    printf("[LAYOUT] routing hops:  structs %10.0f/s | components %10.0f/s | x%.2f\n",
+           hops / ((t1 - t0) / 1e6), hops / ((t2 - t1) / 1e6), (t1 - t0) / (t2 - t1));
+    printf("[LAYOUT] k-NN scans:    structs %10.1f/s | components %10.1f/s | x%.2f\n",
+           queries / ((t3 - t2) / 1e6), queries / ((t4 - t3) / 1e6), (t3 - t2) / (t4 - t3));
+    if (c0 != c1 || c2 != c3) printf("[LAYOUT] Warning: layouts disagree (%g/%g, %g/%g)\n", c0, c1, c2, c3);
+
+    for (int i = 0; i < nodes; i++) free(legacy[i].vector);
+    free(legacy);
+    free(s.density);
+    free(s.coherence);
+    free(s.vectors);
+    free(route_queries);
+    free(knn_queries);
+    topology_free(&t);
+}
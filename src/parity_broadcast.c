@@ -1,69 +1,579 @@
 /*
  * FT-DFRP: Parity Broadcast and Distribution System
- * 
+ *
  * Dual Licensed:
  * 1. AGPL-3.0 for research/academic use: https://www.gnu.org/licenses/agpl-3.0.html
  * 2. Commercial license available - contact michael.doran.808@gmail.com for terms
- * 
+ *
  * Copyright (C) 2025 Michael Doran
  */
 
 #include "fractal.h"
+#include "journal.h"
+#include "memory_guard.h"
+#include "merkle.h"
 #include "parity_types.h"
-#include <mpi.h>
+#include "parity_broadcast.h"
+#include "parity_index.h"
+#include "parity_wire.h"
+#include "partition.h"
+#include "topology.h"
+#include "transport.h"
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <time.h>
+
+typedef struct {
+    long messages[PARITY_MSG_DIGEST + 1];
+    long bytes[PARITY_MSG_DIGEST + 1];
+    long skipped;          // neighbour already up to date
+    long stale_deltas;     // delta base did not match, left to anti-entropy
+} gossip_stats_t;
+
+static gossip_stats_t stats;
+
+// Version of each announcer the replicated parity index reflects, so a
+// late FULL never rolls the index back. Indexed by global node id.
+static uint32_t *indexed_versions;
+static int indexed_capacity;
+
+// Records version as the one indexed for announcer unless the index already
+// reflects a newer one; returns 1 when the caller should update the index.
+static int index_accepts_version(int announcer, uint32_t version) {
+    if (announcer >= indexed_capacity) {
+        int capacity = total_nodes > announcer ? total_nodes : announcer + 1;
+        indexed_versions = realloc(indexed_versions, sizeof(uint32_t) * capacity);
+        memset(indexed_versions + indexed_capacity, 0, sizeof(uint32_t) * (capacity - indexed_capacity));
+        indexed_capacity = capacity;
+    }
+    if (indexed_versions[announcer] > version) return 0;
+    indexed_versions[announcer] = version;
+    return 1;
+}
+
+// Our parity_version each neighbour was last sent, one slot per outgoing
+// topology edge of the owned nodes.
+static uint32_t *sent_versions;
+
+static uint32_t *sent_versions_of(int node_id) {
+    int base = topology.offsets[partition.first];
+    if (!sent_versions) {
+        int edges = topology.offsets[partition.first + partition.owned] - base;
+        sent_versions = calloc(edges > 0 ? edges : 1, sizeof(uint32_t));
+    }
+    return sent_versions + (topology.offsets[node_id] - base);
+}
 
 void sign_announcement(parity_announcement_t *a) {
     snprintf(a->signature, MAX_HASH_SIZE, "SIG-%d-%ld", a->node_id, a->timestamp);
 }
 
+int parity_record_change(int node_id, parity_tag_id_t tag, int removed) {
+    if (!partition_owns(node_id)) return 0;
+    TorusNode *n = node_ref(node_id);
+    if (!n->change_log) {
+        n->change_log = calloc(PARITY_CHANGE_LOG_SIZE, sizeof(parity_change_t));
+    }
+    n->parity_version++;
+    n->change_log[n->parity_version % PARITY_CHANGE_LOG_SIZE] =
+        (parity_change_t){ n->parity_version, tag, removed };
+    merkle_note_changed(node_id);
+    return journal_log_tag(node_id, tag, removed);
+}
+
+// Latest state of announcer that node n knows, or NULL.
+static parity_announcement_t* known_state(TorusNode *n, int announcer) {
+    for (int i = 0; i < n->map_size; i++) {
+        if (n->known_parity_map[i].node_id == announcer) return &n->known_parity_map[i];
+    }
+    return NULL;
+}
+
+// Every rank keeps the parity index for the whole network; knowledge maps
+// exist only on the rank owning node_id.
 void update_parity_knowledge_map(int node_id, parity_announcement_t *a) {
-    TorusNode *n = &network[node_id];
-    if (n->map_size < MAX_PARITY_TAGS) {
+    if (index_accepts_version(a->node_id, a->version)) {
+        parity_index_set_node_tags(a->node_id, a->parity_tags, a->parity_count);
+    }
+    if (!partition_owns(node_id)) return;
+
+    TorusNode *n = node_ref(node_id);
+    parity_announcement_t *known = known_state(n, a->node_id);
+    if (known && known->version > a->version) return;
+    if (known) {
+        *known = *a;
+    } else if (n->map_size < MAX_PARITY_TAGS) {
+        if (!n->known_parity_map) n->known_parity_map = SAFE_MALLOC(sizeof(parity_announcement_t) * MAX_PARITY_TAGS);
         n->known_parity_map[n->map_size++] = *a;
     }
 }
 
-void announce_parity_holdings(int node_id) {
-    TorusNode *node = &network[node_id];
-    parity_announcement_t a;
-    a.node_id = node_id;
-    a.parity_count = node->parity_count;
-    a.load_factor = calculate_node_load(node_id);
-    a.timestamp = get_current_timestamp();
-    for (int i = 0; i < a.parity_count; i++) {
-        strncpy(a.parity_tags[i], node->parity_tags[i], 63);
-    }
-    sign_announcement(&a);
-    MPI_Bcast(&a, sizeof(parity_announcement_t), MPI_BYTE, node_id, MPI_COMM_WORLD);
-    update_parity_knowledge_map(node_id, &a);
+double calculate_node_load(int node_id) {
+    return (double)parity_index_node_count(node_id) / MAX_PARITY_TAGS;
+}
+
+time_t get_current_timestamp(void) {
+    return time(NULL);
 }
 
 void build_announcement(int node_id, parity_announcement_t *a) {
-    TorusNode *n = &network[node_id];
+    TorusNode *n = node_ref(node_id);
     a->node_id = node_id;
+    a->version = n->parity_version;
     a->parity_count = n->parity_count;
     a->load_factor = calculate_node_load(node_id);
     a->timestamp = get_current_timestamp();
-    for (int i = 0; i < n->parity_count; i++) {
-        strncpy(a->parity_tags[i], n->parity_tags[i], 63);
-    }
+    memcpy(a->parity_tags, n->parity_tags, sizeof(parity_tag_id_t) * n->parity_count);
     sign_announcement(a);
 }
 
+// Net tag changes of node_id since base. Fails when the log no longer
+// covers base or the net change does not fit a single delta.
+static int build_delta(int node_id, uint32_t base, parity_delta_t *d) {
+    TorusNode *n = node_ref(node_id);
+    if (!n->change_log || base >= n->parity_version ||
+        n->parity_version - base > PARITY_CHANGE_LOG_SIZE) {
+        return -1;
+    }
+
+    d->node_id = node_id;
+    d->version = n->parity_version;
+    d->base_version = base;
+    d->added_count = d->removed_count = 0;
+    for (uint32_t v = base + 1; v <= n->parity_version; v++) {
+        const parity_change_t *c = &n->change_log[v % PARITY_CHANGE_LOG_SIZE];
+        // Last change to a tag wins.
+        for (int i = 0; i < d->added_count; i++) {
+            if (d->added[i] == c->tag) d->added[i--] = d->added[--d->added_count];
+        }
+        for (int i = 0; i < d->removed_count; i++) {
+            if (d->removed[i] == c->tag) d->removed[i--] = d->removed[--d->removed_count];
+        }
+        if (c->removed) {
+            if (d->removed_count == MAX_PARITY_TAGS) return -1;
+            d->removed[d->removed_count++] = c->tag;
+        } else {
+            if (d->added_count == MAX_PARITY_TAGS) return -1;
+            d->added[d->added_count++] = c->tag;
+        }
+    }
+    d->load_factor = calculate_node_load(node_id);
+    d->timestamp = get_current_timestamp();
+    snprintf(d->signature, MAX_HASH_SIZE, "SIG-%d-%ld", node_id, d->timestamp);
+    return 0;
+}
+
+static int apply_delta(int node_id, const parity_delta_t *d) {
+    parity_announcement_t *known = known_state(node_ref(node_id), d->node_id);
+    if (known && known->version >= d->version) return 0;
+    if (!known || known->version != d->base_version) {
+        stats.stale_deltas++;
+        return -1;
+    }
+
+    for (int i = 0; i < d->removed_count; i++) {
+        for (int j = 0; j < known->parity_count; j++) {
+            if (known->parity_tags[j] == d->removed[i]) {
+                known->parity_tags[j] = known->parity_tags[--known->parity_count];
+                break;
+            }
+        }
+    }
+    for (int i = 0; i < d->added_count; i++) {
+        int present = 0;
+        for (int j = 0; j < known->parity_count; j++) {
+            if (known->parity_tags[j] == d->added[i]) {
+                present = 1;
+                break;
+            }
+        }
+        if (!present && known->parity_count < MAX_PARITY_TAGS) {
+            known->parity_tags[known->parity_count++] = d->added[i];
+        }
+    }
+    known->version = d->version;
+    known->load_factor = d->load_factor;
+    known->timestamp = d->timestamp;
+    memcpy(known->signature, d->signature, MAX_HASH_SIZE);
+    if (index_accepts_version(known->node_id, known->version)) {
+        parity_index_set_node_tags(known->node_id, known->parity_tags, known->parity_count);
+    }
+    return 0;
+}
+
+// Messages travel as frames: a 4-byte little-endian target node id, then
+// the wire-encoded message. Senders encode at frame + PARITY_FRAME_HEADER.
+#define PARITY_FRAME_HEADER 4
+#define PARITY_FRAME_MAX (PARITY_FRAME_HEADER + PARITY_WIRE_MAX_BYTES)
+
+static void frame_target(uint8_t *frame, int node_id) {
+    uint32_t id = (uint32_t)node_id;
+    for (int i = 0; i < PARITY_FRAME_HEADER; i++) frame[i] = (uint8_t)(id >> (8 * i));
+}
+
+static void send_frame(int target, uint8_t *frame, int length) {
+    int type = parity_wire_message_type(frame + PARITY_FRAME_HEADER, length);
+    stats.messages[type]++;
+    stats.bytes[type] += length;
+    frame_target(frame, target);
+    transport_send(partition_owner(target), TRANSPORT_CHANNEL_PARITY, frame, PARITY_FRAME_HEADER + length);
+}
+
+// Runs on the owner of node_id: returns 1 after handing op over when that
+// is another rank.
+static int forward_to_owner(partition_op_t op, int node_id) {
+    if (partition_owns(node_id)) return 0;
+    int32_t id = node_id;
+    partition_post(partition_owner(node_id), op, &id, sizeof(id));
+    return 1;
+}
+
+// Sends node_id's full state to every rank (including this one, which
+// applies it on the next parity_broadcast_poll) without a collective.
+void announce_parity_holdings(int node_id) {
+    if (forward_to_owner(PARTITION_OP_ANNOUNCE, node_id)) return;
+    parity_announcement_t a;
+    uint8_t frame[PARITY_FRAME_MAX];
+    build_announcement(node_id, &a);
+    int length = parity_wire_encode(&a, frame + PARITY_FRAME_HEADER, PARITY_WIRE_MAX_BYTES);
+    if (length < 0) return;
+    stats.messages[PARITY_MSG_FULL]++;
+    stats.bytes[PARITY_MSG_FULL] += length;
+    frame_target(frame, node_id);
+    transport_broadcast(TRANSPORT_CHANNEL_PARITY, frame, PARITY_FRAME_HEADER + length);
+
+    // Everyone gets the full state; gossip has nothing to add.
+    uint32_t *sent = sent_versions_of(node_id);
+    for (int i = 0; i < topology_degree(&topology, node_id); i++) {
+        sent[i] = a.version;
+    }
+}
+
+int announce_owned_holdings(void) {
+    int announced = 0;
+    for (int i = 0; i < partition.owned; i++) {
+        if (network[i].parity_count == 0) continue;
+        announce_parity_holdings(network[i].id);
+        announced++;
+    }
+    transport_flush();
+    return announced;
+}
+
 void send_announcement_to_neighbor(int neighbor_id, parity_announcement_t *a) {
-    MPI_Send(a, sizeof(parity_announcement_t), MPI_BYTE, neighbor_id, 0, MPI_COMM_WORLD);
+    uint8_t frame[PARITY_FRAME_MAX];
+    int length = parity_wire_encode(a, frame + PARITY_FRAME_HEADER, PARITY_WIRE_MAX_BYTES);
+    if (length < 0) return;
+    send_frame(neighbor_id, frame, length);
 }
 
-void gossip_parity_announcement(int node_id) {
-    TorusNode *n = &network[node_id];
+// Brings target from base (0 = nothing known) to node_id's current version.
+static void send_state_update(int node_id, int target, uint32_t base) {
+    uint8_t frame[PARITY_FRAME_MAX];
+    parity_delta_t d;
+    if (base > 0 && build_delta(node_id, base, &d) == 0) {
+        int length = parity_wire_encode_delta(&d, frame + PARITY_FRAME_HEADER, PARITY_WIRE_MAX_BYTES);
+        if (length > 0) {
+            send_frame(target, frame, length);
+            return;
+        }
+    }
     parity_announcement_t a;
     build_announcement(node_id, &a);
-    int gossip_targets = (n->neighbor_count < 3) ? n->neighbor_count : 3;
-    for (int i = 0; i < gossip_targets; i++) {
-        int target = n->neighbors[rand() % n->neighbor_count];
-        send_announcement_to_neighbor(target, &a);
+    send_announcement_to_neighbor(target, &a);
+}
+
+void gossip_parity_announcement(int node_id) {
+    if (forward_to_owner(PARTITION_OP_GOSSIP, node_id)) return;
+    TorusNode *n = node_ref(node_id);
+    int degree = topology_degree(&topology, node_id);
+    if (degree == 0) return;
+    const int *neighbors = topology_neighbors(&topology, node_id);
+    uint32_t *versions = sent_versions_of(node_id);
+
+    int start = rand() % degree;
+    int sent = 0;
+    for (int i = 0; i < degree && sent < PARITY_GOSSIP_FANOUT; i++) {
+        int slot = (start + i) % degree;
+        if (versions[slot] == n->parity_version) {
+            stats.skipped++;
+            continue;
+        }
+        send_state_update(node_id, neighbors[slot], versions[slot]);
+        versions[slot] = n->parity_version;
+        sent++;
+    }
+}
+
+static int build_digest(int node_id, parity_digest_entry_t *entries) {
+    TorusNode *n = node_ref(node_id);
+    int count = 0;
+    entries[count++] = (parity_digest_entry_t){ node_id, n->parity_version };
+    for (int i = 0; i < n->map_size && count < PARITY_DIGEST_MAX_ENTRIES; i++) {
+        if (n->known_parity_map[i].node_id == node_id) continue;
+        entries[count++] = (parity_digest_entry_t){ n->known_parity_map[i].node_id,
+                                                    n->known_parity_map[i].version };
+    }
+    return count;
+}
+
+static void send_digest(int node_id, int target, int flags) {
+    parity_digest_entry_t entries[PARITY_DIGEST_MAX_ENTRIES];
+    uint8_t frame[PARITY_FRAME_MAX];
+    int count = build_digest(node_id, entries);
+    int length = parity_wire_encode_digest(node_id, flags, entries, count,
+                                           frame + PARITY_FRAME_HEADER, PARITY_WIRE_MAX_BYTES);
+    if (length > 0) send_frame(target, frame, length);
+}
+
+void parity_anti_entropy_round(int node_id) {
+    if (forward_to_owner(PARTITION_OP_ANTI_ENTROPY, node_id)) return;
+    int degree = topology_degree(&topology, node_id);
+    if (degree == 0) return;
+    send_digest(node_id, topology_neighbors(&topology, node_id)[rand() % degree], 0);
+}
+
+// Gossip marks an edge up to date as soon as a DELTA goes out, and a
+// receiver whose base does not match drops it. The sweep is what brings
+// such a receiver back: every tick sends digests for the next
+// PARITY_ANTI_ENTROPY_BATCH owned nodes, round robin.
+static int sweep_next;
+
+static void anti_entropy_tick(void) {
+    if (!network || partition.owned == 0 || topology.nodes != total_nodes) return;
+    int batch = partition.owned < PARITY_ANTI_ENTROPY_BATCH ? partition.owned : PARITY_ANTI_ENTROPY_BATCH;
+    for (int i = 0; i < batch; i++) {
+        if (sweep_next >= partition.owned) sweep_next = 0;
+        parity_anti_entropy_round(partition.first + sweep_next++);
+    }
+}
+
+// Pushes every state node_id knows newer than the digest sender, and asks
+// back (once) for anything the sender knows newer than node_id.
+static void handle_digest(int node_id, int sender, int flags,
+                          const parity_digest_entry_t *entries, int count) {
+    TorusNode *n = node_ref(node_id);
+    int sender_ahead = 0;
+
+    for (int i = 0; i < count; i++) {
+        uint32_t mine;
+        if (entries[i].node_id == node_id) {
+            mine = n->parity_version;
+        } else {
+            parity_announcement_t *known = known_state(n, entries[i].node_id);
+            mine = known ? known->version : 0;
+        }
+        if (entries[i].version > mine) sender_ahead = 1;
+    }
+
+    // Own state, then every known state, the sender is missing or behind on.
+    for (int s = -1; s < n->map_size; s++) {
+        int announcer = s < 0 ? node_id : n->known_parity_map[s].node_id;
+        uint32_t mine = s < 0 ? n->parity_version : n->known_parity_map[s].version;
+        if (s >= 0 && announcer == node_id) continue;
+        if (announcer == sender || mine == 0) continue;
+
+        uint32_t theirs = 0;
+        for (int i = 0; i < count; i++) {
+            if (entries[i].node_id == announcer) {
+                theirs = entries[i].version;
+                break;
+            }
+        }
+        if (theirs >= mine) continue;
+        if (s < 0) {
+            send_state_update(node_id, sender, theirs);
+        } else {
+            send_announcement_to_neighbor(sender, &n->known_parity_map[s]);
+        }
+    }
+
+    if (sender_ahead && !(flags & PARITY_DIGEST_REPLY)) {
+        send_digest(node_id, sender, PARITY_DIGEST_REPLY);
+    }
+}
+
+// Applies one wire message on behalf of node_id.
+static int dispatch_message(int node_id, const uint8_t *buf, int length) {
+    int rc = -1, decoded = -1;
+    switch (parity_wire_message_type(buf, length)) {
+    case PARITY_MSG_FULL: {
+        parity_announcement_t a;
+        if ((decoded = parity_wire_decode(buf, length, &a)) >= 0) {
+            update_parity_knowledge_map(node_id, &a);
+            rc = 0;
+        }
+        break;
+    }
+    case PARITY_MSG_DELTA: {
+        parity_delta_t d;
+        if ((decoded = parity_wire_decode_delta(buf, length, &d)) >= 0) rc = apply_delta(node_id, &d);
+        break;
+    }
+    case PARITY_MSG_DIGEST: {
+        parity_digest_entry_t entries[PARITY_DIGEST_MAX_ENTRIES];
+        int sender, flags, count;
+        if ((decoded = parity_wire_decode_digest(buf, length, &sender, &flags, entries,
+                                                 PARITY_DIGEST_MAX_ENTRIES, &count)) >= 0) {
+            handle_digest(node_id, sender, flags, entries, count);
+            rc = 0;
+        }
+        break;
+    }
+    default:
+        break;
+    }
+    if (decoded < 0) {
+        printf("[BROADCAST] Dropping malformed message (%d bytes)\n", length);
+    }
+    return rc;
+}
+
+static int applied_messages;
+
+static void deliver_frame(void *ctx, int source_rank, const uint8_t *frame, int length) {
+    (void)ctx; (void)source_rank;
+    if (length < PARITY_FRAME_HEADER) return;
+    uint32_t node_id = 0;
+    for (int i = 0; i < PARITY_FRAME_HEADER; i++) node_id |= (uint32_t)frame[i] << (8 * i);
+    if ((int)node_id < 0 || (int)node_id >= total_nodes) return;
+    // Broadcast FULLs reach every rank for the parity index; anything else
+    // is for the owner only.
+    const uint8_t *msg = frame + PARITY_FRAME_HEADER;
+    if (!partition_owns((int)node_id) &&
+        parity_wire_message_type(msg, length - PARITY_FRAME_HEADER) != PARITY_MSG_FULL) {
+        return;
+    }
+    if (dispatch_message((int)node_id, msg, length - PARITY_FRAME_HEADER) == 0) {
+        applied_messages++;
+    }
+}
+
+static int handle_node_op(int source, const uint8_t *req, int length, uint8_t *reply, int cap,
+                          void (*op)(int node_id)) {
+    (void)source; (void)reply; (void)cap;
+    int32_t id;
+    if (length < (int)sizeof(id)) return -1;
+    memcpy(&id, req, sizeof(id));
+    if (!partition_owns(id)) return -1;
+    op(id);
+    return 0;
+}
+
+static int handle_announce(int source, const uint8_t *req, int length, uint8_t *reply, int cap) {
+    return handle_node_op(source, req, length, reply, cap, announce_parity_holdings);
+}
+
+static int handle_gossip(int source, const uint8_t *req, int length, uint8_t *reply, int cap) {
+    return handle_node_op(source, req, length, reply, cap, gossip_parity_announcement);
+}
+
+static int handle_anti_entropy(int source, const uint8_t *req, int length, uint8_t *reply, int cap) {
+    return handle_node_op(source, req, length, reply, cap, parity_anti_entropy_round);
+}
+
+// Tag requests carry the node id and the tag name; ids are per process.
+static int handle_tag_op(const uint8_t *req, int length, int removed) {
+    int32_t id;
+    if (length <= (int)sizeof(id) || length > (int)sizeof(id) + MAX_TAG_LENGTH) return -1;
+    memcpy(&id, req, sizeof(id));
+    if (!partition_owns(id)) return -1;
+    parity_tag_id_t tag = tag_intern_n((const char *)req + sizeof(id), length - sizeof(id));
+    if (tag == PARITY_TAG_INVALID) return -1;
+    if (removed) {
+        remove_parity_tag_id(id, tag);
+    } else {
+        assign_parity_tag_id(id, tag);
+    }
+    return 0;
+}
+
+static int handle_assign_tag(int source, const uint8_t *req, int length, uint8_t *reply, int cap) {
+    (void)source; (void)reply; (void)cap;
+    return handle_tag_op(req, length, 0);
+}
+
+static int handle_remove_tag(int source, const uint8_t *req, int length, uint8_t *reply, int cap) {
+    (void)source; (void)reply; (void)cap;
+    return handle_tag_op(req, length, 1);
+}
+
+void parity_forward_tag_change(int node_id, parity_tag_id_t tag, int removed) {
+    const char *name = tag_name(tag);
+    if (!name) return;
+    uint8_t req[sizeof(int32_t) + MAX_TAG_LENGTH];
+    int32_t id = node_id;
+    int length = tag_name_length(tag);
+    memcpy(req, &id, sizeof(id));
+    memcpy(req + sizeof(id), name, length);
+    partition_post(partition_owner(node_id), removed ? PARTITION_OP_REMOVE_TAG : PARTITION_OP_ASSIGN_TAG,
+                   req, (int)sizeof(id) + length);
+}
+
+void assign_parity_tag_batch(int node_id, const parity_tag_id_t *tags, int count) {
+    if (count > MAX_PARITY_TAGS) count = MAX_PARITY_TAGS;
+    if (partition_owns(node_id)) {
+        for (int i = 0; i < count; i++) assign_parity_tag_id(node_id, tags[i]);
+        announce_parity_holdings(node_id);
+        return;
+    }
+    // Node id, then a u8 length and the name of each tag.
+    uint8_t req[sizeof(int32_t) + MAX_PARITY_TAGS * (1 + MAX_TAG_LENGTH)];
+    int32_t id = node_id;
+    memcpy(req, &id, sizeof(id));
+    int used = sizeof(id);
+    for (int i = 0; i < count; i++) {
+        const char *name = tag_name(tags[i]);
+        if (!name) continue;
+        int length = tag_name_length(tags[i]);
+        req[used++] = (uint8_t)length;
+        memcpy(req + used, name, length);
+        used += length;
+    }
+    partition_post(partition_owner(node_id), PARTITION_OP_ASSIGN_TAGS, req, used);
+}
+
+static int handle_assign_tags(int source, const uint8_t *req, int length, uint8_t *reply, int cap) {
+    (void)source; (void)reply; (void)cap;
+    int32_t id;
+    if (length < (int)sizeof(id)) return -1;
+    memcpy(&id, req, sizeof(id));
+    if (!partition_owns(id)) return -1;
+    parity_tag_id_t tags[MAX_PARITY_TAGS];
+    int count = 0;
+    for (int at = sizeof(id); at < length && count < MAX_PARITY_TAGS;) {
+        int n = req[at++];
+        if (n == 0 || n > MAX_TAG_LENGTH || at + n > length) return -1;
+        tags[count] = tag_intern_n((const char *)req + at, n);
+        if (tags[count] != PARITY_TAG_INVALID) count++;
+        at += n;
+    }
+    assign_parity_tag_batch(id, tags, count);
+    return 0;
+}
+
+void parity_broadcast_init(void) {
+    transport_set_handler(TRANSPORT_CHANNEL_PARITY, deliver_frame, NULL);
+    partition_register_handler(PARTITION_OP_ANNOUNCE, handle_announce);
+    partition_register_handler(PARTITION_OP_GOSSIP, handle_gossip);
+    partition_register_handler(PARTITION_OP_ANTI_ENTROPY, handle_anti_entropy);
+    partition_register_handler(PARTITION_OP_ASSIGN_TAG, handle_assign_tag);
+    partition_register_handler(PARTITION_OP_REMOVE_TAG, handle_remove_tag);
+    partition_register_handler(PARTITION_OP_ASSIGN_TAGS, handle_assign_tags);
+    partition_register_tick(anti_entropy_tick, PARITY_ANTI_ENTROPY_INTERVAL_MS);
+}
+
+int parity_broadcast_poll(void) {
+    applied_messages = 0;
+    partition_poll();
+    return applied_messages;
+}
+
+void parity_gossip_report(void) {
+    static const char *names[] = { "", "full", "delta", "digest" };
+    for (int t = PARITY_MSG_FULL; t <= PARITY_MSG_DIGEST; t++) {
+        printf("[GOSSIP] %-6s %8ld msgs %10ld bytes\n", names[t], stats.messages[t], stats.bytes[t]);
     }
+    printf("[GOSSIP] skipped (up to date) %ld | stale deltas %ld\n", stats.skipped, stats.stale_deltas);
 }
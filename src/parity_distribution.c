@@ -9,126 +9,597 @@
  */
 
 #include "parity_types.h"
-#include "distribution_policy.h"
+#include "parity_distribution.h"
+#include "parity_broadcast.h"
+#include "tag_intern.h"
+#include "parity_index.h"
+#include "partition.h"
+#include "thread_pool.h"
+#include "topology.h"
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include <stdio.h>
+#include <time.h>
 
-// Builds the parity computation graph
-static parity_computation_graph_t* build_parity_computation_graph() {
-    parity_computation_graph_t *graph = malloc(sizeof(*graph));
-    graph->node_count = total_nodes;
-    graph->nodes = malloc(sizeof(parity_node_t) * total_nodes);
-    graph->global_scores = malloc(sizeof(double) * total_nodes);
-    graph->adjacency_matrix = NULL; // placeholder for RTT-based future
-    for (int i = 0; i < total_nodes; i++) {
-        TorusNode *n = &network[i];
-        parity_node_t *p = &graph->nodes[i];
-        p->node_id = n->id;
-        p->rtt_latency = 1.0; // default, improve with measurement
-        p->centrality_score = 1.0; // placeholder
-        p->current_load = n->parity_count;
-        p->last_access = n->last_announcement;
-        graph->global_scores[i] = 0.0;
-    }
-    graph->tree_height = (int)log2(total_nodes);
+#define PLACEMENT_GRAIN 16384   // nodes per scoring task; smaller networks score on the caller
+
+williams_distribution_policy_t default_williams_policy = {
+    .rtt_weight = 0.3,
+    .load_balance_weight = 0.4,
+    .knn_similarity_weight = 0.15,
+    .centrality_weight = 0.15,
+    .min_replicas = 3,
+    .max_replicas = 5,
+};
+
+static parity_computation_graph_t *graph = NULL;
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+double calculate_williams_placement_score(const parity_node_t *node,
+                                          const williams_distribution_policy_t *policy) {
+    return policy->rtt_weight / (1 + node->rtt_latency)
+         + policy->load_balance_weight * (1.0 - node->current_load / (double)MAX_PARITY_TAGS)
+         + policy->knn_similarity_weight * node->centrality_score
+         + policy->centrality_weight * node->centrality_score;
+}
+
+// Builds the parity computation graph from the topology and the loads
+// parity_index knows about.
+static parity_computation_graph_t* build_parity_computation_graph(void) {
+    int n = total_nodes;
+    parity_computation_graph_t *g = calloc(1, sizeof(*g));
+    g->node_count = n;
+    g->rtt_latency = malloc(sizeof(double) * n);
+    g->centrality = malloc(sizeof(double) * n);
+    g->load = malloc(sizeof(int) * n);
+    g->base_score = malloc(sizeof(double) * n);
+    g->scores = malloc(sizeof(double) * n);
+    g->order = malloc(sizeof(int) * n);
+
+    int max_degree = 1;
+    for (int i = 0; i < n; i++) {
+        int degree = topology_degree(&topology, i);
+        if (degree > max_degree) max_degree = degree;
+    }
+    for (int i = 0; i < n; i++) {
+        g->rtt_latency[i] = topology_mean_weight(&topology, i);
+        g->centrality[i] = topology_degree(&topology, i) / (double)max_degree;
+        g->load[i] = parity_index_node_count(i);
+    }
+    return g;
+}
+
+parity_computation_graph_t* placement_graph(void) {
+    if (graph && graph->node_count != total_nodes) placement_graph_invalidate();
+    if (!graph) graph = build_parity_computation_graph();
     return graph;
 }
 
-// Constructs a Williams tree from the graph
-static parity_tree_evaluation_t* construct_placement_tree(
-        parity_computation_graph_t *graph,
-        const williams_distribution_policy_t *policy) {
-    parity_tree_evaluation_t *tree = malloc(sizeof(*tree));
-    tree->height = graph->tree_height;
-    tree->fanout = (int)sqrt(graph->node_count);
-    if (tree->fanout < 2) tree->fanout = 2;
-    tree->tree_nodes = malloc(sizeof(parity_node_t*) * graph->node_count);
-    for (int i = 0; i < graph->node_count; i++) {
-        tree->tree_nodes[i] = &graph->nodes[i];
-    }
-    tree->eval_function = calculate_williams_placement_score;
-    tree->policy = (williams_distribution_policy_t*)policy;
-    return tree;
-}
-
-// Recursively evaluates tree to compute scores
-double evaluate_parity_placement_tree(
-        parity_tree_evaluation_t *tree, int node_index) {
-    if (tree->height == 0) {
-        parity_node_t *node = tree->tree_nodes[node_index];
-        return tree->policy->rtt_weight / (1 + node->rtt_latency)
-             + tree->policy->load_balance_weight * (1.0 - node->current_load / (double)MAX_PARITY_TAGS)
-             + tree->policy->knn_similarity_weight * node->centrality_score
-             + tree->policy->centrality_weight * node->centrality_score;
-    }
-    double best = -INFINITY;
-    int start = node_index * tree->fanout + 1;
-    for (int i = 0; i < tree->fanout; i++) {
-        int child = start + i;
-        if (child < (int)pow(tree->fanout, tree->height + 1)) {
-            double score = evaluate_parity_placement_tree(tree, child);
-            if (score > best) best = score;
+void placement_graph_invalidate(void) {
+    if (!graph) return;
+    free(graph->rtt_latency);
+    free(graph->centrality);
+    free(graph->load);
+    free(graph->base_score);
+    free(graph->scores);
+    free(graph->order);
+    free(graph);
+    graph = NULL;
+}
+
+void placement_graph_free(void) {
+    placement_graph_invalidate();
+}
+
+void placement_graph_load_changed(int node_id, int delta) {
+    if (graph && node_id >= 0 && node_id < graph->node_count) graph->load[node_id] += delta;
+}
+
+// ---- Scoring --------------------------------------------------------------
+
+typedef struct {
+    parity_computation_graph_t *g;
+    const williams_distribution_policy_t *policy;
+    double load_penalty;
+    int cap;
+} score_task_t;
+
+static void base_score_task(void *ctx, int begin, int end, int worker) {
+    (void)worker;
+    score_task_t *t = ctx;
+    const williams_distribution_policy_t *p = t->policy;
+    double similarity = p->knn_similarity_weight + p->centrality_weight;
+    for (int i = begin; i < end; i++) {
+        t->g->base_score[i] = p->rtt_weight / (1 + t->g->rtt_latency[i]) + p->load_balance_weight +
+                              similarity * t->g->centrality[i];
+    }
+}
+
+// Nodes at the load cap score -INFINITY, so selection never picks them.
+static void score_task(void *ctx, int begin, int end, int worker) {
+    (void)worker;
+    score_task_t *t = ctx;
+    const double *base = t->g->base_score;
+    const int *load = t->g->load;
+    double *scores = t->g->scores;
+    double penalty = t->load_penalty;
+    int cap = t->cap;
+    for (int i = begin; i < end; i++) {
+        double s = base[i] - penalty * load[i];
+        scores[i] = load[i] < cap ? s : -INFINITY;
+    }
+}
+
+static void run_scoring(thread_pool_task_fn fn, score_task_t *t) {
+    int n = t->g->node_count;
+    if (n < 2 * PLACEMENT_GRAIN) {
+        fn(t, 0, n, 0);
+    } else {
+        thread_pool_parallel_for(thread_pool_default(), n, PLACEMENT_GRAIN, fn, t);
+    }
+}
+
+int placement_load_cap(const williams_distribution_policy_t *policy) {
+    int cap = policy->max_node_load;
+    return cap > 0 && cap < MAX_PARITY_TAGS ? cap : MAX_PARITY_TAGS;
+}
+
+static int same_weights(const williams_distribution_policy_t *a, const williams_distribution_policy_t *b) {
+    return a->rtt_weight == b->rtt_weight && a->load_balance_weight == b->load_balance_weight &&
+           a->knn_similarity_weight == b->knn_similarity_weight &&
+           a->centrality_weight == b->centrality_weight;
+}
+
+// Fills g->scores for policy; recomputes base_score only when the weights
+// changed since the last call.
+static void score_nodes(parity_computation_graph_t *g, const williams_distribution_policy_t *policy) {
+    score_task_t t = { g, policy, policy->load_balance_weight / MAX_PARITY_TAGS, placement_load_cap(policy) };
+    if (!g->scored || !same_weights(&g->policy, policy)) {
+        run_scoring(base_score_task, &t);
+        g->policy = *policy;
+        g->scored = 1;
+    }
+    run_scoring(score_task, &t);
+}
+
+// ---- Selection ------------------------------------------------------------
+
+// Fixed pseudo-random order of node ids (a bijection), for breaking ties.
+static inline uint32_t tie_rank(int node_id) {
+    uint32_t x = (uint32_t)node_id * 2654435761u;
+    return x ^ (x >> 16);
+}
+
+// Higher score first. Ties, common on regular topologies, go by tie_rank
+// rather than id, so equal-score replicas of a tag do not land on
+// consecutive nodes that are likely to fail together.
+static inline int better(const double *scores, int a, int b) {
+    return scores[a] > scores[b] || (scores[a] == scores[b] && tie_rank(a) < tie_rank(b));
+}
+
+static inline void swap_int(int *a, int *b) {
+    int t = *a;
+    *a = *b;
+    *b = t;
+}
+
+// Reorders items so its first k are the k best, in no particular order.
+static void select_top(const double *scores, int *items, int count, int k) {
+    int lo = 0, hi = count - 1;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (better(scores, items[mid], items[lo])) swap_int(&items[mid], &items[lo]);
+        if (better(scores, items[hi], items[lo])) swap_int(&items[hi], &items[lo]);
+        if (better(scores, items[hi], items[mid])) swap_int(&items[hi], &items[mid]);
+        int pivot = items[mid];
+        int i = lo, j = hi;
+        while (i <= j) {
+            while (better(scores, items[i], pivot)) i++;
+            while (better(scores, pivot, items[j])) j--;
+            if (i <= j) swap_int(&items[i++], &items[j--]);
         }
+        if (k - 1 <= j) hi = j;
+        else if (k - 1 >= i) lo = i;
+        else break;
     }
-    return best;
 }
 
-// Identifies top-K candidate nodes for placement
-static int* select_tree_optimal_nodes(
-        parity_computation_graph_t *graph,
-        double *scores,
-        const williams_distribution_policy_t *policy) {
+static void sort_best_first(const double *scores, int *items, int count) {
+    for (int i = 1; i < count; i++) {
+        int v = items[i], j = i;
+        while (j > 0 && better(scores, v, items[j - 1])) {
+            items[j] = items[j - 1];
+            j--;
+        }
+        items[j] = v;
+    }
+}
 
-    int K = policy->min_replicas;
-    int *selected = malloc(sizeof(int) * K);
-    for (int i = 0; i < K; i++) {
-        double best = -INFINITY;
-        int best_idx = -1;
-        for (int j = 0; j < graph->node_count; j++) {
-            if (scores[j] > best) {
-                best = scores[j];
-                best_idx = j;
+// Gathers the nodes below the load cap into g->order; returns how many.
+static int eligible_nodes(parity_computation_graph_t *g) {
+    int count = 0;
+    for (int i = 0; i < g->node_count; i++) {
+        g->order[count] = i;
+        count += g->scores[i] != -INFINITY;
+    }
+    return count;
+}
+
+const double* placement_scores(const williams_distribution_policy_t *policy) {
+    parity_computation_graph_t *g = placement_graph();
+    score_nodes(g, policy);
+    return g->scores;
+}
+
+int placement_select(const williams_distribution_policy_t *policy, int k, int *out) {
+    parity_computation_graph_t *g = placement_graph();
+    score_nodes(g, policy);
+    int count = eligible_nodes(g);
+    if (k > count) k = count;
+    if (k <= 0) return 0;
+    select_top(g->scores, g->order, count, k);
+    sort_best_first(g->scores, g->order, k);
+    memcpy(out, g->order, sizeof(int) * k);
+    return k;
+}
+
+// Max-heap of node ids ordered by better().
+static void heap_sift_down(const double *scores, int *heap, int count, int i) {
+    for (;;) {
+        int best = i, l = 2 * i + 1, r = l + 1;
+        if (l < count && better(scores, heap[l], heap[best])) best = l;
+        if (r < count && better(scores, heap[r], heap[best])) best = r;
+        if (best == i) return;
+        swap_int(&heap[i], &heap[best]);
+        i = best;
+    }
+}
+
+static void heap_sift_up(const double *scores, int *heap, int i) {
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!better(scores, heap[i], heap[parent])) return;
+        swap_int(&heap[i], &heap[parent]);
+        i = parent;
+    }
+}
+
+// Chooses up to k replicas for each of count tags without assigning
+// anything; see distribute_parity_batch. With tag ids, nodes already
+// holding a tag are passed over and a tag is only topped up to k holders
+// (k is at most max_replicas). taken (node_count entries, zeroed) receives
+// the replicas each node was given; requested (optional) the replicas
+// the tags were short of. Returns the number of replicas chosen.
+static int batch_select(const williams_distribution_policy_t *policy, const parity_tag_id_t *tags,
+                        int count, int k, int *placements, unsigned char *taken, int *requested) {
+    parity_computation_graph_t *g = placement_graph();
+    score_nodes(g, policy);
+    int cap = placement_load_cap(policy);
+    double penalty = policy->load_balance_weight / MAX_PARITY_TAGS;
+    double *scores = g->scores;
+    int *heap = g->order;
+    int size = eligible_nodes(g);
+    for (int i = size / 2 - 1; i >= 0; i--) heap_sift_down(scores, heap, size, i);
+
+    int *chosen = malloc(sizeof(int) * (k > 0 ? k : 1));
+    int *passed = NULL;
+    int passed_capacity = 0;
+    int placed = 0;
+    for (int t = 0; t < count; t++) {
+        int *row = placements + (size_t)t * k;
+        int want = k, got = 0, skipped = 0;
+        parity_holder_view_t holders = { NULL, 0 };
+        if (tags) {
+            holders = parity_index_lookup(tags[t]);
+            want = k - holders.count;
+            if (want < 0) want = 0;
+        }
+        if (requested) *requested += want;
+        while (got < want && size > 0) {
+            int v = heap[0];
+            heap[0] = heap[--size];
+            heap_sift_down(scores, heap, size, 0);
+            if (holders.count > 0 && parity_index_holds(tags[t], v)) {
+                if (skipped == passed_capacity) {
+                    passed_capacity = passed_capacity ? passed_capacity * 2 : 8;
+                    passed = realloc(passed, sizeof(int) * passed_capacity);
+                }
+                passed[skipped++] = v;
+                continue;
             }
+            chosen[got++] = v;
         }
-        selected[i] = graph->nodes[best_idx].node_id;
-        scores[best_idx] = -INFINITY;
+        for (int i = 0; i < skipped; i++) {
+            heap[size] = passed[i];
+            heap_sift_up(scores, heap, size++);
+        }
+        for (int i = 0; i < got; i++) {
+            int v = chosen[i];
+            row[i] = v;
+            taken[v]++;
+            scores[v] -= penalty;
+            if (g->load[v] + taken[v] < cap) {
+                heap[size] = v;
+                heap_sift_up(scores, heap, size++);
+            }
+        }
+        for (int i = got; i < k; i++) row[i] = -1;
+        placed += got;
     }
-    return selected;
+    free(chosen);
+    free(passed);
+    return placed;
 }
 
+// ---- Placement ------------------------------------------------------------
+
 // Main entry to distribute a parity bit
 int* distribute_parity_with_tree_evaluation(
         const char *new_parity_tag,
         williams_distribution_policy_t *policy) {
 
+    parity_tag_id_t tag_id = tag_intern(new_parity_tag);
+    if (tag_id == PARITY_TAG_INVALID) {
+        printf("[DISTRIBUTION] Rejected parity tag '%.*s...': longer than %d bytes\n", MAX_TAG_LENGTH,
+               new_parity_tag, MAX_TAG_LENGTH);
+        return NULL;
+    }
     printf("[DISTRIBUTION] Placing parity '%s' …\n", new_parity_tag);
 
-    // Build graph & placement tree
-    parity_computation_graph_t *graph = build_parity_computation_graph();
-    parity_tree_evaluation_t *tree = construct_placement_tree(graph, policy);
-
-    // Compute scores
-    double *scores = malloc(sizeof(double) * graph->node_count);
-    for (int i = 0; i < graph->node_count; i++) {
-        scores[i] = evaluate_parity_placement_tree(tree, i);
+    // The batch path with one tag: it tops an existing tag up instead of
+    // picking its current holders again, and stops at max_replicas.
+    int K = policy->min_replicas;
+    int k = K;
+    if (policy->max_replicas > 0 && k > policy->max_replicas) k = policy->max_replicas;
+    int *chosen = malloc(sizeof(int) * (K > 0 ? K : 1));
+    for (int i = 0; i < K; i++) chosen[i] = -1;
+    int found = 0, requested = 0;
+    if (k > 0) {
+        unsigned char *taken = calloc(placement_graph()->node_count, 1);
+        found = batch_select(policy, &tag_id, 1, k, chosen, taken, &requested);
+        free(taken);
+    }
+    if (found < requested) {
+        printf("[DISTRIBUTION] Warning: only %d of %d nodes have room for '%s'\n", found, requested,
+               new_parity_tag);
     }
-
-    // Select nodes
-    int *chosen = select_tree_optimal_nodes(graph, scores, policy);
 
     // Assign and broadcast
-    for (int i = 0; i < policy->min_replicas; i++) {
+    for (int i = 0; i < found; i++) {
         int nid = chosen[i];
-        assign_parity_tag(nid, new_parity_tag);
+        assign_parity_tag_id(nid, tag_id);
         announce_parity_holdings(nid);
         printf("[DISTRIBUTION] Assigned parity '%s' to node %d\n", new_parity_tag, nid);
     }
+    return chosen;
+}
 
-    free(graph->nodes);
-    free(graph);
-    free(tree->tree_nodes);
-    free(tree);
+// Load after the batch, as far as this rank knows: the index's view plus
+// what the batch just handed out (remote assignments show up in the
+// index only once their owners announce).
+static void batch_load_stats(const parity_computation_graph_t *g, const unsigned char *taken,
+                             placement_batch_stats_t *stats) {
+    double sum = 0.0, squares = 0.0;
+    stats->load_min = INT32_MAX;
+    stats->load_max = 0;
+    for (int i = 0; i < g->node_count; i++) {
+        int load = g->load[i] + taken[i];
+        sum += load;
+        squares += (double)load * load;
+        if (load < stats->load_min) stats->load_min = load;
+        if (load > stats->load_max) stats->load_max = load;
+    }
+    int n = g->node_count > 0 ? g->node_count : 1;
+    stats->load_mean = sum / n;
+    double variance = squares / n - stats->load_mean * stats->load_mean;
+    stats->load_stddev = variance > 0 ? sqrt(variance) : 0.0;
+    stats->imbalance = stats->load_mean > 0 ? stats->load_max / stats->load_mean : 1.0;
+}
+
+int distribute_parity_batch(const char **tags, int count, int replicas,
+                            const williams_distribution_policy_t *policy, int *placements,
+                            placement_batch_stats_t *stats) {
+    placement_batch_stats_t local;
+    if (!stats) stats = &local;
+    memset(stats, 0, sizeof(*stats));
+    if (replicas <= 0) replicas = policy->min_replicas;
+    if (policy->max_replicas > 0 && replicas > policy->max_replicas) replicas = policy->max_replicas;
+    if (count <= 0 || replicas <= 0) return 0;
+
+    double t0 = now_us();
+    parity_computation_graph_t *g = placement_graph();
+    parity_tag_id_t *ids = malloc(sizeof(parity_tag_id_t) * count);
+    for (int t = 0; t < count; t++) {
+        ids[t] = tag_intern(tags[t]);
+        if (ids[t] == PARITY_TAG_INVALID) {
+            printf("[DISTRIBUTION] Rejected batch: tag %d is longer than %d bytes\n", t, MAX_TAG_LENGTH);
+            free(ids);
+            return -1;
+        }
+    }
+    unsigned char *taken = calloc(g->node_count, 1);
+    int requested = 0;
+    int placed = batch_select(policy, ids, count, replicas, placements, taken, &requested);
+    batch_load_stats(g, taken, stats);
+    double t1 = now_us();
+
+    // Group the replicas by node, so each node takes all of its new tags
+    // in one request and announces once.
+    int n = g->node_count;
+    int *offsets = calloc(n + 1, sizeof(int));
+    for (int v = 0; v < n; v++) offsets[v + 1] = offsets[v] + taken[v];
+    parity_tag_id_t *by_node = malloc(sizeof(parity_tag_id_t) * (placed > 0 ? placed : 1));
+    int *fill = malloc(sizeof(int) * (n > 0 ? n : 1));
+    memcpy(fill, offsets, sizeof(int) * n);
+    for (int t = 0; t < count; t++) {
+        const int *row = placements + (size_t)t * replicas;
+        for (int i = 0; i < replicas && row[i] >= 0; i++) by_node[fill[row[i]]++] = ids[t];
+    }
+    for (int v = 0; v < n; v++) {
+        if (!taken[v]) continue;
+        assign_parity_tag_batch(v, by_node + offsets[v], taken[v]);
+        stats->nodes_touched++;
+    }
+    double t2 = now_us();
+
+    stats->tags = count;
+    stats->replicas_requested = requested;
+    stats->replicas_placed = placed;
+    stats->select_ms = (t1 - t0) / 1e3;
+    stats->assign_ms = (t2 - t1) / 1e3;
+    free(ids);
+    free(taken);
+    free(offsets);
+    free(by_node);
+    free(fill);
+    return placed;
+}
+
+void placement_batch_report(const placement_batch_stats_t *stats) {
+    printf("[DISTRIBUTION] Batch: %d tags, %d of %d replicas on %d nodes (%d announcements) | "
+           "select %.1f ms, assign %.1f ms\n",
+           stats->tags, stats->replicas_placed, stats->replicas_requested, stats->nodes_touched,
+           stats->nodes_touched, stats->select_ms, stats->assign_ms);
+    printf("[DISTRIBUTION] Load per node: %d..%d, mean %.2f, stddev %.2f | max/mean %.2f\n",
+           stats->load_min, stats->load_max, stats->load_mean, stats->load_stddev, stats->imbalance);
+}
+
+// ---- Checks ---------------------------------------------------------------
+
+#define PLACEMENT_CHECK_WAIT_US 2000000
+
+// Polls until every tag has exactly want[t] holders in the index or the
+// wait runs out; remote owners' announcements arrive through
+// parity_broadcast_poll.
+static int await_holders(const parity_tag_id_t *ids, const int *want, int count) {
+    double deadline = now_us() + PLACEMENT_CHECK_WAIT_US;
+    for (;;) {
+        parity_broadcast_poll();
+        int t = 0;
+        while (t < count && parity_index_lookup(ids[t]).count == want[t]) t++;
+        if (t == count) return 0;
+        if (now_us() > deadline) return -1;
+    }
+}
+
+int placement_batch_check(int count, int replicas) {
+    williams_distribution_policy_t policy = default_williams_policy;
+    if (count <= 0) count = 32;
+    if (replicas <= 0) replicas = policy.min_replicas;
+    if (policy.max_replicas > 0 && replicas > policy.max_replicas) replicas = policy.max_replicas;
+    char (*names)[MAX_TAG_LENGTH + 1] = malloc(sizeof(*names) * count);
+    const char **tags = malloc(sizeof(char *) * count);
+    parity_tag_id_t *ids = malloc(sizeof(parity_tag_id_t) * count);
+    int *want = malloc(sizeof(int) * count);
+    int *placements = malloc(sizeof(int) * (size_t)count * replicas);
+    for (int t = 0; t < count; t++) {
+        snprintf(names[t], sizeof(names[t]), "placement-check-%d", t);
+        tags[t] = names[t];
+        ids[t] = tag_intern(names[t]);
+    }
+
+    // First run places the replicas; once every owner has announced them,
+    // the second must find nothing missing.
+    placement_batch_stats_t first, second;
+    for (int t = 0; t < count; t++) want[t] = parity_index_lookup(ids[t]).count;
+    distribute_parity_batch(tags, count, replicas, &policy, placements, &first);
+    for (int t = 0; t < count; t++) {
+        for (int i = 0; i < replicas && placements[(size_t)t * replicas + i] >= 0; i++) want[t]++;
+    }
+    int settled = await_holders(ids, want, count) == 0;
+    distribute_parity_batch(tags, count, replicas, &policy, placements, &second);
+    int extra = 0;
+    for (int t = 0; t < count; t++) {
+        if (parity_index_lookup(ids[t]).count > replicas) extra++;
+    }
+    int ok = settled && second.replicas_requested == first.replicas_requested - first.replicas_placed &&
+             second.replicas_placed == 0 && extra == 0;
+    printf("[PLACEMENT] Batch of %d tags x %d: first %d/%d placed, second %d/%d placed, %d tags over "
+           "%d holders | %s\n", count, replicas, first.replicas_placed, first.replicas_requested,
+           second.replicas_placed, second.replicas_requested, extra, replicas, ok ? "idempotent" : "FAILED");
+
+    // Take the check's tags off again, announcing so the indexes follow.
+    for (int t = 0; t < count; t++) {
+        parity_holder_view_t view = parity_index_lookup(ids[t]);
+        int held = view.count;
+        int *holders = malloc(sizeof(int) * (held > 0 ? held : 1));
+        memcpy(holders, view.holders, sizeof(int) * held);
+        for (int i = 0; i < held; i++) {
+            remove_parity_tag_id(holders[i], ids[t]);
+            announce_parity_holdings(holders[i]);
+        }
+        free(holders);
+        want[t] = 0;
+    }
+    await_holders(ids, want, count);
+    free(names);
+    free(tags);
+    free(ids);
+    free(want);
+    free(placements);
+    return ok ? 0 : -1;
+}
+
+// ---- Benchmark ------------------------------------------------------------
+
+// The per-tag path this engine replaced: a fresh graph, one scoring call
+// per node and K passes of argmax.
+static int rebuild_and_select(const williams_distribution_policy_t *policy, int *out) {
+    int n = total_nodes, k = policy->min_replicas;
+    parity_node_t *nodes = malloc(sizeof(parity_node_t) * n);
+    double *scores = malloc(sizeof(double) * n);
+    for (int i = 0; i < n; i++) {
+        nodes[i].node_id = i;
+        nodes[i].rtt_latency = topology_mean_weight(&topology, i);
+        nodes[i].centrality_score = 1.0;
+        nodes[i].current_load = parity_index_node_count(i);
+        nodes[i].last_access = 0;
+        scores[i] = calculate_williams_placement_score(&nodes[i], policy);
+    }
+    for (int i = 0; i < k; i++) {
+        int best = 0;
+        for (int j = 1; j < n; j++) {
+            if (scores[j] > scores[best]) best = j;
+        }
+        out[i] = nodes[best].node_id;
+        scores[best] = -INFINITY;
+    }
+    free(nodes);
     free(scores);
-    return chosen;
+    return k;
+}
+
+void placement_bench(int tags) {
+    if (tags <= 0) tags = 100;
+    williams_distribution_policy_t policy = default_williams_policy;
+    int k = policy.min_replicas;
+    int *out = malloc(sizeof(int) * (size_t)tags * k);
+
+    double t0 = now_us();
+    for (int t = 0; t < tags; t++) rebuild_and_select(&policy, out + (size_t)t * k);
+    double t1 = now_us();
+    placement_graph_invalidate();
+    placement_graph();
+    double t2 = now_us();
+    for (int t = 0; t < tags; t++) placement_select(&policy, k, out + (size_t)t * k);
+    double t3 = now_us();
+    unsigned char *taken = calloc(total_nodes, 1);
+    int placed = batch_select(&policy, NULL, tags, k, out, taken, NULL);
+    double t4 = now_us();
+
+    printf("[PLACEMENT] %d nodes, %d replicas, %d threads | graph build %.1f ms\n", total_nodes, k,
+           thread_pool_size(thread_pool_default()), (t2 - t1) / 1e3);
+    printf("[PLACEMENT] rebuild + argmax:    %10.1f tags/s\n", tags / ((t1 - t0) / 1e6));
+    printf("[PLACEMENT] graph + quickselect: %10.1f tags/s | x%.1f\n", tags / ((t3 - t2) / 1e6),
+           (t1 - t0) / (t3 - t2));
+    printf("[PLACEMENT] batch (%d tags):   %10.1f tags/s | x%.1f | %d replicas\n", tags,
+           tags / ((t4 - t3) / 1e6), (t1 - t0) / (t4 - t3), placed);
+    free(out);
+    free(taken);
 }
@@ -0,0 +1,198 @@
+/*
+ * FT-DFRP: Parity Holder Index
+ *
+ * Dual Licensed:
+ * 1. AGPL-3.0 for research/academic use
+ * 2. Commercial license: contact michael.doran.808@gmail.com
+ *
+ * Copyright (C) 2025 Michael Doran
+ */
+
+#include "parity_index.h"
+#include "distance_field.h"
+#include "parity_distribution.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    int *holders;
+    int count;
+    int capacity;
+    uint32_t version;      // bumped whenever the holder set changes
+} holder_entry_t;
+
+// One entry per interned tag id, grown on demand. Entries never move
+// relative to their id, so the reverse map stores ids directly.
+static holder_entry_t *entries = NULL;
+static int entry_capacity = 0;
+
+// Reverse map: node id -> tag ids it is indexed under, and where in each
+// tag's holder list the node sits, so removal never searches that list.
+typedef struct {
+    parity_tag_id_t *tags;
+    int *slots;             // slots[i]: index of the node in tags[i]'s holders
+    int count;
+    int capacity;
+} node_tags_t;
+
+static node_tags_t *node_tags = NULL;
+static int node_capacity = 0;
+
+static holder_entry_t* entry_for(parity_tag_id_t tag) {
+    if (tag >= (parity_tag_id_t)entry_capacity) {
+        int capacity = entry_capacity ? entry_capacity : 512;
+        while ((parity_tag_id_t)capacity <= tag) capacity *= 2;
+        entries = realloc(entries, sizeof(holder_entry_t) * capacity);
+        memset(entries + entry_capacity, 0, sizeof(holder_entry_t) * (capacity - entry_capacity));
+        entry_capacity = capacity;
+    }
+    return &entries[tag];
+}
+
+static void append_int(int **items, int *count, int *capacity, int value) {
+    if (*count == *capacity) {
+        *capacity = *capacity ? *capacity * 2 : 4;
+        *items = realloc(*items, sizeof(int) * *capacity);
+    }
+    (*items)[(*count)++] = value;
+}
+
+static void append_tag(node_tags_t *nt, parity_tag_id_t tag, int slot) {
+    if (nt->count == nt->capacity) {
+        nt->capacity = nt->capacity ? nt->capacity * 2 : 4;
+        nt->tags = realloc(nt->tags, sizeof(parity_tag_id_t) * nt->capacity);
+        nt->slots = realloc(nt->slots, sizeof(int) * nt->capacity);
+    }
+    nt->tags[nt->count] = tag;
+    nt->slots[nt->count++] = slot;
+}
+
+// Position of tag in nt, or -1. A node holds at most MAX_PARITY_TAGS tags,
+// while a tag may have thousands of holders (e.g. restoring a snapshot),
+// so membership is always checked on the node side.
+static int find_tag(const node_tags_t *nt, parity_tag_id_t tag) {
+    for (int i = 0; i < nt->count; i++) {
+        if (nt->tags[i] == tag) return i;
+    }
+    return -1;
+}
+
+static node_tags_t* node_tags_for(int node_id) {
+    if (node_id >= node_capacity) {
+        int capacity = node_capacity ? node_capacity : 1024;
+        while (capacity <= node_id) capacity *= 2;
+        node_tags = realloc(node_tags, sizeof(node_tags_t) * capacity);
+        memset(node_tags + node_capacity, 0, sizeof(node_tags_t) * (capacity - node_capacity));
+        node_capacity = capacity;
+    }
+    return &node_tags[node_id];
+}
+
+void parity_index_add(parity_tag_id_t tag, int node_id) {
+    if (tag == PARITY_TAG_INVALID) return;
+    holder_entry_t *entry = entry_for(tag);
+    node_tags_t *nt = node_tags_for(node_id);
+    if (find_tag(nt, tag) >= 0) return;
+    append_tag(nt, tag, entry->count);
+    append_int(&entry->holders, &entry->count, &entry->capacity, node_id);
+    entry->version++;
+    distance_field_holder_added(tag, node_id);
+    placement_graph_load_changed(node_id, 1);
+}
+
+void parity_index_remove(parity_tag_id_t tag, int node_id) {
+    if (tag >= (parity_tag_id_t)entry_capacity || node_id < 0 || node_id >= node_capacity) return;
+    node_tags_t *nt = &node_tags[node_id];
+    int i = find_tag(nt, tag);
+    if (i < 0) return;
+
+    // Move the last holder into the freed slot and repoint its reverse entry.
+    holder_entry_t *entry = &entries[tag];
+    int slot = nt->slots[i];
+    int last = entry->holders[--entry->count];
+    if (slot < entry->count) {
+        entry->holders[slot] = last;
+        node_tags_t *moved = &node_tags[last];
+        moved->slots[find_tag(moved, tag)] = slot;
+    }
+    nt->count--;
+    nt->tags[i] = nt->tags[nt->count];
+    nt->slots[i] = nt->slots[nt->count];
+
+    entry->version++;
+    distance_field_holder_removed(tag, node_id);
+    placement_graph_load_changed(node_id, -1);
+}
+
+void parity_index_set_node_tags(int node_id, const parity_tag_id_t *tags, int count) {
+    node_tags_t *nt = node_tags_for(node_id);
+
+    // Drop tags the node no longer announces, then add the announced ones.
+    for (int i = nt->count - 1; i >= 0; i--) {
+        parity_tag_id_t tag = nt->tags[i];
+        int still_held = 0;
+        for (int j = 0; j < count; j++) {
+            if (tags[j] == tag) {
+                still_held = 1;
+                break;
+            }
+        }
+        if (!still_held) parity_index_remove(tag, node_id);
+    }
+    for (int j = 0; j < count; j++) {
+        parity_index_add(tags[j], node_id);
+    }
+}
+
+parity_holder_view_t parity_index_lookup(parity_tag_id_t tag) {
+    if (tag >= (parity_tag_id_t)entry_capacity) {
+        return (parity_holder_view_t){ NULL, 0 };
+    }
+    return (parity_holder_view_t){ entries[tag].holders, entries[tag].count };
+}
+
+void parity_index_lookup_batch(const parity_tag_id_t *tags, int count, parity_holder_view_t *views) {
+    for (int i = 0; i < count; i++) {
+        views[i] = parity_index_lookup(tags[i]);
+    }
+}
+
+int parity_index_holds(parity_tag_id_t tag, int node_id) {
+    if (node_id < 0 || node_id >= node_capacity) return 0;
+    return find_tag(&node_tags[node_id], tag) >= 0;
+}
+
+uint32_t parity_index_version(parity_tag_id_t tag) {
+    return tag < (parity_tag_id_t)entry_capacity ? entries[tag].version : 0;
+}
+
+int parity_index_node_count(int node_id) {
+    if (node_id < 0 || node_id >= node_capacity) return 0;
+    return node_tags[node_id].count;
+}
+
+const parity_tag_id_t* parity_index_node_tags(int node_id, int *count) {
+    if (node_id < 0 || node_id >= node_capacity) {
+        *count = 0;
+        return NULL;
+    }
+    *count = node_tags[node_id].count;
+    return node_tags[node_id].tags;
+}
+
+void parity_index_clear(void) {
+    for (int e = 0; e < entry_capacity; e++) {
+        free(entries[e].holders);
+    }
+    for (int n = 0; n < node_capacity; n++) {
+        free(node_tags[n].tags);
+        free(node_tags[n].slots);
+    }
+    free(entries);
+    free(node_tags);
+    entries = NULL;
+    node_tags = NULL;
+    entry_capacity = node_capacity = 0;
+    distance_field_reset();
+    placement_graph_invalidate();
+}
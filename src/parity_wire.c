@@ -0,0 +1,279 @@
+/*
+ * FT-DFRP: Announcement Wire Format
+ *
+ * Dual Licensed:
+ * 1. AGPL-3.0 for research/academic use
+ * 2. Commercial license: contact michael.doran.808@gmail.com
+ *
+ * Copyright (C) 2025 Michael Doran
+ */
+
+#include "parity_wire.h"
+#include "tag_intern.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+static int put_varint(uint8_t *buf, size_t capacity, size_t *pos, uint64_t value) {
+    do {
+        if (*pos >= capacity) return -1;
+        uint8_t byte = value & 0x7f;
+        value >>= 7;
+        buf[(*pos)++] = byte | (value ? 0x80 : 0);
+    } while (value);
+    return 0;
+}
+
+static int get_varint(const uint8_t *buf, size_t length, size_t *pos, uint64_t *value) {
+    uint64_t result = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (*pos >= length) return -1;
+        uint8_t byte = buf[(*pos)++];
+        result |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static int put_bytes(uint8_t *buf, size_t capacity, size_t *pos, const void *data, size_t n) {
+    if (put_varint(buf, capacity, pos, n) < 0 || capacity - *pos < n) return -1;
+    memcpy(buf + *pos, data, n);
+    *pos += n;
+    return 0;
+}
+
+static int put_header(uint8_t *buf, size_t capacity, size_t *pos, parity_msg_type_t type, int node_id) {
+    if (capacity < 2) return -1;
+    buf[(*pos)++] = PARITY_WIRE_VERSION;
+    buf[(*pos)++] = (uint8_t)type;
+    return put_varint(buf, capacity, pos, (uint32_t)node_id);
+}
+
+static int put_load_and_time(uint8_t *buf, size_t capacity, size_t *pos, double load_factor, time_t timestamp) {
+    uint64_t bits;
+    memcpy(&bits, &load_factor, sizeof(bits));
+    if (capacity - *pos < 8) return -1;
+    for (int i = 0; i < 8; i++) buf[(*pos)++] = (uint8_t)(bits >> (8 * i));
+
+    int64_t delta = (int64_t)timestamp - PARITY_WIRE_EPOCH;
+    return put_varint(buf, capacity, pos, ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63));
+}
+
+static int put_tags(uint8_t *buf, size_t capacity, size_t *pos, const parity_tag_id_t *tags, int count) {
+    if (put_varint(buf, capacity, pos, count) < 0) return -1;
+    for (int i = 0; i < count; i++) {
+        const char *name = tag_name(tags[i]);
+        if (!name || put_bytes(buf, capacity, pos, name, tag_name_length(tags[i])) < 0) return -1;
+    }
+    return 0;
+}
+
+static int put_signature(uint8_t *buf, size_t capacity, size_t *pos, const char *signature) {
+    return put_bytes(buf, capacity, pos, signature, strnlen(signature, MAX_HASH_SIZE - 1));
+}
+
+static int get_header(const uint8_t *buf, size_t length, size_t *pos, parity_msg_type_t type, int *node_id) {
+    uint64_t value;
+    if (parity_wire_message_type(buf, length) != (int)type) return -1;
+    *pos = 2;
+    if (get_varint(buf, length, pos, &value) < 0 || value > INT32_MAX) return -1;
+    *node_id = (int)value;
+    return 0;
+}
+
+static int get_load_and_time(const uint8_t *buf, size_t length, size_t *pos, double *load_factor, time_t *timestamp) {
+    uint64_t value, bits = 0;
+    if (length - *pos < 8) return -1;
+    for (int i = 0; i < 8; i++) bits |= (uint64_t)buf[(*pos)++] << (8 * i);
+    memcpy(load_factor, &bits, sizeof(bits));
+
+    if (get_varint(buf, length, pos, &value) < 0) return -1;
+    *timestamp = (time_t)(PARITY_WIRE_EPOCH + (int64_t)((value >> 1) ^ -(value & 1)));
+    return 0;
+}
+
+static int get_version(const uint8_t *buf, size_t length, size_t *pos, uint32_t *version) {
+    uint64_t value;
+    if (get_varint(buf, length, pos, &value) < 0 || value > UINT32_MAX) return -1;
+    *version = (uint32_t)value;
+    return 0;
+}
+
+static int get_tags(const uint8_t *buf, size_t length, size_t *pos, parity_tag_id_t *tags, int *count) {
+    uint64_t value;
+    if (get_varint(buf, length, pos, &value) < 0 || value > MAX_PARITY_TAGS) return -1;
+    *count = (int)value;
+    for (int i = 0; i < *count; i++) {
+        if (get_varint(buf, length, pos, &value) < 0 || value > MAX_TAG_LENGTH || length - *pos < value) return -1;
+        tags[i] = tag_intern_n((const char *)buf + *pos, (size_t)value);
+        *pos += value;
+    }
+    return 0;
+}
+
+static int get_signature(const uint8_t *buf, size_t length, size_t *pos, char *signature) {
+    uint64_t value;
+    if (get_varint(buf, length, pos, &value) < 0 || value >= MAX_HASH_SIZE || length - *pos < value) return -1;
+    memcpy(signature, buf + *pos, value);
+    signature[value] = '\0';
+    *pos += value;
+    return 0;
+}
+
+int parity_wire_message_type(const uint8_t *buf, size_t length) {
+    if (length < 2 || buf[0] != PARITY_WIRE_VERSION) return -1;
+    if (buf[1] < PARITY_MSG_FULL || buf[1] > PARITY_MSG_DIGEST) return -1;
+    return buf[1];
+}
+
+int parity_wire_encode(const parity_announcement_t *a, uint8_t *buf, size_t capacity) {
+    size_t pos = 0;
+    if (put_header(buf, capacity, &pos, PARITY_MSG_FULL, a->node_id) < 0 ||
+        put_varint(buf, capacity, &pos, a->version) < 0 ||
+        put_load_and_time(buf, capacity, &pos, a->load_factor, a->timestamp) < 0 ||
+        put_tags(buf, capacity, &pos, a->parity_tags, a->parity_count) < 0 ||
+        put_signature(buf, capacity, &pos, a->signature) < 0) {
+        return -1;
+    }
+    return (int)pos;
+}
+
+int parity_wire_encode_delta(const parity_delta_t *d, uint8_t *buf, size_t capacity) {
+    size_t pos = 0;
+    if (put_header(buf, capacity, &pos, PARITY_MSG_DELTA, d->node_id) < 0 ||
+        put_varint(buf, capacity, &pos, d->version) < 0 ||
+        put_varint(buf, capacity, &pos, d->base_version) < 0 ||
+        put_load_and_time(buf, capacity, &pos, d->load_factor, d->timestamp) < 0 ||
+        put_tags(buf, capacity, &pos, d->added, d->added_count) < 0 ||
+        put_tags(buf, capacity, &pos, d->removed, d->removed_count) < 0 ||
+        put_signature(buf, capacity, &pos, d->signature) < 0) {
+        return -1;
+    }
+    return (int)pos;
+}
+
+int parity_wire_encode_digest(int sender, int flags, const parity_digest_entry_t *entries, int count,
+                              uint8_t *buf, size_t capacity) {
+    size_t pos = 0;
+    if (put_header(buf, capacity, &pos, PARITY_MSG_DIGEST, sender) < 0 ||
+        put_varint(buf, capacity, &pos, (uint32_t)flags) < 0 ||
+        put_varint(buf, capacity, &pos, count) < 0) {
+        return -1;
+    }
+    for (int i = 0; i < count; i++) {
+        if (put_varint(buf, capacity, &pos, (uint32_t)entries[i].node_id) < 0 ||
+            put_varint(buf, capacity, &pos, entries[i].version) < 0) {
+            return -1;
+        }
+    }
+    return (int)pos;
+}
+
+int parity_wire_decode(const uint8_t *buf, size_t length, parity_announcement_t *out) {
+    size_t pos;
+    if (get_header(buf, length, &pos, PARITY_MSG_FULL, &out->node_id) < 0 ||
+        get_version(buf, length, &pos, &out->version) < 0 ||
+        get_load_and_time(buf, length, &pos, &out->load_factor, &out->timestamp) < 0 ||
+        get_tags(buf, length, &pos, out->parity_tags, &out->parity_count) < 0 ||
+        get_signature(buf, length, &pos, out->signature) < 0) {
+        return -1;
+    }
+    return (int)pos;
+}
+
+int parity_wire_decode_delta(const uint8_t *buf, size_t length, parity_delta_t *out) {
+    size_t pos;
+    if (get_header(buf, length, &pos, PARITY_MSG_DELTA, &out->node_id) < 0 ||
+        get_version(buf, length, &pos, &out->version) < 0 ||
+        get_version(buf, length, &pos, &out->base_version) < 0 ||
+        get_load_and_time(buf, length, &pos, &out->load_factor, &out->timestamp) < 0 ||
+        get_tags(buf, length, &pos, out->added, &out->added_count) < 0 ||
+        get_tags(buf, length, &pos, out->removed, &out->removed_count) < 0 ||
+        get_signature(buf, length, &pos, out->signature) < 0) {
+        return -1;
+    }
+    return (int)pos;
+}
+
+int parity_wire_decode_digest(const uint8_t *buf, size_t length, int *sender, int *flags,
+                              parity_digest_entry_t *entries, int capacity, int *count) {
+    size_t pos;
+    uint64_t value;
+    if (get_header(buf, length, &pos, PARITY_MSG_DIGEST, sender) < 0 ||
+        get_varint(buf, length, &pos, &value) < 0) {
+        return -1;
+    }
+    *flags = (int)value;
+    if (get_varint(buf, length, &pos, &value) < 0 || value > (uint64_t)capacity) {
+        return -1;
+    }
+    *count = (int)value;
+    for (int i = 0; i < *count; i++) {
+        if (get_varint(buf, length, &pos, &value) < 0 || value > INT32_MAX) return -1;
+        entries[i].node_id = (int)value;
+        if (get_version(buf, length, &pos, &entries[i].version) < 0) return -1;
+    }
+    return (int)pos;
+}
+
+static double elapsed_ns(const struct timespec *start, const struct timespec *end) {
+    return (end->tv_sec - start->tv_sec) * 1e9 + (end->tv_nsec - start->tv_nsec);
+}
+
+void parity_wire_bench(int iterations) {
+    static const int tag_counts[] = { 0, 1, 4, 16, MAX_PARITY_TAGS };
+    uint8_t buf[PARITY_WIRE_MAX_BYTES];
+    char tag[32];
+    if (iterations <= 0) iterations = 100000;
+
+    printf("[WIRE] v%d, fixed struct = %zu bytes\n", PARITY_WIRE_VERSION, sizeof(parity_announcement_t));
+    for (size_t c = 0; c < sizeof(tag_counts) / sizeof(tag_counts[0]); c++) {
+        parity_announcement_t a, decoded;
+        memset(&a, 0, sizeof(a));
+        a.node_id = 4242;
+        a.version = 17;
+        a.load_factor = 0.37;
+        a.timestamp = time(NULL);
+        a.parity_count = tag_counts[c];
+        for (int i = 0; i < a.parity_count; i++) {
+            snprintf(tag, sizeof(tag), "parity-%04d", i);
+            a.parity_tags[i] = tag_intern(tag);
+        }
+        snprintf(a.signature, MAX_HASH_SIZE, "SIG-%d-%ld", a.node_id, (long)a.timestamp);
+
+        struct timespec t0, t1, t2;
+        int bytes = 0;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        for (int i = 0; i < iterations; i++) {
+            bytes = parity_wire_encode(&a, buf, sizeof(buf));
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        for (int i = 0; i < iterations; i++) {
+            parity_wire_decode(buf, bytes, &decoded);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t2);
+
+        printf("[WIRE] %2d tags: %4d bytes/announcement | encode %.1f ns/op | decode %.1f ns/op\n",
+               a.parity_count, bytes, elapsed_ns(&t0, &t1) / iterations, elapsed_ns(&t1, &t2) / iterations);
+    }
+
+    parity_delta_t d;
+    memset(&d, 0, sizeof(d));
+    d.node_id = 4242;
+    d.version = 18;
+    d.base_version = 17;
+    d.added[d.added_count++] = tag_intern("parity-new");
+    d.timestamp = time(NULL);
+    snprintf(d.signature, MAX_HASH_SIZE, "SIG-%d-%ld", d.node_id, (long)d.timestamp);
+    printf("[WIRE] delta (+1 tag): %d bytes\n", parity_wire_encode_delta(&d, buf, sizeof(buf)));
+
+    parity_digest_entry_t digest[PARITY_DIGEST_MAX_ENTRIES];
+    for (int i = 0; i < PARITY_DIGEST_MAX_ENTRIES; i++) {
+        digest[i] = (parity_digest_entry_t){ 4000 + i, 100 + i };
+    }
+    printf("[WIRE] digest (%d entries): %d bytes\n", PARITY_DIGEST_MAX_ENTRIES,
+           parity_wire_encode_digest(4242, 0, digest, PARITY_DIGEST_MAX_ENTRIES, buf, sizeof(buf)));
+}
@@ -0,0 +1,678 @@
+/*
+ * FT-DFRP: Sharded Network Ownership
+ *
+ * Dual Licensed:
+ * 1. AGPL-3.0 for research/academic use
+ * 2. Commercial license: contact michael.doran.808@gmail.com
+ *
+ * Copyright (C) 2025 Michael Doran
+ */
+
+#include "partition.h"
+#include "memory_guard.h"
+#include "merkle.h"
+#include "node_store.h"
+#include "topology.h"
+#include "transport.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// Records on TRANSPORT_CHANNEL_PARTITION: u8 op, u32 call id, payload.
+// Call id 0 marks a one-way request. A reply carries the call id of its
+// request and a u8 status before the payload. Payloads are native structs;
+// all ranks of a job share byte order and layout.
+#define MSG_HEADER 5
+#define REPLY_HEADER (MSG_HEADER + 1)
+#define IDLE_SLEEP_US 20
+
+partition_t partition;
+
+typedef struct pending_call {
+    struct pending_call *next;
+    uint32_t id;
+    uint8_t *reply;
+    int capacity;
+    int length;     // -1 on failure
+    int done;
+} pending_call_t;
+
+static partition_handler_fn handlers[PARTITION_OPS];
+static pthread_mutex_t calls_lock = PTHREAD_MUTEX_INITIALIZER;
+static pending_call_t *pending_calls;
+static uint32_t next_call_id = 1;
+static uint8_t *ghost_filled;
+static int halo_dirty;          // some owned node is marked dirty
+
+typedef struct {
+    partition_tick_fn fn;
+    double interval_ms;
+    double last_ms;
+} tick_t;
+
+static tick_t ticks[PARTITION_MAX_TICKS];
+static int tick_count;
+static int ticking;             // a tick is running; nested polls skip them
+
+typedef struct {
+    int32_t node_id;
+    int32_t k;
+} knn_request_t;
+
+typedef struct {
+    double density;
+    double coherence;
+} node_state_t;
+
+// Round trips shared by partition_measure_link_weights.
+static struct {
+    double *rtt_ms;     // size x size; row r is rank r's median round trips
+    int rows;           // rows filled
+} links;
+
+static void register_builtin_handlers(void);
+
+// Buffers are on the heap: a handler may call partition_call, which polls
+// and delivers further records on the same stack.
+static int send_message(int rank, partition_op_t op, uint32_t call_id,
+                        const void *payload, int length) {
+    if (length < 0 || length > PARTITION_MAX_PAYLOAD) {
+        fprintf(stderr, "[PARTITION] Op %d to rank %d: %d byte payload exceeds %d\n", op, rank, length,
+                PARTITION_MAX_PAYLOAD);
+        return -1;
+    }
+    uint8_t *buf = malloc(MSG_HEADER + length);
+    buf[0] = (uint8_t)op;
+    memcpy(buf + 1, &call_id, 4);
+    if (length > 0) memcpy(buf + MSG_HEADER, payload, length);
+    int status = transport_send(rank, TRANSPORT_CHANNEL_PARTITION, buf, MSG_HEADER + length);
+    free(buf);
+    return status;
+}
+
+static void complete_call(uint32_t call_id, int ok, const uint8_t *payload, int length) {
+    pthread_mutex_lock(&calls_lock);
+    for (pending_call_t *c = pending_calls; c; c = c->next) {
+        if (c->id != call_id) continue;
+        if (!ok || length > c->capacity) {
+            c->length = -1;
+        } else {
+            memcpy(c->reply, payload, length);
+            c->length = length;
+        }
+        c->done = 1;
+        break;
+    }
+    pthread_mutex_unlock(&calls_lock);
+}
+
+static void deliver_record(void *ctx, int source_rank, const uint8_t *record, int length) {
+    (void)ctx;
+    if (length < MSG_HEADER || record[0] >= PARTITION_OPS) return;
+    partition_op_t op = record[0];
+    uint32_t call_id;
+    memcpy(&call_id, record + 1, 4);
+
+    if (op == PARTITION_OP_REPLY) {
+        if (length >= REPLY_HEADER) {
+            complete_call(call_id, record[MSG_HEADER], record + REPLY_HEADER, length - REPLY_HEADER);
+        }
+        return;
+    }
+
+    // The status byte counts against the payload limit.
+    uint8_t *reply = malloc(PARTITION_MAX_PAYLOAD);
+    int n = handlers[op] ? handlers[op](source_rank, record + MSG_HEADER, length - MSG_HEADER,
+                                        reply + 1, PARTITION_MAX_PAYLOAD - 1) : -1;
+    if (call_id != 0) {
+        reply[0] = n >= 0;
+        send_message(source_rank, PARTITION_OP_REPLY, call_id, reply, 1 + (n > 0 ? n : 0));
+    }
+    free(reply);
+}
+
+void partition_init(int total) {
+    partition_free();
+    partition.rank = transport_rank();
+    partition.size = transport_size();
+
+    int base = total / partition.size;
+    int extra = total % partition.size;
+    partition.first = partition.rank * base + (partition.rank < extra ? partition.rank : extra);
+    partition.owned = base + (partition.rank < extra ? 1 : 0);
+
+    partition.halo_out = calloc(partition.size, sizeof(int*));
+    partition.halo_out_count = calloc(partition.size, sizeof(int));
+    partition.halo_out_capacity = calloc(partition.size, sizeof(int));
+    partition.dirty = calloc(partition.owned > 0 ? partition.owned : 1, 1);
+    partition.node_epoch = calloc(partition.owned > 0 ? partition.owned : 1, sizeof(uint64_t));
+
+    register_builtin_handlers();
+    transport_set_handler(TRANSPORT_CHANNEL_PARTITION, deliver_record, NULL);
+}
+
+void partition_free(void) {
+    for (int r = 0; r < partition.size; r++) free(partition.halo_out[r]);
+    free(partition.halo_out);
+    free(partition.halo_out_count);
+    free(partition.halo_out_capacity);
+    free(partition.dirty);
+    free(partition.node_epoch);
+    free(partition.ghost_ids);
+    free(partition.ghost_slots);
+    free(ghost_filled);
+    ghost_filled = NULL;
+    free(links.rtt_ms);
+    memset(&links, 0, sizeof(links));
+    memset(&partition, 0, sizeof(partition));
+}
+
+int partition_owner(int node_id) {
+    int base = total_nodes / partition.size;
+    int extra = total_nodes % partition.size;
+    // The first extra ranks own base + 1 nodes each.
+    int split = extra * (base + 1);
+    if (node_id < split) return node_id / (base + 1);
+    return extra + (node_id - split) / base;
+}
+
+static unsigned ghost_hash(int node_id) {
+    return (unsigned)node_id * 2654435761u;
+}
+
+int partition_ghost_index(int node_id) {
+    if (!partition.ghost_slots) return -1;
+    for (unsigned s = ghost_hash(node_id) & partition.ghost_slot_mask;;
+         s = (s + 1) & partition.ghost_slot_mask) {
+        int g = partition.ghost_slots[s];
+        if (g < 0) return -1;
+        if (partition.ghost_ids[g] == node_id) return g;
+    }
+}
+
+static void rehash_ghosts(int slots) {
+    free(partition.ghost_slots);
+    partition.ghost_slots = malloc(sizeof(int) * slots);
+    memset(partition.ghost_slots, 0xff, sizeof(int) * slots);
+    partition.ghost_slot_mask = slots - 1;
+    for (int g = 0; g < partition.ghost_count; g++) {
+        unsigned s = ghost_hash(partition.ghost_ids[g]) & partition.ghost_slot_mask;
+        while (partition.ghost_slots[s] >= 0) s = (s + 1) & partition.ghost_slot_mask;
+        partition.ghost_slots[s] = g;
+    }
+}
+
+static void add_ghost(int node_id, int *capacity) {
+    if (partition_ghost_index(node_id) >= 0) return;
+    if (partition.ghost_count == *capacity) {
+        *capacity = *capacity ? *capacity * 2 : 16;
+        partition.ghost_ids = realloc(partition.ghost_ids, sizeof(int) * *capacity);
+    }
+    partition.ghost_ids[partition.ghost_count++] = node_id;
+    // Keep the table at most half full.
+    if (2 * partition.ghost_count > partition.ghost_slot_mask + 1) {
+        rehash_ghosts(4 * *capacity);
+    } else {
+        unsigned s = ghost_hash(node_id) & partition.ghost_slot_mask;
+        while (partition.ghost_slots[s] >= 0) s = (s + 1) & partition.ghost_slot_mask;
+        partition.ghost_slots[s] = partition.ghost_count - 1;
+    }
+}
+
+static int compare_int(const void *a, const void *b) {
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+void partition_build_ghosts(void) {
+    int capacity = 0;
+    rehash_ghosts(16);
+    int first_edge = topology.offsets[partition.first];
+    int last_edge = topology.offsets[partition.first + partition.owned];
+    for (int e = first_edge; e < last_edge; e++) {
+        int id = topology.targets[e];
+        if (!partition_owns(id)) add_ghost(id, &capacity);
+    }
+
+    network = SAFE_REALLOC(network, sizeof(TorusNode) * (partition.owned + partition.ghost_count));
+    for (int g = 0; g < partition.ghost_count; g++) {
+        TorusNode *ghost = &network[partition.owned + g];
+        memset(ghost, 0, sizeof(*ghost));
+        ghost->id = partition.ghost_ids[g];
+    }
+    node_store_resize(partition.owned + partition.ghost_count);
+    partition.node_epoch = realloc(partition.node_epoch,
+                                   sizeof(uint64_t) * (partition.owned + partition.ghost_count + 1));
+    memset(partition.node_epoch + partition.owned, 0, sizeof(uint64_t) * partition.ghost_count);
+    ghost_filled = calloc(partition.ghost_count > 0 ? partition.ghost_count : 1, 1);
+    partition.ghosts_pending = partition.ghost_count;
+
+    // One subscription per owner, listing the ids we need.
+    int *ids = malloc(sizeof(int) * (partition.ghost_count > 0 ? partition.ghost_count : 1));
+    if (partition.ghost_count > 0) memcpy(ids, partition.ghost_ids, sizeof(int) * partition.ghost_count);
+    qsort(ids, partition.ghost_count, sizeof(int), compare_int);   // ids sorted = grouped by owner
+    int max_ids = PARTITION_MAX_PAYLOAD / (int)sizeof(int);
+    for (int begin = 0; begin < partition.ghost_count; ) {
+        int owner = partition_owner(ids[begin]);
+        int end = begin;
+        while (end < partition.ghost_count && end - begin < max_ids &&
+               partition_owner(ids[end]) == owner) {
+            end++;
+        }
+        partition_post(owner, PARTITION_OP_HALO_SUBSCRIBE, ids + begin, sizeof(int) * (end - begin));
+        begin = end;
+    }
+    free(ids);
+
+    // Owners answer subscriptions from their own poll loop, so everyone
+    // keeps serving while waiting for their ghosts.
+    while (partition.ghosts_pending > 0) {
+        if (partition_poll() == 0) usleep(IDLE_SLEEP_US);
+    }
+    printf("[PARTITION] Rank %d/%d owns nodes %d..%d (%d) with %d ghosts\n",
+           partition.rank, partition.size, partition.first,
+           partition.first + partition.owned - 1, partition.owned, partition.ghost_count);
+}
+
+void partition_mark_dirty(int node_id) {
+    int local = partition_local_index(node_id);
+    if (local >= 0 && partition.dirty) {
+        partition.dirty[local] = 1;
+        halo_dirty = 1;
+        partition.node_epoch[local] = ++partition.state_epoch;
+    }
+    merkle_note_changed(node_id);
+}
+
+static int halo_record_bytes(void) {
+    return (int)(sizeof(int32_t) + sizeof(node_state_t) + sizeof(double) * vector_dim);
+}
+
+static int write_halo_record(uint8_t *p, int local) {
+    int32_t id = network[local].id;
+    node_state_t state = { node_hot.density[local], node_hot.coherence[local] };
+    memcpy(p, &id, sizeof(id));
+    memcpy(p + sizeof(id), &state, sizeof(state));
+    memcpy(p + sizeof(id) + sizeof(state), node_vector(local), sizeof(double) * vector_dim);
+    return halo_record_bytes();
+}
+
+// Sends the listed owned nodes to rank, packing as many per record as fit.
+static void send_halo(int rank, const int *locals, int count, int dirty_only) {
+    uint8_t buf[PARTITION_MAX_PAYLOAD];
+    int used = 0, record = halo_record_bytes();
+    for (int i = 0; i < count; i++) {
+        if (dirty_only && !partition.dirty[locals[i]]) continue;
+        if (used + record > PARTITION_MAX_PAYLOAD) {
+            partition_post(rank, PARTITION_OP_HALO_UPDATE, buf, used);
+            used = 0;
+        }
+        used += write_halo_record(buf + used, locals[i]);
+    }
+    if (used > 0) partition_post(rank, PARTITION_OP_HALO_UPDATE, buf, used);
+}
+
+void partition_halo_exchange(void) {
+    if (!partition.dirty || !halo_dirty) return;
+    halo_dirty = 0;
+    for (int r = 0; r < partition.size; r++) {
+        if (partition.halo_out_count[r] > 0) {
+            send_halo(r, partition.halo_out[r], partition.halo_out_count[r], 1);
+        }
+    }
+    memset(partition.dirty, 0, partition.owned);
+}
+
+static int handle_halo_subscribe(int source, const uint8_t *req, int length, uint8_t *reply, int cap) {
+    (void)reply; (void)cap;
+    int count = length / (int)sizeof(int);
+    int *list = partition.halo_out[source];
+    int used = partition.halo_out_count[source];
+    int capacity = partition.halo_out_capacity[source];
+    int first_new = used;
+
+    for (int i = 0; i < count; i++) {
+        int id;
+        memcpy(&id, req + i * sizeof(int), sizeof(int));
+        int local = partition_local_index(id);
+        if (local < 0) continue;
+        if (used == capacity) {
+            capacity = capacity ? capacity * 2 : 16;
+            list = realloc(list, sizeof(int) * capacity);
+        }
+        list[used++] = local;
+    }
+    partition.halo_out[source] = list;
+    partition.halo_out_count[source] = used;
+    partition.halo_out_capacity[source] = capacity;
+
+    // Initial fill for the new subscriber.
+    send_halo(source, list + first_new, used - first_new, 0);
+    return 0;
+}
+
+static int handle_halo_update(int source, const uint8_t *req, int length, uint8_t *reply, int cap) {
+    (void)source; (void)reply; (void)cap;
+    int record = halo_record_bytes();
+    for (int pos = 0; pos + record <= length; pos += record) {
+        int32_t id;
+        node_state_t state;
+        memcpy(&id, req + pos, sizeof(id));
+        memcpy(&state, req + pos + sizeof(id), sizeof(state));
+        int g = partition_ghost_index(id);
+        if (g < 0) continue;
+        int slot = partition.owned + g;
+        node_hot.density[slot] = state.density;
+        node_hot.coherence[slot] = state.coherence;
+        memcpy(node_vector(slot), req + pos + sizeof(id) + sizeof(state), sizeof(double) * vector_dim);
+        partition.node_epoch[slot] = ++partition.state_epoch;
+        if (!ghost_filled[g]) {
+            ghost_filled[g] = 1;
+            partition.ghosts_pending--;
+        }
+    }
+    return 0;
+}
+
+static int handle_shutdown(int source, const uint8_t *req, int length, uint8_t *reply, int cap) {
+    (void)source; (void)req; (void)length; (void)reply; (void)cap;
+    partition.shutdown_requested = 1;
+    return 0;
+}
+
+void partition_register_handler(partition_op_t op, partition_handler_fn handler) {
+    if (op > PARTITION_OP_REPLY && op < PARTITION_OPS) handlers[op] = handler;
+}
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+void partition_register_tick(partition_tick_fn tick, double interval_ms) {
+    if (tick_count == PARTITION_MAX_TICKS) return;
+    ticks[tick_count++] = (tick_t){ tick, interval_ms, now_ms() };
+}
+
+static void run_ticks(void) {
+    if (ticking || tick_count == 0) return;
+    ticking = 1;
+    double now = now_ms();
+    for (int i = 0; i < tick_count; i++) {
+        if (now - ticks[i].last_ms < ticks[i].interval_ms) continue;
+        ticks[i].last_ms = now;
+        ticks[i].fn();
+    }
+    ticking = 0;
+}
+
+int partition_call(int rank, partition_op_t op, const void *request, int length,
+                   void *reply, int capacity) {
+    pending_call_t call = { .reply = reply, .capacity = capacity };
+    pthread_mutex_lock(&calls_lock);
+    call.id = next_call_id++;
+    if (next_call_id == 0) next_call_id = 1;
+    call.next = pending_calls;
+    pending_calls = &call;
+    pthread_mutex_unlock(&calls_lock);
+
+    // A request that cannot be sent fails now instead of waiting for a
+    // reply that will never come.
+    if (send_message(rank, op, call.id, request, length) != 0) {
+        call.length = -1;
+    } else {
+        transport_flush();
+        for (;;) {
+            pthread_mutex_lock(&calls_lock);
+            int done = call.done;
+            pthread_mutex_unlock(&calls_lock);
+            if (done) break;
+            if (partition_poll() == 0) usleep(IDLE_SLEEP_US);
+        }
+    }
+
+    pthread_mutex_lock(&calls_lock);
+    for (pending_call_t **p = &pending_calls; *p; p = &(*p)->next) {
+        if (*p == &call) {
+            *p = call.next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&calls_lock);
+    return call.length;
+}
+
+int partition_post(int rank, partition_op_t op, const void *request, int length) {
+    return send_message(rank, op, 0, request, length);
+}
+
+int partition_poll(void) {
+    int delivered = transport_poll();
+    partition_halo_exchange();
+    run_ticks();
+    return delivered;
+}
+
+void partition_serve(void) {
+    while (!partition.shutdown_requested) {
+        if (partition_poll() == 0) usleep(IDLE_SLEEP_US);
+    }
+}
+
+void partition_shutdown_peers(void) {
+    for (int r = 0; r < partition.size; r++) {
+        if (r != partition.rank) partition_post(r, PARTITION_OP_SHUTDOWN, NULL, 0);
+    }
+    transport_flush();
+}
+
+// Local shard search; results carry global node ids.
+static int local_knn(int local, int k, similarity_result_t *out) {
+    int found = find_k_nearest_into(network, partition.owned, local, k, out);
+    for (int i = 0; i < found; i++) out[i].node_id = network[out[i].node_id].id;
+    return found;
+}
+
+static int max_remote_k(void) {
+    return (PARTITION_MAX_PAYLOAD - (int)sizeof(int32_t)) / (int)sizeof(similarity_result_t);
+}
+
+static int handle_knn(int source, const uint8_t *req, int length, uint8_t *reply, int cap) {
+    (void)source;
+    knn_request_t r;
+    if (length < (int)sizeof(r)) return -1;
+    memcpy(&r, req, sizeof(r));
+    int local = partition_local_index(r.node_id);
+    if (local < 0 || r.k <= 0 || r.k > max_remote_k()) return -1;
+
+    // reply is not aligned for similarity_result_t.
+    similarity_result_t *results = malloc(sizeof(similarity_result_t) * r.k);
+    int32_t found = local_knn(local, r.k, results);
+    int bytes = (int)(sizeof(found) + sizeof(similarity_result_t) * found);
+    if (bytes <= cap) {
+        memcpy(reply, &found, sizeof(found));
+        memcpy(reply + sizeof(found), results, sizeof(similarity_result_t) * found);
+    }
+    free(results);
+    return bytes <= cap ? bytes : -1;
+}
+
+int partition_knn(int node_id, int k, similarity_result_t *out) {
+    if (node_id < 0 || node_id >= total_nodes || k <= 0) return -1;
+    int local = partition_local_index(node_id);
+    if (local >= 0) return local_knn(local, k, out);
+
+    if (k > max_remote_k()) k = max_remote_k();
+    knn_request_t r = { node_id, k };
+    uint8_t *reply = malloc(sizeof(int32_t) + sizeof(similarity_result_t) * k);
+    int n = partition_call(partition_owner(node_id), PARTITION_OP_KNN, &r, sizeof(r),
+                           reply, (int)(sizeof(int32_t) + sizeof(similarity_result_t) * k));
+    int32_t found = -1;
+    if (n >= (int)sizeof(found)) {
+        memcpy(&found, reply, sizeof(found));
+        memcpy(out, reply + sizeof(found), sizeof(similarity_result_t) * found);
+    }
+    free(reply);
+    return found;
+}
+
+static int handle_fetch_node(int source, const uint8_t *req, int length, uint8_t *reply, int cap) {
+    (void)source; (void)cap;
+    int32_t id;
+    if (length < (int)sizeof(id)) return -1;
+    memcpy(&id, req, sizeof(id));
+    int local = partition_local_index(id);
+    if (local < 0) return -1;
+    return write_halo_record(reply, local);
+}
+
+int partition_fetch_node(int node_id, double *vector, double *density, double *coherence) {
+    // Ghosts may lag their owner, so only owned nodes are answered locally.
+    if (partition_owns(node_id)) {
+        int local = partition_local_index(node_id);
+        memcpy(vector, node_vector(local), sizeof(double) * vector_dim);
+        if (density) *density = node_hot.density[local];
+        if (coherence) *coherence = node_hot.coherence[local];
+        return 0;
+    }
+    if (node_id < 0 || node_id >= total_nodes) return -1;
+
+    int32_t id = node_id;
+    uint8_t *reply = malloc(halo_record_bytes());
+    int n_bytes = partition_call(partition_owner(node_id), PARTITION_OP_FETCH_NODE, &id, sizeof(id),
+                                 reply, halo_record_bytes());
+    if (n_bytes == halo_record_bytes()) {
+        node_state_t state;
+        memcpy(&state, reply + sizeof(id), sizeof(state));
+        memcpy(vector, reply + sizeof(id) + sizeof(state), sizeof(double) * vector_dim);
+        if (density) *density = state.density;
+        if (coherence) *coherence = state.coherence;
+    }
+    free(reply);
+    return n_bytes == halo_record_bytes() ? 0 : -1;
+}
+
+static int handle_inject_vector(int source, const uint8_t *req, int length, uint8_t *reply, int cap) {
+    (void)source; (void)reply; (void)cap;
+    int32_t id;
+    if (length != (int)(sizeof(id) + sizeof(double) * vector_dim)) return -1;
+    memcpy(&id, req, sizeof(id));
+    int local = partition_local_index(id);
+    if (local < 0) return -1;
+    double *vector = malloc(sizeof(double) * vector_dim);
+    memcpy(vector, req + sizeof(id), sizeof(double) * vector_dim);
+    int status = inject_vector(&network[local], vector, vector_dim);
+    free(vector);
+    return status;
+}
+
+int partition_inject_vector(int node_id, const double *vector) {
+    int local = partition_local_index(node_id);
+    if (local >= 0) return inject_vector(&network[local], vector, vector_dim);
+    int length = (int)(sizeof(int32_t) + sizeof(double) * vector_dim);
+    uint8_t *req = malloc(length);
+    int32_t id = node_id;
+    memcpy(req, &id, sizeof(id));
+    memcpy(req + sizeof(id), vector, sizeof(double) * vector_dim);
+    partition_post(partition_owner(node_id), PARTITION_OP_INJECT_VECTOR, req, length);
+    free(req);
+    return 0;
+}
+
+// ---- Link weights ---------------------------------------------------------
+
+static void links_alloc(void) {
+    if (!links.rtt_ms) links.rtt_ms = calloc((size_t)partition.size * partition.size, sizeof(double));
+}
+
+static int handle_ping(int source, const uint8_t *req, int length, uint8_t *reply, int cap) {
+    (void)source; (void)req; (void)length; (void)reply; (void)cap;
+    return 0;
+}
+
+// A peer may finish timing before this rank starts, so rows are kept
+// whenever they arrive.
+static int handle_rtt_row(int source, const uint8_t *req, int length, uint8_t *reply, int cap) {
+    (void)reply; (void)cap;
+    if (length != (int)sizeof(double) * partition.size) return -1;
+    links_alloc();
+    memcpy(links.rtt_ms + (size_t)source * partition.size, req, length);
+    links.rows++;
+    return 0;
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+void partition_measure_link_weights(topology_t *graph, int probes) {
+    int size = partition.size;
+    if (size < 2) return;
+    if (probes <= 0) probes = PARTITION_RTT_PROBES;
+    links_alloc();
+
+    // Round trips are timed on the caller's clock, so they hold across hosts.
+    double *row = calloc(size, sizeof(double));
+    double *samples = malloc(sizeof(double) * probes);
+    for (int r = 0; r < size; r++) {
+        if (r == partition.rank) continue;
+        int timed = 0;
+        for (int p = 0; p < probes; p++) {
+            double start = now_ms();
+            if (partition_call(r, PARTITION_OP_PING, NULL, 0, NULL, 0) == 0) samples[timed++] = now_ms() - start;
+        }
+        qsort(samples, timed, sizeof(double), compare_double);
+        row[r] = timed > 0 ? samples[timed / 2] : 0.0;
+    }
+    free(samples);
+    memcpy(links.rtt_ms + (size_t)partition.rank * size, row, sizeof(double) * size);
+    links.rows++;
+    for (int r = 0; r < size; r++) {
+        if (r != partition.rank) partition_post(r, PARTITION_OP_RTT_ROW, row, (int)sizeof(double) * size);
+    }
+    transport_flush();
+    free(row);
+    // Keep answering pings until every rank has posted its row.
+    while (links.rows < size) {
+        if (partition_poll() == 0) usleep(IDLE_SLEEP_US);
+    }
+
+    int edges = graph->offsets[graph->nodes];
+    if (!graph->weights) graph->weights = malloc(sizeof(float) * (edges > 0 ? edges : 1));
+    for (int u = 0; u < graph->nodes; u++) {
+        int a = partition_owner(u);
+        for (int e = graph->offsets[u]; e < graph->offsets[u + 1]; e++) {
+            int b = partition_owner(graph->targets[e]);
+            graph->weights[e] = a == b ? 0.0f :
+                (float)((links.rtt_ms[(size_t)a * size + b] + links.rtt_ms[(size_t)b * size + a]) / 2);
+        }
+    }
+
+    double lo = 0.0, hi = 0.0;
+    for (int r = 0; r < size; r++) {
+        if (r == partition.rank) continue;
+        double rtt = links.rtt_ms[(size_t)partition.rank * size + r];
+        if (lo == 0.0 || rtt < lo) lo = rtt;
+        if (rtt > hi) hi = rtt;
+    }
+    printf("[PARTITION] Rank %d RTT to peers %.3f..%.3f ms (median of %d); edge weights set\n",
+           partition.rank, lo, hi, probes);
+    free(links.rtt_ms);
+    memset(&links, 0, sizeof(links));
+}
+
+static void register_builtin_handlers(void) {
+    partition_register_handler(PARTITION_OP_SHUTDOWN, handle_shutdown);
+    partition_register_handler(PARTITION_OP_HALO_SUBSCRIBE, handle_halo_subscribe);
+    partition_register_handler(PARTITION_OP_HALO_UPDATE, handle_halo_update);
+    partition_register_handler(PARTITION_OP_INJECT_VECTOR, handle_inject_vector);
+    partition_register_handler(PARTITION_OP_KNN, handle_knn);
+    partition_register_handler(PARTITION_OP_FETCH_NODE, handle_fetch_node);
+    partition_register_handler(PARTITION_OP_PING, handle_ping);
+    partition_register_handler(PARTITION_OP_RTT_ROW, handle_rtt_row);
+}
@@ -0,0 +1,476 @@
+/*
+ * FT-DFRP: Fractal Toroidal Density Field Routing Protocol - Vector Quantization
+ *
+ * Dual Licensed:
+ * 1. AGPL-3.0 for research/academic use: https://www.gnu.org/licenses/agpl-3.0.html
+ * 2. Commercial license available - contact michael.doran.808@gmail.com for terms
+ *
+ * Copyright (C) 2025 Michael Doran
+ */
+
+#include "quantize.h"
+#include "node_store.h"
+#include <float.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define QUANT_SCAN_CHUNK 256
+
+// Per-query state: the ADC table for PQ, the scale-folded query for int8.
+typedef struct {
+    const quantized_store_t *store;
+    const double *query;
+    double inv_q;
+    double bias;
+    float *table;
+} quant_query_t;
+
+const char* quant_mode_name(quant_mode_t mode) {
+    switch (mode) {
+        case QUANT_FP32: return "fp32";
+        case QUANT_INT8: return "int8";
+        case QUANT_PQ:   return "pq";
+    }
+    return "unknown";
+}
+
+static int default_pq_m(int dim) {
+    int target = dim <= 16 ? dim / 2 : dim / 4;
+    if (target < 1) target = 1;
+    while (dim % target != 0) target--;
+    return target;
+}
+
+// ---- Training -------------------------------------------------------------
+
+static void train_int8(quantized_store_t *store, int total_nodes) {
+    int dim = store->dim;
+    for (int d = 0; d < dim; d++) {
+        double lo = DBL_MAX, hi = -DBL_MAX;
+        for (int i = 0; i < total_nodes; i++) {
+            double v = node_vector(i)[d];
+            if (v < lo) lo = v;
+            if (v > hi) hi = v;
+        }
+        if (total_nodes == 0) lo = hi = 0.0;
+        store->int8_offset[d] = (float)((lo + hi) / 2.0);
+        store->int8_scale[d] = hi > lo ? (float)((hi - lo) / 254.0) : 1.0f;
+    }
+}
+
+static int nearest_centroid(const float *codebook, int centroids, const double *x, int sub_dim) {
+    int best = 0;
+    double best_dist = DBL_MAX;
+    for (int c = 0; c < centroids; c++) {
+        const float *centroid = codebook + (size_t)c * sub_dim;
+        double dist = 0.0;
+        for (int j = 0; j < sub_dim; j++) {
+            double diff = x[j] - centroid[j];
+            dist += diff * diff;
+        }
+        if (dist < best_dist) {
+            best_dist = dist;
+            best = c;
+        }
+    }
+    return best;
+}
+
+// Lloyd's k-means per subspace on a random sample of node vectors.
+static void train_pq(quantized_store_t *store, int total_nodes) {
+    int sub_dim = store->pq_sub_dim;
+    int samples = total_nodes < PQ_TRAIN_SAMPLES ? total_nodes : PQ_TRAIN_SAMPLES;
+    if (samples == 0) return;
+
+    int *sample_ids = malloc(sizeof(int) * samples);
+    for (int i = 0; i < samples; i++) {
+        sample_ids[i] = samples == total_nodes ? i : rand() % total_nodes;
+    }
+
+    double *sums = malloc(sizeof(double) * PQ_CENTROIDS * sub_dim);
+    int *counts = malloc(sizeof(int) * PQ_CENTROIDS);
+
+    for (int m = 0; m < store->pq_m; m++) {
+        float *codebook = store->pq_codebooks + (size_t)m * PQ_CENTROIDS * sub_dim;
+        int offset = m * sub_dim;
+
+        for (int c = 0; c < PQ_CENTROIDS; c++) {
+            const double *seed = node_vector(sample_ids[rand() % samples]) + offset;
+            for (int j = 0; j < sub_dim; j++) codebook[c * sub_dim + j] = (float)seed[j];
+        }
+
+        for (int iter = 0; iter < PQ_TRAIN_ITERATIONS; iter++) {
+            memset(sums, 0, sizeof(double) * PQ_CENTROIDS * sub_dim);
+            memset(counts, 0, sizeof(int) * PQ_CENTROIDS);
+            for (int s = 0; s < samples; s++) {
+                const double *x = node_vector(sample_ids[s]) + offset;
+                int c = nearest_centroid(codebook, PQ_CENTROIDS, x, sub_dim);
+                counts[c]++;
+                for (int j = 0; j < sub_dim; j++) sums[c * sub_dim + j] += x[j];
+            }
+            for (int c = 0; c < PQ_CENTROIDS; c++) {
+                const double *reseed = node_vector(sample_ids[rand() % samples]) + offset;
+                for (int j = 0; j < sub_dim; j++) {
+                    codebook[c * sub_dim + j] = counts[c] ?
+                        (float)(sums[c * sub_dim + j] / counts[c]) : (float)reseed[j];
+                }
+            }
+        }
+    }
+
+    free(sample_ids);
+    free(sums);
+    free(counts);
+}
+
+// ---- Encoding -------------------------------------------------------------
+
+static void grow(quantized_store_t *store, int needed) {
+    int capacity = store->capacity ? store->capacity : 64;
+    while (capacity < needed) capacity *= 2;
+
+    store->inv_norms = realloc(store->inv_norms, sizeof(float) * capacity);
+    switch (store->mode) {
+        case QUANT_FP32:
+            store->fp32 = realloc(store->fp32, sizeof(float) * (size_t)capacity * store->dim);
+            break;
+        case QUANT_INT8:
+            store->int8 = realloc(store->int8, sizeof(int8_t) * (size_t)capacity * store->dim);
+            break;
+        case QUANT_PQ:
+            store->pq_codes = realloc(store->pq_codes, sizeof(uint8_t) * (size_t)capacity * store->pq_m);
+            break;
+    }
+    store->capacity = capacity;
+}
+
+void quantized_store_set(quantized_store_t *store, int id, const double *vector) {
+    if (id >= store->capacity) grow(store, id + 1);
+    int dim = store->dim;
+
+    double norm = 0.0;
+    for (int d = 0; d < dim; d++) norm += vector[d] * vector[d];
+    store->inv_norms[id] = norm > 0.0 ? (float)(1.0 / sqrt(norm)) : 0.0f;
+
+    switch (store->mode) {
+        case QUANT_FP32:
+            for (int d = 0; d < dim; d++) store->fp32[(size_t)id * dim + d] = (float)vector[d];
+            break;
+        case QUANT_INT8:
+            for (int d = 0; d < dim; d++) {
+                long code = lround((vector[d] - store->int8_offset[d]) / store->int8_scale[d]);
+                if (code > 127) code = 127;
+                if (code < -127) code = -127;
+                store->int8[(size_t)id * dim + d] = (int8_t)code;
+            }
+            break;
+        case QUANT_PQ:
+            for (int m = 0; m < store->pq_m; m++) {
+                const float *codebook = store->pq_codebooks + (size_t)m * PQ_CENTROIDS * store->pq_sub_dim;
+                store->pq_codes[(size_t)id * store->pq_m + m] = (uint8_t)nearest_centroid(
+                    codebook, PQ_CENTROIDS, vector + m * store->pq_sub_dim, store->pq_sub_dim);
+            }
+            break;
+    }
+}
+
+quantized_store_t* quantized_store_build(TorusNode *network, int total_nodes, int dim,
+                                         quant_mode_t mode, int pq_m) {
+    (void)network;   // vectors live in node_store
+    quantized_store_t *store = calloc(1, sizeof(quantized_store_t));
+    store->mode = mode;
+    store->dim = dim;
+
+    if (mode == QUANT_INT8) {
+        store->int8_scale = malloc(sizeof(float) * dim);
+        store->int8_offset = malloc(sizeof(float) * dim);
+        train_int8(store, total_nodes);
+    } else if (mode == QUANT_PQ) {
+        store->pq_m = (pq_m > 0 && dim % pq_m == 0) ? pq_m : default_pq_m(dim);
+        store->pq_sub_dim = dim / store->pq_m;
+        store->pq_codebooks = malloc(sizeof(float) * store->pq_m * PQ_CENTROIDS * store->pq_sub_dim);
+        train_pq(store, total_nodes);
+    }
+
+    grow(store, total_nodes > 0 ? total_nodes : 64);
+    for (int i = 0; i < total_nodes; i++) {
+        quantized_store_set(store, i, node_vector(i));
+    }
+    return store;
+}
+
+void quantized_store_free(quantized_store_t *store) {
+    if (!store) return;
+    free(store->inv_norms);
+    free(store->fp32);
+    free(store->int8);
+    free(store->int8_scale);
+    free(store->int8_offset);
+    free(store->pq_codebooks);
+    free(store->pq_codes);
+    free(store);
+}
+
+size_t quantized_store_bytes_per_vector(const quantized_store_t *store) {
+    switch (store->mode) {
+        case QUANT_FP32: return sizeof(float) * store->dim + sizeof(float);
+        case QUANT_INT8: return sizeof(int8_t) * store->dim + sizeof(float);
+        case QUANT_PQ:   return sizeof(uint8_t) * store->pq_m + sizeof(float);
+    }
+    return 0;
+}
+
+// ---- Scoring --------------------------------------------------------------
+
+static void query_prepare(const quantized_store_t *store, const double *query, quant_query_t *q) {
+    int dim = store->dim;
+    double norm = 0.0;
+    for (int d = 0; d < dim; d++) norm += query[d] * query[d];
+
+    q->store = store;
+    q->query = query;
+    q->inv_q = norm > 0.0 ? 1.0 / sqrt(norm) : 0.0;
+    q->bias = 0.0;
+    q->table = NULL;
+
+    if (store->mode == QUANT_INT8) {
+        q->table = malloc(sizeof(float) * dim);
+        for (int d = 0; d < dim; d++) {
+            q->table[d] = (float)(query[d] * store->int8_scale[d]);
+            q->bias += query[d] * store->int8_offset[d];
+        }
+    } else if (store->mode == QUANT_PQ) {
+        int sub_dim = store->pq_sub_dim;
+        q->table = malloc(sizeof(float) * store->pq_m * PQ_CENTROIDS);
+        for (int m = 0; m < store->pq_m; m++) {
+            const float *codebook = store->pq_codebooks + (size_t)m * PQ_CENTROIDS * sub_dim;
+            const double *qs = query + m * sub_dim;
+            for (int c = 0; c < PQ_CENTROIDS; c++) {
+                double dot = 0.0;
+                for (int j = 0; j < sub_dim; j++) dot += qs[j] * codebook[c * sub_dim + j];
+                q->table[m * PQ_CENTROIDS + c] = (float)dot;
+            }
+        }
+    }
+}
+
+static inline double score_one(const quantized_store_t *store, const quant_query_t *q, int id) {
+    int dim = store->dim;
+    double dot = q->bias;
+    switch (store->mode) {
+        case QUANT_FP32: {
+            const float *v = store->fp32 + (size_t)id * dim;
+            for (int d = 0; d < dim; d++) dot += q->query[d] * v[d];
+            break;
+        }
+        case QUANT_INT8: {
+            const int8_t *v = store->int8 + (size_t)id * dim;
+            float acc = 0.0f;
+            for (int d = 0; d < dim; d++) acc += q->table[d] * v[d];
+            dot += acc;
+            break;
+        }
+        case QUANT_PQ: {
+            const uint8_t *codes = store->pq_codes + (size_t)id * store->pq_m;
+            float acc = 0.0f;
+            for (int m = 0; m < store->pq_m; m++) acc += q->table[m * PQ_CENTROIDS + codes[m]];
+            dot += acc;
+            break;
+        }
+    }
+    return dot * q->inv_q * store->inv_norms[id];
+}
+
+static void score_range(const quantized_store_t *store, const quant_query_t *q,
+                        int first, int n, double *out) {
+    for (int i = 0; i < n; i++) out[i] = score_one(store, q, first + i);
+}
+
+// hnsw_score_fn over a prepared query.
+static double score_id(const void *ctx, int id) {
+    const quant_query_t *q = ctx;
+    return score_one(q->store, q, id);
+}
+
+// Exact re-rank of pool[0..count) against the full-precision vectors into the best k.
+static int rerank_exact(const similarity_result_t *pool, int count, const double *query,
+                        double coherence, int dim, int k, similarity_result_t *out) {
+    similarity_heap_t heap;
+    similarity_heap_init(&heap, out, k);
+    for (int i = 0; i < count; i++) {
+        int id = pool[i].node_id;
+        double similarity = cosine_similarity(query, node_vector(id), dim);
+        heap_insert(&heap, id, similarity, similarity * coherence + node_hot.density[id]);
+    }
+    return heap_drain_sorted(&heap);
+}
+
+int quantized_find_k_nearest(quantized_store_t *store, TorusNode *network, int total_nodes,
+                             int query_node, int k, int rerank, similarity_result_t *out) {
+    return quantized_find_k_nearest_vector(store, network, total_nodes, node_vector(query_node),
+                                           node_hot.coherence[query_node], query_node, k, rerank, out);
+}
+
+int quantized_find_k_nearest_vector(quantized_store_t *store, TorusNode *network, int total_nodes,
+                                    const double *query, double coherence, int exclude, int k,
+                                    int rerank, similarity_result_t *out) {
+    (void)network;
+    if (k <= 0) return 0;
+    int pool_size = rerank > 0 ? k * rerank : k;
+    similarity_result_t *pool = rerank > 0 ? malloc(sizeof(similarity_result_t) * pool_size) : out;
+
+    quant_query_t q;
+    query_prepare(store, query, &q);
+
+    similarity_heap_t heap;
+    similarity_heap_init(&heap, pool, pool_size);
+    double similarities[QUANT_SCAN_CHUNK];
+    for (int base = 0; base < total_nodes; base += QUANT_SCAN_CHUNK) {
+        int n = total_nodes - base < QUANT_SCAN_CHUNK ? total_nodes - base : QUANT_SCAN_CHUNK;
+        score_range(store, &q, base, n, similarities);
+        for (int j = 0; j < n; j++) {
+            int i = base + j;
+            if (i == exclude) continue;
+            double score = similarities[j] * coherence + node_hot.density[i];
+            if (heap.count == pool_size && score <= pool[0].combined_score) continue;
+            heap_insert(&heap, i, similarities[j], score);
+        }
+    }
+    free(q.table);
+
+    if (rerank <= 0) return heap_drain_sorted(&heap);
+
+    int found = rerank_exact(pool, heap.count, query, coherence, store->dim, k, out);
+    free(pool);
+    return found;
+}
+
+int quantized_search_index(quantized_store_t *store, const hnsw_index_t *index,
+                           hnsw_scratch_t *scratch, const double *query, double coherence,
+                           int exclude, int k, int rerank, similarity_result_t *out) {
+    if (k <= 0) return 0;
+    int pool_size = rerank > 0 ? k * rerank : k;
+    int ef = index->ef_search > pool_size ? index->ef_search : pool_size;
+
+    quant_query_t q;
+    query_prepare(store, query, &q);
+    similarity_result_t *candidates = malloc(sizeof(similarity_result_t) * ef);
+    int n = hnsw_search_scored(index, scratch, score_id, &q, ef, ef, exclude, candidates);
+    free(q.table);
+
+    // Same combined-score rescoring as the exact index path, on the code
+    // similarities, keeping the pool the re-rank reads.
+    similarity_result_t *pool = rerank > 0 ? malloc(sizeof(similarity_result_t) * pool_size) : out;
+    similarity_heap_t heap;
+    similarity_heap_init(&heap, pool, pool_size);
+    for (int i = 0; i < n; i++) {
+        int id = candidates[i].node_id;
+        heap_insert(&heap, id, candidates[i].similarity,
+                    candidates[i].similarity * coherence + node_hot.density[id]);
+    }
+    free(candidates);
+
+    if (rerank <= 0) return heap_drain_sorted(&heap);
+
+    int found = rerank_exact(pool, heap.count, query, coherence, store->dim, k, out);
+    free(pool);
+    return found;
+}
+
+// Reference top-k by combined score with exact double-precision cosine.
+static int exact_k_nearest(int total_nodes, int query_node, int k, int dim,
+                           similarity_result_t *out) {
+    const double *query = node_vector(query_node);
+    double coherence = node_hot.coherence[query_node];
+    similarity_heap_t heap;
+    similarity_heap_init(&heap, out, k);
+    for (int i = 0; i < total_nodes; i++) {
+        if (i == query_node) continue;
+        double similarity = cosine_similarity(query, node_vector(i), dim);
+        heap_insert(&heap, i, similarity, similarity * coherence + node_hot.density[i]);
+    }
+    return heap_drain_sorted(&heap);
+}
+
+static int count_hits(const similarity_result_t *exact, int n_exact,
+                      const similarity_result_t *approx, int n_approx) {
+    int hits = 0;
+    for (int i = 0; i < n_exact; i++) {
+        for (int j = 0; j < n_approx; j++) {
+            if (approx[j].node_id == exact[i].node_id) {
+                hits++;
+                break;
+            }
+        }
+    }
+    return hits;
+}
+
+static double elapsed_us(const struct timespec *a, const struct timespec *b) {
+    return (b->tv_sec - a->tv_sec) * 1e6 + (b->tv_nsec - a->tv_nsec) / 1e3;
+}
+
+void quantized_report(quantized_store_t *store, TorusNode *network, int total_nodes,
+                      int k, int rerank, int samples) {
+    if (total_nodes < 2) return;
+    if (samples > total_nodes) samples = total_nodes;
+
+    hnsw_index_t *index = ann_get_index();
+    if (index && index->count < 2) index = NULL;
+
+    similarity_result_t *exact = malloc(sizeof(similarity_result_t) * k);
+    similarity_result_t *approx = malloc(sizeof(similarity_result_t) * k);
+    long hits_raw = 0, hits_reranked = 0, hits_graph = 0, expected = 0;
+    double scan_us = 0.0, graph_us = 0.0;
+
+    for (int s = 0; s < samples; s++) {
+        int q = rand() % total_nodes;
+        struct timespec t0, t1, t2;
+        int n_exact = exact_k_nearest(total_nodes, q, k, store->dim, exact);
+        int n_raw = quantized_find_k_nearest(store, network, total_nodes, q, k, 0, approx);
+        hits_raw += count_hits(exact, n_exact, approx, n_raw);
+
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        int n_rr = quantized_find_k_nearest(store, network, total_nodes, q, k, rerank, approx);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        hits_reranked += count_hits(exact, n_exact, approx, n_rr);
+        if (index) {
+            int n_graph = quantized_search_index(store, index, &index->scratch, node_vector(q),
+                                                 node_hot.coherence[q], q, k, rerank, approx);
+            hits_graph += count_hits(exact, n_exact, approx, n_graph);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t2);
+
+        scan_us += elapsed_us(&t0, &t1);
+        graph_us += elapsed_us(&t1, &t2);
+        expected += n_exact;
+    }
+
+    // The codes are held beside the double vectors, which the re-rank and
+    // everything else still read, so they shrink what a query reads, not
+    // the store.
+    size_t full = sizeof(double) * store->dim;
+    size_t compressed = quantized_store_bytes_per_vector(store);
+    size_t codebook = store->mode == QUANT_PQ ?
+        sizeof(float) * store->pq_m * PQ_CENTROIDS * store->pq_sub_dim :
+        store->mode == QUANT_INT8 ? sizeof(float) * 2 * store->dim : 0;
+    double full_mb = (double)full * total_nodes / (1024.0 * 1024.0);
+    double codes_mb = ((double)compressed * total_nodes + codebook) / (1024.0 * 1024.0);
+
+    printf("[QUANT] mode=%s | candidates read %zu instead of %zu bytes/vector (%.1fx)\n",
+           quant_mode_name(store->mode), compressed, full, (double)full / compressed);
+    printf("[QUANT] memory %.2f MB codes and tables on top of %.2f MB double vectors = %.2f MB\n",
+           codes_mb, full_mb, full_mb + codes_mb);
+    printf("[QUANT] scan of all %d nodes: recall@%d = %.4f without re-rank | %.4f with re-rank x%d | %.1f us/query (%d samples)\n",
+           total_nodes, k, expected ? (double)hits_raw / expected : 1.0,
+           expected ? (double)hits_reranked / expected : 1.0, rerank, scan_us / samples, samples);
+    if (index) {
+        printf("[QUANT] hnsw walk on codes (used by find_k_nearest): recall@%d = %.4f with re-rank x%d | ef_search=%d | %.1f us/query\n",
+               k, expected ? (double)hits_graph / expected : 1.0, rerank, index->ef_search,
+               graph_us / samples);
+    }
+
+    free(exact);
+    free(approx);
+}
@@ -0,0 +1,190 @@
+/*
+ * FT-DFRP: Route Path Cache
+ *
+ * Dual Licensed:
+ * 1. AGPL-3.0 for research/academic use
+ * 2. Commercial license: contact michael.doran.808@gmail.com
+ *
+ * Copyright (C) 2025 Michael Doran
+ */
+
+#include "route_cache.h"
+#include "partition.h"
+#include "topology.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#define ROUTE_CACHE_BUCKETS (2 * ROUTE_CACHE_CAPACITY)   // power of two
+
+typedef struct {
+    route_key_t key;
+    uint64_t epoch;        // partition.state_epoch when stored
+    int length;
+    int path[ROUTE_CACHE_MAX_PATH];
+    int prev, next;        // LRU list, most recent at head
+    int chain;             // next entry in the same bucket
+    int bucket;            // -1 while on the free list
+} route_entry_t;
+
+// Fixed pool: entries link to each other by index, so nothing is
+// allocated per route.
+static struct {
+    pthread_mutex_t lock;
+    route_entry_t entries[ROUTE_CACHE_CAPACITY];
+    int buckets[ROUTE_CACHE_BUCKETS];
+    int head, tail;
+    int free_list;
+    int initialized;
+    long hits, misses, stale, evictions;
+} rc = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+static uint64_t mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h;
+}
+
+static int bucket_of(const route_key_t *key) {
+    uint64_t h = mix(key->target ^ mix(key->config ^ (uint64_t)(uint32_t)key->source));
+    return (int)(h & (ROUTE_CACHE_BUCKETS - 1));
+}
+
+static void reset(void) {
+    for (int b = 0; b < ROUTE_CACHE_BUCKETS; b++) rc.buckets[b] = -1;
+    for (int i = 0; i < ROUTE_CACHE_CAPACITY; i++) {
+        rc.entries[i].bucket = -1;
+        rc.entries[i].next = i + 1 < ROUTE_CACHE_CAPACITY ? i + 1 : -1;
+    }
+    rc.free_list = 0;
+    rc.head = rc.tail = -1;
+    rc.initialized = 1;
+}
+
+static void lru_unlink(int i) {
+    route_entry_t *e = &rc.entries[i];
+    if (e->prev >= 0) rc.entries[e->prev].next = e->next; else rc.head = e->next;
+    if (e->next >= 0) rc.entries[e->next].prev = e->prev; else rc.tail = e->prev;
+}
+
+static void lru_push_front(int i) {
+    route_entry_t *e = &rc.entries[i];
+    e->prev = -1;
+    e->next = rc.head;
+    if (rc.head >= 0) rc.entries[rc.head].prev = i;
+    rc.head = i;
+    if (rc.tail < 0) rc.tail = i;
+}
+
+static void bucket_unlink(int i) {
+    int *p = &rc.buckets[rc.entries[i].bucket];
+    while (*p != i) p = &rc.entries[*p].chain;
+    *p = rc.entries[i].chain;
+}
+
+static void release(int i) {
+    lru_unlink(i);
+    bucket_unlink(i);
+    rc.entries[i].bucket = -1;
+    rc.entries[i].next = rc.free_list;
+    rc.free_list = i;
+}
+
+static int find(const route_key_t *key, int bucket) {
+    for (int i = rc.buckets[bucket]; i >= 0; i = rc.entries[i].chain) {
+        const route_key_t *k = &rc.entries[i].key;
+        if (k->source == key->source && k->target == key->target && k->config == key->config) return i;
+    }
+    return -1;
+}
+
+// Each hop was chosen by scoring the neighbours of the node it left, so a
+// path is stale once any of those that this rank holds a copy of changed
+// after it was stored. The last node left by no hop.
+static int stale(const route_entry_t *e) {
+    if (e->epoch == partition.state_epoch) return 0;
+    for (int i = 0; i + 1 < e->length; i++) {
+        const int *neighbors = topology_neighbors(&topology, e->path[i]);
+        int degree = topology_degree(&topology, e->path[i]);
+        for (int j = 0; j < degree; j++) {
+            if (partition_node_epoch(neighbors[j]) > e->epoch) return 1;
+        }
+    }
+    return 0;
+}
+
+static int lookup(const route_key_t *key, int *path, int max_length, int counted) {
+    pthread_mutex_lock(&rc.lock);
+    if (!rc.initialized) reset();
+    int i = find(key, bucket_of(key));
+    int length = -1;
+    if (i >= 0 && stale(&rc.entries[i])) {
+        release(i);
+        rc.stale++;
+        i = -1;
+    }
+    if (i >= 0 && rc.entries[i].length <= max_length) {
+        length = rc.entries[i].length;
+        memcpy(path, rc.entries[i].path, sizeof(int) * length);
+        lru_unlink(i);
+        lru_push_front(i);
+        rc.hits += counted;
+    } else {
+        rc.misses += counted;
+    }
+    pthread_mutex_unlock(&rc.lock);
+    return length;
+}
+
+int route_cache_lookup(const route_key_t *key, int *path, int max_length) {
+    return lookup(key, path, max_length, 1);
+}
+
+int route_cache_probe(const route_key_t *key, int *path, int max_length) {
+    return lookup(key, path, max_length, 0);
+}
+
+void route_cache_store(const route_key_t *key, const int *path, int length) {
+    if (length <= 0 || length > ROUTE_CACHE_MAX_PATH) return;
+    pthread_mutex_lock(&rc.lock);
+    if (!rc.initialized) reset();
+    int bucket = bucket_of(key);
+    int i = find(key, bucket);
+    if (i >= 0) {
+        lru_unlink(i);
+    } else {
+        if (rc.free_list < 0) {
+            release(rc.tail);
+            rc.evictions++;
+        }
+        i = rc.free_list;
+        rc.free_list = rc.entries[i].next;
+        rc.entries[i].key = *key;
+        rc.entries[i].bucket = bucket;
+        rc.entries[i].chain = rc.buckets[bucket];
+        rc.buckets[bucket] = i;
+    }
+    rc.entries[i].epoch = partition.state_epoch;
+    rc.entries[i].length = length;
+    memcpy(rc.entries[i].path, path, sizeof(int) * length);
+    lru_push_front(i);
+    pthread_mutex_unlock(&rc.lock);
+}
+
+void route_cache_clear(void) {
+    pthread_mutex_lock(&rc.lock);
+    reset();
+    pthread_mutex_unlock(&rc.lock);
+}
+
+void route_cache_report(void) {
+    pthread_mutex_lock(&rc.lock);
+    long lookups = rc.hits + rc.misses;
+    int used = 0;
+    for (int i = rc.head; i >= 0; i = rc.entries[i].next) used++;
+    printf("[ROUTE] cache %d/%d paths | hit rate %.1f%% (%ld/%ld) | stale %ld | evicted %ld\n",
+           used, ROUTE_CACHE_CAPACITY, lookups ? 100.0 * rc.hits / lookups : 0.0,
+           rc.hits, lookups, rc.stale, rc.evictions);
+    pthread_mutex_unlock(&rc.lock);
+}
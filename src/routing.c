@@ -9,24 +9,100 @@
  */
 
 #include "fractal.h"
+#include "routing.h"
+#include "ann.h"
+#include "distance_field.h"
+#include "parity_index.h"
+#include "node_store.h"
+#include "partition.h"
+#include "route_cache.h"
+#include "topology.h"
 #include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ROUTE_TARGET_SCALE 1024.0   // target vectors are keyed at 1/1024 resolution
+#define ROUTE_KEY_VECTOR 0x1
+#define ROUTE_KEY_PARITY 0x2
+
+routing_config_t default_routing_config = {
+    .density_weight = 0.3,
+    .similarity_weight = 0.5,
+    .coherence_weight = 0.2,
+    .parity_weight = 0.6,
+    .use_fhe = 0,
+};
+
+// Forwarded hop requests: current id and config, then the target vector
+// (vector_dim doubles, absent for a NULL target) or the parity tag name.
+typedef struct {
+    int32_t current_id;
+    routing_config_t config;
+} hop_request_t;
+
+static int forward_hop(partition_op_t op, int current_id, routing_config_t *config,
+                       const void *extra, int extra_length) {
+    hop_request_t r = { current_id, *config };
+    int length = (int)sizeof(r) + extra_length;
+    uint8_t *req = malloc(length);
+    memcpy(req, &r, sizeof(r));
+    if (extra_length > 0) memcpy(req + sizeof(r), extra, extra_length);
+    int32_t next = -1;
+    if (partition_call(partition_owner(current_id), op, req, length, &next, sizeof(next)) != sizeof(next)) {
+        next = -1;
+    }
+    free(req);
+    return next;
+}
+
+// Density as config scores it: decrypted from the node's ciphertext under
+// use_fhe when FHE support is built in (ENABLE_FHE), plaintext otherwise.
+static double node_density(int slot, const routing_config_t *config) {
+#ifdef ENABLE_FHE
+    if (config->use_fhe) return fhe_decrypt(network[slot].encrypted_density);
+#else
+    (void)config;
+#endif
+    return node_hot.density[slot];
+}
 
 int compute_hybrid_next_hop(int current_id, const double *target_vector, routing_config_t *config) {
-    TorusNode *current = &network[current_id];
+    if (!partition_owns(current_id)) {
+        return forward_hop(PARTITION_OP_NEXT_HOP, current_id, config, target_vector,
+                           target_vector ? (int)sizeof(double) * vector_dim : 0);
+    }
+
+    const int *neighbors = topology_neighbors(&topology, current_id);
+    int degree = topology_degree(&topology, current_id);
     int best_id = -1;
     double best_score = -INFINITY;
 
-    for (int i = 0; i < current->neighbor_count; i++) {
-        int neighbor_id = current->neighbors[i];
-        TorusNode *neighbor = &network[neighbor_id];
+    // Score all neighbours against the target in SIMD batches up front. The
+    // store only holds owned nodes, so any ghost neighbour means scoring
+    // one at a time below.
+    vector_store_t *store = ann_get_vector_store();
+    double similarities[TOPOLOGY_MAX_DEGREE];
+    int local[TOPOLOGY_MAX_DEGREE];
+    int gathered = target_vector && store;
+    for (int i = 0; gathered && i < degree; i++) {
+        local[i] = partition_local_index(neighbors[i]);
+        if (local[i] < 0) gathered = 0;
+    }
+    if (gathered) {
+        vector_store_cosine_gather(store, target_vector, local, degree, similarities);
+    }
 
-        double density = config->use_fhe ?
-            fhe_decrypt(neighbor->encrypted_density) : neighbor->density;
+    for (int i = 0; i < degree; i++) {
+        int neighbor_id = neighbors[i];
+        int slot = partition_slot(neighbor_id);
 
-        double similarity = target_vector ?
-            cosine_similarity(neighbor->vector, target_vector, VECTOR_DIM) : 0.0;
+        double density = node_density(slot, config);
 
-        double coherence = neighbor->coherence;
+        double similarity = !target_vector ? 0.0 :
+            gathered ? similarities[i] : cosine_similarity(node_vector(slot), target_vector, vector_dim);
+
+        double coherence = node_hot.coherence[slot];
 
         double score = config->density_weight * density +
                        config->similarity_weight * similarity +
@@ -42,23 +118,25 @@ int compute_hybrid_next_hop(int current_id, const double *target_vector, routing
 }
 
 int compute_parity_aware_route(int current_id, const char *parity_tag, routing_config_t *config) {
-    int *holders = find_nodes_with_parity(parity_tag);
-    if (!holders || holders[0] == -1) return compute_hybrid_next_hop(current_id, NULL, config);
+    if (!partition_owns(current_id)) {
+        return forward_hop(PARTITION_OP_PARITY_ROUTE, current_id, config, parity_tag,
+                           (int)strnlen(parity_tag, MAX_TAG_LENGTH));
+    }
 
-    TorusNode *current = &network[current_id];
+    parity_tag_id_t tag = tag_lookup(parity_tag);
+    if (parity_index_lookup(tag).count == 0) return compute_hybrid_next_hop(current_id, NULL, config);
+
+    const int *neighbors = topology_neighbors(&topology, current_id);
+    int degree = topology_degree(&topology, current_id);
     int best_id = -1;
     double best_score = -INFINITY;
 
-    for (int i = 0; i < current->neighbor_count; i++) {
-        int neighbor_id = current->neighbors[i];
-        double min_dist = INFINITY;
-
-        for (int j = 0; holders[j] != -1; j++) {
-            double dist = calculate_network_distance(neighbor_id, holders[j]);
-            if (dist < min_dist) min_dist = dist;
-        }
+    for (int i = 0; i < degree; i++) {
+        int neighbor_id = neighbors[i];
+        uint16_t hops = distance_field_get(tag, neighbor_id);
+        double min_dist = hops == DISTANCE_UNREACHABLE ? INFINITY : hops;
 
-        double hybrid_score = compute_node_hybrid_score(neighbor_id, config);
+        double hybrid_score = compute_node_hybrid_score(neighbor_id, NULL, config);
         double parity_score = 1.0 / (1.0 + min_dist);
 
         double score = config->parity_weight * parity_score +
@@ -73,13 +151,255 @@ int compute_parity_aware_route(int current_id, const char *parity_tag, routing_c
     return best_id;
 }
 
-double compute_node_hybrid_score(int node_id, routing_config_t *config) {
-    TorusNode *node = &network[node_id];
-    double density = config->use_fhe ? fhe_decrypt(node->encrypted_density) : node->density;
-    double similarity = cosine_similarity(node->vector, global_query_vector, VECTOR_DIM);
-    double coherence = node->coherence;
+double compute_node_hybrid_score(int node_id, const double *target_vector, routing_config_t *config) {
+    int slot = partition_slot(node_id);
+    double density = node_density(slot, config);
+    double similarity = target_vector ? cosine_similarity(node_vector(slot), target_vector, vector_dim) : 0.0;
+    double coherence = node_hot.coherence[slot];
 
     return config->density_weight * density +
            config->similarity_weight * similarity +
            config->coherence_weight * coherence;
 }
+
+static uint64_t fnv1a(uint64_t h, const void *data, size_t length) {
+    const uint8_t *p = data;
+    for (size_t i = 0; i < length; i++) {
+        h ^= p[i];
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+static uint64_t config_key(const routing_config_t *config) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    h = fnv1a(h, &config->density_weight, sizeof(double));
+    h = fnv1a(h, &config->similarity_weight, sizeof(double));
+    h = fnv1a(h, &config->coherence_weight, sizeof(double));
+    h = fnv1a(h, &config->parity_weight, sizeof(double));
+    return fnv1a(h, &config->use_fhe, sizeof(int));
+}
+
+// Nearby target vectors share a key, so traffic towards one target reuses
+// a path even when the vector is recomputed with rounding noise.
+static uint64_t vector_target_key(int target_id, const double *target_vector) {
+    uint64_t h = fnv1a(0xcbf29ce484222325ULL, &target_id, sizeof(target_id));
+    for (int d = 0; d < vector_dim; d++) {
+        int32_t q = (int32_t)lrint(target_vector[d] * ROUTE_TARGET_SCALE);
+        h = fnv1a(h, &q, sizeof(q));
+    }
+    return h ^ ROUTE_KEY_VECTOR;
+}
+
+static uint64_t parity_target_key(parity_tag_id_t tag) {
+    uint32_t words[2] = { tag, parity_index_version(tag) };
+    return fnv1a(0xcbf29ce484222325ULL, words, sizeof(words)) ^ ROUTE_KEY_PARITY;
+}
+
+typedef struct {
+    int target_id;                  // vector routes: stop here
+    const double *target_vector;
+    parity_tag_id_t tag;            // parity routes: stop at any holder
+    const char *parity_tag;
+} route_goal_t;
+
+static int arrived(const route_goal_t *goal, int node_id) {
+    return goal->parity_tag ? parity_index_holds(goal->tag, node_id) : node_id == goal->target_id;
+}
+
+static int next_hop(const route_goal_t *goal, int current, routing_config_t *config) {
+    return goal->parity_tag ? compute_parity_aware_route(current, goal->parity_tag, config)
+                            : compute_hybrid_next_hop(current, goal->target_vector, config);
+}
+
+// Walks next hops from key->source until the goal, reusing any cached
+// suffix on the way. Fails on a dead end, a loop, or more than
+// max_length nodes.
+static int walk_route(route_key_t key, const route_goal_t *goal, routing_config_t *config,
+                      int *path, int max_length) {
+    int source = key.source;
+    int cached = route_cache_lookup(&key, path, max_length);
+    if (cached > 0) return cached;
+
+    int length = 0;
+    path[length++] = source;
+    int current = source;
+    while (!arrived(goal, current)) {
+        if (length > 1) {
+            key.source = current;
+            cached = route_cache_probe(&key, path + length - 1, max_length - (length - 1));
+            if (cached > 0) {
+                // The suffix was walked from current alone and may come
+                // back through the prefix.
+                for (int j = length; j < length + cached - 1; j++) {
+                    for (int i = 0; i < length - 1; i++) {
+                        if (path[i] == path[j]) return -1;
+                    }
+                }
+                length += cached - 1;
+                break;
+            }
+        }
+        if (length == max_length) return -1;
+
+        int next = next_hop(goal, current, config);
+        if (next < 0) return -1;
+        for (int i = 0; i < length; i++) {
+            if (path[i] == next) return -1;
+        }
+        path[length++] = next;
+        current = next;
+    }
+
+    key.source = source;
+    route_cache_store(&key, path, length);
+    return length;
+}
+
+int compute_route(int source, int target_id, const double *target_vector, routing_config_t *config,
+                  int *path, int max_length) {
+    if (source < 0 || source >= total_nodes || !target_vector || max_length <= 0) return -1;
+    route_key_t key = { source, vector_target_key(target_id, target_vector), config_key(config) };
+    route_goal_t goal = { .target_id = target_id, .target_vector = target_vector };
+    return walk_route(key, &goal, config, path, max_length);
+}
+
+int compute_parity_route(int source, const char *parity_tag, routing_config_t *config,
+                         int *path, int max_length) {
+    parity_tag_id_t tag = tag_lookup(parity_tag);
+    if (source < 0 || source >= total_nodes || tag == PARITY_TAG_INVALID || max_length <= 0) return -1;
+    if (parity_index_lookup(tag).count == 0) return -1;
+    route_key_t key = { source, parity_target_key(tag), config_key(config) };
+    route_goal_t goal = { .tag = tag, .parity_tag = parity_tag };
+    return walk_route(key, &goal, config, path, max_length);
+}
+
+// A walked path must start at source, reach the goal, follow topology
+// edges, visit no node twice and take the hop next_hop picks at every
+// node. 0 when it does.
+static int check_path(const int *path, int length, int source, const route_goal_t *goal) {
+    if (path[0] != source || !arrived(goal, path[length - 1])) return -1;
+    for (int i = 1; i < length; i++) {
+        const int *neighbors = topology_neighbors(&topology, path[i - 1]);
+        int degree = topology_degree(&topology, path[i - 1]);
+        int adjacent = 0;
+        for (int j = 0; j < degree && !adjacent; j++) adjacent = neighbors[j] == path[i];
+        if (!adjacent) return -1;
+        for (int j = 0; j < i; j++) {
+            if (path[j] == path[i]) return -1;
+        }
+        if (next_hop(goal, path[i - 1], &default_routing_config) != path[i]) return -1;
+    }
+    return 0;
+}
+
+typedef struct {
+    int routed, unroutable, invalid, mismatched;
+} route_check_t;
+
+// Routes source to goal twice, the second time from the cache the first
+// filled, and files the outcome in c.
+static void check_route(int source, const route_goal_t *goal, int *fresh, int *cached,
+                        route_check_t *c) {
+    int length, again;
+    if (goal->parity_tag) {
+        length = compute_parity_route(source, goal->parity_tag, &default_routing_config,
+                                      fresh, ROUTE_CACHE_MAX_PATH);
+        again = compute_parity_route(source, goal->parity_tag, &default_routing_config,
+                                     cached, ROUTE_CACHE_MAX_PATH);
+    } else {
+        length = compute_route(source, goal->target_id, goal->target_vector, &default_routing_config,
+                               fresh, ROUTE_CACHE_MAX_PATH);
+        again = compute_route(source, goal->target_id, goal->target_vector, &default_routing_config,
+                              cached, ROUTE_CACHE_MAX_PATH);
+    }
+    if (length != again || (length > 0 && memcmp(fresh, cached, sizeof(int) * length) != 0)) {
+        c->mismatched++;
+    }
+    if (length < 0) c->unroutable++;
+    else if (check_path(fresh, length, source, goal) != 0) c->invalid++;
+    else c->routed++;
+}
+
+static void report_check(const char *kind, int count, const route_check_t *c) {
+    printf("[ROUTE] %d %s routes: %d valid, %d dead ends or loops, %d invalid, %d differ when cached\n",
+           count, kind, c->routed, c->unroutable, c->invalid, c->mismatched);
+}
+
+int route_check(int samples) {
+    if (samples <= 0) samples = 32;
+    if (total_nodes < 2) return -1;
+    double *target = malloc(sizeof(double) * vector_dim);
+    int *fresh = malloc(sizeof(int) * ROUTE_CACHE_MAX_PATH);
+    int *cached = malloc(sizeof(int) * ROUTE_CACHE_MAX_PATH);
+    route_check_t vectors = { 0 }, parity = { 0 };
+    route_cache_clear();
+
+    for (int s = 0; s < samples; s++) {
+        route_goal_t goal = { .target_id = rand() % total_nodes, .target_vector = target };
+        if (partition_fetch_node(goal.target_id, target, NULL, NULL) != 0) {
+            vectors.invalid++;
+            continue;
+        }
+        check_route(rand() % total_nodes, &goal, fresh, cached, &vectors);
+    }
+
+    // Parity routes towards every tag that has holders, up to samples.
+    int tags = 0;
+    for (int t = 0; t < tag_count() && tags < samples; t++) {
+        if (parity_index_lookup((parity_tag_id_t)t).count == 0) continue;
+        route_goal_t goal = { .tag = (parity_tag_id_t)t, .parity_tag = tag_name((parity_tag_id_t)t) };
+        check_route(rand() % total_nodes, &goal, fresh, cached, &parity);
+        tags++;
+    }
+
+    report_check("vector", samples, &vectors);
+    report_check("parity", tags, &parity);
+    int ok = vectors.invalid + vectors.mismatched + parity.invalid + parity.mismatched == 0;
+    printf("[ROUTE] Check %s\n", ok ? "ok" : "FAILED");
+    free(target);
+    free(fresh);
+    free(cached);
+    return ok ? 0 : -1;
+}
+
+static int handle_next_hop(int source, const uint8_t *req, int length, uint8_t *reply, int cap) {
+    (void)source;
+    hop_request_t r;
+    int vector_bytes = (int)sizeof(double) * vector_dim;
+    if (cap < (int)sizeof(int32_t) || length < (int)sizeof(r)) return -1;
+    if (length != (int)sizeof(r) && length != (int)sizeof(r) + vector_bytes) return -1;
+    memcpy(&r, req, sizeof(r));
+    if (!partition_owns(r.current_id)) return -1;
+
+    double *target = NULL;
+    if (length > (int)sizeof(r)) {
+        target = malloc(vector_bytes);
+        memcpy(target, req + sizeof(r), vector_bytes);
+    }
+    int32_t next = compute_hybrid_next_hop(r.current_id, target, &r.config);
+    free(target);
+    memcpy(reply, &next, sizeof(next));
+    return sizeof(next);
+}
+
+static int handle_parity_route(int source, const uint8_t *req, int length, uint8_t *reply, int cap) {
+    (void)source;
+    hop_request_t r;
+    char tag[MAX_TAG_LENGTH + 1];
+    int tag_length = length - (int)sizeof(r);
+    if (cap < (int)sizeof(int32_t) || tag_length < 0 || tag_length > MAX_TAG_LENGTH) return -1;
+    memcpy(&r, req, sizeof(r));
+    if (!partition_owns(r.current_id)) return -1;
+
+    memcpy(tag, req + sizeof(r), tag_length);
+    tag[tag_length] = '\0';
+    int32_t next = compute_parity_aware_route(r.current_id, tag, &r.config);
+    memcpy(reply, &next, sizeof(next));
+    return sizeof(next);
+}
+
+void routing_init(void) {
+    partition_register_handler(PARTITION_OP_NEXT_HOP, handle_next_hop);
+    partition_register_handler(PARTITION_OP_PARITY_ROUTE, handle_parity_route);
+}
@@ -0,0 +1,329 @@
+/*
+ * FT-DFRP: Batched SHA-256
+ *
+ * Dual Licensed:
+ * 1. AGPL-3.0 for research/academic use
+ * 2. Commercial license: contact michael.doran.808@gmail.com
+ *
+ * Copyright (C) 2025 Michael Doran
+ */
+
+// SHA256_Init and friends are deprecated in OpenSSL 3, but the one-shot
+// SHA256() fetches the EVP digest on every call, which costs more than
+// hashing a 64-byte pair.
+#define OPENSSL_SUPPRESS_DEPRECATED
+#include "sha256_mb.h"
+#include <pthread.h>
+#include <string.h>
+#include <openssl/sha.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define SHA256_MB_X86 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+// ---- One message at a time ------------------------------------------------
+
+void sha256_digest(const void *data, size_t length, uint8_t *digest) {
+    SHA256_CTX ctx;
+    SHA256_Init(&ctx);
+    SHA256_Update(&ctx, data, length);
+    SHA256_Final(digest, &ctx);
+}
+
+void sha256_digest_prefixed(uint8_t prefix, const void *data, size_t length, uint8_t *digest) {
+    SHA256_CTX ctx;
+    SHA256_Init(&ctx);
+    SHA256_Update(&ctx, &prefix, 1);
+    SHA256_Update(&ctx, data, length);
+    SHA256_Final(digest, &ctx);
+}
+
+// OpenSSL picks its own implementation, which may well use the SHA
+// extensions too; this is the portable fallback and the reference.
+static void hash_each(const uint8_t *const *messages, const size_t *lengths, int count,
+                      uint8_t (*digests)[SHA256_DIGEST_BYTES]) {
+    for (int i = 0; i < count; i++) sha256_digest(messages[i], lengths[i], digests[i]);
+}
+
+static const sha256_kernels_t scalar_kernels = { "scalar", hash_each };
+
+#ifdef SHA256_MB_X86
+
+// ---- AVX2: eight messages, one per lane -----------------------------------
+
+#define MB_LANES 8
+#define AVX2_TARGET __attribute__((target("avx2")))
+
+static const uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static const uint32_t H0[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+};
+
+#define ROTR(x, n) _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - (n)))
+
+// Byte j of lane's padded message: the message, 0x80, zeros, then the
+// bit length in the last eight bytes of the final block.
+static inline uint8_t padded_byte(const uint8_t *m, size_t length, size_t total, size_t j) {
+    if (j < length) return m[j];
+    if (j == length) return 0x80;
+    if (j >= total - 8) return (uint8_t)(((uint64_t)length * 8) >> (8 * (total - 1 - j)));
+    return 0;
+}
+
+// Loads block b of every lane as big-endian words, transposed so w[t]
+// holds word t of all eight lanes. Lanes past their last block load zeros.
+AVX2_TARGET static void load_block(const uint8_t *const *m, const size_t *length, const size_t *total,
+                                   size_t b, __m256i *w) {
+    uint32_t words[16][MB_LANES];
+    for (int lane = 0; lane < MB_LANES; lane++) {
+        size_t base = b * 64;
+        if (base >= total[lane]) {
+            for (int t = 0; t < 16; t++) words[t][lane] = 0;
+        } else if (base + 64 <= length[lane]) {
+            const uint8_t *p = m[lane] + base;
+            for (int t = 0; t < 16; t++) {
+                words[t][lane] = (uint32_t)p[4 * t] << 24 | (uint32_t)p[4 * t + 1] << 16 |
+                                 (uint32_t)p[4 * t + 2] << 8 | p[4 * t + 3];
+            }
+        } else {
+            for (int t = 0; t < 16; t++) {
+                uint32_t v = 0;
+                for (int k = 0; k < 4; k++) {
+                    v = v << 8 | padded_byte(m[lane], length[lane], total[lane], base + 4 * t + k);
+                }
+                words[t][lane] = v;
+            }
+        }
+    }
+    for (int t = 0; t < 16; t++) w[t] = _mm256_loadu_si256((const __m256i *)words[t]);
+}
+
+AVX2_TARGET static void compress8(__m256i *state, __m256i *w) {
+    __m256i a = state[0], b = state[1], c = state[2], d = state[3];
+    __m256i e = state[4], f = state[5], g = state[6], h = state[7];
+    for (int t = 0; t < 64; t++) {
+        __m256i wt;
+        if (t < 16) {
+            wt = w[t];
+        } else {
+            __m256i w15 = w[(t - 15) & 15], w2 = w[(t - 2) & 15];
+            __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(ROTR(w15, 7), ROTR(w15, 18)), _mm256_srli_epi32(w15, 3));
+            __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(ROTR(w2, 17), ROTR(w2, 19)), _mm256_srli_epi32(w2, 10));
+            wt = _mm256_add_epi32(_mm256_add_epi32(w[t & 15], s0), _mm256_add_epi32(w[(t - 7) & 15], s1));
+            w[t & 15] = wt;
+        }
+        __m256i S1 = _mm256_xor_si256(_mm256_xor_si256(ROTR(e, 6), ROTR(e, 11)), ROTR(e, 25));
+        __m256i ch = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+        __m256i t1 = _mm256_add_epi32(_mm256_add_epi32(h, S1),
+                                      _mm256_add_epi32(ch, _mm256_add_epi32(_mm256_set1_epi32((int)K[t]), wt)));
+        __m256i S0 = _mm256_xor_si256(_mm256_xor_si256(ROTR(a, 2), ROTR(a, 13)), ROTR(a, 22));
+        __m256i maj = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_or_si256(a, b)));
+        __m256i t2 = _mm256_add_epi32(S0, maj);
+        h = g;
+        g = f;
+        f = e;
+        e = _mm256_add_epi32(d, t1);
+        d = c;
+        c = b;
+        b = a;
+        a = _mm256_add_epi32(t1, t2);
+    }
+    state[0] = _mm256_add_epi32(state[0], a);
+    state[1] = _mm256_add_epi32(state[1], b);
+    state[2] = _mm256_add_epi32(state[2], c);
+    state[3] = _mm256_add_epi32(state[3], d);
+    state[4] = _mm256_add_epi32(state[4], e);
+    state[5] = _mm256_add_epi32(state[5], f);
+    state[6] = _mm256_add_epi32(state[6], g);
+    state[7] = _mm256_add_epi32(state[7], h);
+}
+
+// Up to eight messages; unused lanes hash an empty message and are dropped.
+AVX2_TARGET static void hash8(const uint8_t *const *messages, const size_t *lengths, int count,
+                              uint8_t (*digests)[SHA256_DIGEST_BYTES]) {
+    static const uint8_t empty = 0;
+    const uint8_t *m[MB_LANES];
+    size_t length[MB_LANES], total[MB_LANES], blocks = 0;
+    for (int lane = 0; lane < MB_LANES; lane++) {
+        m[lane] = lane < count ? messages[lane] : &empty;
+        length[lane] = lane < count ? lengths[lane] : 0;
+        total[lane] = (length[lane] + 9 + 63) / 64 * 64;
+        if (total[lane] / 64 > blocks) blocks = total[lane] / 64;
+    }
+
+    __m256i state[8], w[16];
+    for (int i = 0; i < 8; i++) state[i] = _mm256_set1_epi32((int)H0[i]);
+    for (size_t b = 0; b < blocks; b++) {
+        __m256i before[8];
+        memcpy(before, state, sizeof(before));
+        load_block(m, length, total, b, w);
+        compress8(state, w);
+        // Lanes already past their last block keep their state.
+        uint32_t done[MB_LANES];
+        for (int lane = 0; lane < MB_LANES; lane++) done[lane] = b * 64 >= total[lane] ? 0xffffffffu : 0;
+        __m256i mask = _mm256_loadu_si256((const __m256i *)done);
+        for (int i = 0; i < 8; i++) state[i] = _mm256_blendv_epi8(state[i], before[i], mask);
+    }
+
+    uint32_t words[8][MB_LANES];
+    for (int i = 0; i < 8; i++) _mm256_storeu_si256((__m256i *)words[i], state[i]);
+    for (int lane = 0; lane < count; lane++) {
+        for (int i = 0; i < 8; i++) {
+            uint32_t v = words[i][lane];
+            digests[lane][4 * i] = (uint8_t)(v >> 24);
+            digests[lane][4 * i + 1] = (uint8_t)(v >> 16);
+            digests[lane][4 * i + 2] = (uint8_t)(v >> 8);
+            digests[lane][4 * i + 3] = (uint8_t)v;
+        }
+    }
+}
+
+static void hash_avx2(const uint8_t *const *messages, const size_t *lengths, int count,
+                      uint8_t (*digests)[SHA256_DIGEST_BYTES]) {
+    int i = 0;
+    while (i < count) {
+        // Gather the next eight short messages; long ones go one at a time.
+        const uint8_t *m[MB_LANES];
+        size_t length[MB_LANES];
+        int index[MB_LANES], lanes = 0;
+        for (; i < count && lanes < MB_LANES; i++) {
+            if (lengths[i] > SHA256_MB_MAX_BYTES) {
+                sha256_digest(messages[i], lengths[i], digests[i]);
+                continue;
+            }
+            m[lanes] = messages[i];
+            length[lanes] = lengths[i];
+            index[lanes++] = i;
+        }
+        if (lanes == 0) break;
+        uint8_t out[MB_LANES][SHA256_DIGEST_BYTES];
+        hash8(m, length, lanes, out);
+        for (int lane = 0; lane < lanes; lane++) memcpy(digests[index[lane]], out[lane], SHA256_DIGEST_BYTES);
+    }
+}
+
+static const sha256_kernels_t avx2_kernels = { "avx2-x8", hash_avx2 };
+
+// ---- SHA extensions: one message, two rounds per instruction -------------
+
+#define SHANI_TARGET __attribute__((target("sha,sse4.1")))
+
+// Runs blocks of data through state (a..h). sha256rnds2 keeps the state as
+// ABEF and CDGH halves, and sha256msg1/msg2 extend the schedule four words
+// at a time.
+SHANI_TARGET static void compress_shani(uint32_t state[8], const uint8_t *data, size_t blocks) {
+    const __m128i byte_swap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    __m128i dcba = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[0]), 0xb1);   // CDAB
+    __m128i efgh = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[4]), 0x1b);   // EFGH
+    __m128i abef = _mm_alignr_epi8(dcba, efgh, 8);
+    __m128i cdgh = _mm_blend_epi16(efgh, dcba, 0xf0);
+
+    for (; blocks > 0; blocks--, data += 64) {
+        __m128i abef_in = abef, cdgh_in = cdgh;
+        __m128i w[4];
+        for (int i = 0; i < 4; i++) {
+            w[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 16 * i)), byte_swap);
+        }
+        for (int r = 0; r < 16; r++) {
+            if (r >= 4) {
+                __m128i next = _mm_sha256msg1_epu32(w[r & 3], w[(r + 1) & 3]);
+                next = _mm_add_epi32(next, _mm_alignr_epi8(w[(r + 3) & 3], w[(r + 2) & 3], 4));
+                w[r & 3] = _mm_sha256msg2_epu32(next, w[(r + 3) & 3]);
+            }
+            __m128i wk = _mm_add_epi32(w[r & 3], _mm_loadu_si128((const __m128i *)&K[4 * r]));
+            cdgh = _mm_sha256rnds2_epu32(cdgh, abef, wk);
+            abef = _mm_sha256rnds2_epu32(abef, cdgh, _mm_shuffle_epi32(wk, 0x0e));
+        }
+        abef = _mm_add_epi32(abef, abef_in);
+        cdgh = _mm_add_epi32(cdgh, cdgh_in);
+    }
+
+    __m128i feba = _mm_shuffle_epi32(abef, 0x1b);
+    __m128i dchg = _mm_shuffle_epi32(cdgh, 0xb1);
+    _mm_storeu_si128((__m128i *)&state[0], _mm_blend_epi16(feba, dchg, 0xf0));
+    _mm_storeu_si128((__m128i *)&state[4], _mm_alignr_epi8(dchg, feba, 8));
+}
+
+SHANI_TARGET static void digest_shani(const uint8_t *m, size_t length, uint8_t *digest) {
+    uint32_t state[8];
+    memcpy(state, H0, sizeof(state));
+    size_t full = length / 64;
+    compress_shani(state, m, full);
+
+    // The tail, 0x80, zeros and the bit length fill one or two more blocks.
+    uint8_t tail[128] = { 0 };
+    size_t rest = length - full * 64;
+    memcpy(tail, m + full * 64, rest);
+    tail[rest] = 0x80;
+    size_t total = rest + 9 > 64 ? 128 : 64;
+    uint64_t bits = (uint64_t)length * 8;
+    for (int k = 0; k < 8; k++) tail[total - 1 - k] = (uint8_t)(bits >> (8 * k));
+    compress_shani(state, tail, total / 64);
+
+    for (int i = 0; i < 8; i++) {
+        digest[4 * i] = (uint8_t)(state[i] >> 24);
+        digest[4 * i + 1] = (uint8_t)(state[i] >> 16);
+        digest[4 * i + 2] = (uint8_t)(state[i] >> 8);
+        digest[4 * i + 3] = (uint8_t)state[i];
+    }
+}
+
+static void hash_shani(const uint8_t *const *messages, const size_t *lengths, int count,
+                       uint8_t (*digests)[SHA256_DIGEST_BYTES]) {
+    for (int i = 0; i < count; i++) digest_shani(messages[i], lengths[i], digests[i]);
+}
+
+static const sha256_kernels_t shani_kernels = { "sha-ni", hash_shani };
+
+static int cpu_has_sha(void) {
+    unsigned int eax, ebx, ecx, edx;
+    // __get_cpuid_count fails when leaf 7 is beyond the highest one the CPU reports.
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) return 0;
+    return (ebx >> 29) & 1 && __builtin_cpu_supports("sse4.1");
+}
+
+#endif // SHA256_MB_X86
+
+int sha256_available_kernels(const sha256_kernels_t **kernels, int capacity) {
+    int count = 0;
+#ifdef SHA256_MB_X86
+    __builtin_cpu_init();
+    if (cpu_has_sha() && count < capacity) kernels[count++] = &shani_kernels;
+    if (__builtin_cpu_supports("avx2") && count < capacity) kernels[count++] = &avx2_kernels;
+#endif
+    if (count < capacity) kernels[count++] = &scalar_kernels;
+    return count;
+}
+
+static pthread_once_t best_once = PTHREAD_ONCE_INIT;
+static const sha256_kernels_t *best_kernels;
+static const sha256_kernels_t *selected_kernels;   // override; atomic, hashing threads read it
+
+static void pick_best_kernels(void) {
+    const sha256_kernels_t *best[1];
+    sha256_available_kernels(best, 1);
+    best_kernels = best[0];
+}
+
+const sha256_kernels_t* sha256_kernels(void) {
+    const sha256_kernels_t *selected = __atomic_load_n(&selected_kernels, __ATOMIC_ACQUIRE);
+    if (selected) return selected;
+    pthread_once(&best_once, pick_best_kernels);
+    return best_kernels;
+}
+
+void sha256_select_kernels(const sha256_kernels_t *kernels) {
+    __atomic_store_n(&selected_kernels, kernels, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,521 @@
+/*
+ * FT-DFRP: Network Snapshots
+ *
+ * Dual Licensed:
+ * 1. AGPL-3.0 for research/academic use
+ * 2. Commercial license: contact michael.doran.808@gmail.com
+ *
+ * Copyright (C) 2025 Michael Doran
+ */
+
+#include "snapshot.h"
+#include "ann.h"
+#include "memory_guard.h"
+#include "node_store.h"
+#include "parity_index.h"
+#include "partition.h"
+#include "tag_intern.h"
+#include "topology.h"
+#include "vector_store.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SNAPSHOT_NODE_CHUNK 4096   // cold records converted per write
+
+static uint64_t align_up(uint64_t n) {
+    return (n + SNAPSHOT_ALIGNMENT - 1) / SNAPSHOT_ALIGNMENT * SNAPSHOT_ALIGNMENT;
+}
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+void snapshot_path(const char *prefix, int rank, char *path, size_t cap) {
+    snprintf(path, cap, "%s.%d", prefix, rank);
+}
+
+// ---- Writing --------------------------------------------------------------
+
+static int write_at(int fd, const void *data, uint64_t bytes, uint64_t offset) {
+    const uint8_t *p = data;
+    while (bytes > 0) {
+        ssize_t n = pwrite(fd, p, bytes, (off_t)offset);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += n;
+        bytes -= n;
+        offset += n;
+    }
+    return 0;
+}
+
+static void place(snapshot_header_t *h, snapshot_section_id_t id, uint64_t bytes, uint64_t *end) {
+    h->sections[id].offset = *end;
+    h->sections[id].bytes = bytes;
+    *end = align_up(*end + bytes);
+}
+
+// Tag names in id order, each NUL-terminated; *bytes is the total.
+static char* tag_table(int count, uint64_t *bytes) {
+    uint64_t total = 0;
+    for (int t = 0; t < count; t++) total += tag_name_length(t) + 1;
+    char *table = malloc(total > 0 ? total : 1);
+    char *p = table;
+    for (int t = 0; t < count; t++) {
+        size_t length = tag_name_length(t);
+        memcpy(p, tag_name(t), length + 1);
+        p += length + 1;
+    }
+    *bytes = total;
+    return table;
+}
+
+static int write_nodes(int fd, const snapshot_header_t *h) {
+    snapshot_node_t *chunk = malloc(sizeof(snapshot_node_t) * SNAPSHOT_NODE_CHUNK);
+    uint64_t offset = h->sections[SNAPSHOT_NODES].offset;
+    int status = 0;
+    for (int i = 0; i < h->owned && status == 0; i += SNAPSHOT_NODE_CHUNK) {
+        int count = h->owned - i < SNAPSHOT_NODE_CHUNK ? h->owned - i : SNAPSHOT_NODE_CHUNK;
+        memset(chunk, 0, sizeof(snapshot_node_t) * count);
+        for (int k = 0; k < count; k++) {
+            const TorusNode *n = &network[i + k];
+            snapshot_node_t *r = &chunk[k];
+            r->id = n->id;
+            r->parity_count = n->parity_count;
+            r->parity_version = n->parity_version;
+            r->replication_factor = n->replication_factor;
+            memcpy(r->parity_tags, n->parity_tags, sizeof(parity_tag_id_t) * n->parity_count);
+            memcpy(r->hash, n->hash, MAX_HASH_SIZE);
+        }
+        status = write_at(fd, chunk, sizeof(snapshot_node_t) * count, offset);
+        offset += sizeof(snapshot_node_t) * count;
+    }
+    free(chunk);
+    return status;
+}
+
+long long snapshot_write(const char *path) {
+    if (!network || !topology.offsets) return -1;
+    snapshot_header_t h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, SNAPSHOT_MAGIC, sizeof(h.magic));
+    h.version = SNAPSHOT_VERSION;
+    h.byte_order = SNAPSHOT_BYTE_ORDER;
+    h.header_bytes = sizeof(h);
+    h.rank = partition.rank;
+    h.ranks = partition.size;
+    h.total_nodes = total_nodes;
+    h.vector_dim = vector_dim;
+    h.first = partition.first;
+    h.owned = partition.owned;
+    h.hot_slots = node_hot.count;
+    h.topology_kind = topology.kind;
+    h.topology_width = topology.width;
+    h.topology_height = topology.height;
+    h.edges = topology.offsets[topology.nodes];
+    h.created = time(NULL);
+    h.journal_lsn = journal_last_lsn();
+    const uint8_t *root = merkle_network_root();
+    if (root) memcpy(h.merkle_root, root, MERKLE_DIGEST_SIZE);
+
+    // Only the blocks covering owned nodes; the store grows by doubling,
+    // and nothing past the last owned node is ever set.
+    vector_store_t *store = ann_get_vector_store();
+    int blocks = (h.owned + VECTOR_LANES - 1) / VECTOR_LANES * VECTOR_LANES;
+    h.store_capacity = store ? (blocks < store->capacity ? blocks : store->capacity) : 0;
+
+    h.tag_count = tag_count();
+    uint64_t names_bytes;
+    char *names = tag_table(h.tag_count, &names_bytes);
+
+    size_t dim = vector_dim;
+    uint64_t end = align_up(sizeof(h));
+    place(&h, SNAPSHOT_NODES, sizeof(snapshot_node_t) * (uint64_t)h.owned, &end);
+    place(&h, SNAPSHOT_DENSITY, sizeof(double) * (uint64_t)h.hot_slots, &end);
+    place(&h, SNAPSHOT_COHERENCE, sizeof(double) * (uint64_t)h.hot_slots, &end);
+    place(&h, SNAPSHOT_VECTORS, sizeof(double) * (uint64_t)h.hot_slots * dim, &end);
+    place(&h, SNAPSHOT_STORE_BLOCKS, sizeof(double) * (uint64_t)h.store_capacity * dim, &end);
+    place(&h, SNAPSHOT_STORE_NORMS, sizeof(double) * (uint64_t)h.store_capacity, &end);
+    place(&h, SNAPSHOT_TOPOLOGY_OFFSETS, sizeof(int) * ((uint64_t)topology.nodes + 1), &end);
+    place(&h, SNAPSHOT_TOPOLOGY_TARGETS, sizeof(int) * h.edges, &end);
+    place(&h, SNAPSHOT_TOPOLOGY_WEIGHTS, topology.weights ? sizeof(float) * h.edges : 0, &end);
+    place(&h, SNAPSHOT_TAG_NAMES, names_bytes, &end);
+
+    char tmp[PATH_MAX];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    int ok = fd >= 0;
+    const snapshot_section_t *s = h.sections;
+    ok = ok && write_at(fd, &h, sizeof(h), 0) == 0;
+    ok = ok && write_nodes(fd, &h) == 0;
+    ok = ok && write_at(fd, node_hot.density, s[SNAPSHOT_DENSITY].bytes, s[SNAPSHOT_DENSITY].offset) == 0;
+    ok = ok && write_at(fd, node_hot.coherence, s[SNAPSHOT_COHERENCE].bytes, s[SNAPSHOT_COHERENCE].offset) == 0;
+    ok = ok && write_at(fd, node_hot.vectors, s[SNAPSHOT_VECTORS].bytes, s[SNAPSHOT_VECTORS].offset) == 0;
+    if (store) {
+        ok = ok && write_at(fd, store->blocks, s[SNAPSHOT_STORE_BLOCKS].bytes,
+                            s[SNAPSHOT_STORE_BLOCKS].offset) == 0;
+        ok = ok && write_at(fd, store->inv_norms, s[SNAPSHOT_STORE_NORMS].bytes,
+                            s[SNAPSHOT_STORE_NORMS].offset) == 0;
+    }
+    ok = ok && write_at(fd, topology.offsets, s[SNAPSHOT_TOPOLOGY_OFFSETS].bytes,
+                        s[SNAPSHOT_TOPOLOGY_OFFSETS].offset) == 0;
+    ok = ok && write_at(fd, topology.targets, s[SNAPSHOT_TOPOLOGY_TARGETS].bytes,
+                        s[SNAPSHOT_TOPOLOGY_TARGETS].offset) == 0;
+    if (topology.weights) {
+        ok = ok && write_at(fd, topology.weights, s[SNAPSHOT_TOPOLOGY_WEIGHTS].bytes,
+                            s[SNAPSHOT_TOPOLOGY_WEIGHTS].offset) == 0;
+    }
+    ok = ok && write_at(fd, names, names_bytes, s[SNAPSHOT_TAG_NAMES].offset) == 0;
+    ok = ok && ftruncate(fd, (off_t)end) == 0 && fsync(fd) == 0;
+    int saved = errno;
+    if (fd >= 0) close(fd);
+    free(names);
+    if (!ok || rename(tmp, path) != 0) {
+        if (ok) saved = errno;
+        fprintf(stderr, "[SNAPSHOT] Cannot write %s: %s\n", path, strerror(saved));
+        unlink(tmp);
+        return -1;
+    }
+    // Until the directory is synced a crash can bring the old file back.
+    if (journal_sync_directory(path) != 0) {
+        fprintf(stderr, "[SNAPSHOT] Cannot sync the directory of %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    return (long long)end;
+}
+
+// Request: snapshot_request_t, then the NUL-terminated prefix.
+typedef struct {
+    int32_t journal_sync;       // journal_sync_t, or -1 for no checkpoint
+    int32_t journal_interval_ms;
+} snapshot_request_t;
+
+// Snapshot, then the journal restarting from it; the journal is only
+// reset once the snapshot's rename is durable. Nothing mutates this rank
+// in between: handlers and the CLI run on the same thread.
+static int64_t checkpoint(const char *prefix, const snapshot_request_t *r) {
+    char path[PATH_MAX];
+    snapshot_path(prefix, partition.rank, path, sizeof(path));
+    int64_t bytes = snapshot_write(path);
+    if (bytes >= 0 && r->journal_sync >= 0) {
+        journal_config_t config = { (journal_sync_t)r->journal_sync, r->journal_interval_ms };
+        if (journal_checkpoint(prefix, &config) != 0) bytes = -1;
+    }
+    return bytes;
+}
+
+static int handle_snapshot(int source, const uint8_t *req, int length, uint8_t *reply, int cap) {
+    (void)source;
+    snapshot_request_t r;
+    if (length < (int)sizeof(r) + 2 || req[length - 1] != '\0' || cap < (int)sizeof(int64_t)) return -1;
+    memcpy(&r, req, sizeof(r));
+    int64_t bytes = checkpoint((const char *)req + sizeof(r), &r);
+    memcpy(reply, &bytes, sizeof(bytes));
+    return sizeof(bytes);
+}
+
+void snapshot_init(void) {
+    partition_register_handler(PARTITION_OP_SNAPSHOT, handle_snapshot);
+}
+
+int snapshot_write_all(const char *prefix, const journal_config_t *journal) {
+    int length = (int)strlen(prefix) + 1;
+    if (length > PATH_MAX - 16) return partition.size;   // room for .<rank>.tmp
+    snapshot_request_t request = { journal ? (int32_t)journal->sync : -1, journal ? journal->interval_ms : 0 };
+    uint8_t *req = malloc(sizeof(request) + length);
+    memcpy(req, &request, sizeof(request));
+    memcpy(req + sizeof(request), prefix, length);
+    int failed = 0;
+    for (int r = 0; r < partition.size; r++) {
+        char path[PATH_MAX];
+        snapshot_path(prefix, r, path, sizeof(path));
+        int64_t bytes = -1;
+        if (r == partition.rank) {
+            bytes = checkpoint(prefix, &request);
+        } else if (partition_call(r, PARTITION_OP_SNAPSHOT, req, (int)sizeof(request) + length, &bytes,
+                                  sizeof(bytes)) != (int)sizeof(bytes)) {
+            bytes = -1;
+        }
+        if (bytes < 0) {
+            printf("[SNAPSHOT] Rank %d failed to write %s\n", r, path);
+            failed++;
+        } else {
+            printf("[SNAPSHOT] Rank %d wrote %s (%.1f MB)\n", r, path, bytes / 1e6);
+        }
+    }
+    free(req);
+    return failed;
+}
+
+// ---- Loading --------------------------------------------------------------
+
+static int section_is(const snapshot_t *snap, snapshot_section_id_t id, uint64_t bytes) {
+    const snapshot_section_t *s = &snap->header->sections[id];
+    return s->bytes == bytes && s->offset % SNAPSHOT_ALIGNMENT == 0 &&
+           s->offset >= sizeof(snapshot_header_t) && s->offset <= snap->bytes &&
+           s->bytes <= snap->bytes - s->offset;
+}
+
+// Why snap cannot be loaded, or NULL. Checks shapes and bounds, and every
+// index the process follows straight off the mapping: the topology CSR
+// and the node ids. The rest of the contents are trusted, and
+// snapshot_verify checks the node state.
+static const char* check(const snapshot_t *snap) {
+    const snapshot_header_t *h = snap->header;
+    if (memcmp(h->magic, SNAPSHOT_MAGIC, sizeof(h->magic)) != 0) return "not a snapshot";
+    if (h->byte_order != SNAPSHOT_BYTE_ORDER) return "written with the other byte order";
+    if (h->version != SNAPSHOT_VERSION) return "unsupported version";
+    if (h->header_bytes != sizeof(snapshot_header_t)) return "header size differs from this build";
+    if (h->total_nodes <= 0 || h->vector_dim <= 0 || h->ranks <= 0 || h->rank < 0 || h->rank >= h->ranks)
+        return "bad network shape";
+    if (h->first < 0 || h->owned < 0 || h->first > h->total_nodes - h->owned || h->hot_slots < h->owned)
+        return "bad shard";
+    if (h->store_capacity < 0 || h->store_capacity % VECTOR_LANES != 0 ||
+        (h->store_capacity > 0 && h->store_capacity < h->owned))
+        return "bad vector store capacity";
+    if (h->tag_count < 0) return "bad tag count";
+
+    uint64_t dim = h->vector_dim;
+    uint64_t slots = h->hot_slots;
+    uint64_t store = h->store_capacity;
+    const snapshot_section_t *weights = &h->sections[SNAPSHOT_TOPOLOGY_WEIGHTS];
+    if (!section_is(snap, SNAPSHOT_NODES, sizeof(snapshot_node_t) * (uint64_t)h->owned) ||
+        !section_is(snap, SNAPSHOT_DENSITY, sizeof(double) * slots) ||
+        !section_is(snap, SNAPSHOT_COHERENCE, sizeof(double) * slots) ||
+        !section_is(snap, SNAPSHOT_VECTORS, sizeof(double) * slots * dim) ||
+        !section_is(snap, SNAPSHOT_STORE_BLOCKS, sizeof(double) * store * dim) ||
+        !section_is(snap, SNAPSHOT_STORE_NORMS, sizeof(double) * store) ||
+        !section_is(snap, SNAPSHOT_TOPOLOGY_OFFSETS, sizeof(int) * ((uint64_t)h->total_nodes + 1)) ||
+        !section_is(snap, SNAPSHOT_TOPOLOGY_TARGETS, sizeof(int) * h->edges) ||
+        !section_is(snap, SNAPSHOT_TOPOLOGY_WEIGHTS, weights->bytes ? sizeof(float) * h->edges : 0) ||
+        !section_is(snap, SNAPSHOT_TAG_NAMES, h->sections[SNAPSHOT_TAG_NAMES].bytes))
+        return "truncated or misplaced section";
+
+    // Routing and BFS index targets through offsets without checks, so a
+    // file that is the right size but wrong inside must stop here. One
+    // pass over both arrays; their pages are wanted right after anyway.
+    if (h->edges > INT_MAX) return "bad topology";
+    const int *offsets = snapshot_section(snap, SNAPSHOT_TOPOLOGY_OFFSETS);
+    if (offsets[0] != 0 || (uint64_t)offsets[h->total_nodes] != h->edges) return "bad topology";
+    for (int i = 0; i < h->total_nodes; i++) {
+        if (offsets[i] > offsets[i + 1]) return "bad topology offsets";
+    }
+    const int *targets = snapshot_section(snap, SNAPSHOT_TOPOLOGY_TARGETS);
+    for (uint64_t e = 0; e < h->edges; e++) {
+        if (targets[e] < 0 || targets[e] >= h->total_nodes) return "bad topology target";
+    }
+
+    const snapshot_node_t *records = snapshot_section(snap, SNAPSHOT_NODES);
+    for (int i = 0; i < h->owned; i++) {
+        if (records[i].id != h->first + i) return "bad node record";
+    }
+
+    const char *names = snapshot_section(snap, SNAPSHOT_TAG_NAMES);
+    uint64_t names_bytes = h->sections[SNAPSHOT_TAG_NAMES].bytes;
+    if (names_bytes > 0 && names[names_bytes - 1] != '\0') return "bad tag table";
+    return NULL;
+}
+
+snapshot_t* snapshot_open(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "[SNAPSHOT] Cannot open %s: %s\n", path, strerror(errno));
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(snapshot_header_t)) {
+        fprintf(stderr, "[SNAPSHOT] %s: too short\n", path);
+        close(fd);
+        return NULL;
+    }
+    // Private and writable: pages stay shared with every other mapping of
+    // the file until this process writes to one.
+    void *base = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        fprintf(stderr, "[SNAPSHOT] Cannot map %s: %s\n", path, strerror(errno));
+        return NULL;
+    }
+    snapshot_t *snap = malloc(sizeof(snapshot_t));
+    snap->base = base;
+    snap->bytes = st.st_size;
+    snap->header = base;
+    const char *problem = check(snap);
+    if (problem) {
+        fprintf(stderr, "[SNAPSHOT] %s: %s\n", path, problem);
+        snapshot_close(snap);
+        return NULL;
+    }
+    return snap;
+}
+
+void snapshot_close(snapshot_t *snap) {
+    if (!snap) return;
+    munmap(snap->base, snap->bytes);
+    free(snap);
+}
+
+// Ids are per process, so the snapshot's are mapped onto this process's
+// by interning the names in order; a fresh process gets the same ids.
+static parity_tag_id_t* intern_tags(const snapshot_t *snap) {
+    int count = snap->header->tag_count;
+    parity_tag_id_t *ids = malloc(sizeof(parity_tag_id_t) * (count > 0 ? count : 1));
+    const char *name = snapshot_section(snap, SNAPSHOT_TAG_NAMES);
+    const char *end = name + snap->header->sections[SNAPSHOT_TAG_NAMES].bytes;
+    for (int t = 0; t < count; t++) {
+        if (name >= end) {
+            ids[t] = PARITY_TAG_INVALID;
+            continue;
+        }
+        size_t length = strlen(name);
+        ids[t] = tag_intern_n(name, length);
+        name += length + 1;
+    }
+    return ids;
+}
+
+int snapshot_restore(snapshot_t *snap) {
+    const snapshot_header_t *h = snap->header;
+    if (h->ranks != partition.size || h->total_nodes != total_nodes || h->vector_dim != vector_dim ||
+        h->first != partition.first || h->owned != partition.owned) {
+        fprintf(stderr, "[SNAPSHOT] Shard %d of %d (nodes %d..%d of %d) does not match rank %d of %d\n",
+                h->rank, h->ranks, h->first, h->first + h->owned - 1, h->total_nodes,
+                partition.rank, partition.size);
+        return -1;
+    }
+
+    topology_free(&topology);
+    topology.kind = h->topology_kind;
+    topology.nodes = h->total_nodes;
+    topology.width = h->topology_width;
+    topology.height = h->topology_height;
+    topology.offsets = snapshot_section(snap, SNAPSHOT_TOPOLOGY_OFFSETS);
+    topology.targets = snapshot_section(snap, SNAPSHOT_TOPOLOGY_TARGETS);
+    topology.borrowed = 1;
+    // Weights are copied: topology_set_weight may allocate them later, and
+    // topology_free then owns them either way.
+    uint64_t weight_bytes = h->sections[SNAPSHOT_TOPOLOGY_WEIGHTS].bytes;
+    if (weight_bytes > 0) {
+        topology.weights = malloc(weight_bytes);
+        memcpy(topology.weights, snapshot_section(snap, SNAPSHOT_TOPOLOGY_WEIGHTS), weight_bytes);
+    }
+
+    // Cold records are rebuilt; they carry pointers the file cannot. The
+    // announcement maps are gossip state and stay unallocated until a
+    // node hears one (update_parity_knowledge_map).
+    parity_tag_id_t *ids = intern_tags(snap);
+    const snapshot_node_t *records = snapshot_section(snap, SNAPSHOT_NODES);
+    int owned = h->owned;
+    network = SAFE_MALLOC(sizeof(TorusNode) * (owned > 0 ? owned : 1));
+    for (int i = 0; i < owned; i++) {
+        const snapshot_node_t *r = &records[i];
+        TorusNode *n = &network[i];
+        memset(n, 0, sizeof(*n));
+        n->id = r->id;
+        for (int t = 0; t < r->parity_count && t < MAX_PARITY_TAGS; t++) {
+            if (r->parity_tags[t] >= (uint32_t)h->tag_count) continue;
+            parity_tag_id_t tag = ids[r->parity_tags[t]];
+            if (tag != PARITY_TAG_INVALID) n->parity_tags[n->parity_count++] = tag;
+        }
+        n->parity_version = r->parity_version;
+        n->replication_factor = r->replication_factor;
+        memcpy(n->hash, r->hash, MAX_HASH_SIZE);
+        n->hash[MAX_HASH_SIZE - 1] = '\0';
+        if (n->parity_count > 0) parity_index_set_node_tags(n->id, n->parity_tags, n->parity_count);
+    }
+    free(ids);
+
+    node_store_attach(owned, h->hot_slots, h->vector_dim, snapshot_section(snap, SNAPSHOT_DENSITY),
+                      snapshot_section(snap, SNAPSHOT_COHERENCE), snapshot_section(snap, SNAPSHOT_VECTORS));
+
+    vector_store_t *store;
+    if (h->store_capacity > 0) {
+        store = vector_store_wrap(h->store_capacity, h->vector_dim,
+                                  snapshot_section(snap, SNAPSHOT_STORE_BLOCKS),
+                                  snapshot_section(snap, SNAPSHOT_STORE_NORMS));
+    } else {
+        store = vector_store_create(owned, h->vector_dim);
+        for (int i = 0; i < owned; i++) vector_store_set(store, i, node_vector(i));
+    }
+    ann_attach_vector_store(store);
+    ann_attach_index(NULL);
+    return 0;
+}
+
+int snapshot_verify(const snapshot_t *snap) {
+    const uint8_t *root = merkle_network_root();
+    if (!root) return snap->header->owned == 0;
+    return memcmp(root, snap->header->merkle_root, MERKLE_DIGEST_SIZE) == 0;
+}
+
+// ---- Benchmark ------------------------------------------------------------
+
+// Sum of one byte per page, so every page is faulted in.
+static unsigned touch_pages(const uint8_t *base, size_t bytes) {
+    unsigned sum = 0;
+    for (size_t i = 0; i < bytes; i += SNAPSHOT_ALIGNMENT) sum += base[i];
+    return sum;
+}
+
+static void drop_cache(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return;
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
+
+static double time_read(const char *path, size_t bytes) {
+    double start = now_ms();
+    uint8_t *buf = malloc(bytes);
+    int fd = open(path, O_RDONLY);
+    size_t done = 0;
+    while (fd >= 0 && done < bytes) {
+        ssize_t n = read(fd, buf + done, bytes - done);
+        if (n <= 0) break;
+        done += n;
+    }
+    if (fd >= 0) close(fd);
+    double elapsed = now_ms() - start;
+    free(buf);
+    return elapsed;
+}
+
+void snapshot_bench(const char *path) {
+    double start = now_ms();
+    long long bytes = snapshot_write(path);
+    if (bytes < 0) return;
+    double write_ms = now_ms() - start;
+    printf("[SNAPSHOT BENCH] %d nodes, dim %d: %.1f MB written in %.1f ms (%.0f MB/s, fsync included)\n",
+           partition.owned, vector_dim, bytes / 1e6, write_ms, bytes / 1e3 / write_ms);
+    printf("  %-6s %12s %14s %14s\n", "cache", "open (ms)", "+touch (ms)", "read() (ms)");
+
+    // Cold rows drop the file's clean pages first (best effort: a no-op
+    // where the kernel ignores the advice).
+    for (int cold = 1; cold >= 0; cold--) {
+        if (cold) drop_cache(path);
+        start = now_ms();
+        snapshot_t *snap = snapshot_open(path);
+        if (!snap) return;
+        double open_ms = now_ms() - start;
+        volatile unsigned sink = touch_pages(snap->base, snap->bytes);
+        (void)sink;
+        double touch_ms = now_ms() - start;
+        snapshot_close(snap);
+        if (cold) drop_cache(path);
+        double read_ms = time_read(path, bytes);
+        printf("  %-6s %12.3f %14.1f %14.1f\n", cold ? "cold" : "warm", open_ms, touch_ms, read_ms);
+    }
+    unlink(path);
+}
@@ -0,0 +1,132 @@
+/*
+ * FT-DFRP: Parity Tag Interning
+ *
+ * Dual Licensed:
+ * 1. AGPL-3.0 for research/academic use
+ * 2. Commercial license: contact michael.doran.808@gmail.com
+ *
+ * Copyright (C) 2025 Michael Doran
+ */
+
+#include "tag_intern.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TAG_PAGE_BITS 12
+#define TAG_PAGE_SIZE (1 << TAG_PAGE_BITS)
+#define TAG_MAX_PAGES 65536
+#define INITIAL_SLOTS 1024
+
+typedef struct {
+    char *name;
+    uint32_t length;
+    uint32_t hash;
+} tag_record_t;
+
+// Records live in fixed-size pages that never move, so tag_name can read
+// without taking the lock while other threads intern new tags.
+static tag_record_t *pages[TAG_MAX_PAGES];
+static int count = 0;
+
+static parity_tag_id_t *slots = NULL;   // open addressing, PARITY_TAG_INVALID = empty
+static int slot_capacity = 0;
+
+static pthread_mutex_t intern_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint32_t hash_bytes(const char *s, size_t length) {
+    uint32_t h = 2166136261u;   // FNV-1a
+    for (size_t i = 0; i < length; i++) {
+        h ^= (unsigned char)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static inline tag_record_t* record(parity_tag_id_t id) {
+    return &pages[id >> TAG_PAGE_BITS][id & (TAG_PAGE_SIZE - 1)];
+}
+
+static void rehash(int capacity) {
+    free(slots);
+    slots = malloc(sizeof(parity_tag_id_t) * capacity);
+    for (int i = 0; i < capacity; i++) slots[i] = PARITY_TAG_INVALID;
+    slot_capacity = capacity;
+    for (int id = 0; id < count; id++) {
+        int s = record(id)->hash & (slot_capacity - 1);
+        while (slots[s] != PARITY_TAG_INVALID) s = (s + 1) & (slot_capacity - 1);
+        slots[s] = id;
+    }
+}
+
+// Caller holds intern_lock.
+static parity_tag_id_t find_locked(const char *tag, size_t length, uint32_t hash) {
+    if (!slots) return PARITY_TAG_INVALID;
+    int s = hash & (slot_capacity - 1);
+    while (slots[s] != PARITY_TAG_INVALID) {
+        tag_record_t *r = record(slots[s]);
+        if (r->hash == hash && r->length == length && memcmp(r->name, tag, length) == 0) {
+            return slots[s];
+        }
+        s = (s + 1) & (slot_capacity - 1);
+    }
+    return PARITY_TAG_INVALID;
+}
+
+parity_tag_id_t tag_intern_n(const char *tag, size_t length) {
+    // Truncating would fold distinct long tags into one.
+    if (length > MAX_TAG_LENGTH) return PARITY_TAG_INVALID;
+    uint32_t hash = hash_bytes(tag, length);
+
+    pthread_mutex_lock(&intern_lock);
+    parity_tag_id_t id = find_locked(tag, length, hash);
+    if (id == PARITY_TAG_INVALID && count < TAG_MAX_PAGES * TAG_PAGE_SIZE) {
+        if (!slots || (count + 1) * 2 > slot_capacity) {
+            rehash(slot_capacity ? slot_capacity * 2 : INITIAL_SLOTS);
+        }
+        id = count;
+        if (!pages[id >> TAG_PAGE_BITS]) {
+            pages[id >> TAG_PAGE_BITS] = calloc(TAG_PAGE_SIZE, sizeof(tag_record_t));
+        }
+        tag_record_t *r = record(id);
+        r->name = malloc(length + 1);
+        memcpy(r->name, tag, length);
+        r->name[length] = '\0';
+        r->length = (uint32_t)length;
+        r->hash = hash;
+
+        int s = hash & (slot_capacity - 1);
+        while (slots[s] != PARITY_TAG_INVALID) s = (s + 1) & (slot_capacity - 1);
+        slots[s] = id;
+        __atomic_store_n(&count, count + 1, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&intern_lock);
+    return id;
+}
+
+parity_tag_id_t tag_intern(const char *tag) {
+    return tag_intern_n(tag, strlen(tag));
+}
+
+parity_tag_id_t tag_lookup(const char *tag) {
+    size_t length = strnlen(tag, MAX_TAG_LENGTH + 1);
+    if (length > MAX_TAG_LENGTH) return PARITY_TAG_INVALID;
+    pthread_mutex_lock(&intern_lock);
+    parity_tag_id_t id = find_locked(tag, length, hash_bytes(tag, length));
+    pthread_mutex_unlock(&intern_lock);
+    return id;
+}
+
+const char* tag_name(parity_tag_id_t id) {
+    if (id >= (parity_tag_id_t)tag_count()) return NULL;
+    return record(id)->name;
+}
+
+size_t tag_name_length(parity_tag_id_t id) {
+    if (id >= (parity_tag_id_t)tag_count()) return 0;
+    return record(id)->length;
+}
+
+int tag_count(void) {
+    return __atomic_load_n(&count, __ATOMIC_ACQUIRE);
+}
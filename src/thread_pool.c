@@ -0,0 +1,169 @@
+/*
+ * FT-DFRP: Worker Thread Pool
+ *
+ * Dual Licensed:
+ * 1. AGPL-3.0 for research/academic use
+ * 2. Commercial license: contact michael.doran.808@gmail.com
+ *
+ * Copyright (C) 2025 Michael Doran
+ */
+
+#include "thread_pool.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+typedef struct {
+    thread_pool_t *pool;
+    int index;
+} worker_arg_t;
+
+struct thread_pool {
+    int threads;
+    pthread_t *workers;
+    worker_arg_t *args;
+
+    pthread_mutex_t job_lock;   // serializes concurrent parallel_for callers
+    pthread_mutex_t lock;
+    pthread_cond_t work_ready;
+    pthread_cond_t work_done;
+    unsigned long generation;   // bumped per parallel_for
+    int shutdown;
+    int active;                 // helpers still inside the current job
+
+    // Current job
+    thread_pool_task_fn fn;
+    void *ctx;
+    int n;
+    int grain;
+    atomic_int next;
+};
+
+static pthread_once_t default_once = PTHREAD_ONCE_INIT;
+static thread_pool_t *default_pool = NULL;
+
+static void run_chunks(thread_pool_t *pool, int worker) {
+    for (;;) {
+        int begin = atomic_fetch_add(&pool->next, pool->grain);
+        if (begin >= pool->n) break;
+        int end = begin + pool->grain < pool->n ? begin + pool->grain : pool->n;
+        pool->fn(pool->ctx, begin, end, worker);
+    }
+}
+
+static void* worker_main(void *arg) {
+    worker_arg_t *wa = arg;
+    thread_pool_t *pool = wa->pool;
+    unsigned long seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->shutdown && pool->generation == seen) {
+            pthread_cond_wait(&pool->work_ready, &pool->lock);
+        }
+        if (pool->shutdown) break;
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        run_chunks(pool, wa->index);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->active == 0) pthread_cond_signal(&pool->work_done);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+thread_pool_t* thread_pool_create(int threads) {
+    if (threads <= 0) threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads <= 0) threads = 1;
+
+    thread_pool_t *pool = calloc(1, sizeof(thread_pool_t));
+    pool->threads = threads;
+    pthread_mutex_init(&pool->job_lock, NULL);
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_ready, NULL);
+    pthread_cond_init(&pool->work_done, NULL);
+    atomic_init(&pool->next, 0);
+
+    // Worker 0 is whoever calls parallel_for; spawn the rest.
+    pool->workers = malloc(sizeof(pthread_t) * threads);
+    pool->args = malloc(sizeof(worker_arg_t) * threads);
+    for (int i = 1; i < threads; i++) {
+        pool->args[i] = (worker_arg_t){ pool, i };
+        pthread_create(&pool->workers[i], NULL, worker_main, &pool->args[i]);
+    }
+    return pool;
+}
+
+void thread_pool_free(thread_pool_t *pool) {
+    if (!pool) return;
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->work_ready);
+    pthread_mutex_unlock(&pool->lock);
+    for (int i = 1; i < pool->threads; i++) {
+        pthread_join(pool->workers[i], NULL);
+    }
+    pthread_mutex_destroy(&pool->job_lock);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->work_ready);
+    pthread_cond_destroy(&pool->work_done);
+    free(pool->workers);
+    free(pool->args);
+    free(pool);
+}
+
+int thread_pool_size(const thread_pool_t *pool) {
+    return pool ? pool->threads : 1;
+}
+
+void thread_pool_parallel_for(thread_pool_t *pool, int n, int grain,
+                              thread_pool_task_fn fn, void *ctx) {
+    if (n <= 0) return;
+    if (grain <= 0) grain = 1;
+
+    if (!pool) {
+        fn(ctx, 0, n, 0);
+        return;
+    }
+
+    pthread_mutex_lock(&pool->job_lock);
+
+    // Small jobs are not worth waking anyone up for.
+    if (pool->threads == 1 || n <= grain) {
+        fn(ctx, 0, n, 0);
+        pthread_mutex_unlock(&pool->job_lock);
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->fn = fn;
+    pool->ctx = ctx;
+    pool->n = n;
+    pool->grain = grain;
+    atomic_store(&pool->next, 0);
+    pool->active = pool->threads - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->work_ready);
+    pthread_mutex_unlock(&pool->lock);
+
+    run_chunks(pool, 0);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->active > 0) {
+        pthread_cond_wait(&pool->work_done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    pthread_mutex_unlock(&pool->job_lock);
+}
+
+static void create_default_pool(void) {
+    default_pool = thread_pool_create(0);
+}
+
+thread_pool_t* thread_pool_default(void) {
+    pthread_once(&default_once, create_default_pool);
+    return default_pool;
+}
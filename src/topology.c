@@ -0,0 +1,195 @@
+/*
+ * FT-DFRP: Network Topology
+ *
+ * Dual Licensed:
+ * 1. AGPL-3.0 for research/academic use
+ * 2. Commercial license: contact michael.doran.808@gmail.com
+ *
+ * Copyright (C) 2025 Michael Doran
+ */
+
+#include "topology.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+topology_t topology;
+
+// Fills out with node_id's neighbours and returns how many; at most
+// TOPOLOGY_MAX_DEGREE.
+typedef int (*neighbor_rule_fn)(const topology_t *t, int node_id, int param, int *out);
+
+static int add_unique(int *out, int count, int self, int target) {
+    if (target == self || count == TOPOLOGY_MAX_DEGREE) return count;
+    for (int i = 0; i < count; i++) {
+        if (out[i] == target) return count;
+    }
+    out[count] = target;
+    return count + 1;
+}
+
+static int build(topology_t *t, topology_kind_t kind, int nodes, neighbor_rule_fn rule, int param) {
+    if (nodes <= 0) return -1;
+    t->kind = kind;
+    t->nodes = nodes;
+    t->weights = NULL;
+    t->borrowed = 0;
+    t->offsets = malloc(sizeof(int) * (nodes + 1));
+    int capacity = nodes * 4;
+    t->targets = malloc(sizeof(int) * capacity);
+    t->offsets[0] = 0;
+    for (int v = 0; v < nodes; v++) {
+        int out[TOPOLOGY_MAX_DEGREE];
+        int count = rule(t, v, param, out);
+        int edges = t->offsets[v];
+        if (edges + count > capacity) {
+            while (edges + count > capacity) capacity *= 2;
+            t->targets = realloc(t->targets, sizeof(int) * capacity);
+        }
+        memcpy(t->targets + edges, out, sizeof(int) * count);
+        t->offsets[v + 1] = edges + count;
+    }
+    return 0;
+}
+
+static int ring_rule(const topology_t *t, int v, int fanout, int *out) {
+    int count = 0;
+    for (int i = 1; i <= fanout; i++) count = add_unique(out, count, v, (v + i) % t->nodes);
+    return count;
+}
+
+// Grid as close to square as possible; ids run row by row and only the
+// last row may be short, so each row and column wraps at its own length.
+static void set_grid(topology_t *t, int nodes) {
+    t->width = (int)ceil(sqrt((double)nodes));
+    t->height = (nodes + t->width - 1) / t->width;
+}
+
+static int row_length(const topology_t *t, int row) {
+    return row < t->height - 1 ? t->width : t->nodes - (t->height - 1) * t->width;
+}
+
+static int column_height(const topology_t *t, int column) {
+    return column < row_length(t, t->height - 1) ? t->height : t->height - 1;
+}
+
+static int wrap(int value, int length) {
+    value %= length;
+    return value < 0 ? value + length : value;
+}
+
+// Neighbours step cells away along both axes, in both directions.
+static int add_steps(const topology_t *t, int v, int step, int *out, int count) {
+    int row = v / t->width, column = v % t->width;
+    int length = row_length(t, row), height = column_height(t, column);
+    if (step < length) {
+        count = add_unique(out, count, v, row * t->width + wrap(column + step, length));
+        count = add_unique(out, count, v, row * t->width + wrap(column - step, length));
+    }
+    if (step < height) {
+        count = add_unique(out, count, v, wrap(row + step, height) * t->width + column);
+        count = add_unique(out, count, v, wrap(row - step, height) * t->width + column);
+    }
+    return count;
+}
+
+static int torus_rule(const topology_t *t, int v, int unused, int *out) {
+    (void)unused;
+    return add_steps(t, v, 1, out, 0);
+}
+
+static int fractal_rule(const topology_t *t, int v, int levels, int *out) {
+    int count = add_steps(t, v, 1, out, 0);
+    for (int level = 1, step = 2; level <= levels; level++, step *= 2) {
+        count = add_steps(t, v, step, out, count);
+    }
+    return count;
+}
+
+int topology_build_ring(topology_t *t, int nodes, int fanout) {
+    if (fanout < 1) fanout = 1;
+    if (fanout > TOPOLOGY_MAX_DEGREE) fanout = TOPOLOGY_MAX_DEGREE;
+    t->width = nodes;
+    t->height = 1;
+    return build(t, TOPOLOGY_RING, nodes, ring_rule, fanout);
+}
+
+int topology_build_torus(topology_t *t, int nodes) {
+    if (nodes <= 0) return -1;
+    t->nodes = nodes;
+    set_grid(t, nodes);
+    return build(t, TOPOLOGY_TORUS, nodes, torus_rule, 0);
+}
+
+int topology_build_fractal(topology_t *t, int nodes, int levels) {
+    if (nodes <= 0) return -1;
+    t->nodes = nodes;
+    set_grid(t, nodes);
+    int longest = t->width > t->height ? t->width : t->height;
+    int fit = 0;
+    while ((2 << fit) < longest) fit++;
+    int cap = TOPOLOGY_MAX_DEGREE / 4 - 1;
+    if (levels <= 0 || levels > fit) levels = fit;
+    if (levels > cap) levels = cap;
+    return build(t, TOPOLOGY_FRACTAL, nodes, fractal_rule, levels);
+}
+
+int topology_build_named(topology_t *t, const char *name, int nodes) {
+    if (strcmp(name, "ring") == 0) return topology_build_ring(t, nodes, TOPOLOGY_RING_FANOUT);
+    if (strcmp(name, "torus") == 0) return topology_build_torus(t, nodes);
+    if (strcmp(name, "fractal") == 0) return topology_build_fractal(t, nodes, 0);
+    return -1;
+}
+
+void topology_free(topology_t *t) {
+    if (!t->borrowed) {
+        free(t->offsets);
+        free(t->targets);
+    }
+    free(t->weights);
+    memset(t, 0, sizeof(*t));
+}
+
+int topology_set_weight(topology_t *t, int from, int to, float weight) {
+    if (from < 0 || from >= t->nodes) return -1;
+    for (int e = t->offsets[from]; e < t->offsets[from + 1]; e++) {
+        if (t->targets[e] != to) continue;
+        if (!t->weights) {
+            int edges = t->offsets[t->nodes];
+            t->weights = malloc(sizeof(float) * (edges > 0 ? edges : 1));
+            for (int i = 0; i < edges; i++) t->weights[i] = 1.0f;
+        }
+        t->weights[e] = weight;
+        return 0;
+    }
+    return -1;
+}
+
+double topology_mean_weight(const topology_t *t, int node_id) {
+    int degree = topology_degree(t, node_id);
+    if (degree == 0) return 0.0;
+    if (!t->weights) return 1.0;
+    double sum = 0.0;
+    for (int e = t->offsets[node_id]; e < t->offsets[node_id + 1]; e++) sum += t->weights[e];
+    return sum / degree;
+}
+
+void topology_report(const topology_t *t) {
+    static const char *names[] = { "ring", "torus", "fractal" };
+    if (!t->offsets) {
+        printf("[TOPOLOGY] Not built\n");
+        return;
+    }
+    int min_degree = TOPOLOGY_MAX_DEGREE, max_degree = 0;
+    for (int v = 0; v < t->nodes; v++) {
+        int d = topology_degree(t, v);
+        if (d < min_degree) min_degree = d;
+        if (d > max_degree) max_degree = d;
+    }
+    int edges = t->offsets[t->nodes];
+    printf("[TOPOLOGY] %s %dx%d: %d nodes, %d edges | degree %d..%d (mean %.1f) | %s | %.1f KB\n",
+           names[t->kind], t->width, t->height, t->nodes, edges, min_degree, max_degree,
+           (double)edges / t->nodes, t->weights ? "weighted" : "unweighted",
+           (sizeof(int) * (t->nodes + 1.0) + (sizeof(int) + (t->weights ? sizeof(float) : 0)) * edges) / 1024.0);
+}
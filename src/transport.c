@@ -0,0 +1,559 @@
+/*
+ * FT-DFRP: Asynchronous MPI Transport
+ *
+ * Dual Licensed:
+ * 1. AGPL-3.0 for research/academic use
+ * 2. Commercial license: contact michael.doran.808@gmail.com
+ *
+ * Copyright (C) 2025 Michael Doran
+ */
+
+#include "transport.h"
+#include <mpi.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define RECORD_HEADER 16   // u32 length, u16 channel, u16 reserved, u64 enqueue time (ns)
+#define IDLE_SLEEP_US 20
+
+typedef struct batch {
+    struct batch *next;
+    int rank;              // destination when outgoing, source when incoming
+    int length;
+    uint8_t *data;         // TRANSPORT_BATCH_BYTES
+} batch_t;
+
+typedef struct {
+    batch_t *open;         // batch still accepting records
+    uint64_t first_ns;     // enqueue time of its first record
+} outbox_t;
+
+typedef struct {
+    MPI_Request request;
+    batch_t *batch;
+} slot_t;
+
+static struct {
+    int rank;
+    int size;
+    int started;
+    MPI_Comm comm;
+    pthread_t thread;
+
+    pthread_mutex_t lock;
+    outbox_t *outboxes;
+    batch_t *sealed_head, *sealed_tail;     // waiting for a send slot
+    batch_t *inbox_head, *inbox_tail;       // received, waiting for transport_poll
+    batch_t *free_batches;
+    int flush_requested;
+    int stop_requested;
+
+    // transport_agree: batches sealed for and received from each rank, and
+    // the exchange of those counts with the caller's value.
+    long *sealed_to;
+    long *received_from;
+    pthread_cond_t agreed;
+    int agree_requested;
+    int agree_posted;
+    int agree_done;
+    long *agree_send;               // per rank: batches sealed for it, value
+    long *agree_recv;               // per rank: batches it sealed for us, its value
+    MPI_Request agree_request;
+
+    transport_handler_fn handlers[TRANSPORT_CHANNELS];
+    void *handler_ctx[TRANSPORT_CHANNELS];
+
+    slot_t sends[TRANSPORT_SEND_SLOTS];
+    slot_t recvs[TRANSPORT_RECV_SLOTS];
+
+    // Stats
+    uint64_t start_ns;
+    long records_sent;
+    long records_delivered;
+    long batches_sent;
+    long bytes_sent;
+    double *latency_us;
+    long latency_count;
+} tp = {
+    .rank = 0,
+    .size = 1,
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .agreed = PTHREAD_COND_INITIALIZER,
+};
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Caller holds tp.lock.
+static batch_t* batch_alloc(int rank) {
+    batch_t *b = tp.free_batches;
+    if (b) {
+        tp.free_batches = b->next;
+    } else {
+        b = malloc(sizeof(batch_t));
+        b->data = malloc(TRANSPORT_BATCH_BYTES);
+    }
+    b->next = NULL;
+    b->rank = rank;
+    b->length = 0;
+    return b;
+}
+
+static void batch_release(batch_t *b) {
+    pthread_mutex_lock(&tp.lock);
+    b->next = tp.free_batches;
+    tp.free_batches = b;
+    pthread_mutex_unlock(&tp.lock);
+}
+
+static void queue_push(batch_t **head, batch_t **tail, batch_t *b) {
+    b->next = NULL;
+    if (*tail) (*tail)->next = b;
+    else *head = b;
+    *tail = b;
+}
+
+// Caller holds tp.lock.
+static void record_arrival(const batch_t *b, uint64_t now) {
+    for (int pos = 0; pos + RECORD_HEADER <= b->length; ) {
+        uint32_t length;
+        uint64_t sent;
+        memcpy(&length, b->data + pos, 4);
+        memcpy(&sent, b->data + pos + 8, 8);
+        if (tp.latency_us) {
+            tp.latency_us[tp.latency_count % TRANSPORT_LATENCY_SAMPLES] = (now - sent) / 1e3;
+        }
+        tp.latency_count++;
+        pos += RECORD_HEADER + length;
+    }
+}
+
+// Caller holds tp.lock. Moves the open batch for rank to the sealed queue,
+// or straight to the inbox when it is addressed to this rank.
+static void seal(int rank) {
+    outbox_t *o = &tp.outboxes[rank];
+    if (!o->open || o->open->length == 0) return;
+    if (rank == tp.rank) {
+        record_arrival(o->open, now_ns());
+        o->open->rank = tp.rank;
+        queue_push(&tp.inbox_head, &tp.inbox_tail, o->open);
+    } else {
+        queue_push(&tp.sealed_head, &tp.sealed_tail, o->open);
+        tp.sealed_to[rank]++;
+    }
+    o->open = NULL;
+}
+
+// Caller holds tp.lock.
+static void allocate_outboxes(void) {
+    tp.outboxes = calloc(tp.size, sizeof(outbox_t));
+    free(tp.sealed_to);
+    free(tp.received_from);
+    tp.sealed_to = calloc(tp.size, sizeof(long));
+    tp.received_from = calloc(tp.size, sizeof(long));
+    if (!tp.latency_us) {
+        tp.latency_us = malloc(sizeof(double) * TRANSPORT_LATENCY_SAMPLES);
+        tp.start_ns = now_ns();
+    }
+}
+
+static void post_recv(slot_t *slot) {
+    pthread_mutex_lock(&tp.lock);
+    slot->batch = batch_alloc(MPI_ANY_SOURCE);
+    pthread_mutex_unlock(&tp.lock);
+    MPI_Irecv(slot->batch->data, TRANSPORT_BATCH_BYTES, MPI_BYTE, MPI_ANY_SOURCE,
+              TRANSPORT_TAG, tp.comm, &slot->request);
+}
+
+static void deliver_received(slot_t *slot, const MPI_Status *status) {
+    batch_t *b = slot->batch;
+    MPI_Get_count(status, MPI_BYTE, &b->length);
+    b->rank = status->MPI_SOURCE;
+    pthread_mutex_lock(&tp.lock);
+    record_arrival(b, now_ns());
+    queue_push(&tp.inbox_head, &tp.inbox_tail, b);
+    tp.received_from[b->rank]++;
+    pthread_mutex_unlock(&tp.lock);
+}
+
+// Progress-thread side of transport_agree. Everything queued before the
+// call is sealed, each rank tells every other how many batches it has
+// sealed for it, and the agreement completes once that many have arrived
+// from each. Returns nonzero if anything moved.
+static int progress_agree(void) {
+    pthread_mutex_lock(&tp.lock);
+    if (!tp.agree_requested || tp.agree_done) {
+        pthread_mutex_unlock(&tp.lock);
+        return 0;
+    }
+    if (!tp.agree_posted) {
+        for (int r = 0; r < tp.size; r++) seal(r);
+        for (int r = 0; r < tp.size; r++) tp.agree_send[2 * r] = tp.sealed_to[r];
+        pthread_mutex_unlock(&tp.lock);
+        MPI_Ialltoall(tp.agree_send, 2, MPI_LONG, tp.agree_recv, 2, MPI_LONG, tp.comm, &tp.agree_request);
+        tp.agree_posted = 1;
+        return 1;
+    }
+    pthread_mutex_unlock(&tp.lock);
+    if (tp.agree_request != MPI_REQUEST_NULL) {
+        int flag = 0;
+        MPI_Test(&tp.agree_request, &flag, MPI_STATUS_IGNORE);
+        if (!flag) return 0;
+    }
+    pthread_mutex_lock(&tp.lock);
+    int arrived = 1;
+    for (int r = 0; r < tp.size && arrived; r++) {
+        if (r != tp.rank && tp.received_from[r] < tp.agree_recv[2 * r]) arrived = 0;
+    }
+    if (arrived) {
+        tp.agree_done = 1;
+        pthread_cond_broadcast(&tp.agreed);
+    }
+    pthread_mutex_unlock(&tp.lock);
+    return arrived;
+}
+
+// One pass over outboxes, send ring and receive ring. Returns nonzero if
+// anything moved.
+static int progress_once(int *sends_idle) {
+    int moved = 0;
+    int indices[TRANSPORT_SEND_SLOTS + TRANSPORT_RECV_SLOTS];
+    MPI_Status statuses[TRANSPORT_RECV_SLOTS];
+    MPI_Request requests[TRANSPORT_SEND_SLOTS];
+    uint64_t now = now_ns();
+
+    // Seal aged (or all, when flushing) outboxes and pull sealed batches.
+    pthread_mutex_lock(&tp.lock);
+    int seal_all = tp.flush_requested || tp.stop_requested;
+    tp.flush_requested = 0;
+    for (int r = 0; r < tp.size; r++) {
+        outbox_t *o = &tp.outboxes[r];
+        if (o->open && o->open->length > 0 &&
+            (seal_all || now - o->first_ns >= TRANSPORT_FLUSH_US * 1000ULL)) {
+            seal(r);
+            moved = 1;
+        }
+    }
+    for (int s = 0; s < TRANSPORT_SEND_SLOTS && tp.sealed_head; s++) {
+        if (tp.sends[s].batch) continue;
+        batch_t *b = tp.sealed_head;
+        tp.sealed_head = b->next;
+        if (!tp.sealed_head) tp.sealed_tail = NULL;
+        tp.sends[s].batch = b;
+        tp.batches_sent++;
+        tp.bytes_sent += b->length;
+        pthread_mutex_unlock(&tp.lock);
+        // Synchronous mode: completion means the receiver matched it, which
+        // transport_stop relies on.
+        MPI_Issend(b->data, b->length, MPI_BYTE, b->rank, TRANSPORT_TAG, tp.comm, &tp.sends[s].request);
+        pthread_mutex_lock(&tp.lock);
+        moved = 1;
+    }
+    int pending_sealed = tp.sealed_head != NULL;
+    pthread_mutex_unlock(&tp.lock);
+
+    // Retire completed sends.
+    int in_flight = 0;
+    for (int s = 0; s < TRANSPORT_SEND_SLOTS; s++) {
+        requests[s] = tp.sends[s].batch ? tp.sends[s].request : MPI_REQUEST_NULL;
+        in_flight += tp.sends[s].batch != NULL;
+    }
+    if (in_flight) {
+        int done = 0;
+        MPI_Testsome(TRANSPORT_SEND_SLOTS, requests, &done, indices, MPI_STATUSES_IGNORE);
+        for (int i = 0; i < done && done != MPI_UNDEFINED; i++) {
+            batch_release(tp.sends[indices[i]].batch);
+            tp.sends[indices[i]].batch = NULL;
+            in_flight--;
+            moved = 1;
+        }
+    }
+
+    // Hand completed receives to the inbox and repost.
+    MPI_Request recv_requests[TRANSPORT_RECV_SLOTS];
+    for (int s = 0; s < TRANSPORT_RECV_SLOTS; s++) recv_requests[s] = tp.recvs[s].request;
+    int done = 0;
+    MPI_Testsome(TRANSPORT_RECV_SLOTS, recv_requests, &done, indices, statuses);
+    for (int i = 0; i < done && done != MPI_UNDEFINED; i++) {
+        slot_t *slot = &tp.recvs[indices[i]];
+        deliver_received(slot, &statuses[i]);
+        post_recv(slot);
+        moved = 1;
+    }
+
+    *sends_idle = !pending_sealed && in_flight == 0;
+    return moved;
+}
+
+static void* progress_main(void *arg) {
+    (void)arg;
+    int barrier_posted = 0;
+    MPI_Request barrier;
+
+    for (;;) {
+        int sends_idle;
+        int moved = progress_once(&sends_idle);
+        moved |= progress_agree();
+
+        pthread_mutex_lock(&tp.lock);
+        int stopping = tp.stop_requested;
+        int outboxes_empty = 1;
+        for (int r = 0; r < tp.size && outboxes_empty; r++) {
+            if (tp.outboxes[r].open && tp.outboxes[r].open->length > 0) outboxes_empty = 0;
+        }
+        pthread_mutex_unlock(&tp.lock);
+
+        // Non-blocking consensus: once every rank's sends have been matched
+        // and it has entered the barrier, nothing else is on the way.
+        if (stopping && sends_idle && outboxes_empty) {
+            if (!barrier_posted) {
+                MPI_Ibarrier(tp.comm, &barrier);
+                barrier_posted = 1;
+            }
+            int flag = 0;
+            MPI_Test(&barrier, &flag, MPI_STATUS_IGNORE);
+            if (flag) break;
+        }
+        if (!moved) usleep(IDLE_SLEEP_US);
+    }
+
+    // Matched receives cannot be cancelled; they complete with data.
+    for (int s = 0; s < TRANSPORT_RECV_SLOTS; s++) {
+        MPI_Status status;
+        int cancelled = 0;
+        MPI_Cancel(&tp.recvs[s].request);
+        MPI_Wait(&tp.recvs[s].request, &status);
+        MPI_Test_cancelled(&status, &cancelled);
+        if (cancelled) {
+            batch_release(tp.recvs[s].batch);
+        } else {
+            deliver_received(&tp.recvs[s], &status);
+        }
+        tp.recvs[s].batch = NULL;
+    }
+    return NULL;
+}
+
+int transport_start(void) {
+    int provided;
+    if (tp.started) return 0;
+    MPI_Query_thread(&provided);
+    if (provided < MPI_THREAD_SERIALIZED) {
+        fprintf(stderr, "[TRANSPORT] MPI thread support too low (%d), need MPI_THREAD_SERIALIZED\n", provided);
+        return -1;
+    }
+    pthread_mutex_lock(&tp.lock);
+    if (tp.outboxes) {
+        // Loopback records queued before start stay in the inbox.
+        seal(tp.rank);
+        free(tp.outboxes);
+        tp.outboxes = NULL;
+    }
+    pthread_mutex_unlock(&tp.lock);
+
+    // Own communicator, so batches never match receives posted elsewhere.
+    MPI_Comm_dup(MPI_COMM_WORLD, &tp.comm);
+    MPI_Comm_rank(tp.comm, &tp.rank);
+    MPI_Comm_size(tp.comm, &tp.size);
+
+    pthread_mutex_lock(&tp.lock);
+    allocate_outboxes();
+    pthread_mutex_unlock(&tp.lock);
+    for (int s = 0; s < TRANSPORT_RECV_SLOTS; s++) post_recv(&tp.recvs[s]);
+
+    tp.started = 1;
+    if (pthread_create(&tp.thread, NULL, progress_main, NULL) != 0) {
+        tp.started = 0;
+        return -1;
+    }
+    return 0;
+}
+
+void transport_stop(void) {
+    if (!tp.started) return;
+    pthread_mutex_lock(&tp.lock);
+    tp.stop_requested = 1;
+    pthread_mutex_unlock(&tp.lock);
+    pthread_join(tp.thread, NULL);
+    MPI_Comm_free(&tp.comm);
+    tp.started = 0;
+    tp.stop_requested = 0;
+}
+
+int transport_rank(void) { return tp.rank; }
+int transport_size(void) { return tp.size; }
+
+int transport_send(int dest_rank, transport_channel_t channel, const uint8_t *payload, int length) {
+    if (length < 0 || length + RECORD_HEADER > TRANSPORT_BATCH_BYTES) return -1;
+    if (channel < 0 || channel >= TRANSPORT_CHANNELS) return -1;
+    if (dest_rank < 0 || dest_rank >= tp.size) return -1;
+    uint64_t now = now_ns();
+
+    pthread_mutex_lock(&tp.lock);
+    // Before transport_start there is only the local rank: loop back.
+    if (!tp.outboxes) allocate_outboxes();
+    outbox_t *o = &tp.outboxes[dest_rank];
+    if (o->open && o->open->length + RECORD_HEADER + length > TRANSPORT_BATCH_BYTES) {
+        seal(dest_rank);
+    }
+    if (!o->open) {
+        o->open = batch_alloc(dest_rank);
+        o->first_ns = now;
+    }
+    uint8_t *p = o->open->data + o->open->length;
+    uint32_t len32 = (uint32_t)length;
+    uint16_t header[2] = { (uint16_t)channel, 0 };
+    memcpy(p, &len32, 4);
+    memcpy(p + 4, header, 4);
+    memcpy(p + 8, &now, 8);
+    memcpy(p + RECORD_HEADER, payload, length);
+    o->open->length += RECORD_HEADER + length;
+    tp.records_sent++;
+    pthread_mutex_unlock(&tp.lock);
+    return 0;
+}
+
+int transport_broadcast(transport_channel_t channel, const uint8_t *payload, int length) {
+    for (int r = 0; r < tp.size; r++) {
+        if (transport_send(r, channel, payload, length) < 0) return -1;
+    }
+    return 0;
+}
+
+long transport_agree(long value) {
+    if (!tp.started) return value;
+    pthread_mutex_lock(&tp.lock);
+    tp.agree_send = malloc(sizeof(long) * 2 * tp.size);
+    tp.agree_recv = malloc(sizeof(long) * 2 * tp.size);
+    for (int r = 0; r < tp.size; r++) tp.agree_send[2 * r + 1] = value;
+    tp.agree_posted = 0;
+    tp.agree_done = 0;
+    tp.agree_requested = 1;
+    while (!tp.agree_done) pthread_cond_wait(&tp.agreed, &tp.lock);
+    tp.agree_requested = 0;
+    long result = value;
+    for (int r = 0; r < tp.size; r++) {
+        if (tp.agree_recv[2 * r + 1] < result) result = tp.agree_recv[2 * r + 1];
+    }
+    free(tp.agree_send);
+    free(tp.agree_recv);
+    tp.agree_send = tp.agree_recv = NULL;
+    pthread_mutex_unlock(&tp.lock);
+    return result;
+}
+
+void transport_flush(void) {
+    pthread_mutex_lock(&tp.lock);
+    tp.flush_requested = 1;
+    pthread_mutex_unlock(&tp.lock);
+}
+
+void transport_set_handler(transport_channel_t channel, transport_handler_fn handler, void *ctx) {
+    pthread_mutex_lock(&tp.lock);
+    tp.handlers[channel] = handler;
+    tp.handler_ctx[channel] = ctx;
+    pthread_mutex_unlock(&tp.lock);
+}
+
+int transport_poll(void) {
+    pthread_mutex_lock(&tp.lock);
+    if (tp.outboxes) seal(tp.rank);   // loopback needs no flush delay
+    batch_t *batches = tp.inbox_head;
+    tp.inbox_head = tp.inbox_tail = NULL;
+    pthread_mutex_unlock(&tp.lock);
+
+    int delivered = 0;
+    while (batches) {
+        batch_t *b = batches;
+        batches = b->next;
+        for (int pos = 0; pos + RECORD_HEADER <= b->length; ) {
+            uint32_t length;
+            uint16_t channel;
+            memcpy(&length, b->data + pos, 4);
+            memcpy(&channel, b->data + pos + 4, 2);
+            if (channel < TRANSPORT_CHANNELS && tp.handlers[channel]) {
+                tp.handlers[channel](tp.handler_ctx[channel], b->rank, b->data + pos + RECORD_HEADER, (int)length);
+            }
+            pos += RECORD_HEADER + length;
+            delivered++;
+        }
+        batch_release(b);
+    }
+    __atomic_add_fetch(&tp.records_delivered, delivered, __ATOMIC_RELAXED);
+    return delivered;
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void latency_percentiles(double *p50, double *p99) {
+    pthread_mutex_lock(&tp.lock);
+    long n = tp.latency_count < TRANSPORT_LATENCY_SAMPLES ? tp.latency_count : TRANSPORT_LATENCY_SAMPLES;
+    double *sorted = malloc(sizeof(double) * (n ? n : 1));
+    if (n) memcpy(sorted, tp.latency_us, sizeof(double) * n);
+    pthread_mutex_unlock(&tp.lock);
+
+    qsort(sorted, n, sizeof(double), compare_double);
+    *p50 = n ? sorted[n / 2] : 0.0;
+    *p99 = n ? sorted[(long)(n * 0.99) < n ? (long)(n * 0.99) : n - 1] : 0.0;
+    free(sorted);
+}
+
+void transport_report(void) {
+    double p50, p99;
+    double seconds = (now_ns() - tp.start_ns) / 1e9;
+    latency_percentiles(&p50, &p99);
+    printf("[TRANSPORT] rank %d/%d | sent %ld records in %ld batches (%ld bytes) | delivered %ld (%.0f msgs/sec) | latency p50 %.1f us p99 %.1f us\n",
+           tp.rank, tp.size, tp.records_sent, tp.batches_sent, tp.bytes_sent, tp.records_delivered,
+           seconds > 0 ? tp.records_delivered / seconds : 0.0, p50, p99);
+}
+
+static void count_record(void *ctx, int source_rank, const uint8_t *payload, int length) {
+    (void)source_rank;
+    (void)payload;
+    (void)length;
+    (*(long *)ctx)++;
+}
+
+void transport_bench(int messages, int payload_bytes) {
+    if (messages <= 0) messages = 100000;
+    if (payload_bytes <= 0) payload_bytes = 64;
+    if (payload_bytes > TRANSPORT_BATCH_BYTES - RECORD_HEADER) payload_bytes = TRANSPORT_BATCH_BYTES - RECORD_HEADER;
+
+    uint8_t *payload = calloc(payload_bytes, 1);
+    long received = 0;
+    transport_set_handler(TRANSPORT_CHANNEL_BENCH, count_record, &received);
+    pthread_mutex_lock(&tp.lock);
+    tp.latency_count = 0;
+    pthread_mutex_unlock(&tp.lock);
+
+    // Rank r sends to r+1, r+2, ... in turn, so every rank also receives
+    // exactly messages records.
+    uint64_t t0 = now_ns();
+    for (int i = 0; i < messages; i++) {
+        int dest = tp.size == 1 ? tp.rank : (tp.rank + 1 + i % (tp.size - 1)) % tp.size;
+        transport_send(dest, TRANSPORT_CHANNEL_BENCH, payload, payload_bytes);
+        if ((i & 1023) == 0) transport_poll();
+    }
+    transport_flush();
+    while (received < messages) {
+        if (transport_poll() == 0) usleep(IDLE_SLEEP_US);
+    }
+    transport_set_handler(TRANSPORT_CHANNEL_BENCH, NULL, NULL);
+    double seconds = (now_ns() - t0) / 1e9;
+
+    double p50, p99;
+    latency_percentiles(&p50, &p99);
+    printf("[TRANSPORT] bench rank %d/%d: %d x %d bytes in %.3f s = %.0f msgs/sec | latency p50 %.1f us p99 %.1f us\n",
+           tp.rank, tp.size, messages, payload_bytes, seconds, messages / seconds, p50, p99);
+    free(payload);
+}
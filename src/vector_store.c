@@ -0,0 +1,304 @@
+/*
+ * FT-DFRP: Fractal Toroidal Density Field Routing Protocol - Vector Store
+ *
+ * Dual Licensed:
+ * 1. AGPL-3.0 for research/academic use: https://www.gnu.org/licenses/agpl-3.0.html
+ * 2. Commercial license available - contact michael.doran.808@gmail.com for terms
+ *
+ * Copyright (C) 2025 Michael Doran
+ */
+
+#include "vector_store.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define VECTOR_STORE_X86 1
+#include <immintrin.h>
+#endif
+
+// Gather scratch up to this dimension lives on the stack (4 KB); larger
+// dimensions allocate it, so thread-pool workers never need deep stacks.
+#define GATHER_STACK_DIM 64
+
+// Each kernel body is force-inlined into a generic entry point and into one
+// wrapper per common dimension, where the constant trip count lets the
+// compiler unroll the dimension loop.
+#define SPECIALIZED_DIMS(X) X(8) X(64) X(128) X(384) X(768)
+
+typedef struct {
+    int dim;
+    vector_kernels_t kernels;
+} dim_kernels_t;
+
+#define KERNEL_INLINE static inline __attribute__((always_inline))
+
+// ---- Scalar kernels -------------------------------------------------------
+
+KERNEL_INLINE void dot_block_scalar_body(const double *block, const double *query, int dim, double *out) {
+    double acc[VECTOR_LANES] = { 0 };
+    for (int d = 0; d < dim; d++) {
+        const double *row = block + d * VECTOR_LANES;
+        for (int l = 0; l < VECTOR_LANES; l++) acc[l] += query[d] * row[l];
+    }
+    memcpy(out, acc, sizeof(acc));
+}
+
+#define SCALAR_SPECIALIZE(D) \
+    static void dot_block_scalar_##D(const double *block, const double *query, int dim, double *out) { \
+        (void)dim; dot_block_scalar_body(block, query, D, out); \
+    }
+#define SCALAR_ENTRY(D) { D, { "scalar/d" #D, dot_block_scalar_##D } },
+
+static void dot_block_scalar(const double *block, const double *query, int dim, double *out) {
+    dot_block_scalar_body(block, query, dim, out);
+}
+
+SPECIALIZED_DIMS(SCALAR_SPECIALIZE)
+
+static const vector_kernels_t scalar_kernels = { "scalar", dot_block_scalar };
+static const dim_kernels_t scalar_specialized[] = { SPECIALIZED_DIMS(SCALAR_ENTRY) };
+
+#ifdef VECTOR_STORE_X86
+
+// ---- AVX2 + FMA: two ymm registers cover the 8 lanes ------------------------
+
+#define AVX2_TARGET __attribute__((target("avx2,fma")))
+
+AVX2_TARGET KERNEL_INLINE void dot_block_avx2_body(const double *block, const double *query, int dim, double *out) {
+    __m256d lo = _mm256_setzero_pd();
+    __m256d hi = _mm256_setzero_pd();
+    for (int d = 0; d < dim; d++) {
+        const double *row = block + d * VECTOR_LANES;
+        __m256d q = _mm256_broadcast_sd(query + d);
+        lo = _mm256_fmadd_pd(q, _mm256_load_pd(row), lo);
+        hi = _mm256_fmadd_pd(q, _mm256_load_pd(row + 4), hi);
+    }
+    _mm256_storeu_pd(out, lo);
+    _mm256_storeu_pd(out + 4, hi);
+}
+
+#define AVX2_SPECIALIZE(D) \
+    AVX2_TARGET static void dot_block_avx2_##D(const double *block, const double *query, int dim, double *out) { \
+        (void)dim; dot_block_avx2_body(block, query, D, out); \
+    }
+#define AVX2_ENTRY(D) { D, { "avx2/d" #D, dot_block_avx2_##D } },
+
+AVX2_TARGET static void dot_block_avx2(const double *block, const double *query, int dim, double *out) {
+    dot_block_avx2_body(block, query, dim, out);
+}
+
+SPECIALIZED_DIMS(AVX2_SPECIALIZE)
+
+static const vector_kernels_t avx2_kernels = { "avx2", dot_block_avx2 };
+static const dim_kernels_t avx2_specialized[] = { SPECIALIZED_DIMS(AVX2_ENTRY) };
+
+// ---- AVX-512: one zmm register per block row, two accumulator chains --------
+
+#define AVX512_TARGET __attribute__((target("avx512f")))
+
+AVX512_TARGET KERNEL_INLINE void dot_block_avx512_body(const double *block, const double *query, int dim, double *out) {
+    __m512d acc0 = _mm512_setzero_pd();
+    __m512d acc1 = _mm512_setzero_pd();
+    int d = 0;
+    for (; d + 1 < dim; d += 2) {
+        const double *row = block + d * VECTOR_LANES;
+        acc0 = _mm512_fmadd_pd(_mm512_set1_pd(query[d]), _mm512_load_pd(row), acc0);
+        acc1 = _mm512_fmadd_pd(_mm512_set1_pd(query[d + 1]), _mm512_load_pd(row + VECTOR_LANES), acc1);
+    }
+    if (d < dim) {
+        acc0 = _mm512_fmadd_pd(_mm512_set1_pd(query[d]), _mm512_load_pd(block + d * VECTOR_LANES), acc0);
+    }
+    _mm512_storeu_pd(out, _mm512_add_pd(acc0, acc1));
+}
+
+#define AVX512_SPECIALIZE(D) \
+    AVX512_TARGET static void dot_block_avx512_##D(const double *block, const double *query, int dim, double *out) { \
+        (void)dim; dot_block_avx512_body(block, query, D, out); \
+    }
+#define AVX512_ENTRY(D) { D, { "avx512/d" #D, dot_block_avx512_##D } },
+
+AVX512_TARGET static void dot_block_avx512(const double *block, const double *query, int dim, double *out) {
+    dot_block_avx512_body(block, query, dim, out);
+}
+
+SPECIALIZED_DIMS(AVX512_SPECIALIZE)
+
+static const vector_kernels_t avx512_kernels = { "avx512", dot_block_avx512 };
+static const dim_kernels_t avx512_specialized[] = { SPECIALIZED_DIMS(AVX512_ENTRY) };
+
+#endif // VECTOR_STORE_X86
+
+#define SPECIALIZED_COUNT (sizeof(scalar_specialized) / sizeof(scalar_specialized[0]))
+
+static const vector_kernels_t *selected_kernels = NULL;
+static const dim_kernels_t *selected_specialized = NULL;
+
+const vector_kernels_t* vector_kernels(void) {
+    if (selected_kernels) return selected_kernels;
+    selected_kernels = &scalar_kernels;
+    selected_specialized = scalar_specialized;
+#ifdef VECTOR_STORE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        selected_kernels = &avx512_kernels;
+        selected_specialized = avx512_specialized;
+    } else if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        selected_kernels = &avx2_kernels;
+        selected_specialized = avx2_specialized;
+    }
+#endif
+    return selected_kernels;
+}
+
+const vector_kernels_t* vector_kernels_for_dim(int dim) {
+    const vector_kernels_t *generic = vector_kernels();
+    for (size_t i = 0; i < SPECIALIZED_COUNT; i++) {
+        if (selected_specialized[i].dim == dim) return &selected_specialized[i].kernels;
+    }
+    return generic;
+}
+
+// ---- Arena management -----------------------------------------------------
+
+static void* aligned_calloc(size_t bytes) {
+    void *ptr = NULL;
+    if (bytes == 0) bytes = VECTOR_ALIGNMENT;
+    if (posix_memalign(&ptr, VECTOR_ALIGNMENT, bytes) != 0) return NULL;
+    memset(ptr, 0, bytes);
+    return ptr;
+}
+
+static inline double* block_of(const vector_store_t *store, int id) {
+    return store->blocks + (size_t)(id - id % VECTOR_LANES) * store->dim;
+}
+
+static double inverse_norm(const double *v, int dim) {
+    double norm = 0.0;
+    for (int i = 0; i < dim; i++) norm += v[i] * v[i];
+    return norm > 0.0 ? 1.0 / sqrt(norm) : 0.0;
+}
+
+static void grow(vector_store_t *store, int needed) {
+    int capacity = store->capacity ? store->capacity : VECTOR_LANES;
+    while (capacity < needed) capacity *= 2;
+    capacity = (capacity + VECTOR_LANES - 1) / VECTOR_LANES * VECTOR_LANES;
+
+    double *blocks = aligned_calloc(sizeof(double) * (size_t)capacity * store->dim);
+    double *inv_norms = aligned_calloc(sizeof(double) * (size_t)capacity);
+    if (store->blocks) {
+        memcpy(blocks, store->blocks, sizeof(double) * (size_t)store->capacity * store->dim);
+        memcpy(inv_norms, store->inv_norms, sizeof(double) * (size_t)store->capacity);
+    }
+    if (!store->borrowed) {
+        free(store->blocks);
+        free(store->inv_norms);
+    }
+    store->blocks = blocks;
+    store->inv_norms = inv_norms;
+    store->capacity = capacity;
+    store->borrowed = 0;
+}
+
+vector_store_t* vector_store_create(int capacity, int dim) {
+    vector_store_t *store = calloc(1, sizeof(vector_store_t));
+    store->dim = dim;
+    store->kernels = vector_kernels_for_dim(dim);
+    grow(store, capacity > 0 ? capacity : VECTOR_LANES);
+    return store;
+}
+
+vector_store_t* vector_store_wrap(int capacity, int dim, double *blocks, double *inv_norms) {
+    if (capacity <= 0 || capacity % VECTOR_LANES != 0) return NULL;
+    if ((uintptr_t)blocks % VECTOR_ALIGNMENT != 0) return NULL;
+    vector_store_t *store = calloc(1, sizeof(vector_store_t));
+    store->dim = dim;
+    store->capacity = capacity;
+    store->blocks = blocks;
+    store->inv_norms = inv_norms;
+    store->kernels = vector_kernels_for_dim(dim);
+    store->borrowed = 1;
+    return store;
+}
+
+void vector_store_free(vector_store_t *store) {
+    if (!store) return;
+    if (!store->borrowed) {
+        free(store->blocks);
+        free(store->inv_norms);
+    }
+    free(store);
+}
+
+void vector_store_set(vector_store_t *store, int id, const double *vector) {
+    if (id >= store->capacity) grow(store, id + 1);
+    double *block = block_of(store, id);
+    int lane = id % VECTOR_LANES;
+    for (int d = 0; d < store->dim; d++) {
+        block[d * VECTOR_LANES + lane] = vector[d];
+    }
+    store->inv_norms[id] = inverse_norm(vector, store->dim);
+}
+
+void vector_store_get(const vector_store_t *store, int id, double *out) {
+    const double *block = block_of(store, id);
+    int lane = id % VECTOR_LANES;
+    for (int d = 0; d < store->dim; d++) {
+        out[d] = block[d * VECTOR_LANES + lane];
+    }
+}
+
+// ---- Batch scoring --------------------------------------------------------
+
+void vector_store_cosine_range(const vector_store_t *store, const double *query,
+                               int first, int n, double *out) {
+    vector_block_kernel_fn dot = store->kernels->dot;
+    double inv_q = inverse_norm(query, store->dim);
+    double scores[VECTOR_LANES];
+    int end = first + n;
+
+    for (int base = first - first % VECTOR_LANES; base < end; base += VECTOR_LANES) {
+        dot(store->blocks + (size_t)base * store->dim, query, store->dim, scores);
+        int lo = base < first ? first : base;
+        int hi = base + VECTOR_LANES < end ? base + VECTOR_LANES : end;
+        for (int id = lo; id < hi; id++) {
+            out[id - first] = scores[id - base] * inv_q * store->inv_norms[id];
+        }
+    }
+}
+
+void vector_store_cosine_gather(const vector_store_t *store, const double *query,
+                                const int *ids, int n, double *out) {
+    vector_block_kernel_fn dot = store->kernels->dot;
+    double inv_q = inverse_norm(query, store->dim);
+    double scores[VECTOR_LANES];
+    int dim = store->dim;
+
+    double stack_scratch[VECTOR_LANES * GATHER_STACK_DIM] __attribute__((aligned(VECTOR_ALIGNMENT)));
+    double *scratch = dim <= GATHER_STACK_DIM ?
+        stack_scratch : aligned_calloc(sizeof(double) * VECTOR_LANES * dim);
+
+    for (int start = 0; start < n; start += VECTOR_LANES) {
+        int lanes = n - start < VECTOR_LANES ? n - start : VECTOR_LANES;
+        for (int l = 0; l < VECTOR_LANES; l++) {
+            if (l < lanes) {
+                int id = ids[start + l];
+                const double *block = block_of(store, id);
+                int lane = id % VECTOR_LANES;
+                for (int d = 0; d < dim; d++) {
+                    scratch[d * VECTOR_LANES + l] = block[d * VECTOR_LANES + lane];
+                }
+            } else {
+                for (int d = 0; d < dim; d++) scratch[d * VECTOR_LANES + l] = 0.0;
+            }
+        }
+        dot(scratch, query, dim, scores);
+        for (int l = 0; l < lanes; l++) {
+            out[start + l] = scores[l] * inv_q * store->inv_norms[ids[start + l]];
+        }
+    }
+
+    if (scratch != stack_scratch) free(scratch);
+}